@@ -0,0 +1 @@
+#include <../private/package/RepositoryCacheIndex.h>
@@ -144,6 +144,8 @@ private:
 
 			void*			ReadRawFromPort(int32* code,
 								bigtime_t timeout = B_INFINITE_TIMEOUT);
+			void*			_ReadRawFromPort(int32* code, ssize_t* _size,
+								bigtime_t timeout);
 			BMessage*		ReadMessageFromPort(
 								bigtime_t timeout = B_INFINITE_TIMEOUT);
 	virtual	BMessage*		ConvertToMessage(void* raw, int32 code);
@@ -174,7 +176,8 @@ private:
 			bool			fTerminating;
 			bool			fRunCalled;
 			bool			fOwnsPort;
-			uint32			_reserved[11];
+			int32			fAdoptableSize;
+			uint32			_reserved[10];
 };
 
 #endif	// _LOOPER_H
@@ -524,6 +524,13 @@ private:
 			status_t			_InitHeader();
 			status_t			_Clear();
 
+			status_t			_AllocateHeader();
+			status_t			_AllocateFields(uint32 count);
+			status_t			_AllocateData(size_t size);
+			void				_FreeFields();
+			void				_FreeData();
+			status_t			_AdoptFlatBuffer(void* buffer, size_t size);
+
 			status_t			_FlattenToArea(message_header** _header) const;
 			status_t			_CopyForWrite();
 			status_t			_Reference();
@@ -584,7 +591,11 @@ private:
 
 			void*				fArchivingPointer;
 
-			uint32				fReserved[8];
+			uint32				fStorageFlags;
+				// tells which of fHeader, fFields and fData live in a
+				// shared storage block, see MessagePrivate.h
+
+			uint32				fReserved[7];
 
 			enum				{ sNumReplyPorts = 3 };
 	static	port_id				sReplyPorts[sNumReplyPorts];
@@ -16,6 +16,8 @@ class BRegion;
 
 namespace BPrivate {
 	class BufferCache;
+	class BufferRing;
+	class BufferRingList;
 	namespace media {
 		class BMediaRosterEx;
 	}
@@ -127,6 +129,11 @@ private:
 	static	status_t			SetOutputEnabled(const media_source& source,
 									bool enabled, int32* changeTag);
 
+			void				_ReceiveBuffer(media_buffer_id bufferID,
+									const media_header& header);
+			void				_DrainBufferRing(BPrivate::BufferRing* ring,
+									int32 maxCount);
+
 			status_t			_Reserved_BufferConsumer_0(void*);
 									// used for SeekTagRequested()
 	virtual	status_t			_Reserved_BufferConsumer_1(void*);
@@ -149,7 +156,9 @@ private:
 			media_type			fConsumerType;
 			BPrivate::BufferCache* fBufferCache;
 			BBufferGroup*		fDeleteBufferGroup;
-			uint32				_reserved[14];
+			BPrivate::BufferRingList* fBufferRings;
+			uint32				_reserved[14
+									- sizeof(void*) / sizeof(uint32)];
 };
 
 
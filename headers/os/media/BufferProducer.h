@@ -15,6 +15,7 @@ class BRegion;
 
 
 namespace BPrivate {
+	class BufferRingList;
 	namespace media {
 		class BMediaRosterEx;
 	}
@@ -227,7 +228,10 @@ private:
 			uint32				fInitialFlags;
 			bigtime_t			fDelay;
 
-			uint32				_reserved_buffer_producer_[12];
+			BPrivate::BufferRingList* fBufferRings;
+
+			uint32				_reserved_buffer_producer_[12
+									- sizeof(void*) / sizeof(uint32)];
 };
 
 #endif // _BUFFER_PRODUCER_H
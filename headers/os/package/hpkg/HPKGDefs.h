@@ -133,9 +133,13 @@ enum {
 
 // Reader Init() flags
 enum {
-	B_HPKG_READER_DONT_PRINT_VERSION_MISMATCH_MESSAGE	= 0x01
+	B_HPKG_READER_DONT_PRINT_VERSION_MISMATCH_MESSAGE	= 0x01,
 		// Fail silently when encountering a package format version mismatch.
 		// Don't print anything to the error output.
+	B_HPKG_READER_READ_AHEAD							= 0x02
+		// Decompress the heap chunks following the ones read on other
+		// threads, while the heap is read sequentially. Speeds up reading
+		// the data of many or large files, e.g. when extracting the package.
 };
 
 
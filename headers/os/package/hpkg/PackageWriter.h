@@ -57,9 +57,16 @@ public:
 			int32				CompressionLevel() const;
 			void				SetCompressionLevel(int32 compressionLevel);
 
+			int32				CompressionThreadCount() const;
+			void				SetCompressionThreadCount(int32 count);
+									// defaults to 1; 0 means one thread per
+									// CPU
+
 private:
 			uint32				fFlags;
 			uint32				fCompression;
+									// the thread count is kept in the upper
+									// 16 bits
 			int32				fCompressionLevel;
 };
 
@@ -16,6 +16,7 @@ class BFile;
 class BMenu;
 class BMessage;
 class BPositionIO;
+class BRect;
 class BTextView;
 class BTranslatorRoster;
 struct entry_ref;
@@ -46,6 +47,12 @@ public:
 									BTranslatorRoster* roster = NULL);
 	static	BBitmap*			GetBitmap(BPositionIO* stream,
 									BTranslatorRoster* roster = NULL);
+	static	BBitmap*			GetBitmap(const entry_ref* ref,
+									const BRect& sizeHint,
+									BTranslatorRoster* roster = NULL);
+	static	BBitmap*			GetBitmap(BPositionIO* stream,
+									const BRect& sizeHint,
+									BTranslatorRoster* roster = NULL);
 
 	static	void				SetBitmapColorSpace(color_space space);
 	static	color_space			BitmapColorSpace();
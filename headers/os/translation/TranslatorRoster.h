@@ -88,6 +88,11 @@ public:
 									BPositionIO* destination,
 									uint32 wantOutType);
 
+			status_t			TranslateBatch(BPositionIO** sources,
+									BPositionIO** destinations, int32 count,
+									BMessage* ioExtension, uint32 wantOutType,
+									status_t* _results = NULL);
+
 	virtual	status_t			MakeConfigurationView(
 									translator_id translatorID,
 									BMessage* ioExtension, BView** _view,
@@ -1,5 +1,5 @@
 /*
- * Copyright 2007, Haiku, Inc.
+ * Copyright 2007-2026, Haiku, Inc.
  * Distributed under the terms of the MIT License.
  *
  * Authors:
@@ -18,7 +18,10 @@ class BDirectMessageTarget {
 	public:
 		BDirectMessageTarget();
 
-		bool AddMessage(BMessage* message);
+		bool AddMessage(BMessage* message, bool* _wasEmpty = NULL);
+		bool FlushPendingMessages();
+		bool HasPendingMessages() const;
+		BMessage* NextMessage();
 
 		void Close();
 		void Acquire();
@@ -28,9 +31,12 @@ class BDirectMessageTarget {
 
 	private:
 		~BDirectMessageTarget();
-		
+
 		int32			fReferenceCount;
 		BMessageQueue	fQueue;
+		BMessage*		fPending;
+			// messages added by AddMessage() that have not yet been moved
+			// to fQueue, in reverse order
 		bool			fClosed;
 };
 
@@ -19,6 +19,15 @@
 #define MAX_DATA_PREALLOCATION			B_PAGE_SIZE * 10
 #define MAX_FIELD_PREALLOCATION			50
 
+/*	Small messages keep their header, fields and data in a single storage
+	block taken from a block cache, so that constructing, filling and deleting
+	a typical message does not need to go to the heap at all. The block
+	starts with the message_header, followed by MESSAGE_INLINE_FIELD_COUNT
+	field_headers, and the remainder of the block is used for the data.
+*/
+#define MESSAGE_STORAGE_BLOCK_SIZE		512
+#define MESSAGE_INLINE_FIELD_COUNT		6
+
 
 static const int32 kPortMessageCode = 'pjpp';
 
@@ -36,6 +45,19 @@ enum {
 };
 
 
+enum {
+	MESSAGE_STORAGE_BLOCK = 0x0001,
+		// fHeader is the start of a storage block
+	MESSAGE_STORAGE_INLINE_FIELDS = 0x0002,
+		// fFields points into the storage block
+	MESSAGE_STORAGE_INLINE_DATA = 0x0004,
+		// fData points into the storage block
+	MESSAGE_STORAGE_ADOPTED = 0x0008
+		// fHeader is an adopted flat buffer that fFields and fData point
+		// into; the fields and data are copied out on first modification
+};
+
+
 enum {
 	FIELD_FLAG_VALID = 0x0001,
 	FIELD_FLAG_FIXED_SIZE = 0x0002,
@@ -170,6 +192,24 @@ class BMessage::Private {
 			return fMessage->fData;
 		}
 
+		BMessage*
+		QueueLink()
+		{
+			return fMessage->fQueueLink;
+		}
+
+		void
+		SetQueueLink(BMessage* link)
+		{
+			fMessage->fQueueLink = link;
+		}
+
+		status_t
+		AdoptFlatBuffer(void* buffer, size_t size)
+		{
+			return fMessage->_AdoptFlatBuffer(buffer, size);
+		}
+
 		status_t
 		FlattenToArea(message_header **header) const
 		{
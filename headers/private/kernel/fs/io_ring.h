@@ -0,0 +1,29 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef _KERNEL_IO_RING_H
+#define _KERNEL_IO_RING_H
+
+
+#include <OS.h>
+
+
+struct io_ring_params;
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// syscalls
+int			_user_create_io_ring(struct io_ring_params *params);
+int32		_user_io_ring_enter(int ring, uint32 submitCount, uint32 waitCount,
+				uint32 flags, bigtime_t timeout);
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif	/* _KERNEL_IO_RING_H */
@@ -10,6 +10,8 @@
 #define _MEDIA_EXTRACTOR_H
 
 
+#include <RealtimeAlloc.h>
+
 #include "ReaderPlugin.h"
 #include "DecoderPlugin.h"
 
@@ -91,6 +93,7 @@ private:
 
 			stream_info*		fStreamInfo;
 			int32				fStreamCount;
+			rtm_pool*			fChunkPool;
 
 			media_file_format	fFileFormat;
 };
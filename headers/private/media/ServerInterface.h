@@ -123,6 +123,8 @@ enum {
 	CONSUMER_GET_LATENCY_FOR,
 	CONSUMER_FORMAT_CHANGED,
 	CONSUMER_SEEK_TAG_REQUESTED,
+	CONSUMER_CREATE_BUFFER_RING,
+	CONSUMER_BUFFER_RING_NOTIFY,
 	CONSUMER_MESSAGE_END,
 
 	PRODUCER_MESSAGE_START = 0x400,
@@ -144,6 +146,7 @@ enum {
 	PRODUCER_SET_PLAY_RATE,
 	PRODUCER_ENABLE_OUTPUT,
 	PRODUCER_SET_RUN_MODE_DELAY,
+	PRODUCER_SET_BUFFER_RING,
 	PRODUCER_MESSAGE_END,
 
 	FILEINTERFACE_MESSAGE_START = 0x500,
@@ -803,6 +806,14 @@ struct producer_set_run_mode_delay_command : command_data {
 	bigtime_t				delay;
 };
 
+struct producer_set_buffer_ring_request : area_request_data {
+	media_source			source;
+	media_destination		destination;
+};
+
+struct producer_set_buffer_ring_reply : reply_data {
+};
+
 struct producer_get_next_output_request : request_data {
 	int32					cookie;
 };
@@ -908,6 +919,19 @@ struct consumer_seek_tag_requested_reply : reply_data {
 	uint32					flags;
 };
 
+struct consumer_create_buffer_ring_request : request_data {
+	media_source			source;
+	media_destination		destination;
+};
+
+struct consumer_create_buffer_ring_reply : reply_data {
+	area_id					area;
+};
+
+struct consumer_buffer_ring_notify_command : command_data {
+	media_destination		destination;
+};
+
 
 // #pragma mark - node commands
 
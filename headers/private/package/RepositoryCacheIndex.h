@@ -0,0 +1,97 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef _PACKAGE__PRIVATE__REPOSITORY_CACHE_INDEX_H_
+#define _PACKAGE__PRIVATE__REPOSITORY_CACHE_INDEX_H_
+
+
+#include <Entry.h>
+#include <String.h>
+
+
+namespace BPackageKit {
+
+
+class BPackageInfo;
+
+namespace BHPKG {
+	class BStandardErrorOutput;
+	namespace BPrivate {
+		class RepositoryReaderImpl;
+	}
+}
+
+
+namespace BPrivate {
+
+
+struct repository_cache_index_header;
+struct repository_cache_index_package;
+struct repository_cache_index_resolvable;
+
+
+/*!	An index of a repository cache, stored next to it as "<cache>.index".
+
+	The index is mapped into memory and provides the packages' names and
+	texts, sorted by name, and the packages providing a resolvable, without
+	parsing the cache. A single package's BPackageInfo is read from just its
+	part of the cache.
+*/
+class RepositoryCacheIndex {
+public:
+								RepositoryCacheIndex();
+								~RepositoryCacheIndex();
+
+	static	status_t			Write(const BEntry& cacheEntry);
+
+			status_t			SetTo(const BEntry& cacheEntry);
+									// B_ENTRY_NOT_FOUND, if there's no index,
+									// B_MISMATCHED_VALUES, if it's outdated
+			status_t			SetTo(const BString& repositoryName);
+									// finds the cache like
+									// BPackageRoster::GetRepositoryCache()
+			void				Unset();
+
+			uint32				CountPackages() const;
+			const char*			PackageNameAt(uint32 index) const;
+			const char*			PackageVersionAt(uint32 index) const;
+			const char*			PackageSummaryAt(uint32 index) const;
+			const char*			PackageDescriptionAt(uint32 index) const;
+
+			bool				PackageMatches(uint32 index,
+									const char* searchString) const;
+									// case insensitive substring match of
+									// name, summary, description, and
+									// provides
+
+			int32				FindPackage(const char* name) const;
+									// index of the first package with the
+									// given name, -1 if there's none
+			uint32				FindProviders(const char* resolvableName,
+									const uint32*& _packages) const;
+
+			status_t			GetPackageInfo(uint32 index,
+									BPackageInfo& _info);
+
+private:
+			const char*			_String(uint32 offset) const;
+			const repository_cache_index_package* _PackageAt(uint32 index)
+									const;
+
+private:
+			BEntry				fCacheEntry;
+			void*				fAddress;
+			size_t				fSize;
+			const repository_cache_index_header* fHeader;
+			BHPKG::BStandardErrorOutput* fErrorOutput;
+			BHPKG::BPrivate::RepositoryReaderImpl* fReader;
+};
+
+
+}	// namespace BPrivate
+
+}	// namespace BPackageKit
+
+
+#endif // _PACKAGE__PRIVATE__REPOSITORY_CACHE_INDEX_H_
@@ -70,6 +70,59 @@ struct hpkg_repo_header {
 };
 
 
+// package delta file
+
+enum {
+	B_HPKG_DELTA_MAGIC		= 'hpkd',
+	B_HPKG_DELTA_VERSION	= 1
+};
+
+struct hpkg_delta_header {
+	uint32	magic;							// "hpkd"
+	uint16	header_size;
+	uint16	version;
+	uint64	total_size;
+
+	// the package the delta applies to
+	uint64	old_package_size;
+	uint8	old_package_checksum[32];		// SHA-256
+
+	// the package the delta produces
+	uint64	new_package_size;
+	uint8	new_package_checksum[32];		// SHA-256
+	uint32	new_heap_offset;
+	uint16	heap_compression;
+	uint16	heap_compression_level;
+	uint64	heap_size_uncompressed;
+	uint64	heap_chunk_count;
+};
+
+// The delta header is followed by the first new_heap_offset bytes of the
+// new package (its header), and one command per heap chunk of the new
+// package. The chunk size table is not stored, but computed.
+enum {
+	B_HPKG_DELTA_CHUNK_COPY		= 1,
+		// uint64 offset, uint32 size: the compressed chunk at the given offset
+		// in the old package file
+	B_HPKG_DELTA_CHUNK_LITERAL	= 2,
+		// uint32 size, data: the compressed chunk
+	B_HPKG_DELTA_CHUNK_COMPRESS	= 3,
+		// pieces of the uncompressed chunk, to be compressed with
+		// heap_compression_level
+	B_HPKG_DELTA_CHUNK_STORE	= 4
+		// pieces of the uncompressed chunk, to be stored as is
+};
+
+// Pieces are stored as a uint32 count followed by the pieces.
+enum {
+	B_HPKG_DELTA_PIECE_REFERENCE	= 1,
+		// uint64 offset, uint32 size: data from the old package's uncompressed
+		// heap
+	B_HPKG_DELTA_PIECE_DATA			= 2
+		// uint32 size, data
+};
+
+
 // attribute tag arithmetics
 // (using 7 bits for id, 3 for type, 1 for hasChildren and 2 for encoding)
 static inline uint16
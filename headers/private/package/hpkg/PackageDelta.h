@@ -0,0 +1,146 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef _PACKAGE__HPKG__PRIVATE__PACKAGE_DELTA_H_
+#define _PACKAGE__HPKG__PRIVATE__PACKAGE_DELTA_H_
+
+
+#include <Array.h>
+
+#include <package/hpkg/PackageFileHeapAccessorBase.h>
+
+
+class BDataIO;
+
+
+namespace BPackageKit {
+
+namespace BHPKG {
+
+
+class BErrorOutput;
+
+
+namespace BPrivate {
+
+
+class DeltaPackage;
+
+
+struct PackageDeltaStatistics {
+	uint64	copiedChunks;
+	uint64	copiedBytes;
+		// compressed chunks taken from the old package as is
+	uint64	rebuiltChunks;
+	uint64	referencedBytes;
+	uint64	dataBytes;
+		// chunks rebuilt from the old package's heap and data in the delta
+	uint64	literalChunks;
+	uint64	literalBytes;
+		// compressed chunks stored in the delta
+};
+
+
+/*!	Creates a delta that turns one package file into another.
+	The new package's heap chunks are first matched against the old package's
+	by the SHA-256 digest of their compressed data. The digest is only used
+	for matching; a matching chunk is stored as the offset and size of the
+	compressed chunk in the old package file. The chunks that don't match are
+	split into content-defined segments, which are looked up in the old
+	package's uncompressed heap. That also finds data that have only been
+	moved by insertions or removals before them.
+*/
+class PackageDeltaWriter {
+public:
+								PackageDeltaWriter(BErrorOutput* errorOutput);
+								~PackageDeltaWriter();
+
+			status_t			Create(const char* oldPackageFileName,
+									const char* newPackageFileName,
+									const char* deltaFileName);
+
+			const PackageDeltaStatistics& Statistics() const
+									{ return fStatistics; }
+
+private:
+			struct Segment;
+			struct Piece;
+			struct DigestEntry;
+			struct DigestHashDefinition;
+			struct DigestTable;
+			class SegmentScanner;
+
+private:
+			status_t			_Init(const char* oldPackageFileName,
+									const char* newPackageFileName);
+			status_t			_IndexOldPackage();
+			status_t			_ScanNewPackage();
+			status_t			_WriteDelta(BPositionIO* output);
+			status_t			_WriteChunk(BDataIO* output,
+									uint64 chunkIndex);
+			bool				_Recompresses(const void* data, size_t size,
+									const void* compressedData,
+									size_t compressedSize);
+			status_t			_GetPieces(uint64 offset, size_t size);
+
+private:
+			BErrorOutput*		fErrorOutput;
+			DeltaPackage*		fOldPackage;
+			DeltaPackage*		fNewPackage;
+			DigestTable*		fOldChunks;
+			DigestTable*		fOldSegments;
+			Array<Segment>		fNewSegments;
+			int32				fNextSegment;
+			Array<Piece>		fPieces;
+			void*				fCompressedBuffer;
+			void*				fUncompressedBuffer;
+			void*				fRecompressedBuffer;
+			CompressionAlgorithmOwner* fCompressionAlgorithm;
+			int32				fCompressionLevel;
+			PackageDeltaStatistics fStatistics;
+};
+
+
+/*!	Rebuilds the new package from the old package and a delta created by
+	PackageDeltaWriter. The old package and the result are verified against
+	the checksums stored in the delta.
+*/
+class PackageDeltaApplier {
+public:
+								PackageDeltaApplier(BErrorOutput* errorOutput);
+								~PackageDeltaApplier();
+
+			status_t			Apply(const char* oldPackageFileName,
+									const char* deltaFileName,
+									const char* newPackageFileName);
+
+private:
+			class Input;
+
+private:
+			status_t			_Apply(const char* oldPackageFileName,
+									const char* deltaFileName,
+									BDataIO* output);
+			status_t			_ReadPieces(Input& input, size_t size);
+			status_t			_ReadOldHeapData(uint64 offset, void* buffer,
+									size_t size);
+
+private:
+			BErrorOutput*		fErrorOutput;
+			DeltaPackage*		fOldPackage;
+			void*				fCompressedBuffer;
+			void*				fUncompressedBuffer;
+			void*				fOldChunkBuffer;
+			uint64				fOldChunkIndex;
+};
+
+
+}	// namespace BPrivate
+
+}	// namespace BHPKG
+
+}	// namespace BPackageKit
+
+
+#endif	// _PACKAGE__HPKG__PRIVATE__PACKAGE_DELTA_H_
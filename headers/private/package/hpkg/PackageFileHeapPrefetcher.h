@@ -0,0 +1,80 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef _PACKAGE__HPKG__PRIVATE__PACKAGE_FILE_HEAP_PREFETCHER_H_
+#define _PACKAGE__HPKG__PRIVATE__PACKAGE_FILE_HEAP_PREFETCHER_H_
+
+
+#include <pthread.h>
+
+#include <package/hpkg/DataReader.h>
+
+
+namespace BPackageKit {
+
+namespace BHPKG {
+
+namespace BPrivate {
+
+
+class PackageFileHeapReader;
+
+
+/*!	Reads the heap of a PackageFileHeapReader, decompressing the chunks
+	following the one read last on a number of threads, as long as the heap is
+	read sequentially.
+	The heap reader must outlive the prefetcher. ReadDataToOutput() may be
+	called from several threads, but the calls are serialized.
+*/
+class PackageFileHeapPrefetcher : public BAbstractBufferedDataReader {
+public:
+								PackageFileHeapPrefetcher(
+									PackageFileHeapReader* heapReader);
+	virtual						~PackageFileHeapPrefetcher();
+
+			status_t			Init(int32 threadCount = 0);
+									// 0 means one thread per CPU
+
+	// BAbstractBufferedDataReader
+	virtual	status_t			ReadDataToOutput(off_t offset,
+									size_t size, BDataIO* output);
+
+private:
+			struct Slot;
+
+private:
+			status_t			_GetChunk(uint64 chunkIndex, Slot*& _slot);
+			void				_ScheduleChunks(uint64 endChunk);
+	inline	Slot&				_SlotFor(uint64 chunkIndex);
+
+	static	void*				_ThreadEntry(void* data);
+			void				_Work();
+
+private:
+			PackageFileHeapReader* fHeapReader;
+			pthread_mutex_t		fReadLock;
+			pthread_mutex_t		fLock;
+			pthread_cond_t		fChunkScheduledCondition;
+			pthread_cond_t		fChunkDoneCondition;
+			Slot*				fSlots;
+			int32				fSlotCount;
+			pthread_t*			fThreads;
+			int32				fThreadCount;
+			uint64				fChunkCount;
+			uint64				fFirstChunk;
+			uint64				fNextChunkToRead;
+			uint64				fScheduledEnd;
+			uint64				fLastChunk;
+			bool				fQuit;
+};
+
+
+}	// namespace BPrivate
+
+}	// namespace BHPKG
+
+}	// namespace BPackageKit
+
+
+#endif	// _PACKAGE__HPKG__PRIVATE__PACKAGE_FILE_HEAP_PREFETCHER_H_
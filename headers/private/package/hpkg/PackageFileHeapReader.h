@@ -40,6 +40,8 @@ public:
 									{ return fOffsets; }
 
 protected:
+			friend class PackageFileHeapPrefetcher;
+
 	virtual	status_t			ReadAndDecompressChunk(size_t chunkIndex,
 									void* compressedDataBuffer,
 									void* uncompressedDataBuffer);
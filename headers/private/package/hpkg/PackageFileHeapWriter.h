@@ -42,6 +42,9 @@ public:
 										decompressionAlgorithm);
 								~PackageFileHeapWriter();
 
+			void				SetCompressionThreadCount(int32 count);
+									// to be called before Init(); 0 means
+									// one thread per CPU
 			void				Init();
 			void				Reinit(PackageFileHeapReader* heapReader);
 
@@ -63,13 +66,20 @@ private:
 			struct Chunk;
 			struct ChunkSegment;
 			struct ChunkBuffer;
+			struct CompressionJob;
+			struct CompressionWorkers;
+			struct WorkersSuspender;
 
 			friend struct ChunkBuffer;
+			friend struct WorkersSuspender;
 
 private:
 			void				_Uninit();
 
 			status_t			_FlushPendingData();
+			status_t			_QueuePendingData();
+			status_t			_WriteQueuedChunks(bool wait);
+			status_t			_WriteCompressionJob(CompressionJob& job);
 			status_t			_WriteChunk(const void* data, size_t size,
 									bool mayCompress);
 			status_t			_WriteDataCompressed(const void* data,
@@ -87,6 +97,8 @@ private:
 			size_t				fPendingDataSize;
 			Array<uint64>		fOffsets;
 			CompressionAlgorithmOwner* fCompressionAlgorithm;
+			int32				fCompressionThreadCount;
+			CompressionWorkers*	fCompressionWorkers;
 };
 
 
@@ -58,6 +58,10 @@ protected:
 								// from ReaderImplBase
 	virtual	status_t			ReadAttributeValue(uint8 type, uint8 encoding,
 									AttributeValue& _value);
+	virtual	status_t			CreateCachedHeapReader(
+									PackageFileHeapReader* heapReader,
+									BAbstractBufferedDataReader*&
+										_cachedReader);
 
 private:
 			struct AttributeAttributeHandler;
@@ -77,6 +81,7 @@ private:
 private:
 			uint64				fHeapOffset;
 			uint64				fHeapSize;
+			uint32				fFlags;
 
 			PackageFileSection	fTOCSection;
 };
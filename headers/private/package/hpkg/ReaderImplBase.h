@@ -143,6 +143,10 @@ protected:
 			status_t			ParsePackageAttributesSection(
 									AttributeHandlerContext* context,
 									AttributeHandler* rootAttributeHandler);
+			status_t			ParsePackageAttributesSection(
+									PackageFileSection& section,
+									AttributeHandlerContext* context,
+									AttributeHandler* rootAttributeHandler);
 			status_t			ParseAttributeTree(
 									AttributeHandlerContext* context,
 									bool& _sectionHandled);
@@ -37,13 +37,33 @@ public:
 
 			status_t			ParseContent(
 									BRepositoryContentHandler* contentHandler);
+			status_t			ParsePackage(uint64 offset, uint64 size,
+									BRepositoryContentHandler* contentHandler);
+									// parses only the package at the given
+									// location, as returned by
+									// CurrentPackageOffset()/Size()
+
+			uint64				CurrentPackageOffset() const
+									{ return fPackageOffset; }
+			uint64				CurrentPackageSize() const
+									{ return fPackageEndOffset
+										- fPackageOffset; }
+									// valid in the content handler's
+									// HandlePackageDone()
 
 private:
 			class PackagesAttributeHandler;
+			class PackageAttributeHandler;
 			class PackageContentHandlerAdapter;
 
+private:
+			status_t			_PreparePackageAttributesSection();
+
 private:
 			BRepositoryInfo		fRepositoryInfo;
+			bool				fPackageAttributesPrepared;
+			uint64				fPackageOffset;
+			uint64				fPackageEndOffset;
 };
 
 
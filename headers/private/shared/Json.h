@@ -26,6 +26,8 @@ public:
 	static	status_t			Parse(const BString& JSON, BMessage& message);
 	static	void				Parse(BDataIO* data,
 									BJsonEventListener* listener);
+	static	void				Parse(const char* data, size_t length,
+									BJsonEventListener* listener);
 
 private:
 	static	bool				NextChar(JsonParseContext& jsonParseContext,
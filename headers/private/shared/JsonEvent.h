@@ -33,6 +33,9 @@ class BJsonEvent {
 public:
 								BJsonEvent(json_event_type eventType,
 									const char* content);
+								BJsonEvent(json_event_type eventType,
+									const char* content, size_t length);
+									// content needn't be null-terminated
 								BJsonEvent(const char* content);
 								BJsonEvent(double content);
 								BJsonEvent(int64 content);
@@ -42,6 +45,10 @@ public:
 			json_event_type		EventType() const;
 
 			const char*			Content() const;
+			size_t				ContentLength() const;
+			const char*			ContentData() const;
+									// like Content(), but not necessarily
+									// null-terminated
 			double				ContentDouble() const;
 			int64				ContentInteger() const;
 
@@ -49,7 +56,8 @@ private:
 
 			json_event_type		fEventType;
 			const char*			fContent;
-			char*				fOwnedContent;
+			ssize_t				fContentLength;
+	mutable	char*				fOwnedContent;
 };
 
 } // namespace BPrivate
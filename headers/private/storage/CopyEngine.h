@@ -14,6 +14,7 @@
 #include <EntryOperationEngineBase.h>
 
 
+class BDirectory;
 class BFile;
 class BNode;
 
@@ -29,6 +30,10 @@ public:
 				COPY_RECURSIVELY			= 0x01,
 				MERGE_EXISTING_DIRECTORIES	= 0x02,
 				UNLINK_DESTINATION			= 0x04,
+				COPY_CONCURRENTLY			= 0x08,
+					// copies the entries of a directory tree on several
+					// threads; the controller's hooks are called one at a
+					// time, but not in tree order
 			};
 
 public:
@@ -47,14 +52,36 @@ public:
 									const Entry& destEntry);
 
 private:
+			struct Copier;
+
+private:
+	static	status_t			_AllocateBuffer(char*& _buffer,
+									size_t& _size);
+
 			status_t			_CopyEntry(const char* sourcePath,
 									const char* destPath);
+			status_t			_CopyNode(const char* sourcePath,
+									const char* destPath, char* buffer,
+									size_t bufferSize, BDirectory& sourceDir,
+									bool& _done);
 			status_t			_CopyFileData(const char* sourcePath,
 									BFile& source, const char* destPath,
-									BFile& destination);
+									BFile& destination, char* buffer,
+									size_t bufferSize);
 			status_t			_CopyAttributes(const char* sourcePath,
 									BNode& source, const char* destPath,
-									BNode& destination);
+									BNode& destination, char* buffer,
+									size_t bufferSize);
+
+			bool				_EntryStarted(const char* path);
+			bool				_EntryFinished(const char* path,
+									status_t error);
+			bool				_AttributeStarted(const char* path,
+									const char* attribute,
+									uint32 attributeType);
+			bool				_AttributeFinished(const char* path,
+									const char* attribute,
+									uint32 attributeType, status_t error);
 
 			void				_NotifyError(status_t error, const char* format,
 									...);
@@ -71,6 +98,7 @@ private:
 			uint32				fFlags;
 			char*				fBuffer;
 			size_t				fBufferSize;
+			Copier*				fCopier;
 };
 
 
@@ -1,5 +1,5 @@
 /*
- * Copyright 2013, Haiku, Inc. All Rights Reserved.
+ * Copyright 2013-2026, Haiku, Inc. All Rights Reserved.
  * Distributed under the terms of the MIT License.
  *
  * Authors:
@@ -21,18 +21,41 @@ class BRemoveEngine : public BEntryOperationEngineBase {
 public:
 			class BController;
 
+			enum {
+				REMOVE_CONCURRENTLY			= 0x01,
+					// removes the entries of a directory tree on several
+					// threads; the controller's hooks are called one at a
+					// time, but not in tree order
+			};
+
 public:
-								BRemoveEngine();
+								BRemoveEngine(uint32 flags = 0);
 								~BRemoveEngine();
 
 			BController*		Controller() const;
 			void				SetController(BController* controller);
 
+			uint32				Flags() const;
+			BRemoveEngine&		SetFlags(uint32 flags);
+			BRemoveEngine&		AddFlags(uint32 flags);
+			BRemoveEngine&		RemoveFlags(uint32 flags);
+
 			status_t			RemoveEntry(const Entry& entry);
 
+private:
+			struct Remover;
+
 private:
 			status_t			_RemoveEntry(const char* path);
+			status_t			_RemoveNode(const char* path,
+									bool isDirectory);
+
+			bool				_EntryStarted(const char* path);
+			bool				_EntryFinished(const char* path,
+									status_t error);
 
+			void				_NotifyError(status_t error,
+									const char* format, ...);
 			void				_NotifyErrorVarArgs(status_t error,
 									const char* format, va_list args);
 			status_t			_HandleEntryError(const char* path,
@@ -40,6 +63,8 @@ private:
 
 private:
 			BController*		fController;
+			uint32				fFlags;
+			Remover*			fRemover;
 };
 
 
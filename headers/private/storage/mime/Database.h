@@ -26,6 +26,7 @@
 
 class BNode;
 class BBitmap;
+class BFile;
 class BMessage;
 class BString;
 
@@ -97,6 +98,9 @@ class Database {
 		status_t GuessMimeType(const entry_ref *file, BString *result);
 		status_t GuessMimeType(const void *buffer, int32 length, BString *result);
 		status_t GuessMimeType(const char *filename, BString *result);
+		status_t GuessMimeType(const entry_ref *ref, BFile *file,
+					const void *buffer, int32 length, BString *result);
+		ssize_t SniffBytesNeeded();
 
 		// Monitor
 		status_t StartWatching(BMessenger target);
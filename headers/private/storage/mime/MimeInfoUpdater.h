@@ -12,6 +12,10 @@
 #include <mime/MimeEntryProcessor.h>
 
 
+class BNode;
+class BString;
+
+
 namespace BPrivate {
 namespace Storage {
 namespace Mime {
@@ -25,6 +29,10 @@ public:
 	virtual						~MimeInfoUpdater();
 
 	virtual	status_t			Do(const entry_ref& entry, bool* _entryIsDir);
+
+private:
+			status_t			_GuessMimeType(const entry_ref& entry,
+									BNode& node, BString& type);
 };
 
 
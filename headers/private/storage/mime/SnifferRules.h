@@ -11,6 +11,8 @@
 #include <list>
 #include <string>
 
+#include <sniffer/RuleSet.h>
+
 class BFile;
 class BString;
 struct entry_ref;
@@ -19,9 +21,6 @@ struct entry_ref;
 namespace BPrivate {
 namespace Storage {
 
-namespace Sniffer {
-	class Rule;
-}
 
 namespace Mime {
 
@@ -37,6 +36,9 @@ public:
 	
 	status_t GuessMimeType(const entry_ref *ref, BString *type);
 	status_t GuessMimeType(const void *buffer, int32 length, BString *type);
+	status_t GuessMimeType(BFile* file, const void *buffer, int32 length,
+		BString *type);
+	ssize_t MaxBytesNeeded();
 	
 	status_t SetSnifferRule(const char *type, const char *rule);
 	status_t DeleteSnifferRule(const char *type);
@@ -47,18 +49,17 @@ public:
 		std::string type;							// The mime type that own the rule
 		std::string rule_string;					// The unparsed string version of the rule
 		BPrivate::Storage::Sniffer::Rule *rule;		// The parsed rule
+		int32 slot;									// The rule's slot in fRuleSet
 		
 		sniffer_rule(BPrivate::Storage::Sniffer::Rule *rule = NULL);
 		~sniffer_rule(); 
 	};		
 private:
 	status_t BuildRuleList();
-	status_t GuessMimeType(BFile* file, const void *buffer, int32 length,
-		BString *type);
-	ssize_t MaxBytesNeeded();
 	status_t ProcessType(const char *type, ssize_t *bytesNeeded);
 
 	std::list<sniffer_rule> fRuleList;
+	BPrivate::Storage::Sniffer::RuleSet fRuleSet;
 
 private:
 	DatabaseLocation*	fDatabaseLocation;
@@ -11,12 +11,16 @@
 
 #include <sys/types.h>
 
+#include <vector>
+
 class BPositionIO;
 
 namespace BPrivate {
 namespace Storage {
 namespace Sniffer {
 
+struct Anchor;
+
 //! Abstract class defining methods acting on a list of ORed patterns
 class DisjList {
 public:
@@ -25,6 +29,7 @@ public:
 
 	virtual bool Sniff(BPositionIO *data) const = 0;
 	virtual ssize_t BytesNeeded() const = 0;
+	virtual bool GetAnchors(std::vector<Anchor> &anchors) const = 0;
 	
 	void SetCaseInsensitive(bool how);
 	bool IsCaseInsensitive();
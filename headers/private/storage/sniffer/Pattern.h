@@ -21,6 +21,16 @@ namespace Sniffer {
 
 class Err;
 
+/*! \brief A single byte a pattern requires somewhere within a range of the
+	data; used by RuleSet to rule out rules without sniffing them.
+*/
+struct Anchor {
+	int32 start;			// first possible offset of the byte
+	int32 end;				// last possible offset of the byte
+	uint8 value;
+	bool caseInsensitive;
+};
+
 //! A byte string and optional mask to be compared against a data stream.
 /*! The byte string and mask (if supplied) must be of the same length. */
 class Pattern {
@@ -34,6 +44,7 @@ public:
 	
 	bool Sniff(Range range, BPositionIO *data, bool caseInsensitive) const;
 	ssize_t BytesNeeded() const;
+	bool GetAnchor(Range range, bool caseInsensitive, Anchor *anchor) const;
 	
 	status_t SetTo(const std::string &string, const std::string &mask);
 private:
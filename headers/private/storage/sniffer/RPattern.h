@@ -17,6 +17,7 @@ namespace BPrivate {
 namespace Storage {
 namespace Sniffer {
 
+struct Anchor;
 class Err;
 class Pattern;
 
@@ -31,6 +32,7 @@ public:
 	
 	bool Sniff(BPositionIO *data, bool caseInsensitive) const;
 	ssize_t BytesNeeded() const;
+	bool GetAnchor(bool caseInsensitive, Anchor *anchor) const;
 private:
 	Range fRange;
 	Pattern *fPattern;
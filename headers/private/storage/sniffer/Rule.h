@@ -20,6 +20,7 @@ namespace BPrivate {
 namespace Storage {
 namespace Sniffer {
 
+struct Anchor;
 class DisjList;
 
 /*! \brief A priority and a list of expressions to be used for sniffing out the
@@ -34,6 +35,7 @@ public:
 	double Priority() const;	
 	bool Sniff(BPositionIO *data) const;	
 	ssize_t BytesNeeded() const;
+	bool GetAnchors(std::vector<Anchor> &anchors) const;
 private:
 	friend class Parser;
 
@@ -0,0 +1,86 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef _SNIFFER_RULE_SET_H
+#define _SNIFFER_RULE_SET_H
+
+
+#include <SupportDefs.h>
+
+#include <vector>
+
+
+namespace BPrivate {
+namespace Storage {
+namespace Sniffer {
+
+
+struct Anchor;
+class Rule;
+
+
+class RuleSet {
+public:
+								RuleSet();
+								~RuleSet();
+
+			int32				AddRule(const Rule* rule);
+			void				RemoveRule(int32 slot);
+			void				MakeEmpty();
+
+			int32				CountSlots() const
+									{ return fSlotsUsed.size(); }
+
+			void				FindCandidates(const void* buffer,
+									size_t length,
+									std::vector<bool>& candidates) const;
+
+private:
+			struct fixed_anchor {
+				int32			offset;
+				uint8			value;
+				int32			slot;
+
+				bool operator<(const fixed_anchor& other) const
+				{
+					if (offset != other.offset)
+						return offset < other.offset;
+					return value < other.value;
+				}
+			};
+
+			struct ranged_anchor {
+				int32			start;
+				int32			end;
+				uint8			value;
+				uint8			otherValue;
+				int32			slot;
+			};
+
+			struct offset_group {
+				int32			offset;
+				uint32			first;
+				uint32			count;
+			};
+
+			void				_AddFixedAnchor(int32 offset, uint8 value,
+									int32 slot);
+			void				_RebuildOffsetIndex();
+
+private:
+			std::vector<bool>	fSlotsUsed;
+			std::vector<int32>	fUnanchoredSlots;
+			std::vector<fixed_anchor> fFixedAnchors;
+									// sorted by offset and value
+			std::vector<offset_group> fOffsetIndex;
+			std::vector<ranged_anchor> fRangedAnchors;
+};
+
+
+}	// namespace Sniffer
+}	// namespace Storage
+}	// namespace BPrivate
+
+
+#endif	// _SNIFFER_RULE_SET_H
@@ -35,6 +35,7 @@ public:
 									// caller owns job
 
 			size_t				CountJobs() const;
+			size_t				CountRunnableJobs() const;
 
 			void				Close();
 
@@ -35,9 +35,15 @@ public:
 			bool				IsGzipFormat() const;
 			void				SetGzipFormat(bool gzipFormat);
 
+			int32				WorkerCount() const;
+			void				SetWorkerCount(int32 count);
+									// 0 compresses on the calling thread;
+									// only used by CompressBuffer()
+
 private:
 			int32				fCompressionLevel;
 			size_t				fBufferSize;
+			int32				fWorkerCount;
 			bool				fGzipFormat;
 };
 
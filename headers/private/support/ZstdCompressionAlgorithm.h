@@ -32,9 +32,14 @@ public:
 			size_t				BufferSize() const;
 			void				SetBufferSize(size_t size);
 
+			int32				WorkerCount() const;
+			void				SetWorkerCount(int32 count);
+									// 0 compresses on the calling thread
+
 private:
 			int32				fCompressionLevel;
 			size_t				fBufferSize;
+			int32				fWorkerCount;
 };
 
 
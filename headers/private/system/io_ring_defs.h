@@ -0,0 +1,104 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef _SYSTEM_IO_RING_DEFS_H
+#define _SYSTEM_IO_RING_DEFS_H
+
+
+#include <OS.h>
+
+
+/*!	An I/O ring lets an application queue any number of I/O operations, and
+	submit all of them with a single _kern_io_ring_enter() call. The
+	operations are executed concurrently by kernel threads, and their results
+	are put into the completion queue, where they can be picked up without
+	entering the kernel.
+
+	Both queues live in an area that is shared between the kernel and the
+	application, and that starts with an io_ring_header. The application
+	writes submissions at sq_tail and advances it, the kernel advances
+	sq_head when it has taken over the submissions. The kernel writes
+	completions at cq_tail and advances it, the application advances cq_head
+	when it has processed them. All indices only ever increase, and are masked
+	with the respective mask to get the array index.
+
+	A ring can only be used by the team that created it; a child inherits
+	the descriptor on fork(), but _kern_io_ring_enter() fails there with
+	B_NOT_ALLOWED.
+*/
+
+
+#define IO_RING_MAX_ENTRIES		4096
+#define IO_RING_MAX_WORKERS		256
+
+
+enum {
+	IO_RING_OP_NOP = 0,
+	IO_RING_OP_READ,		// read_pos(fd, offset, address, length)
+	IO_RING_OP_WRITE,		// write_pos(fd, offset, address, length)
+	IO_RING_OP_FSYNC,		// fsync(fd)
+	IO_RING_OP_ACCEPT,		// accept(fd, address, extra)
+	IO_RING_OP_SEND,		// send(fd, address, length, op_flags)
+	IO_RING_OP_RECV,		// recv(fd, address, length, op_flags)
+};
+
+
+typedef struct io_ring_params {
+	uint32			submission_entries;
+		// in: rounded up to a power of two
+	uint32			completion_entries;
+		// out: twice the number of submission entries
+	uint32			max_workers;
+		// in: the number of operations that may run in parallel, 0 for
+		// the default; out: the actual value
+	uint32			flags;
+		// reserved, must be 0
+	area_id			area;
+		// out: the area shared with the kernel
+	void*			address;
+		// out: the address of the io_ring_header
+} io_ring_params;
+
+
+typedef struct io_ring_header {
+	uint32			sq_head;
+	uint32			sq_tail;
+	uint32			sq_mask;
+	uint32			sq_offset;
+		// offset of the io_ring_submission array from the header
+	uint32			cq_head;
+	uint32			cq_tail;
+	uint32			cq_mask;
+	uint32			cq_offset;
+		// offset of the io_ring_completion array from the header
+} io_ring_header;
+
+
+typedef struct io_ring_submission {
+	uint8			opcode;
+	uint8			_reserved0;
+	uint16			_reserved1;
+	int32			fd;
+	int64			offset;
+		// -1 to use the file position
+	uint64			address;
+	uint64			length;
+	uint64			extra;
+		// IO_RING_OP_ACCEPT: socklen_t* for the address length
+	uint32			op_flags;
+	uint32			_reserved2;
+	uint64			user_data;
+		// passed on to the completion unchanged
+} io_ring_submission;
+
+
+typedef struct io_ring_completion {
+	uint64			user_data;
+	int64			result;
+		// the return value of the operation, a negative error code if it
+		// failed
+} io_ring_completion;
+
+
+#endif	/* _SYSTEM_IO_RING_DEFS_H */
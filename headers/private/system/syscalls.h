@@ -27,6 +27,7 @@ struct fd_info;
 struct fd_set;
 struct fs_info;
 struct iovec;
+struct io_ring_params;
 struct msqid_ds;
 struct net_stat;
 struct pollfd;
@@ -377,6 +378,11 @@ extern status_t		_kern_socketpair(int family, int type, int protocol,
 extern status_t		_kern_get_next_socket_stat(int family, uint32 *cookie,
 						struct net_stat *stat);
 
+// I/O ring functions
+extern int			_kern_create_io_ring(struct io_ring_params *params);
+extern int32		_kern_io_ring_enter(int ring, uint32 submitCount,
+						uint32 waitCount, uint32 flags, bigtime_t timeout);
+
 // node monitor functions
 extern status_t		_kern_stop_notifying(port_id port, uint32 token);
 extern status_t		_kern_start_watching(dev_t device, ino_t node, uint32 flags,
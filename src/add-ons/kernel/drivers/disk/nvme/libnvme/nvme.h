@@ -363,6 +363,13 @@ struct nvme_ctrlr_opts {
 	 */
 	enum nvme_cc_ams	arb_mechanism;
 
+	/**
+	 * Number of interrupt vectors for the I/O completion queues:
+	 * the queue with ID n signals vector n modulo this number.
+	 * (default: 0, all queues use vector 0)
+	 */
+	unsigned int		io_interrupt_vectors;
+
 };
 
 /**
@@ -14,6 +14,7 @@
 #include <condition_variable.h>
 #include <AutoDeleter.h>
 #include <kernel.h>
+#include <smp.h>
 #include <util/AutoLock.h>
 
 #include <fs/devfs.h>
@@ -68,7 +69,8 @@ static const uint8 kDriveIcon[] = {
 #define NVME_DISK_DEVICE_MODULE_NAME 	"drivers/disk/nvme_disk/device_v1"
 #define NVME_DISK_DEVICE_ID_GENERATOR	"nvme_disk/device_id"
 
-#define NVME_MAX_QPAIRS					(8)
+#define NVME_MAX_QPAIRS					(32)
+	// one per CPU; MSI-X is limited to 32 vectors anyway
 
 
 static device_manager_info* sDeviceManager;
@@ -88,13 +90,18 @@ typedef struct {
 	struct qpair_info {
 		struct nvme_qpair*	qpair;
 		mutex				mtx;
+			// protects both submissions and completions
+		ConditionVariable	interrupt;
+		uint8				irq;
 	}						qpairs[NVME_MAX_QPAIRS];
 	uint32					qpair_count;
-	uint32					next_qpair;
 
 	rw_lock					rounded_write_lock;
 
-	ConditionVariable		interrupt;
+	uint8					irq;
+		// the admin queue's, and that of all I/O queues without their own
+	bool					uses_msi;
+		// MSI or MSI-X is configured, and needs to be disabled again
 } nvme_disk_driver_info;
 typedef nvme_disk_driver_info::qpair_info qpair_info;
 
@@ -162,6 +169,99 @@ nvme_disk_set_capacity(nvme_disk_driver_info* info, uint64 capacity,
 
 
 static int32 nvme_interrupt_handler(void* _info);
+static int32 nvme_qpair_interrupt_handler(void* _qpinfo);
+
+
+/*!	Sets up MSI-X with up to \a vectorCount vectors, and falls back to a
+	single MSI-X vector, MSI, and finally the pin based interrupt. Returns
+	the first vector, and sets \a vectorCount to the number of MSI-X vectors
+	in use, 0 if it's not MSI-X.
+*/
+static uint8
+nvme_disk_configure_interrupts(nvme_disk_driver_info* info,
+	uint8& vectorCount)
+{
+	uint8 bus = info->info.bus;
+	uint8 device = info->info.device;
+	uint8 function = info->info.function;
+
+	info->uses_msi = false;
+
+	if (sPCIx86Module == NULL) {
+		vectorCount = 0;
+		return info->info.u.h0.interrupt_line;
+	}
+
+	uint8 msixCount = sPCIx86Module->get_msix_count(bus, device, function);
+	vectorCount = std::min(msixCount, vectorCount);
+	while (vectorCount > 0) {
+		uint8 msixVector = 0;
+		if (sPCIx86Module->configure_msix(bus, device, function, vectorCount,
+				&msixVector) == B_OK) {
+			info->uses_msi = true;
+			if (sPCIx86Module->enable_msix(bus, device, function) == B_OK) {
+				TRACE_ALWAYS("using MSI-X with %d vectors\n", vectorCount);
+				return msixVector;
+			}
+
+			sPCIx86Module->unconfigure_msi(bus, device, function);
+			info->uses_msi = false;
+		}
+
+		// try again with a single vector, as before
+		vectorCount = vectorCount > 1 ? 1 : 0;
+	}
+
+	if (sPCIx86Module->get_msi_count(bus, device, function) >= 1) {
+		uint8 msiVector = 0;
+		if (sPCIx86Module->configure_msi(bus, device, function, 1,
+				&msiVector) == B_OK) {
+			info->uses_msi = true;
+			if (sPCIx86Module->enable_msi(bus, device, function) == B_OK) {
+				TRACE_ALWAYS("using message signaled interrupts\n");
+				return msiVector;
+			}
+
+			sPCIx86Module->unconfigure_msi(bus, device, function);
+			info->uses_msi = false;
+		}
+	}
+
+	return info->info.u.h0.interrupt_line;
+}
+
+
+static void
+nvme_disk_unconfigure_interrupts(nvme_disk_driver_info* info)
+{
+	if (!info->uses_msi)
+		return;
+
+	// these take care of MSI-X as well
+	sPCIx86Module->disable_msi(info->info.bus, info->info.device,
+		info->info.function);
+	sPCIx86Module->unconfigure_msi(info->info.bus, info->info.device,
+		info->info.function);
+	info->uses_msi = false;
+}
+
+
+/*!	Undoes what nvme_disk_init_device() did before it failed. The interrupt
+	handlers are only installed once nothing can fail anymore.
+*/
+static void
+nvme_disk_init_failed(nvme_disk_driver_info* info)
+{
+	if (info->ns != NULL)
+		nvme_ns_close(info->ns);
+	if (info->ctrlr != NULL)
+		nvme_ctrlr_close(info->ctrlr);
+	info->ns = NULL;
+	info->ctrlr = NULL;
+	info->qpair_count = 0;
+
+	nvme_disk_unconfigure_interrupts(info);
+}
 
 
 static status_t
@@ -170,6 +270,11 @@ nvme_disk_init_device(void* _info, void** _cookie)
 	CALLED();
 	nvme_disk_driver_info* info = (nvme_disk_driver_info*)_info;
 
+	info->ctrlr = NULL;
+	info->ns = NULL;
+	info->qpair_count = 0;
+	info->uses_msi = false;
+
 	pci_device_module_info* pci;
 	pci_device* pcidev;
 	device_node* parent = sDeviceManager->get_parent_node(info->node);
@@ -192,10 +297,43 @@ nvme_disk_init_device(void* _info, void** _cookie)
 
 	device->pci_info = &info->info;
 
+	// Set up the interrupts first, as the number of I/O queues depends on
+	// the number of vectors we get.
+	if (get_module(B_PCI_X86_MODULE_NAME, (module_info**)&sPCIx86Module)
+			!= B_OK) {
+		sPCIx86Module = NULL;
+	}
+
+	uint16 command = pci->read_pci_config(pcidev, PCI_command, 2);
+	command &= ~(PCI_command_int_disable);
+	pci->write_pci_config(pcidev, PCI_command, 2, command);
+
+	// We want one I/O queue per CPU, and, if possible, an MSI-X vector for
+	// each of them in addition to the one of the admin queue.
+	uint32 queueCount = std::min(smp_get_num_cpus(), (int32)NVME_MAX_QPAIRS);
+	uint8 vectorCount = std::min(queueCount + 1, (uint32)32);
+
+	uint8 irq = nvme_disk_configure_interrupts(info, vectorCount);
+	if (irq == 0 || irq == 0xFF) {
+		TRACE_ERROR("device PCI:%d:%d:%d was assigned an invalid IRQ\n",
+			info->info.bus, info->info.device, info->info.function);
+		nvme_disk_init_failed(info);
+		return B_ERROR;
+	}
+	info->irq = irq;
+	if (vectorCount > 1)
+		queueCount = std::min(queueCount, (uint32)vectorCount - 1);
+
 	// open the controller
-	info->ctrlr = nvme_ctrlr_open(device, NULL);
+	struct nvme_ctrlr_opts options;
+	memset(&options, 0, sizeof(options));
+	options.io_queues = queueCount;
+	options.io_interrupt_vectors = vectorCount;
+
+	info->ctrlr = nvme_ctrlr_open(device, &options);
 	if (info->ctrlr == NULL) {
 		TRACE_ERROR("failed to open the controller!\n");
+		nvme_disk_init_failed(info);
 		return B_ERROR;
 	}
 
@@ -203,6 +341,7 @@ nvme_disk_init_device(void* _info, void** _cookie)
 	int err = nvme_ctrlr_stat(info->ctrlr, &cstat);
 	if (err != 0) {
 		TRACE_ERROR("failed to get controller information!\n");
+		nvme_disk_init_failed(info);
 		return err;
 	}
 
@@ -214,6 +353,7 @@ nvme_disk_init_device(void* _info, void** _cookie)
 	info->ns = nvme_ns_open(info->ctrlr, cstat.ns_ids[0]);
 	if (info->ns == NULL) {
 		TRACE_ERROR("failed to open namespace!\n");
+		nvme_disk_init_failed(info);
 		return B_ERROR;
 	}
 
@@ -221,6 +361,7 @@ nvme_disk_init_device(void* _info, void** _cookie)
 	err = nvme_ns_stat(info->ns, &nsstat);
 	if (err != 0) {
 		TRACE_ERROR("failed to get namespace information!\n");
+		nvme_disk_init_failed(info);
 		return err;
 	}
 
@@ -231,66 +372,39 @@ nvme_disk_init_device(void* _info, void** _cookie)
 		info->capacity, info->block_size);
 
 	// allocate qpairs
-	info->qpair_count = info->next_qpair = 0;
-	for (uint32 i = 0; i < NVME_MAX_QPAIRS && i < cstat.io_qpairs; i++) {
-		info->qpairs[i].qpair = nvme_ioqp_get(info->ctrlr,
-			(enum nvme_qprio)0, 0);
-		if (info->qpairs[i].qpair == NULL)
+	info->qpair_count = 0;
+	for (uint32 i = 0; i < queueCount && i < cstat.io_qpairs; i++) {
+		qpair_info& qpinfo = info->qpairs[i];
+		qpinfo.qpair = nvme_ioqp_get(info->ctrlr, (enum nvme_qprio)0, 0);
+		if (qpinfo.qpair == NULL)
 			break;
 
-		mutex_init(&info->qpairs[i].mtx, "qpair mutex");
+		mutex_init(&qpinfo.mtx, "qpair mutex");
+		qpinfo.interrupt.Init(NULL, NULL);
+		qpinfo.irq = vectorCount > 1
+			? irq + qpinfo.qpair->id % vectorCount : irq;
 		info->qpair_count++;
 	}
 	if (info->qpair_count == 0) {
 		TRACE_ERROR("failed to allocate qpairs!\n");
+		nvme_disk_init_failed(info);
 		return B_NO_MEMORY;
 	}
 
 	// set up rounded-write lock
 	rw_lock_init(&info->rounded_write_lock, "nvme rounded writes");
 
-	// set up interrupt
-	if (get_module(B_PCI_X86_MODULE_NAME, (module_info**)&sPCIx86Module)
-			!= B_OK) {
-		sPCIx86Module = NULL;
-	}
-
-	uint16 command = pci->read_pci_config(pcidev, PCI_command, 2);
-	command &= ~(PCI_command_int_disable);
-	pci->write_pci_config(pcidev, PCI_command, 2, command);
-
-	uint8 irq = info->info.u.h0.interrupt_line;
-	if (sPCIx86Module != NULL) {
-		if (sPCIx86Module->get_msix_count(info->info.bus, info->info.device,
-				info->info.function)) {
-			uint8 msixVector = 0;
-			if (sPCIx86Module->configure_msix(info->info.bus, info->info.device,
-					info->info.function, 1, &msixVector) == B_OK
-				&& sPCIx86Module->enable_msix(info->info.bus, info->info.device,
-					info->info.function) == B_OK) {
-				TRACE_ALWAYS("using MSI-X\n");
-				irq = msixVector;
-			}
-		} else if (sPCIx86Module->get_msi_count(info->info.bus,
-				info->info.device, info->info.function) >= 1) {
-			uint8 msiVector = 0;
-			if (sPCIx86Module->configure_msi(info->info.bus, info->info.device,
-					info->info.function, 1, &msiVector) == B_OK
-				&& sPCIx86Module->enable_msi(info->info.bus, info->info.device,
-					info->info.function) == B_OK) {
-				TRACE_ALWAYS("using message signaled interrupts\n");
-				irq = msiVector;
-			}
+	// The admin queue is polled, so the interrupts are only needed from now
+	install_io_interrupt_handler(irq, nvme_interrupt_handler, (void*)info,
+		B_NO_HANDLED_INFO);
+	for (uint32 i = 0; i < info->qpair_count; i++) {
+		qpair_info& qpinfo = info->qpairs[i];
+		if (qpinfo.irq != irq) {
+			install_io_interrupt_handler(qpinfo.irq,
+				nvme_qpair_interrupt_handler, &qpinfo, B_NO_HANDLED_INFO);
 		}
 	}
-
-	if (irq == 0 || irq == 0xFF) {
-		TRACE_ERROR("device PCI:%d:%d:%d was assigned an invalid IRQ\n",
-			info->info.bus, info->info.device, info->info.function);
-		return B_ERROR;
-	}
-	info->interrupt.Init(NULL, NULL);
-	install_io_interrupt_handler(irq, nvme_interrupt_handler, (void*)info, B_NO_HANDLED_INFO);
+	TRACE_ALWAYS("\tusing %" B_PRIu32 " qpairs\n", info->qpair_count);
 
 	if (info->ctrlr->feature_supported[NVME_FEAT_INTERRUPT_COALESCING]) {
 		uint32 microseconds = 16, threshold = 32;
@@ -309,15 +423,22 @@ nvme_disk_uninit_device(void* _cookie)
 	CALLED();
 	nvme_disk_driver_info* info = (nvme_disk_driver_info*)_cookie;
 
-	remove_io_interrupt_handler(info->info.u.h0.interrupt_line,
-		nvme_interrupt_handler, (void*)info);
+	for (uint32 i = 0; i < info->qpair_count; i++) {
+		qpair_info& qpinfo = info->qpairs[i];
+		if (qpinfo.irq != info->irq) {
+			remove_io_interrupt_handler(qpinfo.irq,
+				nvme_qpair_interrupt_handler, &qpinfo);
+		}
+	}
+	remove_io_interrupt_handler(info->irq, nvme_interrupt_handler,
+		(void*)info);
 
 	rw_lock_destroy(&info->rounded_write_lock);
 
 	nvme_ns_close(info->ns);
 	nvme_ctrlr_close(info->ctrlr);
 
-	// TODO: Deallocate MSI(-X).
+	nvme_disk_unconfigure_interrupts(info);
 }
 
 
@@ -367,16 +488,48 @@ static int32
 nvme_interrupt_handler(void* _info)
 {
 	nvme_disk_driver_info* info = (nvme_disk_driver_info*)_info;
-	info->interrupt.NotifyAll();
+
+	// We don't know which of the queues sharing this vector is done.
+	for (uint32 i = 0; i < info->qpair_count; i++) {
+		if (info->qpairs[i].irq == info->irq)
+			info->qpairs[i].interrupt.NotifyAll();
+	}
+	return 0;
+}
+
+
+static int32
+nvme_qpair_interrupt_handler(void* _qpinfo)
+{
+	qpair_info* qpinfo = (qpair_info*)_qpinfo;
+	qpinfo->interrupt.NotifyAll();
 	return 0;
 }
 
 
 static qpair_info*
-get_next_qpair(nvme_disk_driver_info* info)
+get_qpair(nvme_disk_driver_info* info)
+{
+	// Use the queue of the current CPU; should the thread be migrated in the
+	// meantime, the queue's lock still keeps it safe.
+	return &info->qpairs[smp_get_current_cpu() % info->qpair_count];
+}
+
+
+/*!	Polls the queue under its own lock only, unlike nvme_ioqp_poll(), which
+	takes the controller lock. That lock protects the queues against a
+	controller reset, which disables and recreates them. libnvme only resets
+	the controller when asked to attach, detach, delete or format a
+	namespace, or to update the firmware; this driver does none of that.
+	The controller is only closed in nvme_disk_uninit_device(), when no
+	I/O is in flight anymore. Should the driver ever make one of the above
+	calls, it has to hold the locks of all queues while doing so.
+*/
+static void
+poll_qpair(qpair_info* qpinfo)
 {
-	return &info->qpairs[atomic_add((int32*)&info->next_qpair, 1)
-		% info->qpair_count];
+	MutexLocker _(qpinfo->mtx);
+	nvme_qpair_poll(qpinfo->qpair, 0);
 }
 
 
@@ -388,19 +541,19 @@ disk_io_callback(status_t* status, const struct nvme_cpl* cpl)
 
 
 static void
-await_status(nvme_disk_driver_info* info, struct nvme_qpair* qpair, status_t& status)
+await_status(qpair_info* qpinfo, status_t& status)
 {
 	ConditionVariableEntry entry;
 	while (status == EINPROGRESS) {
-		info->interrupt.Add(&entry);
+		qpinfo->interrupt.Add(&entry);
 
-		nvme_ioqp_poll(qpair, 0);
+		poll_qpair(qpinfo);
 
 		if (status != EINPROGRESS)
 			return;
 
 		entry.Wait();
-		nvme_ioqp_poll(qpair, 0);
+		poll_qpair(qpinfo);
 	}
 }
 
@@ -414,7 +567,7 @@ do_nvme_io(nvme_disk_driver_info* info, off_t rounded_pos, void* buffer,
 
 	status_t status = EINPROGRESS;
 
-	qpair_info* qpinfo = get_next_qpair(info);
+	qpair_info* qpinfo = get_qpair(info);
 	mutex_lock(&qpinfo->mtx);
 	int ret = -1;
 	if (write) {
@@ -433,7 +586,7 @@ do_nvme_io(nvme_disk_driver_info* info, off_t rounded_pos, void* buffer,
 		return ret;
 	}
 
-	await_status(info, qpinfo->qpair, status);
+	await_status(qpinfo, status);
 
 	if (status != B_OK) {
 		TRACE_ERROR("%s at %" B_PRIdOFF " of %" B_PRIuSIZE " bytes failed!\n",
@@ -572,7 +725,7 @@ nvme_disk_flush(nvme_disk_driver_info* info)
 {
 	status_t status = EINPROGRESS;
 
-	qpair_info* qpinfo = get_next_qpair(info);
+	qpair_info* qpinfo = get_qpair(info);
 	mutex_lock(&qpinfo->mtx);
 	int ret = nvme_ns_flush(info->ns, qpinfo->qpair,
 		(nvme_cmd_cb)disk_io_callback, &status);
@@ -580,7 +733,7 @@ nvme_disk_flush(nvme_disk_driver_info* info)
 	if (ret != 0)
 		return ret;
 
-	await_status(info, qpinfo->qpair, status);
+	await_status(qpinfo, status);
 	return status;
 }
 
@@ -28,7 +28,7 @@
 
 #include "dma_resources.h"
 #include "IORequest.h"
-#include "IOSchedulerSimple.h"
+#include "IOSchedulerRoster.h"
 
 
 //#define TRACE_SCSI_DISK
@@ -470,7 +470,7 @@ das_set_capacity(das_driver_info* info, uint64 capacity, uint32 blockSize)
 		if (status != B_OK)
 			panic("initializing DMAResource failed: %s", strerror(status));
 
-		info->io_scheduler = new(std::nothrow) IOSchedulerSimple(
+		info->io_scheduler = IOSchedulerRoster::Default()->CreateScheduler(
 			info->dma_resource);
 		if (info->io_scheduler == NULL)
 			panic("allocating IOScheduler failed.");
@@ -1,13 +1,22 @@
 /*
  * Copyright 2005, Axel Dörfler, axeld@pinc-software.de. All rights reserved.
+ * Copyright 2026, Haiku, Inc. All rights reserved.
  * Distributed under the terms of the MIT License.
  */
 
-/** This module memorizes all opened files for a certain session. A session
- *	can be the start of an application or the boot process.
- *	When a session is started, it will prefetch all files from an earlier
+/** This module memorizes which parts of which files are read during a
+ *	certain session. A session can be the start of an application or the
+ *	boot process.
+ *	When a session is started, it will prefetch the data of an earlier
  *	session in order to speed up the launching or booting process.
  *
+ *	Files on the boot volume are traced by their node IDs, which remain valid
+ *	over a reboot. Files on packagefs volumes are traced by their paths
+ *	instead, since packagefs assigns new node IDs on each mount. Tracing the
+ *	package files themselves wouldn't work, since packagefs opens them with
+ *	the file cache disabled, and caches the extracted data of each of its
+ *	files in that file's own file cache instead.
+ *
  *	Note: this module is using private kernel API and is definitely not
  *		meant to be an example on how to write modules.
  */
@@ -16,70 +25,128 @@
 #include "launch_speedup.h"
 
 #include <KernelExport.h>
-#include <Node.h>
+#include <driver_settings.h>
 
-#include <util/kernel_cpp.h>
 #include <util/AutoLock.h>
-#include <thread.h>
-#include <team.h>
+#include <util/OpenHashTable.h>
 #include <file_cache.h>
+#include <fs/fd.h>
+#include <fs_info.h>
 #include <generic_syscall.h>
+#include <kernel.h>
 #include <syscalls.h>
+#include <team.h>
+#include <vfs.h>
+#include <vm/VMCache.h>
 
-#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <new>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <stdio.h>
-#include <errno.h>
-#include <ctype.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
-extern dev_t gBootDevice;
 
+extern dev_t gBootDevice;
 
-// ToDo: combine the last 3-5 sessions to their intersection
-// ToDo: maybe ignore sessions if the node count is < 3 (without system libs)
 
-#define TRACE_CACHE_MODULE
+//#define TRACE_CACHE_MODULE
 #ifdef TRACE_CACHE_MODULE
 #	define TRACE(x) dprintf x
 #else
 #	define TRACE(x) ;
 #endif
 
-#define VNODE_HASH(mountid, vnodeid) (((uint32)((vnodeid) >> 32) \
-	+ (uint32)(vnodeid)) ^ (uint32)(mountid))
 
-struct data_part {
-	off_t		offset;
+// ToDo: combine the last 3-5 sessions to their intersection
+
+static const char* const kTraceDirectory = "/boot/system/cache/launch_speedup";
+static const char* const kBootSessionName = "system boot";
+
+static const uint32 kTraceMagic = 'LSpd';
+static const uint32 kTraceVersion = 2;
+
+static const bigtime_t kBootSessionTimeout = 120000000LL;
+static const bigtime_t kLaunchSessionTimeout = 10000000LL;
+static const bigtime_t kWorkerInterval = 1000000LL;
+
+static const int32 kMaxNodeCount = 4096;
+static const uint32 kMaxRangesPerNode = 64;
+static const page_num_t kMaxRangeGap = 16;
+	// pages between two ranges up to which they are merged into one
+static const off_t kMaxTraceFileSize = 2 * 1024 * 1024;
+static const int32 kMaxVolumes = 16;
+
+struct trace_header {
+	uint32		magic;
+	uint32		version;
+	uint32		name_length;
+	uint32		node_count;
+	uint32		range_count;
+	uint32		flags;
+	bigtime_t	duration;
+	uint32		paths_size;
+	uint32		reserved;
+};
+
+#define TRACE_PREFETCHED	0x01
+	// the session was prefetched when it was recorded
+
+struct trace_node {
+	ino_t		id;
+		// the node ID on the boot volume, -1 for a node with a path
 	off_t		size;
+	uint32		first_range;
+	uint32		range_count;
+	uint32		path_offset;
+	uint32		path_length;
+		// the path of a node on a packagefs volume, 0 for boot volume nodes
+};
+
+struct trace_range {
+	uint32		first_page;
+	uint32		page_count;
+};
+
+// a trace file consists of a trace_header, the session name, the trace_node
+// array in the order the nodes were first accessed, the trace_range array,
+// and the null terminated paths; the ranges of each node are sorted and do
+// not overlap
+
+
+struct node_key {
+	dev_t			device;
+	ino_t			id;
 };
 
 struct node {
-	struct node	*next;
-	node_ref	ref;
-	int32		ref_count;
-	bigtime_t	timestamp;
-	data_part	parts[5];
-	size_t		part_count;
+	struct node*	next;
+	dev_t			device;
+	ino_t			parent;
+	ino_t			id;
+	bigtime_t		timestamp;
 };
 
 struct NodeHash {
-	typedef node_ref	KeyType;
+	typedef node_key	KeyType;
 	typedef	node		ValueType;
 
 	size_t HashKey(KeyType key) const
 	{
-		return VNODE_HASH(key.device, key.node);
+		return (uint32)(key.id >> 32) ^ (uint32)key.id ^ (uint32)key.device;
 	}
 
 	size_t Hash(ValueType* value) const
 	{
-		return HashKey(value->ref);
+		node_key key = { value->device, value->id };
+		return HashKey(key);
 	}
 
 	bool Compare(KeyType key, ValueType* node) const
 	{
-		return (node->ref.device == key.device && node->ref.node == key.node);
+		return node->id == key.id && node->device == key.device;
 	}
 
 	ValueType*& GetLink(ValueType* value) const
@@ -90,99 +157,64 @@ struct NodeHash {
 
 typedef BOpenHashTable<NodeHash> NodeTable;
 
+
 class Session {
 	public:
-		Session(team_id team, const char *name, dev_t device,
-			ino_t node, int32 seconds);
-		Session(const char *name);
+		Session(team_id team, const char *name, bigtime_t timeout);
 		~Session();
 
 		status_t InitCheck();
 		team_id Team() const { return fTeam; }
 		const char *Name() const { return fName; }
-		const node_ref &NodeRef() const { return fNodeRef; }
 		bool IsActive() const { return fActiveUntil >= system_time(); }
-		bool IsClosing() const { return fClosing; }
-		bool IsMainSession() const;
+		bool IsMainSession() const { return fTeam < 0; }
 		bool IsWorthSaving() const;
 
-		void AddNode(dev_t device, ino_t node);
-		void RemoveNode(dev_t device, ino_t node);
-
-		void Lock() { mutex_lock(&fLock); }
-		void Unlock() { mutex_unlock(&fLock); }
+		void SetPrefetched(bool prefetched) { fPrefetched = prefetched; }
+		void SetStopped() { fStopTime = system_time(); }
+		bigtime_t Duration() const;
 
-		status_t StartWatchingTeam();
-		void StopWatchingTeam();
-
-		status_t LoadFromDirectory(int fd);
+		void AddNode(dev_t device, ino_t parent, ino_t id);
 		status_t Save();
-		void Prefetch();
 
 		Session *&Next() { return fNext; }
+		Session *&QueueNext() { return fQueueNext; }
 
 	private:
-		struct node *_FindNode(dev_t device, ino_t node);
+		status_t _CollectRanges(struct node *node, trace_node &traceNode,
+			trace_range *&ranges, uint32 &rangeCount,
+			uint32 &rangeCapacity);
 
 		Session		*fNext;
-		char		fName[B_OS_NAME_LENGTH];
-		mutex		fLock;
+		Session		*fQueueNext;
+		char		fName[B_PATH_NAME_LENGTH];
 		NodeTable	*fNodeHash;
-		struct node	*fNodes;
 		int32		fNodeCount;
 		team_id		fTeam;
-		node_ref	fNodeRef;
+		bigtime_t	fStartTime;
+		bigtime_t	fLastAccess;
+		bigtime_t	fStopTime;
 		bigtime_t	fActiveUntil;
-		bigtime_t	fTimestamp;
-		bool		fClosing;
-		bool		fIsWatchingTeam;
+		bool		fPrefetched;
 };
 
-class SessionGetter {
-	public:
-		SessionGetter(team_id team, Session **_session);
-		~SessionGetter();
-
-		status_t New(const char *name, dev_t device, ino_t node,
-					Session **_session);
-		void Stop();
-
-	private:
-		Session	*fSession;
-};
-
-static Session *sMainSession;
-static SessionTable *sTeamHash;
-static PrefetchTable *sPrefetchHash;
-static Session *sMainPrefetchSessions;
-	// singly-linked list
-static recursive_lock sLock;
-
-
-node_ref::node_ref()
-{
-	// part of libbe.so
-}
-
-
-struct PrefetchHash {
-	typedef node_ref	KeyType;
+struct SessionHash {
+	typedef team_id		KeyType;
 	typedef	Session		ValueType;
 
 	size_t HashKey(KeyType key) const
 	{
-		return VNODE_HASH(key.device, key.node);
+		return key;
 	}
 
 	size_t Hash(ValueType* value) const
 	{
-		return HashKey(value->NodeRef());
+		return HashKey(value->Team());
 	}
 
 	bool Compare(KeyType key, ValueType* session) const
 	{
-		return (session->NodeRef().device == key.device
-			&& session->NodeRef().node == key.node);
+		return session->Team() == key;
 	}
 
 	ValueType*& GetLink(ValueType* value) const
@@ -191,37 +223,137 @@ struct PrefetchHash {
 	}
 };
 
-typedef BOpenHashTable<PrefetchHash> PrefetchTable;
+typedef BOpenHashTable<SessionHash> SessionTable;
 
+struct prefetch_request {
+	prefetch_request	*next;
+	char				name[1];
+};
 
-struct SessionHash {
-	typedef team_id		KeyType;
-	typedef	Session		ValueType;
+struct volume_type {
+	dev_t	device;
+	bool	is_package_volume;
+};
 
-	size_t HashKey(KeyType key) const
-	{
-		return key;
-	}
+static Session *sMainSession;
+static SessionTable *sTeamHash;
+static Session *sSaveQueue;
+static prefetch_request *sPrefetchQueue;
+static mutex sLock = MUTEX_INITIALIZER("launch speedup");
+static sem_id sWorkerSemaphore = -1;
+static thread_id sWorkerThread = -1;
+static bool sPrefetchEnabled = true;
+static volume_type sVolumes[kMaxVolumes];
+static int32 sVolumeCount;
+static mutex sVolumeLock = MUTEX_INITIALIZER("launch speedup volumes");
+
+
+/*!	Returns the name of the file the trace of the session \a name is stored
+	in. The name itself is stored in the trace, so that collisions can be
+	detected.
+*/
+static void
+get_trace_path(const char *name, char *path, size_t size)
+{
+	// FNV-1a
+	uint32 hash = 2166136261U;
+	for (; name[0] != '\0'; name++)
+		hash = (hash ^ (uint8)name[0]) * 16777619U;
 
-	size_t Hash(ValueType* value) const
-	{
-		return HashKey(value->Team());
-	}
+	snprintf(path, size, "%s/%08" B_PRIx32, kTraceDirectory, hash);
+}
 
-	bool Compare(KeyType key, ValueType* session) const
-	{
-		return session->Team == key;
-	}
 
-	ValueType*& GetLink(ValueType* value) const
-	{
-		return value->Next();
+/*!	Returns whether the volume is a packagefs volume. The result is
+	remembered, since this is asked for every file that is opened on a volume
+	other than the boot volume. The file system is asked without holding
+	any of our locks, since threads holding its locks may open files, and
+	then wait for ours.
+*/
+static bool
+is_package_volume(dev_t device)
+{
+	MutexLocker locker(sVolumeLock);
+	for (int32 i = 0; i < sVolumeCount; i++) {
+		if (sVolumes[i].device == device)
+			return sVolumes[i].is_package_volume;
+	}
+	locker.Unlock();
+
+	fs_info info;
+	bool isPackageVolume = _kern_read_fs_info(device, &info) == B_OK
+		&& strcmp(info.fsh_name, "packagefs") == 0;
+
+	// mount IDs are not reused, so the result stays valid
+	locker.Lock();
+	if (sVolumeCount < kMaxVolumes) {
+		sVolumes[sVolumeCount].device = device;
+		sVolumes[sVolumeCount].is_package_volume = isPackageVolume;
+		sVolumeCount++;
 	}
-};
 
-typedef BOpenHashTable<SessionHash> SessionTable;
+	return isPackageVolume;
+}
+
+
+/*!	Gets the path of a node on a packagefs volume, and makes sure that the
+	path actually leads to that node. The parent directory the node was
+	opened in is not necessarily the one it lives in, if the path contained
+	links.
+*/
+static status_t
+get_node_path(const struct node *node, char *path, size_t size)
+{
+	if (node->parent < 0)
+		return B_ENTRY_NOT_FOUND;
+
+	struct vnode *vnode;
+	status_t status = vfs_get_vnode(node->device, node->id, true, &vnode);
+	if (status != B_OK)
+		return status;
+
+	char name[B_FILE_NAME_LENGTH];
+	status = vfs_get_vnode_name(vnode, name, sizeof(name));
+	vfs_put_vnode(vnode);
+	if (status != B_OK)
+		return status;
+
+	status = vfs_entry_ref_to_path(node->device, node->parent, name, true,
+		path, size);
+	if (status != B_OK)
+		return status;
+
+	status = vfs_get_vnode_from_path(path, true, &vnode);
+	if (status != B_OK)
+		return status;
+
+	struct stat stat;
+	status = vfs_stat_vnode(vnode, &stat);
+	vfs_put_vnode(vnode);
+	if (status == B_OK
+		&& (stat.st_dev != node->device || stat.st_ino != node->id))
+		status = B_ENTRY_NOT_FOUND;
+
+	return status;
+}
 
 
+static int
+compare_nodes(const void *_a, const void *_b)
+{
+	const struct node *a = *(const struct node **)_a;
+	const struct node *b = *(const struct node **)_b;
+
+	if (a->timestamp == b->timestamp)
+		return 0;
+	return a->timestamp < b->timestamp ? -1 : 1;
+}
+
+
+/*!	Hands the session over to the worker thread, which will save it if it is
+	worth it, and then delete it.
+	You must hold sLock when calling this function.
+*/
 static void
 stop_session(Session *session)
 {
@@ -230,219 +362,311 @@ stop_session(Session *session)
 
 	TRACE(("stop_session(%s)\n", session->Name()));
 
-	if (session->IsWorthSaving())
-		session->Save();
+	if (session->Team() >= 0)
+		sTeamHash->Remove(session);
+	if (session == sMainSession)
+		sMainSession = NULL;
 
-	{
-		RecursiveLocker locker(&sLock);
+	session->SetStopped();
+	session->QueueNext() = sSaveQueue;
+	sSaveQueue = session;
+	release_sem_etc(sWorkerSemaphore, 1, B_DO_NOT_RESCHEDULE);
+}
 
-		if (session->Team() >= B_OK)
-			sTeamHash->Remove(session);
 
-		if (session == sMainSession)
-			sMainSession = NULL;
-	}
+/*!	Asks the worker thread to prefetch the data of an earlier session with
+	the given name.
+	You must hold sLock when calling this function.
+*/
+static bool
+queue_prefetch(const char *name)
+{
+	if (!sPrefetchEnabled)
+		return false;
+
+	size_t length = strlen(name);
+	prefetch_request *request = (prefetch_request *)malloc(
+		sizeof(prefetch_request) + length);
+	if (request == NULL)
+		return false;
 
-	delete session;
+	memcpy(request->name, name, length + 1);
+
+	// requests are handled in LIFO order, as the most recent launch is
+	// likely the one the user waits for
+	request->next = sPrefetchQueue;
+	sPrefetchQueue = request;
+	release_sem_etc(sWorkerSemaphore, 1, B_DO_NOT_RESCHEDULE);
+	return true;
 }
 
 
+/*!	Starts a new session, and prefetches the data of an earlier session with
+	the same name.
+	You must hold sLock when calling this function.
+*/
 static Session *
-start_session(team_id team, dev_t device, ino_t node, const char *name,
-	int32 seconds = 30)
+start_session(team_id team, const char *name, bigtime_t timeout)
 {
-	RecursiveLocker locker(&sLock);
-
-	Session *session = new Session(team, name, device, node, seconds);
+	Session *session = new(std::nothrow) Session(team, name, timeout);
 	if (session == NULL)
 		return NULL;
 
-	if (session->InitCheck() != B_OK || session->StartWatchingTeam() != B_OK) {
+	if (session->InitCheck() != B_OK) {
 		delete session;
 		return NULL;
 	}
 
-	// let's see if there is a prefetch session for this session
+	session->SetPrefetched(queue_prefetch(session->Name()));
 
-	Session *prefetchSession;
-	if (session->IsMainSession()) {
-		// search for session by name
-		for (prefetchSession = sMainPrefetchSessions;
-				prefetchSession != NULL;
-				prefetchSession = prefetchSession->Next()) {
-			if (!strcmp(prefetchSession->Name(), name)) {
-				// found session!
-				break;
-			}
-		}
-	} else {
-		// ToDo: search for session by device/node ID
-		prefetchSession = NULL;
-	}
-	if (prefetchSession != NULL) {
-		TRACE(("found prefetch session %s\n", prefetchSession->Name()));
-		prefetchSession->Prefetch();
-	}
-
-	if (team >= B_OK)
+	if (team >= 0)
 		sTeamHash->Insert(session);
 
-	session->Lock();
 	return session;
 }
 
 
+/*!	Stops all sessions that are no longer active. This is done by the worker
+	thread, so that sessions of teams that no longer open any files are
+	saved, too.
+*/
 static void
-team_gone(team_id team, void *_session)
+stop_inactive_sessions()
 {
-	Session *session = (Session *)_session;
+	MutexLocker locker(sLock);
+
+	if (sMainSession != NULL && !sMainSession->IsActive())
+		stop_session(sMainSession);
+
+	// removing a session might resize the table, so we need to start over
+	// each time
+	while (true) {
+		Session *expired = NULL;
+		SessionTable::Iterator iterator = sTeamHash->GetIterator();
+		while (iterator.HasNext()) {
+			Session *session = iterator.Next();
+			if (!session->IsActive()) {
+				expired = session;
+				break;
+			}
+		}
 
-	session->Lock();
-	stop_session(session);
+		if (expired == NULL)
+			break;
+		stop_session(expired);
+	}
 }
 
 
-static bool
-parse_node_ref(const char *string, node_ref &ref, const char **_end = NULL)
+static status_t
+read_trace(const char *name, trace_header &header, uint8 *&buffer)
 {
-	// parse node ref
-	char *end;
-	ref.device = strtol(string, &end, 0);
-	if (end == NULL || ref.device == 0)
-		return false;
+	char path[B_PATH_NAME_LENGTH];
+	get_trace_path(name, path, sizeof(path));
 
-	ref.node = strtoull(end + 1, &end, 0);
+	int fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return errno;
 
-	if (_end)
-		*_end = end;
-	return true;
-}
+	struct stat stat;
+	if (fstat(fd, &stat) != 0) {
+		close(fd);
+		return errno;
+	}
 
+	if (stat.st_size < (off_t)sizeof(trace_header)
+		|| stat.st_size > kMaxTraceFileSize) {
+		close(fd);
+		return B_BAD_DATA;
+	}
 
-static struct node *
-new_node(dev_t device, ino_t id)
-{
-	struct node *node = new ::node;
-	if (node == NULL)
-		return NULL;
+	buffer = (uint8 *)malloc(stat.st_size);
+	if (buffer == NULL) {
+		close(fd);
+		return B_NO_MEMORY;
+	}
 
-	node->ref.device = device;
-	node->ref.node = id;
-	node->timestamp = system_time();
+	ssize_t bytesRead = read(fd, buffer, stat.st_size);
+	close(fd);
 
-	return node;
+	if (bytesRead != stat.st_size) {
+		free(buffer);
+		return B_IO_ERROR;
+	}
+
+	memcpy(&header, buffer, sizeof(trace_header));
+
+	size_t nameLength = strlen(name);
+	uint64 size = sizeof(trace_header) + (uint64)header.name_length
+		+ (uint64)header.node_count * sizeof(trace_node)
+		+ (uint64)header.range_count * sizeof(trace_range)
+		+ header.paths_size;
+	if (header.magic != kTraceMagic || header.version != kTraceVersion
+		|| size != (uint64)stat.st_size || header.name_length != nameLength
+		|| memcmp(buffer + sizeof(trace_header), name, nameLength) != 0) {
+		free(buffer);
+		return B_BAD_DATA;
+	}
+
+	return B_OK;
 }
 
 
+/*!	Reads the trace of the session \a name, and issues asynchronous reads
+	for everything it contains, in the order the files were accessed.
+*/
 static void
-load_prefetch_data()
+prefetch_session(const char *name)
 {
-	DIR *dir = opendir("/etc/launch_cache");
-	if (dir == NULL)
+	trace_header header;
+	uint8 *buffer;
+	if (read_trace(name, header, buffer) != B_OK)
 		return;
 
-	struct dirent *dirent;
-	while ((dirent = readdir(dir)) != NULL) {
-		if (dirent->d_name[0] == '.')
+	const trace_node *nodes = (const trace_node *)(buffer
+		+ sizeof(trace_header) + header.name_length);
+	const trace_range *ranges = (const trace_range *)(nodes
+		+ header.node_count);
+	const char *paths = (const char *)(ranges + header.range_count);
+
+	bigtime_t startTime = system_time();
+	uint32 nodeCount = 0;
+	off_t bytes = 0;
+
+	for (uint32 i = 0; i < header.node_count; i++) {
+		const trace_node &traceNode = nodes[i];
+		if (traceNode.first_range > header.range_count
+			|| traceNode.range_count
+				> header.range_count - traceNode.first_range) {
+			break;
+		}
+
+		struct vnode *vnode;
+		status_t status;
+		if (traceNode.path_length == 0)
+			status = vfs_get_vnode(gBootDevice, traceNode.id, true, &vnode);
+		else {
+			if (traceNode.path_offset >= header.paths_size
+				|| traceNode.path_length
+					>= header.paths_size - traceNode.path_offset
+				|| paths[traceNode.path_offset + traceNode.path_length]
+					!= '\0') {
+				break;
+			}
+			status = vfs_get_vnode_from_path(paths + traceNode.path_offset,
+				true, &vnode);
+		}
+		if (status != B_OK)
 			continue;
 
-		Session *session = new Session(dirent->d_name);
+		// ignore files that have changed since the trace has been written
+		struct stat stat;
+		if (vfs_stat_vnode(vnode, &stat) == B_OK && S_ISREG(stat.st_mode)
+			&& stat.st_size == traceNode.size) {
+			for (uint32 j = 0; j < traceNode.range_count; j++) {
+				const trace_range &range = ranges[traceNode.first_range + j];
+				cache_prefetch_vnode(vnode,
+					(off_t)range.first_page * B_PAGE_SIZE,
+					(size_t)range.page_count * B_PAGE_SIZE);
+				bytes += (off_t)range.page_count * B_PAGE_SIZE;
+			}
+			nodeCount++;
+		}
 
-		if (session->LoadFromDirectory(dirfd(dir)) != B_OK) {
-			delete session;
-			continue;
+		vfs_put_vnode(vnode);
+	}
+
+	dprintf("launch_speedup: prefetched %" B_PRIu32 " files, %" B_PRIdOFF
+		" KB for \"%s\" in %" B_PRId64 " ms\n", nodeCount, bytes / 1024, name,
+		(system_time() - startTime) / 1000);
+
+	free(buffer);
+}
+
+
+static status_t
+worker_thread(void *)
+{
+	while (true) {
+		status_t status = acquire_sem_etc(sWorkerSemaphore, 1,
+			B_RELATIVE_TIMEOUT, kWorkerInterval);
+		if (status != B_OK && status != B_TIMED_OUT)
+			break;
+
+		stop_inactive_sessions();
+
+		MutexLocker locker(sLock);
+		prefetch_request *requests = sPrefetchQueue;
+		sPrefetchQueue = NULL;
+		Session *sessions = sSaveQueue;
+		sSaveQueue = NULL;
+		locker.Unlock();
+
+		while (requests != NULL) {
+			prefetch_request *request = requests;
+			requests = request->next;
+
+			prefetch_session(request->name);
+			free(request);
 		}
 
-		if (session->IsMainSession()) {
-			session->Next() = sMainPrefetchSessions;
-			sMainPrefetchSessions = session;
-		} else {
-			sPrefetchHash->Insert(session);
+		while (sessions != NULL) {
+			Session *session = sessions;
+			sessions = session->QueueNext();
+
+			if (session->IsWorthSaving())
+				session->Save();
+			delete session;
 		}
 	}
 
-	closedir(dir);
+	return B_OK;
 }
 
 
 //	#pragma mark -
 
 
-Session::Session(team_id team, const char *name, dev_t device,
-	ino_t node, int32 seconds)
+Session::Session(team_id team, const char *name, bigtime_t timeout)
 	:
-	fNodes(NULL),
+	fNext(NULL),
+	fQueueNext(NULL),
 	fNodeCount(0),
 	fTeam(team),
-	fClosing(false),
-	fIsWatchingTeam(false)
+	fStopTime(0),
+	fPrefetched(false)
 {
-	if (name != NULL) {
-		size_t length = strlen(name) + 1;
-		if (length > B_OS_NAME_LENGTH)
-			name += length - B_OS_NAME_LENGTH;
-
-		strlcpy(fName, name, B_OS_NAME_LENGTH);
-	} else
-		fName[0] = '\0';
+	strlcpy(fName, name, sizeof(fName));
 
-	mutex_init(&fLock, "launch speedup session");
 	fNodeHash = new(std::nothrow) NodeTable();
-	if (fNodeHash && fNodeHash->Init(64) != B_OK) {
+	if (fNodeHash != NULL && fNodeHash->Init(64) != B_OK) {
 		delete fNodeHash;
 		fNodeHash = NULL;
 	}
-	fActiveUntil = system_time() + seconds * 1000000LL;
-	fTimestamp = system_time();
-
-	fNodeRef.device = device;
-	fNodeRef.node = node;
-
-	TRACE(("start session %ld:%Ld \"%s\", system_time: %Ld, active until: %Ld\n",
-		device, node, Name(), system_time(), fActiveUntil));
-}
-
-
-Session::Session(const char *name)
-	:
-	fNodeHash(NULL),
-	fNodes(NULL),
-	fClosing(false),
-	fIsWatchingTeam(false)
-{
-	fTeam = -1;
-	fNodeRef.device = -1;
-	fNodeRef.node = -1;
 
-	if (isdigit(name[0]))
-		parse_node_ref(name, fNodeRef);
+	fStartTime = system_time();
+	fLastAccess = fStartTime;
+	fActiveUntil = fStartTime + timeout;
 
-	strlcpy(fName, name, B_OS_NAME_LENGTH);
+	TRACE(("start session \"%s\", team %" B_PRId32 ", system_time: %" B_PRId64
+		", active until: %" B_PRId64 "\n", Name(), team, fStartTime,
+		fActiveUntil));
 }
 
 
 Session::~Session()
 {
-	mutex_destroy(&fLock);
-
-	// free all nodes
-	struct node *node, *next = NULL;
-
-	if (fNodeHash) {
-		// ... from the hash
-		node = fNodeHash->Clear(true);
-	} else {
-		// ... from the list
-		node = fNodes;
-	}
+	if (fNodeHash == NULL)
+		return;
 
-	for (; node != NULL; node = next) {
-		next = node->next;
-		free(node);
+	struct node *node = fNodeHash->Clear(true);
+	while (node != NULL) {
+		struct node *next = node->next;
+		delete node;
+		node = next;
 	}
 
 	delete fNodeHash;
-	StopWatchingTeam();
 }
 
 
@@ -456,255 +680,313 @@ Session::InitCheck()
 }
 
 
-node *
-Session::_FindNode(dev_t device, ino_t node)
+bigtime_t
+Session::Duration() const
 {
-	node_ref key;
-	key.device = device;
-	key.node = node;
+	if (IsMainSession() && fStopTime != 0 && fStopTime < fActiveUntil)
+		return fStopTime - fStartTime;
 
-	return fNodeHash->Lookup(key);
+	return fLastAccess - fStartTime;
 }
 
 
 void
-Session::AddNode(dev_t device, ino_t id)
+Session::AddNode(dev_t device, ino_t parent, ino_t id)
 {
-	struct node *node = _FindNode(device, id);
-	if (node != NULL) {
-		node->ref_count++;
+	fLastAccess = system_time();
+
+	node_key key = { device, id };
+	if (fNodeCount >= kMaxNodeCount || fNodeHash->Lookup(key) != NULL)
 		return;
-	}
 
-	node = new_node(device, id);
+	struct node *node = new(std::nothrow) ::node;
 	if (node == NULL)
 		return;
 
+	node->device = device;
+	node->parent = parent;
+	node->id = id;
+	node->timestamp = fLastAccess;
+
 	fNodeHash->Insert(node);
 	fNodeCount++;
 }
 
 
-void
-Session::RemoveNode(dev_t device, ino_t id)
+/*!	Merges the two neighbouring ranges with the smallest gap between them,
+	so that as few pages as possible are read in addition.
+*/
+static void
+merge_closest_ranges(trace_range *ranges, uint32 count)
 {
-	struct node *node = _FindNode(device, id);
-	if (node != NULL && --node->ref_count <= 0) {
-		fNodeHash->Remove(node);
-		fNodeCount--;
+	uint32 closest = 0;
+	page_num_t closestGap = ~(page_num_t)0;
+	for (uint32 i = 0; i + 1 < count; i++) {
+		page_num_t gap = ranges[i + 1].first_page
+			- (ranges[i].first_page + ranges[i].page_count);
+		if (gap < closestGap) {
+			closest = i;
+			closestGap = gap;
+		}
 	}
-}
-
 
-status_t
-Session::StartWatchingTeam()
-{
-	if (Team() < B_OK)
-		return B_OK;
-
-	status_t status = start_watching_team(Team(), team_gone, this);
-	if (status == B_OK)
-		fIsWatchingTeam = true;
-
-	return status;
+	ranges[closest].page_count = ranges[closest + 1].first_page
+		+ ranges[closest + 1].page_count - ranges[closest].first_page;
+	memmove(&ranges[closest + 1], &ranges[closest + 2],
+		(count - closest - 2) * sizeof(trace_range));
 }
 
 
-void
-Session::StopWatchingTeam()
-{
-	if (fIsWatchingTeam)
-		stop_watching_team(Team(), team_gone, this);
-}
-
-
-void
-Session::Prefetch()
+/*!	Adds the ranges of the file that are currently in the file cache to
+	\a ranges. Ranges that are close to each other are merged, so that they
+	can be read with fewer, larger I/O requests. If a file has too many
+	ranges, the closest ones are merged.
+	If this fails, none of the file's ranges are added.
+*/
+status_t
+Session::_CollectRanges(struct node *node, trace_node &traceNode,
+	trace_range *&ranges, uint32 &rangeCount, uint32 &rangeCapacity)
 {
-	if (fNodes == NULL || fNodeHash != NULL)
-		return;
-
-	for (struct node *node = fNodes; node != NULL; node = node->next) {
-		cache_prefetch(node->ref.device, node->ref.node, 0, ~0UL);
+	traceNode.id = node->id;
+	traceNode.first_range = rangeCount;
+	traceNode.range_count = 0;
+
+	struct vnode *vnode;
+	status_t status = vfs_get_vnode(node->device, node->id, true, &vnode);
+	if (status != B_OK)
+		return status;
+
+	VMCache *cache;
+	status = vfs_get_vnode_cache(vnode, &cache, false);
+	if (status != B_OK) {
+		vfs_put_vnode(vnode);
+		return status;
+	}
+	if (cache->type != CACHE_TYPE_VNODE) {
+		cache->ReleaseRef();
+		vfs_put_vnode(vnode);
+		return B_BAD_TYPE;
 	}
-}
 
+	cache->Lock();
+	traceNode.size = cache->virtual_end;
 
-status_t
-Session::LoadFromDirectory(int directoryFD)
-{
-	TRACE(("load session %s\n", Name()));
+	for (VMCachePagesTree::Iterator iterator = cache->pages.GetIterator();
+			vm_page *page = iterator.Next();) {
+		page_num_t index = page->cache_offset;
 
-	int fd = _kern_open(directoryFD, Name(), O_RDONLY, 0);
-	if (fd < B_OK)
-		return fd;
+		if (traceNode.range_count > 0) {
+			trace_range &last = ranges[rangeCount - 1];
+			page_num_t end = (page_num_t)last.first_page + last.page_count;
+			if (index < end + kMaxRangeGap) {
+				last.page_count = index + 1 - last.first_page;
+				continue;
+			}
 
-	struct stat stat;
-	if (fstat(fd, &stat) != 0) {
-		close(fd);
-		return errno;
-	}
+			if (traceNode.range_count == kMaxRangesPerNode) {
+				// make room for the new range
+				merge_closest_ranges(ranges + traceNode.first_range,
+					traceNode.range_count);
+				rangeCount--;
+				traceNode.range_count--;
+			}
+		}
 
-	if (stat.st_size > 32768) {
-		// for safety reasons
-		// ToDo: make a bit larger later
-		close(fd);
-		return B_BAD_DATA;
-	}
+		if (rangeCount == rangeCapacity) {
+			uint32 capacity = rangeCapacity < 256 ? 256 : rangeCapacity * 2;
+			trace_range *newRanges = (trace_range *)realloc(ranges,
+				capacity * sizeof(trace_range));
+			if (newRanges == NULL) {
+				status = B_NO_MEMORY;
+				break;
+			}
+			ranges = newRanges;
+			rangeCapacity = capacity;
+		}
 
-	char *buffer = (char *)malloc(stat.st_size);
-	if (buffer == NULL) {
-		close(fd);
-		return B_NO_MEMORY;
+		ranges[rangeCount].first_page = index;
+		ranges[rangeCount].page_count = 1;
+		rangeCount++;
+		traceNode.range_count++;
 	}
 
-	if (read(fd, buffer, stat.st_size) < stat.st_size) {
-		free(buffer);
-		close(fd);
-		return B_ERROR;
-	}
+	cache->ReleaseRefAndUnlock();
+	vfs_put_vnode(vnode);
 
-	const char *line = buffer;
-	node_ref nodeRef;
-	while (parse_node_ref(line, nodeRef, &line)) {
-		struct node *node = new_node(nodeRef.device, nodeRef.node);
-		if (node != NULL) {
-			// note: this reverses the order of the nodes in the file
-			node->next = fNodes;
-			fNodes = node;
-		}
-		line++;
+	if (status != B_OK) {
+		rangeCount = traceNode.first_range;
+		traceNode.range_count = 0;
 	}
 
-	free(buffer);
-	close(fd);
-	return B_OK;
+	return status;
 }
 
 
+/*!	Writes the trace of this session: the accessed files in the order they
+	were first opened, together with the parts of them that are in the file
+	cache now. This is only an approximation of what the session actually
+	read, but it catches accesses via mapped files as well, and it doesn't
+	cost anything while the session is running.
+	This is only called from the worker thread.
+*/
 status_t
 Session::Save()
 {
-	fClosing = true;
-
-	char name[B_OS_NAME_LENGTH + 25];
-	if (!IsMainSession()) {
-		snprintf(name, sizeof(name), "/etc/launch_cache/%ld:%Ld %s",
-			fNodeRef.device, fNodeRef.node, Name());
-	} else
-		snprintf(name, sizeof(name), "/etc/launch_cache/%s", Name());
-
-	int fd = open(name, O_CREAT | O_TRUNC | O_WRONLY, 0644);
-	if (fd < B_OK)
-		return errno;
-
-	status_t status = B_OK;
-	off_t fileSize = 0;
-
-	// ToDo: order nodes by timestamp... (should improve launch speed)
-	// ToDo: test which parts of a file have been read (and save that as well)
-
-	// enlarge file, so that it can be written faster
-	ftruncate(fd, 512 * 1024);
+	struct node **nodes = (struct node **)malloc(
+		fNodeCount * sizeof(struct node *));
+	trace_node *traceNodes = (trace_node *)malloc(
+		fNodeCount * sizeof(trace_node));
+	if (nodes == NULL || traceNodes == NULL) {
+		free(nodes);
+		free(traceNodes);
+		return B_NO_MEMORY;
+	}
 
+	int32 count = 0;
 	NodeTable::Iterator iterator(fNodeHash);
-	while (iterator.HasNext()) {
-		struct node *node = iterator.Next();
-		snprintf(name, sizeof(name), "%ld:%Ld\n", node->ref.device, node->ref.node);
+	while (iterator.HasNext() && count < fNodeCount)
+		nodes[count++] = iterator.Next();
+
+	qsort(nodes, count, sizeof(struct node *), &compare_nodes);
+
+	trace_range *ranges = NULL;
+	uint32 rangeCount = 0;
+	uint32 rangeCapacity = 0;
+	char *paths = NULL;
+	uint32 pathsSize = 0;
+	uint32 pathsCapacity = 0;
+	uint32 traceNodeCount = 0;
+	off_t bytes = 0;
+	char nodePath[B_PATH_NAME_LENGTH];
+
+	for (int32 i = 0; i < count; i++) {
+		struct node *node = nodes[i];
+		trace_node &traceNode = traceNodes[traceNodeCount];
+		traceNode.path_offset = 0;
+		traceNode.path_length = 0;
+
+		bool hasPath = node->device != gBootDevice;
+		if (hasPath && get_node_path(node, nodePath, sizeof(nodePath)) != B_OK)
+			continue;
 
-		ssize_t bytesWritten = write(fd, name, strlen(name));
-		if (bytesWritten < B_OK) {
-			status = bytesWritten;
-			break;
+		if (_CollectRanges(node, traceNode, ranges, rangeCount,
+				rangeCapacity) != B_OK || traceNode.range_count == 0) {
+			continue;
 		}
 
-		fileSize += bytesWritten;
-	}
-
-	ftruncate(fd, fileSize);
-	close(fd);
-
-	return status;
-}
+		if (hasPath) {
+			uint32 length = strlen(nodePath);
+			if (pathsSize + length + 1 > pathsCapacity) {
+				uint32 capacity = pathsCapacity < 4096
+					? 4096 : pathsCapacity * 2;
+				if (capacity < pathsSize + length + 1)
+					capacity = pathsSize + length + 1;
+				char *newPaths = (char *)realloc(paths, capacity);
+				if (newPaths == NULL) {
+					rangeCount = traceNode.first_range;
+					continue;
+				}
+				paths = newPaths;
+				pathsCapacity = capacity;
+			}
 
+			memcpy(paths + pathsSize, nodePath, length + 1);
+			traceNode.id = -1;
+			traceNode.path_offset = pathsSize;
+			traceNode.path_length = length;
+			pathsSize += length + 1;
+		}
 
-bool
-Session::IsWorthSaving() const
-{
-	// ToDo: sort out entries with only very few nodes, and those that load
-	//	instantly, anyway
-	if (fNodeCount < 5 || system_time() - fTimestamp < 400000) {
-		// sort anything out that opens less than 5 files, or needs less
-		// than 0.4 seconds to load an run
-		return false;
+		for (uint32 j = 0; j < traceNode.range_count; j++) {
+			bytes += (off_t)ranges[traceNode.first_range + j].page_count
+				* B_PAGE_SIZE;
+		}
+		traceNodeCount++;
 	}
-	return true;
-}
-
-
-bool
-Session::IsMainSession() const
-{
-	return fNodeRef.node == -1;
-}
-
-
-//	#pragma mark -
 
+	free(nodes);
+
+	trace_header header;
+	header.magic = kTraceMagic;
+	header.version = kTraceVersion;
+	header.name_length = strlen(fName);
+	header.node_count = traceNodeCount;
+	header.range_count = rangeCount;
+	header.flags = fPrefetched ? TRACE_PREFETCHED : 0;
+	header.duration = Duration();
+	header.paths_size = pathsSize;
+	header.reserved = 0;
+
+	// report how long the session took, and how long it took last time
+	uint8 *previous;
+	trace_header previousHeader;
+	if (read_trace(fName, previousHeader, previous) == B_OK) {
+		dprintf("launch_speedup: \"%s\" took %" B_PRId64 " ms %s prefetching,"
+			" last time %" B_PRId64 " ms %s prefetching\n", fName,
+			header.duration / 1000, fPrefetched ? "with" : "without",
+			previousHeader.duration / 1000,
+			(previousHeader.flags & TRACE_PREFETCHED) != 0
+				? "with" : "without");
+		free(previous);
+	} else {
+		dprintf("launch_speedup: \"%s\" took %" B_PRId64 " ms %s "
+			"prefetching\n", fName, header.duration / 1000,
+			fPrefetched ? "with" : "without");
+	}
 
-SessionGetter::SessionGetter(team_id team, Session **_session)
-{
-	RecursiveLocker locker(&sLock);
+	status_t status = B_OK;
+	char path[B_PATH_NAME_LENGTH];
+	get_trace_path(fName, path, sizeof(path));
+
+	uint64 fileSize = sizeof(trace_header) + header.name_length
+		+ (uint64)traceNodeCount * sizeof(trace_node)
+		+ (uint64)rangeCount * sizeof(trace_range) + pathsSize;
+	if (traceNodeCount == 0 || fileSize > (uint64)kMaxTraceFileSize)
+		status = B_BAD_DATA;
+
+	int fd = -1;
+	if (status == B_OK) {
+		fd = open(path, O_CREAT | O_TRUNC | O_WRONLY, 0644);
+		if (fd < 0)
+			status = errno;
+	}
 
-	if (sMainSession != NULL)
-		fSession = sMainSession;
-	else
-		fSession = sTeamHash->Lookup(team);
+	if (status == B_OK) {
+		if (write(fd, &header, sizeof(header)) != (ssize_t)sizeof(header)
+			|| write(fd, fName, header.name_length)
+				!= (ssize_t)header.name_length
+			|| write(fd, traceNodes, traceNodeCount * sizeof(trace_node))
+				!= (ssize_t)(traceNodeCount * sizeof(trace_node))
+			|| write(fd, ranges, rangeCount * sizeof(trace_range))
+				!= (ssize_t)(rangeCount * sizeof(trace_range))
+			|| write(fd, paths, pathsSize) != (ssize_t)pathsSize) {
+			status = B_IO_ERROR;
+		}
+		close(fd);
 
-	if (fSession != NULL) {
-		if (!fSession->IsClosing())
-			fSession->Lock();
-		else
-			fSession = NULL;
+		if (status != B_OK)
+			unlink(path);
 	}
 
-	*_session = fSession;
-}
-
+	TRACE(("saved session \"%s\": %" B_PRIu32 " files, %" B_PRIdOFF " KB: "
+		"%s\n", fName, traceNodeCount, bytes / 1024, strerror(status)));
 
-SessionGetter::~SessionGetter()
-{
-	if (fSession != NULL)
-		fSession->Unlock();
+	free(traceNodes);
+	free(ranges);
+	free(paths);
+	return status;
 }
 
 
-status_t
-SessionGetter::New(const char *name, dev_t device, ino_t node,
-	Session **_session)
+bool
+Session::IsWorthSaving() const
 {
-	Thread *thread = thread_get_current_thread();
-	fSession = start_session(thread->team->id, device, node, name);
-
-	if (fSession != NULL) {
-		*_session = fSession;
-		return B_OK;
-	}
-
-	return B_ERROR;
+	// sort out sessions that opened less than 3 files, or didn't even need
+	// 0.1 seconds to load and run
+	return fNodeCount >= 3 && Duration() >= 100000;
 }
 
 
-void
-SessionGetter::Stop()
-{
-	if (fSession == sMainSession)
-		sMainSession = NULL;
-
-	stop_session(fSession);
-	fSession = NULL;
-}
-
 //	#pragma mark -
 
 
@@ -712,49 +994,54 @@ static void
 node_opened(struct vnode *vnode, int32 fdType, dev_t device, ino_t parent,
 	ino_t node, const char *name, off_t size)
 {
-	if (device < gBootDevice) {
-		// we ignore any access to rootfs, pipefs, and devfs
-		// ToDo: if we can ever move the boot device on the fly, this will break
+	if (fdType != FDTYPE_FILE) {
+		// only files can be prefetched
+		return;
+	}
+	if (device != gBootDevice && !is_package_volume(device)) {
+		// only nodes on the boot volume have persistent IDs, and only
+		// paths on packagefs volumes lead to the same files again
 		return;
 	}
 
-	Session *session;
-	SessionGetter getter(team_get_current_team_id(), &session);
-
-	if (session == NULL) {
-		char buffer[B_FILE_NAME_LENGTH];
-		if (name == NULL
-			&& vfs_get_vnode_name(vnode, buffer, sizeof(buffer)) == B_OK)
-			name = buffer;
+	MutexLocker locker(sLock);
 
-		// create new session for this team
-		getter.New(name, device, node, &session);
-	}
+	Session *session = sMainSession;
+	if (session == NULL)
+		session = sTeamHash->Lookup(team_get_current_team_id());
+	if (session == NULL)
+		return;
 
-	if (session == NULL || !session->IsActive()) {
-		if (sMainSession != NULL) {
-			// ToDo: this opens a race condition with the "stop session" syscall
-			getter.Stop();
-		}
+	if (!session->IsActive()) {
+		stop_session(session);
 		return;
 	}
 
-	session->AddNode(device, node);
+	session->AddNode(device, parent, node);
 }
 
 
 static void
-node_closed(struct vnode *vnode, int32 fdType, dev_t device, ino_t node,
-	int32 accessType)
+node_launched(size_t argCount, char * const *args)
 {
-	Session *session;
-	SessionGetter getter(team_get_current_team_id(), &session);
+	if (argCount == 0 || args[0] == NULL || args[0][0] != '/')
+		return;
 
-	if (session == NULL)
+	MutexLocker locker(sLock);
+
+	if (sMainSession != NULL) {
+		// everything that happens during boot is part of the boot session
 		return;
+	}
 
-	if (accessType == FILE_CACHE_NO_IO)
-		session->RemoveNode(device, node);
+	team_id team = team_get_current_team_id();
+	Session *session = sTeamHash->Lookup(team);
+	if (session != NULL) {
+		// the team has called exec(), the old session is over
+		stop_session(session);
+	}
+
+	start_session(team, args[0], kLaunchSessionTimeout);
 }
 
 
@@ -763,6 +1050,15 @@ launch_speedup_control(const char *subsystem, uint32 function,
 	void *buffer, size_t bufferSize)
 {
 	switch (function) {
+		case B_SYSCALL_INFO:
+		{
+			uint32 version = 1;
+			if (!IS_USER_ADDRESS(buffer)
+				|| user_memcpy(buffer, &version, sizeof(version)) != B_OK)
+				return B_BAD_ADDRESS;
+			return B_OK;
+		}
+
 		case LAUNCH_SPEEDUP_START_SESSION:
 		{
 			char name[B_OS_NAME_LENGTH];
@@ -770,12 +1066,15 @@ launch_speedup_control(const char *subsystem, uint32 function,
 				|| user_strlcpy(name, (const char *)buffer, B_OS_NAME_LENGTH) < B_OK)
 				return B_BAD_ADDRESS;
 
-			if (isdigit(name[0]) || name[0] == '.')
+			if (name[0] == '/' || name[0] == '\0')
 				return B_BAD_VALUE;
 
-			sMainSession = start_session(-1, -1, -1, name, 60);
-			sMainSession->Unlock();
-			return B_OK;
+			MutexLocker locker(sLock);
+			if (sMainSession != NULL)
+				return B_BUSY;
+
+			sMainSession = start_session(-1, name, kBootSessionTimeout);
+			return sMainSession != NULL ? B_OK : B_NO_MEMORY;
 		}
 
 		case LAUNCH_SPEEDUP_STOP_SESSION:
@@ -785,16 +1084,16 @@ launch_speedup_control(const char *subsystem, uint32 function,
 				|| user_strlcpy(name, (const char *)buffer, B_OS_NAME_LENGTH) < B_OK)
 				return B_BAD_ADDRESS;
 
-			// ToDo: this check is not thread-safe
+			MutexLocker locker(sLock);
 			if (sMainSession == NULL || strcmp(sMainSession->Name(), name))
 				return B_BAD_VALUE;
 
-			if (!strcmp(name, "system boot"))
-				dprintf("STOP BOOT %Ld\n", system_time());
+			if (!strcmp(name, kBootSessionName)) {
+				dprintf("launch_speedup: boot process done after %" B_PRId64
+					" ms\n", system_time() / 1000);
+			}
 
-			sMainSession->Lock();
 			stop_session(sMainSession);
-			sMainSession = NULL;
 			return B_OK;
 		}
 	}
@@ -808,79 +1107,99 @@ uninit()
 {
 	unregister_generic_syscall(LAUNCH_SPEEDUP_SYSCALLS, 1);
 
-	recursive_lock_lock(&sLock);
+	delete_sem(sWorkerSemaphore);
+	status_t result;
+	wait_for_thread(sWorkerThread, &result);
 
-	// free all sessions from the hashes
+	// free all sessions and pending requests without saving them
+
+	MutexLocker locker(sLock);
 
 	Session *session = sTeamHash->Clear(true);
 	while (session != NULL) {
-		Session *next = session->next;
+		Session *next = session->Next();
 		delete session;
 		session = next;
 	}
-	session = sPrefetchHash->Clear(true);
-	while (session != NULL) {
-		Session *next = session->next;
+	while (sSaveQueue != NULL) {
+		session = sSaveQueue;
+		sSaveQueue = session->QueueNext();
 		delete session;
-		session = next;
 	}
-
-	// free all sessions from the main prefetch list
-
-	for (session = sMainPrefetchSessions; session != NULL; ) {
-		sMainPrefetchSessions = session->Next();
-		delete session;
-		session = sMainPrefetchSessions;
+	while (sPrefetchQueue != NULL) {
+		prefetch_request *request = sPrefetchQueue;
+		sPrefetchQueue = request->next;
+		free(request);
 	}
 
+	delete sMainSession;
+	sMainSession = NULL;
+
 	delete sTeamHash;
-	delete sPrefetchHash;
-	recursive_lock_destroy(&sLock);
 }
 
 
 static status_t
 init()
 {
+	void *settings = load_driver_settings("launch_speedup");
+	if (settings != NULL) {
+		bool disabled = get_driver_boolean_parameter(settings, "disabled",
+			false, true);
+		// "prefetch false" still records the sessions, so that the launch
+		// times with and without prefetching can be compared
+		sPrefetchEnabled = get_driver_boolean_parameter(settings, "prefetch",
+			true, true);
+		unload_driver_settings(settings);
+
+		if (disabled)
+			return B_ERROR;
+	}
+
 	sTeamHash = new(std::nothrow) SessionTable();
-	if (sTeamHash == NULL || sTeamHash->Init(64) != B_OK)
+	if (sTeamHash == NULL || sTeamHash->Init(64) != B_OK) {
+		delete sTeamHash;
 		return B_NO_MEMORY;
+	}
 
-	status_t status;
-
-	sPrefetchHash = new(std::nothrow) PrefetchTable();
-	if (sPrefetchHash == NULL || sPrefetchHash->Init(64) != B_OK) {
-		status = B_NO_MEMORY;
-		goto err1;
+	sWorkerSemaphore = create_sem(0, "launch speedup work");
+	if (sWorkerSemaphore < 0) {
+		delete sTeamHash;
+		return sWorkerSemaphore;
 	}
 
-	recursive_lock_init(&sLock, "launch speedup");
+	sWorkerThread = spawn_kernel_thread(&worker_thread, "launch speedup",
+		B_NORMAL_PRIORITY, NULL);
+	if (sWorkerThread < 0) {
+		delete_sem(sWorkerSemaphore);
+		delete sTeamHash;
+		return sWorkerThread;
+	}
 
 	// register kernel syscalls
 	if (register_generic_syscall(LAUNCH_SPEEDUP_SYSCALLS,
 			launch_speedup_control, 1, 0) != B_OK) {
-		status = B_ERROR;
-		goto err3;
+		delete_sem(sWorkerSemaphore);
+		status_t result;
+		wait_for_thread(sWorkerThread, &result);
+		delete sTeamHash;
+		return B_ERROR;
 	}
 
-	// read in prefetch knowledge base
+	mkdir(kTraceDirectory, 0755);
 
-	mkdir("/etc/launch_cache", 0755);
-	load_prefetch_data();
+	// start boot session, this also prefetches the last one
 
-	// start boot session
+	mutex_lock(&sLock);
+	sMainSession = start_session(-1, kBootSessionName, kBootSessionTimeout);
+	mutex_unlock(&sLock);
 
-	sMainSession = start_session(-1, -1, -1, "system boot");
-	sMainSession->Unlock();
-	dprintf("START BOOT %Ld\n", system_time());
-	return B_OK;
+	resume_thread(sWorkerThread);
 
-err3:
-	recursive_lock_destroy(&sLock);
-	delete sPrefetchHash;
-err1:
-	delete sTeamHash;
-	return status;
+	dprintf("launch_speedup: boot session started at %" B_PRId64 " ms, "
+		"prefetching %s\n", system_time() / 1000,
+		sPrefetchEnabled ? "enabled" : "disabled");
+	return B_OK;
 }
 
 
@@ -908,8 +1227,8 @@ static struct cache_module_info sLaunchSpeedupModule = {
 		std_ops,
 	},
 	node_opened,
-	node_closed,
 	NULL,
+	node_launched,
 };
 
 
@@ -24,6 +24,7 @@
 #include <AutoDeleter.h>
 #include <PackagesDirectoryDefs.h>
 
+#include <smp.h>
 #include <vfs.h>
 
 #include "AttributeIndex.h"
@@ -61,6 +62,9 @@ const size_t kMaxActivationRequestSize = 10 * 1024 * 1024;
 // sanity limit for activation file size
 const size_t kMaxActivationFileSize = 10 * 1024 * 1024;
 
+// maximum number of threads loading packages for an activation change
+static const int32 kMaxPackageLoaderThreads = 8;
+
 static const char* const kAdministrativeDirectoryName
 	= PACKAGES_DIRECTORY_ADMIN_DIRECTORY;
 static const char* const kActivationFileName
@@ -159,6 +163,92 @@ private:
 };
 
 
+// #pragma mark - PackageLoader
+
+
+/*!	Loads a set of packages in parallel.
+	Reading a package's TOC and building its node tree is independent of all
+	other packages, so the packages are handed out one by one to up to
+	kMaxPackageLoaderThreads threads, the calling thread being one of them.
+*/
+struct Volume::PackageLoader {
+	PackageLoader(Volume* volume, PackagesDirectory* packagesDirectory,
+		const char* const* names, int32 count, BReference<Package>* packages)
+		:
+		fVolume(volume),
+		fPackagesDirectory(packagesDirectory),
+		fNames(names),
+		fPackages(packages),
+		fCount(count),
+		fNextIndex(0),
+		fError(B_OK)
+	{
+	}
+
+	status_t Run()
+	{
+		int32 threadCount = min_c(min_c(smp_get_num_cpus(),
+			kMaxPackageLoaderThreads), fCount);
+
+		thread_id threads[kMaxPackageLoaderThreads];
+		int32 spawnedCount = 0;
+		for (int32 i = 1; i < threadCount; i++) {
+			thread_id thread = spawn_kernel_thread(&_LoaderThreadEntry,
+				"packagefs package loader", B_NORMAL_PRIORITY, this);
+			if (thread < 0)
+				break;
+
+			threads[spawnedCount++] = thread;
+			resume_thread(thread);
+		}
+
+		_Load();
+
+		for (int32 i = 0; i < spawnedCount; i++)
+			wait_for_thread(threads[i], NULL);
+
+		return fError;
+	}
+
+private:
+	static status_t _LoaderThreadEntry(void* data)
+	{
+		((PackageLoader*)data)->_Load();
+		return B_OK;
+	}
+
+	void _Load()
+	{
+		while (atomic_get(&fError) == B_OK) {
+			int32 index = atomic_add(&fNextIndex, 1);
+			if (index >= fCount)
+				return;
+
+			Package* package;
+			status_t error = fVolume->_LoadPackage(fPackagesDirectory,
+				fNames[index], package);
+			if (error != B_OK) {
+				ERROR("Volume::_LoadPackages(): failed to load package "
+					"\"%s\"\n", fNames[index]);
+				atomic_test_and_set(&fError, error, B_OK);
+				return;
+			}
+
+			fPackages[index].SetTo(package, true);
+		}
+	}
+
+private:
+	Volume*				fVolume;
+	PackagesDirectory*	fPackagesDirectory;
+	const char* const*	fNames;
+	BReference<Package>* fPackages;
+	int32				fCount;
+	int32				fNextIndex;
+	int32				fError;
+};
+
+
 // #pragma mark - Volume
 
 
@@ -1498,6 +1588,18 @@ Volume::_LoadPackage(PackagesDirectory* packagesDirectory, const char* name,
 }
 
 
+status_t
+Volume::_LoadPackages(PackagesDirectory* packagesDirectory,
+	const char* const* names, int32 count, BReference<Package>* _packages)
+{
+	if (count == 0)
+		return B_OK;
+
+	return PackageLoader(this, packagesDirectory, names, count, _packages)
+		.Run();
+}
+
+
 status_t
 Volume::_ChangeActivation(ActivationChangeRequest& request)
 {
@@ -1569,25 +1671,31 @@ Volume::_ChangeActivation(ActivationChangeRequest& request)
 			oldPackageReferences);
 
 	// load all new packages
+	const char** newPackageNames
+		= new(std::nothrow) const char*[newPackageCount];
+	if (newPackageNames == NULL)
+		RETURN_ERROR(B_NO_MEMORY);
+	ArrayDeleter<const char*> newPackageNamesDeleter(newPackageNames);
+
 	int32 newPackageIndex = 0;
 	for (uint32 i = 0; i < itemCount; i++) {
 		PackageFSActivationChangeItem* item = request.ItemAt(i);
 
-		if (item->type != PACKAGE_FS_ACTIVATE_PACKAGE
-			&& item->type != PACKAGE_FS_REACTIVATE_PACKAGE) {
-			continue;
+		if (item->type == PACKAGE_FS_ACTIVATE_PACKAGE
+			|| item->type == PACKAGE_FS_REACTIVATE_PACKAGE) {
+			newPackageNames[newPackageIndex++] = item->name;
 		}
+	}
 
-		Package* package;
-		status_t error = _LoadPackage(fPackagesDirectory, item->name, package);
-		if (error != B_OK) {
-			ERROR("Volume::_ChangeActivation(): failed to load package "
-				"\"%s\"\n", item->name);
-			RETURN_ERROR(error);
-		}
+	bigtime_t loadStartTime = system_time();
+	status_t error = _LoadPackages(fPackagesDirectory, newPackageNames,
+		newPackageCount, newPackageReferences);
+	if (error != B_OK)
+		RETURN_ERROR(error);
 
-		newPackageReferences[newPackageIndex++].SetTo(package, true);
-	}
+	INFORM("Volume::_ChangeActivation(): loaded %" B_PRId32 " packages in %"
+		B_PRIdBIGTIME " us\n", newPackageCount,
+		system_time() - loadStartTime);
 
 	// apply the changes
 	VolumeWriteLocker systemVolumeLocker(_SystemVolumeIfNotSelf());
@@ -1618,7 +1726,6 @@ Volume::_ChangeActivation(ActivationChangeRequest& request)
 // with the same name would be active after activating the new one. Check!
 
 	// add the new packages
-	status_t error = B_OK;
 	for (newPackageIndex = 0; newPackageIndex < newPackageCount;
 		newPackageIndex++) {
 		Package* package = newPackageReferences[newPackageIndex];
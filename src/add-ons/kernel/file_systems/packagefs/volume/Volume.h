@@ -108,6 +108,7 @@ private:
 private:
 			struct ShineThroughDirectory;
 			struct ActivationChangeRequest;
+			struct PackageLoader;
 
 private:
 			status_t			_LoadOldPackagesStates(
@@ -155,6 +156,10 @@ private:
 			status_t			_LoadPackage(
 									PackagesDirectory* packagesDirectory,
 									const char* name, Package*& _package);
+			status_t			_LoadPackages(
+									PackagesDirectory* packagesDirectory,
+									const char* const* names, int32 count,
+									BReference<Package>* _packages);
 
 			status_t			_ChangeActivation(
 									ActivationChangeRequest& request);
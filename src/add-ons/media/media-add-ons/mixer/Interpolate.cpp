@@ -11,14 +11,38 @@
 #include <cmath>
 
 #include <MediaDefs.h>
+#include <RealtimeAlloc.h>
 
 #include "MixerDebug.h"
 
 
 /*! Resampling class doing linear interpolation.
+
+	The source samples are converted into contiguous floats, behind the last
+	sample of the previous buffer, so that the interpolation itself can use
+	the vectorized kernel. The buffer for that is allocated up front for up to
+	\a maxSourceCount samples; larger buffers, and the formats needing an
+	offset, use the scalar kernel instead.
 */
 
 
+static const int32 kChunkSize = 256;
+
+
+template<typename outType> static inline bool
+is_float_sample(outType*)
+{
+	return false;
+}
+
+
+static inline bool
+is_float_sample(float*)
+{
+	return true;
+}
+
+
 template<typename inType, typename outType, int gnum, int gden, int offset,
 	int32 min, int32 max> static void
 kernel(Resampler* object, const void *_src, int32 srcSampleOffset,
@@ -69,27 +93,84 @@ kernel(Resampler* object, const void *_src, int32 srcSampleOffset,
 }
 
 
-Interpolate::Interpolate(uint32 src_format, uint32 dst_format)
+template<typename inType, typename outType, int gnum, int gden, int offset,
+	int32 min, int32 max> static void
+vector_kernel(Resampler* object, const void *_src, int32 srcSampleOffset,
+	int32 srcSampleCount, void *_dest, int32 destSampleOffset,
+	int32 destSampleCount, float _gain)
+{
+	Interpolate* self = (Interpolate*)object;
+	if (offset != 0 || srcSampleCount == destSampleCount
+		|| srcSampleCount + 2 > self->fSamplesCapacity) {
+		kernel<inType, outType, gnum, gden, offset, min, max>(object, _src,
+			srcSampleOffset, srcSampleCount, _dest, destSampleOffset,
+			destSampleCount, _gain);
+		return;
+	}
+
+	const char* src = (const char*)_src;
+	char* dest = (char*)_dest;
+	float gain = _gain * gnum / gden;
+
+	// The interpolation reads one sample past each position; the last
+	// position may round up to the last sample.
+	float* samples = self->fSamples;
+	samples[0] = self->fOldSample;
+	for (int32 i = 1; i <= srcSampleCount; i++) {
+		samples[i] = *(const inType*)src;
+		src += srcSampleOffset;
+	}
+	samples[srcSampleCount + 1] = samples[srcSampleCount];
+	self->fOldSample = samples[srcSampleCount];
+
+	float delta = float(srcSampleCount) / float(destSampleCount);
+	void (*interpolate)(float*, const float*, float, int32, int32, float,
+		float, float) = get_mixer_kernels().interpolate;
+
+	if (is_float_sample((outType*)dest) && destSampleOffset == sizeof(float)) {
+		interpolate((float*)dest, samples, delta, 0, destSampleCount, gain,
+			min, max);
+		return;
+	}
+
+	float chunk[kChunkSize];
+	for (int32 first = 0; first < destSampleCount; first += kChunkSize) {
+		int32 count = min_c(kChunkSize, destSampleCount - first);
+		interpolate(chunk, samples, delta, first, count, gain, min, max);
+		for (int32 i = 0; i < count; i++) {
+			*(outType *)dest = (outType)chunk[i];
+			dest += destSampleOffset;
+		}
+	}
+}
+
+
+Interpolate::Interpolate(uint32 src_format, uint32 dst_format,
+	int32 maxSourceCount)
 	:
 	Resampler(),
-	fOldSample(0)
+	fOldSample(0),
+	fSamples((float*)rtm_alloc(NULL, (maxSourceCount + 2) * sizeof(float))),
+	fSamplesCapacity(fSamples != NULL ? maxSourceCount + 2 : 0)
 {
+	fConvert = find_convert_function(src_format, dst_format);
+
 	if (dst_format == media_raw_audio_format::B_AUDIO_FLOAT) {
 		switch (src_format) {
 			case media_raw_audio_format::B_AUDIO_FLOAT:
-				fFunc = &kernel<float, float, 1, 1, 0, -1, 1>;
+				fFunc = &vector_kernel<float, float, 1, 1, 0, -1, 1>;
 				return;
 			case media_raw_audio_format::B_AUDIO_INT:
-				fFunc = &kernel<int32, float, 1, INT32_MAX, 0, -1, 1>;
+				fFunc = &vector_kernel<int32, float, 1, INT32_MAX, 0, -1, 1>;
 				return;
 			case media_raw_audio_format::B_AUDIO_SHORT:
-				fFunc = &kernel<int16, float, 1, INT16_MAX, 0, -1, 1>;
+				fFunc = &vector_kernel<int16, float, 1, INT16_MAX, 0, -1, 1>;
 				return;
 			case media_raw_audio_format::B_AUDIO_CHAR:
-				fFunc = &kernel<int8, float, 1, INT8_MAX, 0, -1, 1>;
+				fFunc = &vector_kernel<int8, float, 1, INT8_MAX, 0, -1, 1>;
 				return;
 			case media_raw_audio_format::B_AUDIO_UCHAR:
-				fFunc = &kernel<uint8, float, 2, UINT8_MAX, -128, -1, 1>;
+				fFunc = &vector_kernel<uint8, float, 2, UINT8_MAX, -128, -1, 1>;
 				return;
 			default:
 				ERROR("Resampler::Resampler: unknown source format 0x%x\n",
@@ -102,19 +183,19 @@ Interpolate::Interpolate(uint32 src_format, uint32 dst_format)
 		switch (dst_format) {
 			// float=>float already handled above
 			case media_raw_audio_format::B_AUDIO_INT:
-				fFunc = &kernel<float, int32, INT32_MAX, 1, 0,
+				fFunc = &vector_kernel<float, int32, INT32_MAX, 1, 0,
 					INT32_MIN, INT32_MAX>;
 				return;
 			case media_raw_audio_format::B_AUDIO_SHORT:
-				fFunc = &kernel<float, int16, INT16_MAX, 1, 0,
+				fFunc = &vector_kernel<float, int16, INT16_MAX, 1, 0,
 					INT16_MIN, INT16_MAX>;
 				return;
 			case media_raw_audio_format::B_AUDIO_CHAR:
-				fFunc = &kernel<float, int8, INT8_MAX, 1, 0,
+				fFunc = &vector_kernel<float, int8, INT8_MAX, 1, 0,
 					INT8_MIN, INT8_MAX>;
 				return;
 			case media_raw_audio_format::B_AUDIO_UCHAR:
-				fFunc = &kernel<float, uint8, UINT8_MAX, 2, 1,
+				fFunc = &vector_kernel<float, uint8, UINT8_MAX, 2, 1,
 					0, UINT8_MAX>;
 				return;
 			default:
@@ -129,3 +210,9 @@ Interpolate::Interpolate(uint32 src_format, uint32 dst_format)
 }
 
 
+Interpolate::~Interpolate()
+{
+	rtm_free(fSamples);
+}
+
+
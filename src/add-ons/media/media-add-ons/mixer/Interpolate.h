@@ -12,9 +12,12 @@
 class Interpolate: public Resampler {
 public:
 							Interpolate(uint32 sourceFormat,
-								uint32 destFormat);
+								uint32 destFormat, int32 maxSourceCount);
+	virtual					~Interpolate();
 
 			float			fOldSample;
+			float*			fSamples;
+			int32			fSamplesCapacity;
 };
 
 
@@ -24,10 +24,12 @@
 #include "AudioMixer.h"
 #include "Interpolate.h"
 #include "MixerInput.h"
+#include "MixerKernels.h"
 #include "MixerOutput.h"
 #include "MixerUtils.h"
 #include "Resampler.h"
 #include "RtList.h"
+#include "WindowedSinc.h"
 
 
 #define DOUBLE_RATE_MIXING 	0
@@ -408,7 +410,13 @@ MixerCore::_UpdateResamplers(const media_multi_audio_format& format)
 		switch (Settings()->ResamplingAlgorithm()) {
 			case 2:
 				fResampler[i] = new Interpolate(
-					media_raw_audio_format::B_AUDIO_FLOAT, format.format);
+					media_raw_audio_format::B_AUDIO_FLOAT, format.format,
+					fMixBufferFrameCount);
+				break;
+			case 3:
+				fResampler[i] = new WindowedSinc(
+					media_raw_audio_format::B_AUDIO_FLOAT, format.format,
+					fMixBufferFrameCount);
 				break;
 			default:
 				fResampler[i] = new Resampler(
@@ -634,24 +642,33 @@ MixerCore::_MixThread()
 			}
 		}
 
+		// The mix buffer's channels are stored one after the other, like the
+		// inputs' are, so they can be mixed with vector instructions.
 		memset(fMixBuffer, 0,
 			fMixBufferChannelCount * fMixBufferFrameCount * sizeof(float));
 		for (int channel = 0; channel < fMixBufferChannelCount; channel++) {
 			PRINT(5, "_MixThread: channel %d has %d sources\n", channel,
 				mixChanInfos[channel].CountItems());
 
+			float* channelBuffer = fMixBuffer + channel * fMixBufferFrameCount;
 			int count = mixChanInfos[channel].CountItems();
 			for (int i = 0; i < count; i++) {
 				chan_info* info = mixChanInfos[channel].ItemAt(i);
 				PRINT(5, "_MixThread:   base %p, sample-offset %2d, gain %.3f\n",
 					info->base, info->sample_offset, info->gain);
+				if (info->sample_offset == sizeof(float)) {
+					get_mixer_kernels().mix(channelBuffer,
+						(const float*)info->base, info->gain,
+						fMixBufferFrameCount);
+					continue;
+				}
+
 				// This looks slightly ugly, but the current GCC will generate
 				// the fastest code this way.
 				// fMixBufferFrameCount is always > 0.
-				uint32 dstSampleOffset
-					= fMixBufferChannelCount * sizeof(float);
+				uint32 dstSampleOffset = sizeof(float);
 				uint32 srcSampleOffset = info->sample_offset;
-				register char* dst = (char*)&fMixBuffer[channel];
+				register char* dst = (char*)channelBuffer;
 				register char* src = (char*)info->base;
 				register float gain = info->gain;
 				register int j = fMixBufferFrameCount;
@@ -672,8 +689,7 @@ MixerCore::_MixThread()
 			// copy data from mix buffer into output buffer
 			for (int i = 0; i < fMixBufferChannelCount; i++) {
 				fResampler[i]->Resample(
-					reinterpret_cast<char*>(fMixBuffer) + i * sizeof(float),
-					fMixBufferChannelCount * sizeof(float),
+					fMixBuffer + i * fMixBufferFrameCount, sizeof(float),
 					fMixBufferFrameCount,
 					reinterpret_cast<char*>(buffer->Data())
 						+ (i * bytes_per_sample(
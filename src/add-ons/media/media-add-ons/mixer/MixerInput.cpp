@@ -18,6 +18,7 @@
 #include "MixerInput.h"
 #include "MixerUtils.h"
 #include "Resampler.h"
+#include "WindowedSinc.h"
 
 
 MixerInput::MixerInput(MixerCore* core, const media_input& input,
@@ -257,7 +258,7 @@ MixerInput::BufferReceived(BBuffer* buffer)
 		fLastDataFrameWritten = out_frames2 - 1;
 
 		// convert offset from frames into bytes
-		offset *= sizeof(float) * fInputChannelCount;
+		offset *= sizeof(float);
 
 		for (int i = 0; i < fInputChannelCount; i++) {
 			fResampler[i]->Resample(
@@ -265,7 +266,7 @@ MixerInput::BufferReceived(BBuffer* buffer)
 					+ i * bytes_per_sample(fInput.format.u.raw_audio),
 				bytes_per_frame(fInput.format.u.raw_audio), in_frames1,
 				reinterpret_cast<char*>(fInputChannelInfo[i].buffer_base)
-					+ offset, fInputChannelCount * sizeof(float), out_frames1,
+					+ offset, sizeof(float), out_frames1,
 				fInputChannelInfo[i].gain);
 
 			fResampler[i]->Resample(
@@ -274,7 +275,7 @@ MixerInput::BufferReceived(BBuffer* buffer)
 					+ in_frames1 * bytes_per_frame(fInput.format.u.raw_audio),
 				bytes_per_frame(fInput.format.u.raw_audio), in_frames2,
 				reinterpret_cast<char*>(fInputChannelInfo[i].buffer_base),
-				fInputChannelCount * sizeof(float), out_frames2,
+				sizeof(float), out_frames2,
 				fInputChannelInfo[i].gain);
 
 		}
@@ -293,14 +294,14 @@ MixerInput::BufferReceived(BBuffer* buffer)
 
 		fLastDataFrameWritten = offset + out_frames - 1;
 		// convert offset from frames into bytes
-		offset *= sizeof(float) * fInputChannelCount;
+		offset *= sizeof(float);
 		for (int i = 0; i < fInputChannelCount; i++) {
 			fResampler[i]->Resample(
 				reinterpret_cast<char*>(data)
 					+ i * bytes_per_sample(fInput.format.u.raw_audio),
 				bytes_per_frame(fInput.format.u.raw_audio), in_frames,
 				reinterpret_cast<char*>(fInputChannelInfo[i].buffer_base)
-					+ offset, fInputChannelCount * sizeof(float),
+					+ offset, sizeof(float),
 				out_frames, fInputChannelInfo[i].gain);
 		}
 	}
@@ -323,7 +324,14 @@ MixerInput::UpdateResamplingAlgorithm()
 			case 2:
 				fResampler[i] = new Interpolate(
 					fInput.format.u.raw_audio.format,
-					media_raw_audio_format::B_AUDIO_FLOAT);
+					media_raw_audio_format::B_AUDIO_FLOAT,
+					frames_per_buffer(fInput.format.u.raw_audio));
+				break;
+			case 3:
+				fResampler[i] = new WindowedSinc(
+					fInput.format.u.raw_audio.format,
+					media_raw_audio_format::B_AUDIO_FLOAT,
+					frames_per_buffer(fInput.format.u.raw_audio));
 				break;
 			default:
 				fResampler[i] = new Resampler(
@@ -557,8 +565,8 @@ MixerInput::_UpdateInputChannelDestinations()
 			if (fInputChannelInfo[j].destination_mask
 					& ChannelTypeToChannelMask(
 						fMixerChannelInfo[i].destination_type)) {
-				fMixerChannelInfo[i].buffer_base = fMixBuffer ? &fMixBuffer[j]
-					: 0;
+				fMixerChannelInfo[i].buffer_base = fMixBuffer
+					? &fMixBuffer[j * fMixBufferFrameCount] : 0;
 				break;
 			}
 		}
@@ -726,8 +734,11 @@ MixerInput::SetMixBufferFormat(int32 framerate, int32 frames)
 
 	memset(fMixBuffer, 0, size);
 
+	// The channels are stored one after the other, so that they can be mixed
+	// with vector instructions.
 	for (int i = 0; i < fInputChannelCount; i++)
-		fInputChannelInfo[i].buffer_base = &fMixBuffer[i];
+		fInputChannelInfo[i].buffer_base
+			= &fMixBuffer[i * fMixBufferFrameCount];
 
 	_UpdateInputChannelDestinationMask();
 	_UpdateInputChannelDestinations();
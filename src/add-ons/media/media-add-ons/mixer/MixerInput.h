@@ -160,8 +160,8 @@ MixerInput::GetMixerChannelInfo(int mixerChannel, int64 framepos,
 	}
 	*buffer = reinterpret_cast<float*>(reinterpret_cast<char*>(
 		fMixerChannelInfo[mixerChannel].buffer_base)
-		+ (offset * sizeof(float) * fInputChannelCount));
-	*sampleOffset = sizeof(float) * fInputChannelCount;
+		+ (offset * sizeof(float)));
+	*sampleOffset = sizeof(float);
 	*type = fMixerChannelInfo[mixerChannel].destination_type;
 	*gain = fMixerChannelInfo[mixerChannel].destination_gain;
 	return true;
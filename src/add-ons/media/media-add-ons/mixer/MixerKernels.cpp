@@ -0,0 +1,539 @@
+/*
+ * Copyright 2026 Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include "MixerKernels.h"
+
+#include <pthread.h>
+
+#include <MediaDefs.h>
+#include <OS.h>
+
+#if (defined(__i386__) || defined(__x86_64__)) && __GNUC__ >= 5
+#	define MIXER_X86_KERNELS 1
+#	include <immintrin.h>
+#endif
+
+
+// #pragma mark - generic
+
+
+static void
+mix_generic(float* dest, const float* src, float gain, int32 sampleCount)
+{
+	for (int32 i = 0; i < sampleCount; i++)
+		dest[i] += src[i] * gain;
+}
+
+
+static float
+dot_product_generic(const float* a, const float* b, int32 count)
+{
+	float sum = 0;
+	for (int32 i = 0; i < count; i++)
+		sum += a[i] * b[i];
+	return sum;
+}
+
+
+static void
+interpolate_generic(float* dest, const float* src, float delta, int32 first,
+	int32 count, float gain, float min, float max)
+{
+	for (int32 i = 0; i < count; i++) {
+		float position = float(first + i) * delta;
+		int32 base = (int32)position;
+		float fraction = position - base;
+
+		float tmp = (src[base] + (src[base + 1] - src[base]) * fraction) * gain;
+		if (tmp < min)
+			tmp = min;
+		if (tmp > max)
+			tmp = max;
+		dest[i] = tmp;
+	}
+}
+
+
+static const mixer_kernels kGenericKernels = {
+	MIXER_KERNELS_GENERIC,
+	"generic",
+	&mix_generic,
+	&dot_product_generic,
+	&interpolate_generic,
+	NULL, NULL, NULL, NULL, NULL
+};
+
+
+#ifdef MIXER_X86_KERNELS
+
+
+// #pragma mark - SSE2
+
+
+/*!	The same conversion as the Resampler does without resampling, for when
+	neither side is contiguous.
+*/
+template<typename inType, typename outType, int gnum, int gden, int32 min,
+	int32 max> static void
+convert_generic(const void* _src, int32 srcSampleOffset, void* _dest,
+	int32 destSampleOffset, int32 count, float _gain)
+{
+	const char* src = (const char*)_src;
+	char* dest = (char*)_dest;
+	float gain = _gain * gnum / gden;
+
+	while (count--) {
+		float tmp = *(const inType*)src * gain;
+		if (tmp < min)
+			tmp = min;
+		if (tmp > max)
+			tmp = max;
+		*(outType*)dest = (outType)tmp;
+		src += srcSampleOffset;
+		dest += destSampleOffset;
+	}
+}
+
+
+static inline __attribute__((target("sse2"))) __m128
+clamp_sse2(__m128 values, __m128 min, __m128 max)
+{
+	return _mm_min_ps(_mm_max_ps(values, min), max);
+}
+
+
+static inline __attribute__((target("sse2"))) __m128
+load_strided_sse2(const float* src, int32 sampleOffset)
+{
+	const char* bytes = (const char*)src;
+	return _mm_setr_ps(*src, *(const float*)(bytes + sampleOffset),
+		*(const float*)(bytes + 2 * sampleOffset),
+		*(const float*)(bytes + 3 * sampleOffset));
+}
+
+
+template<typename inType> static inline __attribute__((target("sse2"))) __m128
+load_strided_sse2(const inType* src, int32 sampleOffset)
+{
+	const char* bytes = (const char*)src;
+	return _mm_cvtepi32_ps(_mm_setr_epi32(*src,
+		*(const inType*)(bytes + sampleOffset),
+		*(const inType*)(bytes + 2 * sampleOffset),
+		*(const inType*)(bytes + 3 * sampleOffset)));
+}
+
+
+static inline __attribute__((target("sse2"))) void
+store_strided_sse2(__m128 values, float* dest, int32 sampleOffset)
+{
+	float results[4];
+	_mm_storeu_ps(results, values);
+
+	char* bytes = (char*)dest;
+	for (int i = 0; i < 4; i++)
+		*(float*)(bytes + i * sampleOffset) = results[i];
+}
+
+
+template<typename outType> static inline __attribute__((target("sse2"))) void
+store_strided_sse2(__m128 values, outType* dest, int32 sampleOffset)
+{
+	// Truncates like the cast does. Values clamped to INT32_MAX are rounded up
+	// to 2^31 and would wrap around, saturate them instead.
+	__m128 overflow = _mm_cmpge_ps(values, _mm_set1_ps(2147483648.0f));
+	int32 results[4];
+	_mm_storeu_si128((__m128i*)results, _mm_xor_si128(
+		_mm_cvttps_epi32(values), _mm_castps_si128(overflow)));
+
+	char* bytes = (char*)dest;
+	for (int i = 0; i < 4; i++)
+		*(outType*)(bytes + i * sampleOffset) = (outType)results[i];
+}
+
+
+/*!	Converts from a format with strided samples (like a channel of an
+	interleaved buffer) to contiguous floats.
+*/
+template<typename inType, int gnum, int gden> static void
+	__attribute__((target("sse2")))
+convert_to_float_sse2(const void* _src, int32 srcSampleOffset, void* _dest,
+	int32 destSampleOffset, int32 count, float _gain)
+{
+	if (destSampleOffset != sizeof(float)) {
+		convert_generic<inType, float, gnum, gden, -1, 1>(_src,
+			srcSampleOffset, _dest, destSampleOffset, count, _gain);
+		return;
+	}
+
+	const char* src = (const char*)_src;
+	float* dest = (float*)_dest;
+	float gain = _gain * gnum / gden;
+
+	const __m128 gainVector = _mm_set1_ps(gain);
+	const __m128 minVector = _mm_set1_ps(-1.0f);
+	const __m128 maxVector = _mm_set1_ps(1.0f);
+
+	int32 i = 0;
+	for (; i + 4 <= count; i += 4) {
+		__m128 values = load_strided_sse2((const inType*)src,
+			srcSampleOffset);
+		src += 4 * srcSampleOffset;
+
+		_mm_storeu_ps(dest + i, clamp_sse2(_mm_mul_ps(values, gainVector),
+			minVector, maxVector));
+	}
+
+	for (; i < count; i++) {
+		float tmp = *(const inType*)src * gain;
+		if (tmp < -1)
+			tmp = -1;
+		if (tmp > 1)
+			tmp = 1;
+		dest[i] = tmp;
+		src += srcSampleOffset;
+	}
+}
+
+
+/*!	Converts from contiguous floats to a format with strided samples. */
+template<typename outType, int gnum, int gden, int32 min, int32 max>
+	static void __attribute__((target("sse2")))
+convert_from_float_sse2(const void* _src, int32 srcSampleOffset, void* _dest,
+	int32 destSampleOffset, int32 count, float _gain)
+{
+	if (srcSampleOffset != sizeof(float)) {
+		convert_generic<float, outType, gnum, gden, min, max>(_src,
+			srcSampleOffset, _dest, destSampleOffset, count, _gain);
+		return;
+	}
+
+	const float* src = (const float*)_src;
+	char* dest = (char*)_dest;
+	float gain = _gain * gnum / gden;
+
+	const __m128 gainVector = _mm_set1_ps(gain);
+	const __m128 minVector = _mm_set1_ps(min);
+	const __m128 maxVector = _mm_set1_ps(max);
+
+	int32 i = 0;
+	for (; i + 4 <= count; i += 4) {
+		__m128 values = clamp_sse2(_mm_mul_ps(_mm_loadu_ps(src + i),
+			gainVector), minVector, maxVector);
+		store_strided_sse2(values, (outType*)dest, destSampleOffset);
+		dest += 4 * destSampleOffset;
+	}
+
+	for (; i < count; i++) {
+		float tmp = src[i] * gain;
+		if (tmp < min)
+			tmp = min;
+		if (tmp > max)
+			tmp = max;
+		*(outType*)dest = (outType)tmp;
+		dest += destSampleOffset;
+	}
+}
+
+
+static void
+convert_float_to_float_sse2(const void* src, int32 srcSampleOffset,
+	void* dest, int32 destSampleOffset, int32 count, float gain)
+{
+	if (destSampleOffset == sizeof(float)) {
+		convert_to_float_sse2<float, 1, 1>(src, srcSampleOffset, dest,
+			destSampleOffset, count, gain);
+	} else {
+		convert_from_float_sse2<float, 1, 1, -1, 1>(src, srcSampleOffset, dest,
+			destSampleOffset, count, gain);
+	}
+}
+
+
+static void __attribute__((target("sse2")))
+mix_sse2(float* dest, const float* src, float gain, int32 sampleCount)
+{
+	const __m128 gainVector = _mm_set1_ps(gain);
+
+	int32 i = 0;
+	for (; i + 8 <= sampleCount; i += 8) {
+		__m128 a = _mm_add_ps(_mm_loadu_ps(dest + i),
+			_mm_mul_ps(_mm_loadu_ps(src + i), gainVector));
+		__m128 b = _mm_add_ps(_mm_loadu_ps(dest + i + 4),
+			_mm_mul_ps(_mm_loadu_ps(src + i + 4), gainVector));
+		_mm_storeu_ps(dest + i, a);
+		_mm_storeu_ps(dest + i + 4, b);
+	}
+
+	for (; i < sampleCount; i++)
+		dest[i] += src[i] * gain;
+}
+
+
+static float __attribute__((target("sse2")))
+dot_product_sse2(const float* a, const float* b, int32 count)
+{
+	__m128 sum0 = _mm_setzero_ps();
+	__m128 sum1 = _mm_setzero_ps();
+	for (int32 i = 0; i < count; i += 8) {
+		sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(a + i),
+			_mm_loadu_ps(b + i)));
+		sum1 = _mm_add_ps(sum1, _mm_mul_ps(_mm_loadu_ps(a + i + 4),
+			_mm_loadu_ps(b + i + 4)));
+	}
+
+	__m128 sum = _mm_add_ps(sum0, sum1);
+	sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+	sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+	return _mm_cvtss_f32(sum);
+}
+
+
+/*!	Without gathers, the samples on both sides of the positions are loaded one
+	by one; the positions and the interpolation itself are vectorized.
+*/
+static void __attribute__((target("sse2")))
+interpolate_sse2(float* dest, const float* src, float delta, int32 first,
+	int32 count, float gain, float min, float max)
+{
+	const __m128 deltaVector = _mm_set1_ps(delta);
+	const __m128 gainVector = _mm_set1_ps(gain);
+	const __m128 minVector = _mm_set1_ps(min);
+	const __m128 maxVector = _mm_set1_ps(max);
+	__m128i index = _mm_setr_epi32(first, first + 1, first + 2, first + 3);
+
+	int32 i = 0;
+	for (; i + 4 <= count; i += 4) {
+		__m128 position = _mm_mul_ps(_mm_cvtepi32_ps(index), deltaVector);
+		__m128i base = _mm_cvttps_epi32(position);
+		__m128 fraction = _mm_sub_ps(position, _mm_cvtepi32_ps(base));
+		index = _mm_add_epi32(index, _mm_set1_epi32(4));
+
+		int32 bases[4];
+		_mm_storeu_si128((__m128i*)bases, base);
+		__m128 a = _mm_setr_ps(src[bases[0]], src[bases[1]], src[bases[2]],
+			src[bases[3]]);
+		__m128 b = _mm_setr_ps(src[bases[0] + 1], src[bases[1] + 1],
+			src[bases[2] + 1], src[bases[3] + 1]);
+
+		__m128 values = _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), fraction));
+		_mm_storeu_ps(dest + i, clamp_sse2(_mm_mul_ps(values, gainVector),
+			minVector, maxVector));
+	}
+
+	interpolate_generic(dest + i, src, delta, first + i, count - i, gain, min,
+		max);
+}
+
+
+static const mixer_kernels kSSE2Kernels = {
+	MIXER_KERNELS_SSE2,
+	"SSE2",
+	&mix_sse2,
+	&dot_product_sse2,
+	&interpolate_sse2,
+	&convert_float_to_float_sse2,
+	&convert_to_float_sse2<int32, 1, INT32_MAX>,
+	&convert_to_float_sse2<int16, 1, INT16_MAX>,
+	&convert_from_float_sse2<int32, INT32_MAX, 1, INT32_MIN, INT32_MAX>,
+	&convert_from_float_sse2<int16, INT16_MAX, 1, INT16_MIN, INT16_MAX>
+};
+
+
+// #pragma mark - AVX2
+
+
+static void __attribute__((target("avx2")))
+mix_avx2(float* dest, const float* src, float gain, int32 sampleCount)
+{
+	const __m256 gainVector = _mm256_set1_ps(gain);
+
+	int32 i = 0;
+	for (; i + 16 <= sampleCount; i += 16) {
+		__m256 a = _mm256_add_ps(_mm256_loadu_ps(dest + i),
+			_mm256_mul_ps(_mm256_loadu_ps(src + i), gainVector));
+		__m256 b = _mm256_add_ps(_mm256_loadu_ps(dest + i + 8),
+			_mm256_mul_ps(_mm256_loadu_ps(src + i + 8), gainVector));
+		_mm256_storeu_ps(dest + i, a);
+		_mm256_storeu_ps(dest + i + 8, b);
+	}
+
+	for (; i < sampleCount; i++)
+		dest[i] += src[i] * gain;
+}
+
+
+static float __attribute__((target("avx2")))
+dot_product_avx2(const float* a, const float* b, int32 count)
+{
+	__m256 sum = _mm256_setzero_ps();
+	for (int32 i = 0; i < count; i += 8) {
+		sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_loadu_ps(a + i),
+			_mm256_loadu_ps(b + i)));
+	}
+
+	__m128 half = _mm_add_ps(_mm256_castps256_ps128(sum),
+		_mm256_extractf128_ps(sum, 1));
+	half = _mm_add_ps(half, _mm_movehl_ps(half, half));
+	half = _mm_add_ss(half, _mm_shuffle_ps(half, half, 1));
+	return _mm_cvtss_f32(half);
+}
+
+
+static void __attribute__((target("avx2")))
+interpolate_avx2(float* dest, const float* src, float delta, int32 first,
+	int32 count, float gain, float min, float max)
+{
+	const __m256 deltaVector = _mm256_set1_ps(delta);
+	const __m256 gainVector = _mm256_set1_ps(gain);
+	const __m256 minVector = _mm256_set1_ps(min);
+	const __m256 maxVector = _mm256_set1_ps(max);
+	__m256i index = _mm256_add_epi32(_mm256_set1_epi32(first),
+		_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+
+	int32 i = 0;
+	for (; i + 8 <= count; i += 8) {
+		__m256 position = _mm256_mul_ps(_mm256_cvtepi32_ps(index),
+			deltaVector);
+		__m256i base = _mm256_cvttps_epi32(position);
+		__m256 fraction = _mm256_sub_ps(position, _mm256_cvtepi32_ps(base));
+		index = _mm256_add_epi32(index, _mm256_set1_epi32(8));
+
+		__m256 a = _mm256_i32gather_ps(src, base, sizeof(float));
+		__m256 b = _mm256_i32gather_ps(src + 1, base, sizeof(float));
+
+		__m256 values = _mm256_add_ps(a,
+			_mm256_mul_ps(_mm256_sub_ps(b, a), fraction));
+		values = _mm256_min_ps(_mm256_max_ps(
+			_mm256_mul_ps(values, gainVector), minVector), maxVector);
+		_mm256_storeu_ps(dest + i, values);
+	}
+
+	interpolate_generic(dest + i, src, delta, first + i, count - i, gain, min,
+		max);
+}
+
+
+// The conversions are bound by the strided accesses, wider vectors don't help
+// them.
+static const mixer_kernels kAVX2Kernels = {
+	MIXER_KERNELS_AVX2,
+	"AVX2",
+	&mix_avx2,
+	&dot_product_avx2,
+	&interpolate_avx2,
+	&convert_float_to_float_sse2,
+	&convert_to_float_sse2<int32, 1, INT32_MAX>,
+	&convert_to_float_sse2<int16, 1, INT16_MAX>,
+	&convert_from_float_sse2<int32, INT32_MAX, 1, INT32_MIN, INT32_MAX>,
+	&convert_from_float_sse2<int16, INT16_MAX, 1, INT16_MIN, INT16_MAX>
+};
+
+
+#endif	// MIXER_X86_KERNELS
+
+
+// #pragma mark - selection
+
+
+static pthread_once_t sInitOnce = PTHREAD_ONCE_INIT;
+static int32 sSupportedLevel = MIXER_KERNELS_GENERIC;
+static const mixer_kernels* sKernels = &kGenericKernels;
+
+
+static void
+init_mixer_kernels()
+{
+#ifdef MIXER_X86_KERNELS
+	cpuid_info info;
+	if (get_cpuid(&info, 0, 0) != B_OK)
+		return;
+	uint32 maxLeaf = info.eax_0.max_eax;
+
+	if (maxLeaf < 1 || get_cpuid(&info, 1, 0) != B_OK
+		|| (info.regs.edx & (1 << 26)) == 0) {
+		// no SSE2
+		return;
+	}
+
+	sSupportedLevel = MIXER_KERNELS_SSE2;
+
+	// AVX2 also requires the OS to save the AVX registers
+	const uint32 kOSXSAVE = 1 << 27;
+	const uint32 kAVX = 1 << 28;
+	if ((info.regs.ecx & (kOSXSAVE | kAVX)) == (kOSXSAVE | kAVX)) {
+		uint32 low;
+		uint32 high;
+		__asm__ __volatile__("xgetbv" : "=a" (low), "=d" (high) : "c" (0));
+		if ((low & 0x6) == 0x6 && maxLeaf >= 7
+			&& get_cpuid(&info, 7, 0) == B_OK
+			&& (info.regs.ebx & (1 << 5)) != 0) {
+			sSupportedLevel = MIXER_KERNELS_AVX2;
+		}
+	}
+
+	sKernels = sSupportedLevel == MIXER_KERNELS_AVX2
+		? &kAVX2Kernels : &kSSE2Kernels;
+#endif
+}
+
+
+const mixer_kernels&
+get_mixer_kernels()
+{
+	pthread_once(&sInitOnce, &init_mixer_kernels);
+	return *sKernels;
+}
+
+
+void
+select_mixer_kernels(int32 level)
+{
+	pthread_once(&sInitOnce, &init_mixer_kernels);
+
+	if (level > sSupportedLevel)
+		level = sSupportedLevel;
+
+	switch (level) {
+#ifdef MIXER_X86_KERNELS
+		case MIXER_KERNELS_AVX2:
+			sKernels = &kAVX2Kernels;
+			break;
+		case MIXER_KERNELS_SSE2:
+			sKernels = &kSSE2Kernels;
+			break;
+#endif
+		default:
+			sKernels = &kGenericKernels;
+			break;
+	}
+}
+
+
+mixer_convert_func
+find_convert_function(uint32 sourceFormat, uint32 destFormat)
+{
+	const mixer_kernels& kernels = get_mixer_kernels();
+
+	if (destFormat == media_raw_audio_format::B_AUDIO_FLOAT) {
+		switch (sourceFormat) {
+			case media_raw_audio_format::B_AUDIO_FLOAT:
+				return kernels.float_to_float;
+			case media_raw_audio_format::B_AUDIO_INT:
+				return kernels.int32_to_float;
+			case media_raw_audio_format::B_AUDIO_SHORT:
+				return kernels.int16_to_float;
+		}
+	} else if (sourceFormat == media_raw_audio_format::B_AUDIO_FLOAT) {
+		switch (destFormat) {
+			case media_raw_audio_format::B_AUDIO_INT:
+				return kernels.float_to_int32;
+			case media_raw_audio_format::B_AUDIO_SHORT:
+				return kernels.float_to_int16;
+		}
+	}
+
+	return NULL;
+}
@@ -0,0 +1,63 @@
+/*
+ * Copyright 2026 Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef _MIXER_KERNELS_H
+#define _MIXER_KERNELS_H
+
+
+#include <SupportDefs.h>
+
+
+enum {
+	MIXER_KERNELS_GENERIC	= 0,
+	MIXER_KERNELS_SSE2,
+	MIXER_KERNELS_AVX2
+};
+
+
+typedef void (*mixer_convert_func)(const void* src, int32 srcSampleOffset,
+	void* dest, int32 destSampleOffset, int32 sampleCount, float gain);
+
+
+/*!	The mixer's inner loops. Besides the generic versions, there are versions
+	using SSE2 and AVX2, of which the best one the CPU supports is selected
+	at runtime.
+*/
+struct mixer_kernels {
+	int32				level;
+	const char*			name;
+
+	void				(*mix)(float* dest, const float* src, float gain,
+							int32 sampleCount);
+							// dest += src * gain
+	float				(*dot_product)(const float* a, const float* b,
+							int32 count);
+							// count must be a multiple of 8
+	void				(*interpolate)(float* dest, const float* src,
+							float delta, int32 first, int32 count, float gain,
+							float min, float max);
+							// dest[i] = src linearly interpolated at
+							// (first + i) * delta, times gain, clamped to
+							// [min, max]; reads one sample past the position
+
+	// Format conversions without resampling, equivalent to the Resampler's.
+	// NULL in the generic kernels, since the Resampler's are just as good.
+	mixer_convert_func	float_to_float;
+	mixer_convert_func	int32_to_float;
+	mixer_convert_func	int16_to_float;
+	mixer_convert_func	float_to_int32;
+	mixer_convert_func	float_to_int16;
+};
+
+
+const mixer_kernels&	get_mixer_kernels();
+void					select_mixer_kernels(int32 level);
+							// for testing; the level is lowered to what
+							// the CPU supports
+
+mixer_convert_func		find_convert_function(uint32 sourceFormat,
+							uint32 destFormat);
+
+
+#endif	// _MIXER_KERNELS_H
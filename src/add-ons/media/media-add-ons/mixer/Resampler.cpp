@@ -64,7 +64,8 @@ kernel(Resampler* object, const void *_src, int32 srcSampleOffset,
 
 Resampler::Resampler(uint32 src_format, uint32 dst_format)
 	:
-	fFunc(0)
+	fFunc(0),
+	fConvert(find_convert_function(src_format, dst_format))
 {
 	if (dst_format == media_raw_audio_format::B_AUDIO_FLOAT) {
 		switch (src_format) {
@@ -123,7 +124,13 @@ Resampler::Resampler(uint32 src_format, uint32 dst_format)
 
 Resampler::Resampler()
 	:
-	fFunc(0)
+	fFunc(0),
+	fConvert(NULL)
+{
+}
+
+
+Resampler::~Resampler()
 {
 }
 
@@ -8,11 +8,14 @@
 
 #include <SupportDefs.h>
 
+#include "MixerKernels.h"
+
 
 class Resampler {
 public:
 								Resampler(uint32 sourceFormat,
 									uint32 destFormat);
+	virtual						~Resampler();
 
 			status_t			InitCheck() const;
 
@@ -27,6 +30,8 @@ protected:
 									int32 srcSampleOffset, int32 srcSampleCount,
 									void* dest, int32 destSampleOffset,
 									int32 destSampleCount, float gain);
+			mixer_convert_func	fConvert;
+				// faster conversion without resampling, if available
 };
 
 
@@ -35,6 +40,12 @@ Resampler::Resample(const void *src, int32 srcSampleOffset,
 	int32 srcSampleCount, void *dest, int32 destSampleOffset,
 	int32 destSampleCount, float gain)
 {
+	if (fConvert != NULL && srcSampleCount == destSampleCount) {
+		(*fConvert)(src, srcSampleOffset, dest, destSampleOffset,
+			destSampleCount, gain);
+		return;
+	}
+
 	(*fFunc)(this, src, srcSampleOffset, srcSampleCount, dest, destSampleOffset,
 		destSampleCount, gain);
 }
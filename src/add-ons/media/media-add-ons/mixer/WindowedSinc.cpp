@@ -0,0 +1,225 @@
+/*
+ * Copyright 2026, Haiku, Inc.
+ * Distributed under the terms of the MIT Licence.
+ */
+
+
+#include "WindowedSinc.h"
+
+#include <math.h>
+#include <string.h>
+
+#include <MediaDefs.h>
+#include <RealtimeAlloc.h>
+
+#include "MixerDebug.h"
+
+
+/*!	Resampling class using a windowed sinc filter.
+
+	The filter has kTaps taps and is tabulated for kPhases fractional source
+	positions. When downsampling, its cutoff is lowered to the destination's
+	Nyquist frequency, so that there is less aliasing than with the
+	interpolating resamplers. The output is delayed by kTaps / 2 source
+	samples, with or without resampling.
+
+	The source samples are converted into a buffer from the realtime pool,
+	that is allocated up front for buffers of up to \a maxSourceCount
+	samples, so that the mixer thread doesn't have to allocate memory.
+*/
+
+
+WindowedSinc::WindowedSinc(uint32 src_format, uint32 dst_format,
+	int32 maxSourceCount)
+	:
+	Resampler(),
+	fSamples(NULL),
+	fSamplesCapacity(0),
+	fCutoff(0),
+	fDotProduct(get_mixer_kernels().dot_product)
+{
+	memset(fHistory, 0, sizeof(fHistory));
+	_UpdateFilter(1.0f);
+	_GrowSamples(maxSourceCount + kTaps - 1);
+
+	if (dst_format == media_raw_audio_format::B_AUDIO_FLOAT) {
+		switch (src_format) {
+			case media_raw_audio_format::B_AUDIO_FLOAT:
+				fFunc = &_Kernel<float, float, 1, 1, 0, -1, 1>;
+				return;
+			case media_raw_audio_format::B_AUDIO_INT:
+				fFunc = &_Kernel<int32, float, 1, INT32_MAX, 0, -1, 1>;
+				return;
+			case media_raw_audio_format::B_AUDIO_SHORT:
+				fFunc = &_Kernel<int16, float, 1, INT16_MAX, 0, -1, 1>;
+				return;
+			case media_raw_audio_format::B_AUDIO_CHAR:
+				fFunc = &_Kernel<int8, float, 1, INT8_MAX, 0, -1, 1>;
+				return;
+			case media_raw_audio_format::B_AUDIO_UCHAR:
+				fFunc = &_Kernel<uint8, float, 2, UINT8_MAX, -128, -1, 1>;
+				return;
+			default:
+				ERROR("WindowedSinc::WindowedSinc: unknown source format "
+					"0x%x\n", src_format);
+				return;
+		}
+	}
+
+	if (src_format == media_raw_audio_format::B_AUDIO_FLOAT) {
+		switch (dst_format) {
+			// float=>float already handled above
+			case media_raw_audio_format::B_AUDIO_INT:
+				fFunc = &_Kernel<float, int32, INT32_MAX, 1, 0,
+					INT32_MIN, INT32_MAX>;
+				return;
+			case media_raw_audio_format::B_AUDIO_SHORT:
+				fFunc = &_Kernel<float, int16, INT16_MAX, 1, 0,
+					INT16_MIN, INT16_MAX>;
+				return;
+			case media_raw_audio_format::B_AUDIO_CHAR:
+				fFunc = &_Kernel<float, int8, INT8_MAX, 1, 0,
+					INT8_MIN, INT8_MAX>;
+				return;
+			case media_raw_audio_format::B_AUDIO_UCHAR:
+				fFunc = &_Kernel<float, uint8, UINT8_MAX, 2, 1,
+					0, UINT8_MAX>;
+				return;
+			default:
+				ERROR("WindowedSinc::WindowedSinc: unknown destination format "
+					"0x%x\n", dst_format);
+				return;
+		}
+	}
+
+	ERROR("WindowedSinc::WindowedSinc: source or destination format must be "
+		"B_AUDIO_FLOAT\n");
+}
+
+
+WindowedSinc::~WindowedSinc()
+{
+	rtm_free(fSamples);
+}
+
+
+template<typename inType, typename outType, int gnum, int gden, int offset,
+	int32 min, int32 max> /*static*/ void
+WindowedSinc::_Kernel(Resampler* object, const void* _src,
+	int32 srcSampleOffset, int32 srcSampleCount, void* _dest,
+	int32 destSampleOffset, int32 destSampleCount, float _gain)
+{
+	WindowedSinc* self = (WindowedSinc*)object;
+	const char* src = (const char*)_src;
+	char* dest = (char*)_dest;
+	float gain = _gain * gnum / gden;
+
+	// The filter needs the last kTaps - 1 samples of the previous buffer in
+	// front of this one's, and all of them as contiguous floats.
+	int32 sampleCount = srcSampleCount + kTaps - 1;
+	float* samples = self->_GrowSamples(sampleCount);
+	if (samples == NULL) {
+		ERROR("WindowedSinc::_Kernel: out of memory\n");
+		for (int32 i = 0; i < destSampleCount; i++) {
+			float tmp = offset;
+			if (tmp < min) tmp = min;
+			if (tmp > max) tmp = max;
+			*(outType*)dest = (outType)tmp;
+			dest += destSampleOffset;
+		}
+		return;
+	}
+
+	memcpy(samples, self->fHistory, sizeof(self->fHistory));
+	for (int32 i = kTaps - 1; i < sampleCount; i++) {
+		samples[i] = *(const inType*)src;
+		src += srcSampleOffset;
+	}
+	memcpy(self->fHistory, samples + srcSampleCount, sizeof(self->fHistory));
+
+	if (srcSampleCount == destSampleCount) {
+		// no resampling, just delay like the filter does
+		const float* sample = samples + kTaps / 2 - 1;
+		for (int32 i = 0; i < destSampleCount; i++) {
+			float tmp = sample[i] * gain + offset;
+			if (tmp < min) tmp = min;
+			if (tmp > max) tmp = max;
+			*(outType*)dest = (outType)tmp;
+			dest += destSampleOffset;
+		}
+		return;
+	}
+
+	float delta = float(srcSampleCount) / float(destSampleCount);
+	self->_UpdateFilter(delta);
+
+	for (int32 i = 0; i < destSampleCount; i++) {
+		float position = i * delta;
+		int32 base = (int32)position;
+		if (base > srcSampleCount - 1)
+			base = srcSampleCount - 1;
+		int32 phase = (int32)((position - base) * kPhases);
+		if (phase > kPhases - 1)
+			phase = kPhases - 1;
+
+		float tmp = self->fDotProduct(samples + base,
+			self->fFilter + phase * kTaps, kTaps) * gain + offset;
+		if (tmp < min) tmp = min;
+		if (tmp > max) tmp = max;
+		*(outType*)dest = (outType)tmp;
+		dest += destSampleOffset;
+	}
+}
+
+
+float*
+WindowedSinc::_GrowSamples(int32 count)
+{
+	if (count > fSamplesCapacity) {
+		// only happens if a buffer is larger than announced
+		float* samples = (float*)rtm_alloc(NULL, count * sizeof(float));
+		if (samples == NULL)
+			return NULL;
+
+		rtm_free(fSamples);
+		fSamples = samples;
+		fSamplesCapacity = count;
+	}
+
+	return fSamples;
+}
+
+
+void
+WindowedSinc::_UpdateFilter(float delta)
+{
+	// Leave some room below the Nyquist frequency, as the filter is short.
+	float cutoff = (delta > 1.0f ? 1.0f / delta : 1.0f) * 0.95f;
+	if (fabsf(cutoff - fCutoff) <= fCutoff * 0.01f)
+		return;
+
+	fCutoff = cutoff;
+
+	const int32 kCenter = kTaps / 2 - 1;
+	for (int32 phase = 0; phase < kPhases; phase++) {
+		float* filter = fFilter + phase * kTaps;
+		float fraction = float(phase) / kPhases;
+		float sum = 0;
+
+		for (int32 tap = 0; tap < kTaps; tap++) {
+			// distance from the output position, in source samples
+			double x = tap - kCenter - fraction;
+			double sinc = x == 0 ? 1.0
+				: sin(M_PI * cutoff * x) / (M_PI * cutoff * x);
+			double window = 0.42 + 0.5 * cos(M_PI * x / (kTaps / 2))
+				+ 0.08 * cos(2 * M_PI * x / (kTaps / 2));
+
+			filter[tap] = sinc * window;
+			sum += filter[tap];
+		}
+
+		// unity gain at DC
+		for (int32 tap = 0; tap < kTaps; tap++)
+			filter[tap] /= sum;
+	}
+}
@@ -0,0 +1,43 @@
+/*
+ * Copyright 2026, Haiku, Inc.
+ * Distributed under the terms of the MIT Licence.
+ */
+#ifndef _WINDOWED_SINC_H
+#define _WINDOWED_SINC_H
+
+
+#include "Resampler.h"
+
+
+class WindowedSinc : public Resampler {
+public:
+								WindowedSinc(uint32 sourceFormat,
+									uint32 destFormat, int32 maxSourceCount);
+	virtual						~WindowedSinc();
+
+private:
+	static	const int32			kTaps = 16;
+	static	const int32			kPhases = 256;
+
+			template<typename inType, typename outType, int gnum, int gden,
+				int offset, int32 min, int32 max>
+	static	void				_Kernel(Resampler* object, const void* src,
+									int32 srcSampleOffset, int32 srcSampleCount,
+									void* dest, int32 destSampleOffset,
+									int32 destSampleCount, float gain);
+
+			float*				_GrowSamples(int32 count);
+			void				_UpdateFilter(float delta);
+
+private:
+			float				fHistory[kTaps - 1];
+			float*				fSamples;
+			int32				fSamplesCapacity;
+			float				fFilter[kTaps * kPhases];
+			float				fCutoff;
+			float				(*fDotProduct)(const float* a, const float* b,
+									int32 count);
+};
+
+
+#endif	// _WINDOWED_SINC_H
@@ -34,6 +34,8 @@ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <syslog.h>
 
+#include <algorithm>
+
 #include <Alignment.h>
 #include <Catalog.h>
 #include <LayoutBuilder.h>
@@ -61,7 +63,7 @@ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define B_TRANSLATOR_BITMAP_DESCRIPTION "Be Bitmap Format (JPEGTranslator)"
 
 
-static const int32 sTranslatorVersion = B_TRANSLATION_MAKE_VERSION(1, 2, 0);
+static const int32 sTranslatorVersion = B_TRANSLATION_MAKE_VERSION(1, 3, 0);
 
 static const char* sTranslatorName = B_TRANSLATE("JPEG images");
 static const char* sTranslatorInfo = B_TRANSLATE("©2002-2003, Marcin Konicki\n"
@@ -1136,9 +1138,6 @@ JPEGTranslator::Decompress(BPositionIO* in, BPositionIO* out,
 		}
 	}
 
-	// Initialize decompression
-	jpeg_start_decompress(&cinfo);
-
 	// retrieve orientation from settings/EXIF
 	int32 orientation;
 	if (ioExtension == NULL
@@ -1147,6 +1146,31 @@ JPEGTranslator::Decompress(BPositionIO* in, BPositionIO* out,
 			orientation = 1;
 	}
 
+	// If the caller is going to scale the bitmap down anyway, let libjpeg
+	// decode it at a fraction of its size, as long as it is still at least
+	// as large as requested. This skips most of the IDCT work.
+	BRect sizeHint;
+	if (ioExtension != NULL
+		&& ioExtension->FindRect(B_TRANSLATOR_EXT_BITMAP_SIZE_HINT,
+			&sizeHint) == B_OK && sizeHint.IsValid()) {
+		uint32 wantedWidth = sizeHint.IntegerWidth() + 1;
+		uint32 wantedHeight = sizeHint.IntegerHeight() + 1;
+		if (orientation > 4)
+			std::swap(wantedWidth, wantedHeight);
+
+		for (uint32 denom = 8; denom > 1; denom /= 2) {
+			if ((cinfo.image_width + denom - 1) / denom >= wantedWidth
+				&& (cinfo.image_height + denom - 1) / denom >= wantedHeight) {
+				cinfo.scale_num = 1;
+				cinfo.scale_denom = denom;
+				break;
+			}
+		}
+	}
+
+	// Initialize decompression
+	jpeg_start_decompress(&cinfo);
+
 	if (orientation != 1 && converter == NULL)
 		converter = translate_8;
 
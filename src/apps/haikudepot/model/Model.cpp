@@ -242,15 +242,10 @@ public:
 		if (package.Get() == NULL)
 			return false;
 		// Every search term must be found in one of the package texts
+		const BString& text = package->SearchText();
 		for (int32 i = fSearchTerms.CountItems() - 1; i >= 0; i--) {
-			const BString& term = fSearchTerms.ItemAtFast(i);
-			if (!_TextContains(package->Name(), term)
-				&& !_TextContains(package->Title(), term)
-				&& !_TextContains(package->Publisher().Name(), term)
-				&& !_TextContains(package->ShortDescription(), term)
-				&& !_TextContains(package->FullDescription(), term)) {
+			if (text.FindFirst(fSearchTerms.ItemAtFast(i)) < 0)
 				return false;
-			}
 		}
 		return true;
 	}
@@ -269,14 +264,6 @@ public:
 		return searchTerms;
 	}
 
-private:
-	bool _TextContains(BString text, const BString& string) const
-	{
-		text.ToLower();
-		int32 index = text.FindFirst(string);
-		return index >= 0;
-	}
-
 private:
 	StringList fSearchTerms;
 };
@@ -9,6 +9,8 @@
 
 #include <stdio.h>
 
+#include <vector>
+
 #include <FindDirectory.h>
 #include <package/PackageDefs.h>
 #include <package/PackageFlags.h>
@@ -532,6 +534,7 @@ PackageInfo::PackageInfo(const BPackageInfo& info)
 		publisherName.Prepend("© ");
 
 	fPublisher = PublisherInfo(BitmapRef(), publisherName, "", publisherURL);
+	_UpdateSearchText();
 }
 
 
@@ -566,6 +569,7 @@ PackageInfo::PackageInfo(const BString& name,
 	fIsCollatingChanges(false),
 	fCollatedChanges(0)
 {
+	_UpdateSearchText();
 }
 
 
@@ -595,6 +599,7 @@ PackageInfo::PackageInfo(const PackageInfo& other)
 	fFileName(other.fFileName),
 	fSize(other.fSize),
 	fDepotName(other.fDepotName),
+	fSearchText(other.fSearchText),
 	fIsCollatingChanges(false),
 	fCollatedChanges(0)
 {
@@ -627,6 +632,7 @@ PackageInfo::operator=(const PackageInfo& other)
 	fLocalFilePath = other.fLocalFilePath;
 	fFileName = other.fFileName;
 	fSize = other.fSize;
+	fSearchText = other.fSearchText;
 
 	return *this;
 }
@@ -672,6 +678,7 @@ PackageInfo::SetTitle(const BString& title)
 {
 	if (fTitle != title) {
 		fTitle = title;
+		_UpdateSearchText();
 		_NotifyListeners(PKG_CHANGED_TITLE);
 	}
 }
@@ -689,6 +696,7 @@ PackageInfo::SetShortDescription(const BString& description)
 {
 	if (fShortDescription != description) {
 		fShortDescription = description;
+		_UpdateSearchText();
 		_NotifyListeners(PKG_CHANGED_SUMMARY);
 	}
 }
@@ -699,6 +707,7 @@ PackageInfo::SetFullDescription(const BString& description)
 {
 	if (fFullDescription != description) {
 		fFullDescription = description;
+		_UpdateSearchText();
 		_NotifyListeners(PKG_CHANGED_DESCRIPTION);
 	}
 }
@@ -1003,6 +1012,23 @@ PackageInfo::EndCollatingChanges()
 }
 
 
+/*! Builds the texts that the search terms are looked for in, lower case and
+    separated by new lines, so that a term can't match across two of them.
+    It is rebuilt whenever one of the texts changes, so that filtering the
+    package list doesn't need to convert all the texts each time, and
+    reading it doesn't modify the package.
+*/
+
+void
+PackageInfo::_UpdateSearchText()
+{
+	fSearchText.SetTo(fName);
+	fSearchText << '\n' << Title() << '\n' << fPublisher.Name() << '\n'
+		<< fShortDescription << '\n' << fFullDescription;
+	fSearchText.ToLower();
+}
+
+
 void
 PackageInfo::_NotifyListeners(uint32 changes)
 {
@@ -1142,27 +1168,27 @@ DepotInfo::PackageIndexByName(const BString& packageName) const
 }
 
 
+/*! Both lists are sorted by name, so the packages are looked up with a
+    binary search rather than by comparing each one with each other one.
+*/
+
 void
 DepotInfo::SyncPackages(const PackageList& otherPackages)
 {
 	PackageList packages(fPackages);
+	std::vector<bool> synced(packages.CountItems(), false);
 
 	for (int32 i = otherPackages.CountItems() - 1; i >= 0; i--) {
 		const PackageInfoRef& otherPackage = otherPackages.ItemAtFast(i);
-		bool found = false;
-		for (int32 j = packages.CountItems() - 1; j >= 0; j--) {
-			const PackageInfoRef& package = packages.ItemAtFast(j);
-			if (package->Name() == otherPackage->Name()) {
-				package->SetState(otherPackage->State());
-				package->SetLocalFilePath(otherPackage->LocalFilePath());
-				package->SetSystemDependency(
-					otherPackage->IsSystemDependency());
-				found = true;
-				packages.Remove(j);
-				break;
-			}
-		}
-		if (!found) {
+		int32 index = packages.Search(&otherPackage->Name());
+		if (index >= 0) {
+			const PackageInfoRef& package = packages.ItemAtFast(index);
+			package->SetState(otherPackage->State());
+			package->SetLocalFilePath(otherPackage->LocalFilePath());
+			package->SetSystemDependency(
+				otherPackage->IsSystemDependency());
+			synced[index] = true;
+		} else {
 			printf("%s: new package: '%s'\n", fName.String(),
 				otherPackage->Name().String());
 			fPackages.Add(otherPackage);
@@ -1170,10 +1196,12 @@ DepotInfo::SyncPackages(const PackageList& otherPackages)
 	}
 
 	for (int32 i = packages.CountItems() - 1; i >= 0; i--) {
+		if (synced[i])
+			continue;
 		const PackageInfoRef& package = packages.ItemAtFast(i);
 		printf("%s: removing package: '%s'\n", fName.String(),
 			package->Name().String());
-		fPackages.Remove(package);
+		fPackages.Remove(fPackages.Search(&package->Name()));
 	}
 }
 
@@ -283,6 +283,9 @@ public:
 			const PublisherInfo& Publisher() const
 									{ return fPublisher; }
 
+			const BString&		SearchText() const
+									{ return fSearchText; }
+
 			void				SetIcon(const BitmapRef& icon);
 			const BitmapRef&	Icon() const
 									{ return fIcon; }
@@ -369,6 +372,7 @@ public:
 			void				EndCollatingChanges();
 
 private:
+			void				_UpdateSearchText();
 			void				_NotifyListeners(uint32 changes);
 			void				_NotifyListenersImmediate(uint32 changes);
 
@@ -400,6 +404,8 @@ private:
 			int64				fSize;
 			BString				fDepotName;
 
+			BString				fSearchText;
+
 			bool				fIsCollatingChanges;
 			uint32				fCollatedChanges;
 
@@ -79,7 +79,8 @@ ProcessCoordinatorState::ErrorStatus() const
 ProcessCoordinator::ProcessCoordinator(ProcessCoordinatorListener* listener)
 	:
 	fListener(listener),
-	fWasStopped(false)
+	fWasStopped(false),
+	fStartTime(0)
 {
 }
 
@@ -127,6 +128,7 @@ ProcessCoordinator::IsRunning()
 void
 ProcessCoordinator::Start()
 {
+	fStartTime = system_time();
 	_CoordinateAndCallListener();
 }
 
@@ -229,6 +231,11 @@ ProcessCoordinator::_CoordinateAndCallListener()
 {
 	ProcessCoordinatorState state = _Coordinate();
 
+	if (!state.IsRunning() && Logger::IsInfoEnabled()) {
+		printf("[Coordinator] did complete all processes in %6.3g secs\n",
+			(system_time() - fStartTime) / 1000000.0);
+	}
+
 	if (fListener != NULL)
 		fListener->CoordinatorChanged(state);
 }
@@ -109,6 +109,7 @@ private:
 			ProcessCoordinatorListener*
 								fListener;
 			bool				fWasStopped;
+			bigtime_t			fStartTime;
 };
 
 
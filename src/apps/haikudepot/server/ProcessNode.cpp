@@ -12,7 +12,11 @@
 #include "Logger.h"
 
 
-#define SPIN_UNTIL_STARTED_DELAY_MI 250 * 1000
+#define SPIN_UNTIL_STARTED_DELAY_MI 1000
+	// a millisecond; the process' thread switches to running right away and
+	// the coordinator is locked meanwhile, keeping other processes waiting
+
+#define SPIN_UNTIL_STOPPED_DELAY_MI 250 * 1000
 	// quarter of a second
 
 #define TIMEOUT_UNTIL_STARTED_SECS 10
@@ -47,7 +51,7 @@ ProcessNode::Process() const
 
 status_t
 ProcessNode::_SpinUntilProcessState(
-	uint32 desiredStatesMask, uint32 timeoutSeconds)
+	uint32 desiredStatesMask, bigtime_t delay, uint32 timeoutSeconds)
 {
 	uint32 start = real_time_clock();
 
@@ -55,7 +59,7 @@ ProcessNode::_SpinUntilProcessState(
 		if ((Process()->ProcessState() & desiredStatesMask) != 0)
 			return B_OK;
 
-		usleep(SPIN_UNTIL_STARTED_DELAY_MI);
+		usleep(delay);
 
 		if (real_time_clock() - start > timeoutSeconds) {
 			printf("[Node<%s>] timeout waiting for process state\n",
@@ -84,7 +88,7 @@ ProcessNode::StartProcess()
 	if (fWorker >= 0) {
 		resume_thread(fWorker);
 		return _SpinUntilProcessState(PROCESS_RUNNING | PROCESS_COMPLETE,
-			TIMEOUT_UNTIL_STARTED_SECS);
+			SPIN_UNTIL_STARTED_DELAY_MI, TIMEOUT_UNTIL_STARTED_SECS);
 	}
 
 	return B_ERROR;
@@ -100,7 +104,7 @@ ProcessNode::StopProcess()
 	Process()->SetListener(NULL);
 	status_t stopResult = Process()->Stop();
 	status_t waitResult = _SpinUntilProcessState(PROCESS_COMPLETE,
-		TIMEOUT_UNTIL_STOPPED_SECS);
+		SPIN_UNTIL_STOPPED_DELAY_MI, TIMEOUT_UNTIL_STOPPED_SECS);
 
 	// if the thread is still running then it will be necessary to tear it
 	// down.
@@ -43,6 +43,7 @@ private:
 	static	status_t			_StartProcess(void* cookie);
 			status_t			_SpinUntilProcessState(
 									uint32 desiredStatesMask,
+									bigtime_t delay,
 									uint32 timeoutSeconds);
 			void				_AddSuccessor(ProcessNode* node);
 
@@ -32,6 +32,12 @@
 #define B_TRANSLATION_CONTEXT "ServerPkgDataUpdateProcess"
 
 
+static const uint32 kPackagesPerModelLock = 100;
+	// The model is locked for a batch of packages rather than for each one.
+	// It stays locked while the next packages are parsed, so the batches
+	// mustn't be too large or the user interface would stall.
+
+
 /*! This package listener (not at the JSON level) is feeding in the
     packages as they are parsed and processing them.
 */
@@ -50,6 +56,8 @@ public:
 			uint32				Count();
 
 private:
+			void				_UnlockModel();
+
 			int32				IndexOfPackageByName(const BString& name) const;
 			int32				IndexOfCategoryByName(
 									const BString& name) const;
@@ -61,6 +69,7 @@ private:
 			CategoryList		fCategories;
 			Stoppable*			fStoppable;
 			uint32				fCount;
+			uint32				fBatchCount;
 			bool				fDebugEnabled;
 };
 
@@ -72,6 +81,7 @@ PackageFillingPkgListener::PackageFillingPkgListener(Model* model,
 	fModel(model),
 	fStoppable(stoppable),
 	fCount(0),
+	fBatchCount(0),
 	fDebugEnabled(Logger::IsDebugEnabled())
 {
 	fCategories = model->Categories();
@@ -80,6 +90,7 @@ PackageFillingPkgListener::PackageFillingPkgListener(Model* model,
 
 PackageFillingPkgListener::~PackageFillingPkgListener()
 {
+	_UnlockModel();
 }
 
 
@@ -197,6 +208,9 @@ PackageFillingPkgListener::Count()
 bool
 PackageFillingPkgListener::Handle(DumpExportPkg* pkg)
 {
+	if (fBatchCount == 0)
+		fModel->Lock()->Lock();
+
 	const DepotInfo* depotInfo = fModel->DepotForName(fDepotName);
 
 	if (depotInfo != NULL) {
@@ -204,11 +218,10 @@ PackageFillingPkgListener::Handle(DumpExportPkg* pkg)
 		int32 packageIndex = depotInfo->PackageIndexByName(packageName);
 
 		if (-1 != packageIndex) {
-			PackageList packages = depotInfo->Packages();
+			const PackageList& packages = depotInfo->Packages();
 			const PackageInfoRef& packageInfoRef =
 				packages.ItemAtFast(packageIndex);
 
-			AutoLocker<BLocker> locker(fModel->Lock());
 			ConsumePackage(packageInfoRef, pkg);
 		} else {
 			printf("[PackageFillingPkgListener] unable to find the pkg [%s]\n",
@@ -219,6 +232,9 @@ PackageFillingPkgListener::Handle(DumpExportPkg* pkg)
 			fDepotName.String());
 	}
 
+	if (++fBatchCount == kPackagesPerModelLock)
+		_UnlockModel();
+
 	return !fStoppable->WasStopped();
 }
 
@@ -226,6 +242,17 @@ PackageFillingPkgListener::Handle(DumpExportPkg* pkg)
 void
 PackageFillingPkgListener::Complete()
 {
+	_UnlockModel();
+}
+
+
+void
+PackageFillingPkgListener::_UnlockModel()
+{
+	if (fBatchCount > 0) {
+		fModel->Lock()->Unlock();
+		fBatchCount = 0;
+	}
 }
 
 
@@ -17,6 +17,10 @@
 #include <string.h>
 #include <time.h>
 
+#include <algorithm>
+#include <map>
+#include <vector>
+
 
 static struct option const kLongOptions[] = {
 	{"verbose", no_argument, 0, 'v'},
@@ -38,6 +42,30 @@ extern const char *__progname;
 static const char *kProgramName = __progname;
 
 
+struct job_timing {
+	BString		name;
+	BStringList	requirements;
+	bigtime_t	queued;
+	bigtime_t	started;
+	bigtime_t	launched;
+	bigtime_t	ready;
+
+	bigtime_t Done() const
+	{
+		return ready != 0 ? ready : launched;
+	}
+};
+
+typedef std::map<BString, job_timing> TimingMap;
+
+
+static bool
+job_timing_less(const job_timing* a, const job_timing* b)
+{
+	return a->Done() < b->Done();
+}
+
+
 static void
 list_jobs(bool verbose)
 {
@@ -219,6 +247,101 @@ get_info(const char* name)
 }
 
 
+static void
+print_timing(const job_timing& timing)
+{
+	printf("%10.1f %10.1f %10.1f  %s\n", timing.Done() / 1000.0,
+		(timing.started - timing.queued) / 1000.0,
+		(timing.Done() - timing.started) / 1000.0, timing.name.String());
+}
+
+
+/*!	Follows the requirements of the job that became ready last back to the
+	first one, always picking the requirement that became ready last. This is
+	the chain of jobs that determined how long it took to get there.
+*/
+static void
+print_critical_path(bool verbose)
+{
+	BLaunchRoster roster;
+	BStringList jobs;
+	status_t status = roster.GetJobs(NULL, jobs);
+	if (status != B_OK) {
+		fprintf(stderr, "%s: Could not get job listing: %s\n", kProgramName,
+			strerror(status));
+		exit(EXIT_FAILURE);
+	}
+
+	TimingMap timings;
+	for (int32 i = 0; i < jobs.CountStrings(); i++) {
+		BMessage info;
+		if (roster.GetJobInfo(jobs.StringAt(i), info) != B_OK)
+			continue;
+
+		job_timing timing;
+		timing.name = jobs.StringAt(i);
+		info.FindStrings("requires", &timing.requirements);
+		timing.queued = info.GetInt64("queued_time", 0);
+		timing.started = info.GetInt64("start_time", 0);
+		timing.launched = info.GetInt64("launch_time", 0);
+		timing.ready = info.GetInt64("ready_time", 0);
+
+		// Ignore jobs that were never launched
+		if (timing.started == 0 || timing.Done() == 0)
+			continue;
+
+		timings.insert(std::make_pair(timing.name, timing));
+	}
+
+	if (timings.empty()) {
+		fprintf(stderr, "%s: No launch timing available.\n", kProgramName);
+		exit(EXIT_FAILURE);
+	}
+
+	const job_timing* last = NULL;
+	for (TimingMap::const_iterator iterator = timings.begin();
+			iterator != timings.end(); iterator++) {
+		if (last == NULL || last->Done() < iterator->second.Done())
+			last = &iterator->second;
+	}
+
+	std::vector<const job_timing*> path;
+	while (last != NULL) {
+		path.push_back(last);
+
+		const job_timing* next = NULL;
+		for (int32 i = 0; i < last->requirements.CountStrings(); i++) {
+			TimingMap::const_iterator found
+				= timings.find(last->requirements.StringAt(i));
+			if (found == timings.end()
+				|| found->second.Done() >= last->Done()) {
+				continue;
+			}
+			if (next == NULL || next->Done() < found->second.Done())
+				next = &found->second;
+		}
+		last = next;
+	}
+
+	printf("%10s %10s %10s  %s\n", "ready (ms)", "wait", "launch", "job");
+	for (int32 i = path.size() - 1; i >= 0; i--)
+		print_timing(*path[i]);
+
+	if (verbose) {
+		std::vector<const job_timing*> all;
+		for (TimingMap::const_iterator iterator = timings.begin();
+				iterator != timings.end(); iterator++) {
+			all.push_back(&iterator->second);
+		}
+		std::sort(all.begin(), all.end(), &job_timing_less);
+
+		printf("\nAll jobs:\n");
+		for (size_t i = 0; i < all.size(); i++)
+			print_timing(*all[i]);
+	}
+}
+
+
 static void
 start_job(const char* name)
 {
@@ -279,6 +402,8 @@ usage(int status)
 		"Where <command> is one of:\n"
 		"  list - Lists all jobs (the default command)\n"
 		"  list-targets - Lists all targets\n"
+		"  critical-path - Shows the chain of jobs that delayed the launch of\n"
+		"    the last job the most; with -v, the launch times of all jobs\n"
 		"The following <command>s have a <name> argument:\n"
 		"  start - Starts a job/target\n"
 		"  stop - Stops a running job/target\n"
@@ -320,6 +445,8 @@ main(int argc, char** argv)
 		list_jobs(verbose);
 	} else if (strcmp(command, "list-targets") == 0) {
 		list_targets(verbose);
+	} else if (strcmp(command, "critical-path") == 0) {
+		print_critical_path(verbose);
 	} else if (strcmp(command, "log") == 0) {
 		get_log(argc - optind, &argv[optind]);
 	} else if (argc == optind + 1) {
@@ -40,6 +40,7 @@ command_create(int argc, const char* const* argv)
 	bool verbose = false;
 	int32 compressionLevel = BPackageKit::BHPKG::B_HPKG_COMPRESSION_LEVEL_BEST;
 	int32 compression = BPackageKit::BHPKG::B_HPKG_COMPRESSION_ZLIB;
+	int32 threadCount = 1;
 
 	while (true) {
 		static struct option sLongOptions[] = {
@@ -50,7 +51,7 @@ command_create(int argc, const char* const* argv)
 		};
 
 		opterr = 0; // don't print errors
-		int c = getopt_long(argc, (char**)argv, "+b0123456789C:hi:I:qvz",
+		int c = getopt_long(argc, (char**)argv, "+b0123456789C:hi:I:j:qvz",
 			sLongOptions, NULL);
 		if (c == -1)
 			break;
@@ -89,6 +90,12 @@ command_create(int argc, const char* const* argv)
 				installPath = optarg;
 				break;
 
+			case 'j':
+				threadCount = atoi(optarg);
+				if (threadCount < 0)
+					print_usage_and_exit(true);
+				break;
+
 			case 'q':
 				quiet = true;
 				break;
@@ -131,6 +138,7 @@ command_create(int argc, const char* const* argv)
 	if (compressionLevel == 0)
 		compression = BPackageKit::BHPKG::B_HPKG_COMPRESSION_NONE;
 	writerParameters.SetCompression(compression);
+	writerParameters.SetCompressionThreadCount(threadCount);
 
 	PackageWriterListener listener(verbose, quiet);
 	BPackageWriter packageWriter(&listener);
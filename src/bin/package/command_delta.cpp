@@ -0,0 +1,97 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include <package/hpkg/PackageDelta.h>
+#include <package/hpkg/StandardErrorOutput.h>
+
+#include "package.h"
+
+
+using BPackageKit::BHPKG::BStandardErrorOutput;
+using BPackageKit::BHPKG::BPrivate::PackageDeltaStatistics;
+using BPackageKit::BHPKG::BPrivate::PackageDeltaWriter;
+
+
+int
+command_delta(int argc, const char* const* argv)
+{
+	bool quiet = false;
+
+	while (true) {
+		static struct option sLongOptions[] = {
+			{ "help", no_argument, 0, 'h' },
+			{ "quiet", no_argument, 0, 'q' },
+			{ 0, 0, 0, 0 }
+		};
+
+		opterr = 0; // don't print errors
+		int c = getopt_long(argc, (char**)argv, "+hq", sLongOptions, NULL);
+		if (c == -1)
+			break;
+
+		switch (c) {
+			case 'h':
+				print_usage_and_exit(false);
+				break;
+
+			case 'q':
+				quiet = true;
+				break;
+
+			default:
+				print_usage_and_exit(true);
+				break;
+		}
+	}
+
+	// The remaining arguments are the old and new package files and the
+	// delta file, i.e. three more arguments.
+	if (argc - optind != 3)
+		print_usage_and_exit(true);
+
+	const char* oldPackageFileName = argv[optind++];
+	const char* newPackageFileName = argv[optind++];
+	const char* deltaFileName = argv[optind++];
+
+	BStandardErrorOutput errorOutput;
+	PackageDeltaWriter deltaWriter(&errorOutput);
+	status_t error = deltaWriter.Create(oldPackageFileName, newPackageFileName,
+		deltaFileName);
+	if (error != B_OK)
+		return 1;
+
+	if (quiet)
+		return 0;
+
+	struct stat newStat;
+	struct stat deltaStat;
+	if (stat(newPackageFileName, &newStat) != 0
+		|| stat(deltaFileName, &deltaStat) != 0) {
+		return 0;
+	}
+
+	const PackageDeltaStatistics& statistics = deltaWriter.Statistics();
+	printf("copied chunks:    %10" B_PRIu64 " (%" B_PRIu64 " bytes)\n",
+		statistics.copiedChunks, statistics.copiedBytes);
+	printf("rebuilt chunks:   %10" B_PRIu64 " (%" B_PRIu64 " bytes "
+		"referenced, %" B_PRIu64 " bytes included)\n",
+		statistics.rebuiltChunks, statistics.referencedBytes,
+		statistics.dataBytes);
+	printf("literal chunks:   %10" B_PRIu64 " (%" B_PRIu64 " bytes)\n",
+		statistics.literalChunks, statistics.literalBytes);
+	printf("new package size: %10" B_PRIdOFF "\n", newStat.st_size);
+	printf("delta size:       %10" B_PRIdOFF " (%.1f%%)\n", deltaStat.st_size,
+		newStat.st_size > 0
+			? deltaStat.st_size * 100.0 / newStat.st_size : 0.0);
+
+	return 0;
+}
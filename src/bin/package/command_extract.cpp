@@ -83,7 +83,7 @@ struct VersionPolicyV1 {
 	}
 
 	static inline status_t InitReader(PackageReader& packageReader,
-		const char* fileName)
+		const char* fileName, bool readAhead)
 	{
 		return packageReader.Init(fileName);
 	}
@@ -135,11 +135,12 @@ struct VersionPolicyV2 {
 	}
 
 	static inline status_t InitReader(PackageReader& packageReader,
-		const char* fileName)
+		const char* fileName, bool readAhead)
 	{
 		return packageReader.Init(fileName,
 			BPackageKit::BHPKG
-				::B_HPKG_READER_DONT_PRINT_VERSION_MISMATCH_MESSAGE);
+				::B_HPKG_READER_DONT_PRINT_VERSION_MISMATCH_MESSAGE
+			| (readAhead ? BPackageKit::BHPKG::B_HPKG_READER_READ_AHEAD : 0));
 	}
 
 	static status_t GetHeapReader(PackageReader& packageReader,
@@ -766,7 +767,7 @@ template<typename VersionPolicy>
 static void
 do_extract(const char* packageFileName, const char* changeToDirectory,
 	const char* packageInfoFileName, const char* const* explicitEntries,
-	int explicitEntryCount, bool ignoreVersionError)
+	int explicitEntryCount, bool readAhead, bool ignoreVersionError)
 {
 	// open package
 	BStandardErrorOutput errorOutput;
@@ -777,7 +778,8 @@ do_extract(const char* packageFileName, const char* changeToDirectory,
 	}
 
 	typename VersionPolicy::PackageReader packageReader(&errorOutput);
-	status_t error = VersionPolicy::InitReader(packageReader, packageFileName);
+	status_t error = VersionPolicy::InitReader(packageReader, packageFileName,
+		readAhead);
 	if (error != B_OK) {
 		if (ignoreVersionError && error == B_MISMATCHED_VALUES)
 			return;
@@ -861,6 +863,7 @@ command_extract(int argc, const char* const* argv)
 {
 	const char* changeToDirectory = NULL;
 	const char* packageInfoFileName = NULL;
+	bool readAhead = true;
 
 	while (true) {
 		static struct option sLongOptions[] = {
@@ -869,7 +872,7 @@ command_extract(int argc, const char* const* argv)
 		};
 
 		opterr = 0; // don't print errors
-		int c = getopt_long(argc, (char**)argv, "+C:hi:", sLongOptions, NULL);
+		int c = getopt_long(argc, (char**)argv, "+C:hi:s", sLongOptions, NULL);
 		if (c == -1)
 			break;
 
@@ -886,6 +889,10 @@ command_extract(int argc, const char* const* argv)
 				packageInfoFileName = optarg;
 				break;
 
+			case 's':
+				readAhead = false;
+				break;
+
 			default:
 				print_usage_and_exit(true);
 				break;
@@ -901,9 +908,11 @@ command_extract(int argc, const char* const* argv)
 	const char* const* explicitEntries = argv + optind;
 	int explicitEntryCount = argc - optind;
 	do_extract<VersionPolicyV2>(packageFileName, changeToDirectory,
-		packageInfoFileName, explicitEntries, explicitEntryCount, true);
+		packageInfoFileName, explicitEntries, explicitEntryCount, readAhead,
+		true);
 	do_extract<VersionPolicyV1>(packageFileName, changeToDirectory,
-		packageInfoFileName, explicitEntries, explicitEntryCount, false);
+		packageInfoFileName, explicitEntries, explicitEntryCount, readAhead,
+		false);
 
 	return 0;
 }
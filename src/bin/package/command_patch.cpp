@@ -0,0 +1,61 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <package/hpkg/PackageDelta.h>
+#include <package/hpkg/StandardErrorOutput.h>
+
+#include "package.h"
+
+
+using BPackageKit::BHPKG::BStandardErrorOutput;
+using BPackageKit::BHPKG::BPrivate::PackageDeltaApplier;
+
+
+int
+command_patch(int argc, const char* const* argv)
+{
+	while (true) {
+		static struct option sLongOptions[] = {
+			{ "help", no_argument, 0, 'h' },
+			{ 0, 0, 0, 0 }
+		};
+
+		opterr = 0; // don't print errors
+		int c = getopt_long(argc, (char**)argv, "+h", sLongOptions, NULL);
+		if (c == -1)
+			break;
+
+		switch (c) {
+			case 'h':
+				print_usage_and_exit(false);
+				break;
+
+			default:
+				print_usage_and_exit(true);
+				break;
+		}
+	}
+
+	// The remaining arguments are the old package file, the delta file, and
+	// the new package file, i.e. three more arguments.
+	if (argc - optind != 3)
+		print_usage_and_exit(true);
+
+	const char* oldPackageFileName = argv[optind++];
+	const char* deltaFileName = argv[optind++];
+	const char* newPackageFileName = argv[optind++];
+
+	BStandardErrorOutput errorOutput;
+	PackageDeltaApplier deltaApplier(&errorOutput);
+	status_t error = deltaApplier.Apply(oldPackageFileName, deltaFileName,
+		newPackageFileName);
+	return error == B_OK ? 0 : 1;
+}
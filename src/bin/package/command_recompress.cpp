@@ -46,6 +46,7 @@ command_recompress(int argc, const char* const* argv)
 	bool verbose = false;
 	int32 compressionLevel = BPackageKit::BHPKG::B_HPKG_COMPRESSION_LEVEL_BEST;
 	int32 compression = BPackageKit::BHPKG::B_HPKG_COMPRESSION_ZLIB;
+	int32 threadCount = 1;
 
 	while (true) {
 		static struct option sLongOptions[] = {
@@ -56,7 +57,7 @@ command_recompress(int argc, const char* const* argv)
 		};
 
 		opterr = 0; // don't print errors
-		int c = getopt_long(argc, (char**)argv, "+0123456789:hqvz",
+		int c = getopt_long(argc, (char**)argv, "+0123456789:hj:qvz",
 			sLongOptions, NULL);
 		if (c == -1)
 			break;
@@ -79,6 +80,12 @@ command_recompress(int argc, const char* const* argv)
 				print_usage_and_exit(false);
 				break;
 
+			case 'j':
+				threadCount = atoi(optarg);
+				if (threadCount < 0)
+					print_usage_and_exit(true);
+				break;
+
 			case 'q':
 				quiet = true;
 				break;
@@ -132,6 +139,7 @@ command_recompress(int argc, const char* const* argv)
 	if (compressionLevel == 0)
 		compression = BPackageKit::BHPKG::B_HPKG_COMPRESSION_NONE;
 	writerParameters.SetCompression(compression);
+	writerParameters.SetCompressionThreadCount(threadCount);
 
 	PackageWriterListener listener(verbose, quiet);
 	BPackageWriter packageWriter(&listener);
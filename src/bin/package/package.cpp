@@ -71,9 +71,20 @@ static const char* kUsage =
 	"                 the package .self link to point to <path>, which is "
 		"useful\n"
 	"                 to redirect a \"make install\". Only allowed with -b.\n"
+	"    -j <count> - Compress using <count> threads, 0 means one thread per "
+		"CPU.\n"
+	"                 Defaults to 1. The package is the same either way.\n"
 	"    -q         - Be quiet (don't show any output except for errors).\n"
 	"    -v         - Be verbose (show more info about created package).\n"
 	"\n"
+	"  delta [ <options> ] <old package> <new package> <delta>\n"
+	"    Writes to <delta> the changes needed to turn package file "
+		"<old package>\n"
+	"    into <new package>. Chunks unchanged between the two are only "
+		"referenced.\n"
+	"\n"
+	"    -q         - Be quiet (don't show any output except for errors).\n"
+	"\n"
 	"  dump [ <options> ] <package>\n"
 	"    Dumps the TOC section of package file <package>. For debugging only.\n"
 	"\n"
@@ -86,6 +97,9 @@ static const char* kUsage =
 		"contents\n"
 	"                  of the archive.\n"
 	"    -i <info>  - Extract the .PackageInfo file to <info> instead.\n"
+	"    -s         - Decompress the data on a single thread. By default the\n"
+	"                 data following the current file are decompressed "
+		"ahead.\n"
 	"\n"
 	"  info [ <options> ] <package>\n"
 	"    Prints individual meta information of package file <package>.\n"
@@ -107,6 +121,12 @@ static const char* kUsage =
 	"    -i         - Only print the meta information, not the files.\n"
 	"    -p         - Only print a list of file paths.\n"
 	"\n"
+	"  patch <old package> <delta> <new package>\n"
+	"    Rebuilds package file <new package> from <old package> and <delta>,\n"
+	"    as created by the delta command. The result is identical to the "
+		"package\n"
+	"    the delta was created from.\n"
+	"\n"
 	"  recompress [ <options> ] <input package> <output package>\n"
 	"    Reads the package file <input package> and writes it to new package\n"
 	"    <output package> using the specified compression options. If the\n"
@@ -119,6 +139,9 @@ static const char* kUsage =
 	"    -0 ... -9  - Use compression level 0 ... 9. 0 means no, 9 best "
 		"compression.\n"
 	"                 Defaults to 9.\n"
+	"    -j <count> - Compress using <count> threads, 0 means one thread per "
+		"CPU.\n"
+	"                 Defaults to 1. The package is the same either way.\n"
 	"    -q         - Be quiet (don't show any output except for errors).\n"
 	"    -v         - Be verbose (show more info about created package).\n"
 	"    -z         - Use Zstd compression.\n"
@@ -152,6 +175,9 @@ main(int argc, const char* const* argv)
 	if (strcmp(command, "create") == 0)
 		return command_create(argc - 1, argv + 1);
 
+	if (strcmp(command, "delta") == 0)
+		return command_delta(argc - 1, argv + 1);
+
 	if (strcmp(command, "dump") == 0)
 		return command_dump(argc - 1, argv + 1);
 
@@ -164,6 +190,9 @@ main(int argc, const char* const* argv)
 	if (strcmp(command, "info") == 0)
 		return command_info(argc - 1, argv + 1);
 
+	if (strcmp(command, "patch") == 0)
+		return command_patch(argc - 1, argv + 1);
+
 	if (strcmp(command, "recompress") == 0)
 		return command_recompress(argc - 1, argv + 1);
 
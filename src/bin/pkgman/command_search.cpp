@@ -17,7 +17,13 @@
 #include <algorithm>
 #include <set>
 
+#include <package/PackageInfo.h>
+#include <package/PackageRoster.h>
+#include <package/RepositoryCacheIndex.h>
+#include <package/RepositoryConfig.h>
 #include <package/solver/SolverPackage.h>
+#include <package/solver/SolverRepository.h>
+#include <StringList.h>
 #include <TextTable.h>
 
 #include "Command.h"
@@ -30,6 +36,7 @@
 
 
 using namespace BPackageKit;
+using BPackageKit::BPrivate::RepositoryCacheIndex;
 
 
 static const char* const kShortUsage =
@@ -127,6 +134,54 @@ compare_packages(const BSolverPackage* a, const BSolverPackage* b,
 }
 
 
+/*!	Creates a repository for each remote repository, containing only the
+	packages that may match the search string. Fails, if the cache of any
+	repository doesn't have an up-to-date index.
+*/
+static bool
+get_indexed_repositories(const char* searchString,
+	BObjectList<BSolverRepository>& _repositories)
+{
+	BPackageRoster roster;
+	BStringList repositoryNames;
+	if (roster.GetRepositoryNames(repositoryNames) != B_OK)
+		return false;
+
+	int32 repositoryNameCount = repositoryNames.CountStrings();
+	for (int32 i = 0; i < repositoryNameCount; i++) {
+		BRepositoryConfig config;
+		RepositoryCacheIndex index;
+		if (roster.GetRepositoryConfig(repositoryNames.StringAt(i), &config)
+				!= B_OK
+			|| index.SetTo(config.Name()) != B_OK) {
+			return false;
+		}
+
+		BSolverRepository* repository
+			= new(std::nothrow) BSolverRepository(config.Name());
+		if (repository == NULL || !_repositories.AddItem(repository)) {
+			delete repository;
+			return false;
+		}
+		repository->SetPriority(config.Priority());
+
+		uint32 packageCount = index.CountPackages();
+		for (uint32 k = 0; k < packageCount; k++) {
+			if (!index.PackageMatches(k, searchString))
+				continue;
+
+			BPackageInfo info;
+			if (index.GetPackageInfo(k, info) != B_OK
+				|| repository->AddPackage(info) != B_OK) {
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+
 int
 SearchCommand::Execute(int argc, const char* const* argv)
 {
@@ -196,12 +251,29 @@ SearchCommand::Execute(int argc, const char* const* argv)
 
 	const char* searchString = listAll ? "" : argv[optind++];
 
+	// When searching the remote repositories for a string, their cache
+	// indices allow us to read only the candidate packages. Otherwise we read
+	// the caches completely.
+	BObjectList<BSolverRepository> indexedRepositories(10, true);
+	bool useIndices = !installedOnly && !listAll && !requirements
+		&& get_indexed_repositories(searchString, indexedRepositories);
+	if (!useIndices)
+		indexedRepositories.MakeEmpty();
+
 	// create the solver
 	PackageManager packageManager(B_PACKAGE_INSTALLATION_LOCATION_HOME);
 	packageManager.SetDebugLevel(fCommonOptions.DebugLevel());
 	packageManager.Init(
 		(!uninstalledOnly ? PackageManager::B_ADD_INSTALLED_REPOSITORIES : 0)
-			| (!installedOnly ? PackageManager::B_ADD_REMOTE_REPOSITORIES : 0));
+			| (!installedOnly && !useIndices
+				? PackageManager::B_ADD_REMOTE_REPOSITORIES : 0));
+
+	for (int32 i = 0; i < indexedRepositories.CountItems(); i++) {
+		status_t error = packageManager.Solver()->AddRepository(
+			indexedRepositories.ItemAt(i));
+		if (error != B_OK)
+			DIE(error, "failed to add repository to solver");
+	}
 
 	uint32 flags = BSolver::B_FIND_CASE_INSENSITIVE | BSolver::B_FIND_IN_NAME
 		| BSolver::B_FIND_IN_SUMMARY | BSolver::B_FIND_IN_DESCRIPTION
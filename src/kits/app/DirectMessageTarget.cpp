@@ -1,5 +1,5 @@
 /*
- * Copyright 2007, Haiku, Inc.
+ * Copyright 2007-2026, Haiku, Inc.
  * Distributed under the terms of the MIT License.
  *
  * Authors:
@@ -9,13 +9,54 @@
 
 #include <DirectMessageTarget.h>
 
+#include <limits.h>
+
+#include <MessagePrivate.h>
+
 
 namespace BPrivate {
 
 
+static inline BMessage*
+atomic_pointer_test_and_set(BMessage** _pointer, BMessage* set,
+	BMessage* test)
+{
+#if LONG_MAX == INT_MAX
+	return (BMessage*)atomic_test_and_set((int32*)_pointer, (int32)set,
+		(int32)test);
+#else
+	return (BMessage*)atomic_test_and_set64((int64*)_pointer, (int64)set,
+		(int64)test);
+#endif
+}
+
+
+static inline BMessage*
+atomic_pointer_get_and_set(BMessage** _pointer, BMessage* set)
+{
+#if LONG_MAX == INT_MAX
+	return (BMessage*)atomic_get_and_set((int32*)_pointer, (int32)set);
+#else
+	return (BMessage*)atomic_get_and_set64((int64*)_pointer, (int64)set);
+#endif
+}
+
+
+static inline BMessage*
+atomic_pointer_get(BMessage** _pointer)
+{
+#if LONG_MAX == INT_MAX
+	return (BMessage*)atomic_get((int32*)_pointer);
+#else
+	return (BMessage*)atomic_get64((int64*)_pointer);
+#endif
+}
+
+
 BDirectMessageTarget::BDirectMessageTarget()
 	:
 	fReferenceCount(1),
+	fPending(NULL),
 	fClosed(false)
 {
 }
@@ -23,22 +64,115 @@ BDirectMessageTarget::BDirectMessageTarget()
 
 BDirectMessageTarget::~BDirectMessageTarget()
 {
+	BMessage* message = atomic_pointer_get_and_set(&fPending, NULL);
+	while (message != NULL) {
+		BMessage* next = BMessage::Private(message).QueueLink();
+		delete message;
+		message = next;
+	}
 }
 
 
+/*!	Adds the \a message to the target without acquiring any lock; this may be
+	called by any number of threads concurrently. The message is moved over to
+	the actual queue once the looper runs out of messages to process, or
+	whenever someone looks at the queue.
+	If \a _wasEmpty is given, it is set to \c true when there were no pending
+	messages before, and the looper might need to be woken up. The queue is
+	not taken into account: the looper may have just taken the pending
+	messages, and not yet added them to it.
+*/
 bool
-BDirectMessageTarget::AddMessage(BMessage* message)
+BDirectMessageTarget::AddMessage(BMessage* message, bool* _wasEmpty)
 {
 	if (fClosed) {
 		delete message;
 		return false;
 	}
 
-	fQueue.AddMessage(message);
+	BMessage::Private messagePrivate(message);
+	BMessage* head = atomic_pointer_get(&fPending);
+	while (true) {
+		messagePrivate.SetQueueLink(head);
+
+		BMessage* previous = atomic_pointer_test_and_set(&fPending, message,
+			head);
+		if (previous == head)
+			break;
+
+		head = previous;
+	}
+
+	if (_wasEmpty != NULL)
+		*_wasEmpty = head == NULL;
+
+	return true;
+}
+
+
+/*!	Moves all messages added via AddMessage() to the queue, preserving their
+	order. Returns whether or not there were any such messages.
+*/
+bool
+BDirectMessageTarget::FlushPendingMessages()
+{
+	if (atomic_pointer_get(&fPending) == NULL)
+		return false;
+
+	// Holding the queue lock while taking the pending messages makes sure
+	// that concurrent flushes can't reorder them.
+	if (!fQueue.Lock())
+		return false;
+
+	BMessage* message = atomic_pointer_get_and_set(&fPending, NULL);
+	if (message == NULL) {
+		fQueue.Unlock();
+		return false;
+	}
+
+	// the pending list is in LIFO order, reverse it
+	BMessage* first = NULL;
+	while (message != NULL) {
+		BMessage::Private messagePrivate(message);
+		BMessage* next = messagePrivate.QueueLink();
+		messagePrivate.SetQueueLink(first);
+		first = message;
+		message = next;
+	}
+
+	while (first != NULL) {
+		BMessage* next = BMessage::Private(first).QueueLink();
+		fQueue.AddMessage(first);
+		first = next;
+	}
+
+	fQueue.Unlock();
 	return true;
 }
 
 
+bool
+BDirectMessageTarget::HasPendingMessages() const
+{
+	return atomic_pointer_get((BMessage**)&fPending) != NULL
+		|| !fQueue.IsEmpty();
+}
+
+
+/*!	Returns the next message for the looper to process, or \c NULL if there
+	is none.
+*/
+BMessage*
+BDirectMessageTarget::NextMessage()
+{
+	BMessage* message = fQueue.NextMessage();
+	if (message == NULL && FlushPendingMessages())
+		message = fQueue.NextMessage();
+
+	return message;
+}
+
+
 void
 BDirectMessageTarget::Close()
 {
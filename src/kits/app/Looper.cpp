@@ -139,7 +139,7 @@ BLooper::~BLooper()
 	fDirectTarget->Close();
 
 	BMessage* message;
-	while ((message = fDirectTarget->Queue()->NextMessage()) != NULL) {
+	while ((message = fDirectTarget->NextMessage()) != NULL) {
 		delete message;
 			// msg will automagically post generic reply
 	}
@@ -324,6 +324,8 @@ BLooper::DispatchExternalMessage(BMessage* message, BHandler* handler,
 BMessageQueue*
 BLooper::MessageQueue() const
 {
+	// make messages posted from other threads visible in the queue
+	fDirectTarget->FlushPendingMessages();
 	return fDirectTarget->Queue();
 }
 
@@ -333,7 +335,7 @@ BLooper::IsMessageWaiting() const
 {
 	AssertLocked();
 
-	if (!fDirectTarget->Queue()->IsEmpty())
+	if (fDirectTarget->HasPendingMessages())
 		return true;
 
 	int32 count;
@@ -969,6 +971,7 @@ BLooper::_InitData(const char* name, int32 priority, port_id port,
 	fThread = B_ERROR;
 	fTerminating = false;
 	fOwnsPort = true;
+	fAdoptableSize = 0;
 	fMsgPort = -1;
 	fAtomicCount = 0;
 
@@ -1021,6 +1024,8 @@ BLooper::_AddMessagePriv(BMessage* message)
 	// Others may want to peek into our message queue, so the preferred
 	// handler must be set correctly already if no token was given
 
+	// Messages posted directly before this one need to stay in front of it
+	fDirectTarget->FlushPendingMessages();
 	fDirectTarget->Queue()->AddMessage(message);
 }
 
@@ -1046,6 +1051,15 @@ BLooper::_task0_(void* arg)
 
 void*
 BLooper::ReadRawFromPort(int32* msgCode, bigtime_t timeout)
+{
+	ssize_t bufferSize;
+	return _ReadRawFromPort(msgCode, &bufferSize, timeout);
+}
+
+
+void*
+BLooper::_ReadRawFromPort(int32* msgCode, ssize_t* _bufferSize,
+	bigtime_t timeout)
 {
 	PRINT(("BLooper::ReadRawFromPort()\n"));
 	uint8* buffer = NULL;
@@ -1078,6 +1092,7 @@ BLooper::ReadRawFromPort(int32* msgCode, bigtime_t timeout)
 	PRINT(("BLooper::ReadRawFromPort() read: %.4s, %p (%d bytes)\n",
 		(char*)msgCode, buffer, bufferSize));
 
+	*_bufferSize = bufferSize;
 	return buffer;
 }
 
@@ -1087,14 +1102,24 @@ BLooper::ReadMessageFromPort(bigtime_t timeout)
 {
 	PRINT(("BLooper::ReadMessageFromPort()\n"));
 	int32 msgCode;
+	ssize_t bufferSize;
 	BMessage* message = NULL;
 
-	void* buffer = ReadRawFromPort(&msgCode, timeout);
+	void* buffer = _ReadRawFromPort(&msgCode, &bufferSize, timeout);
 	if (buffer == NULL)
 		return NULL;
 
+	// Native messages can just reference the buffer we received, and only
+	// copy their contents once they are actually modified. If our
+	// ConvertToMessage() takes over the buffer, it resets fAdoptableSize.
+	fAdoptableSize = msgCode == kPortMessageCode ? bufferSize : 0;
+
 	message = ConvertToMessage(buffer, msgCode);
-	free(buffer);
+
+	bool adopted = msgCode == kPortMessageCode && fAdoptableSize == 0;
+	fAdoptableSize = 0;
+	if (!adopted)
+		free(buffer);
 
 	PRINT(("BLooper::ReadMessageFromPort() done: %p\n", message));
 	return message;
@@ -1109,6 +1134,19 @@ BLooper::ConvertToMessage(void* buffer, int32 code)
 		return NULL;
 
 	BMessage* message = new BMessage();
+
+	if (code == kPortMessageCode && fAdoptableSize > 0) {
+		// the buffer was just read from our port, and we may keep it
+		if (BMessage::Private(message).AdoptFlatBuffer(buffer, fAdoptableSize)
+				== B_OK) {
+			fAdoptableSize = 0;
+			PRINT(("BLooper::ConvertToMessage(): %p\n", message));
+			return message;
+		}
+
+		fAdoptableSize = -1;
+	}
+
 	if (message->Unflatten((const char*)buffer) != B_OK) {
 		PRINT(("BLooper::ConvertToMessage(): unflattening message failed\n"));
 		delete message;
@@ -1158,13 +1196,15 @@ BLooper::task_looper()
 		// loop: As long as there are messages in the queue and the port is
 		//		 empty... and we are not terminating, of course.
 		bool dispatchNextMessage = true;
+		bool locked = false;
 		while (!fTerminating && dispatchNextMessage) {
 			PRINT(("LOOPER: inner loop\n"));
 			// Get next message from queue (assign to fLastMessage after
 			// locking)
-			BMessage* message = fDirectTarget->Queue()->NextMessage();
+			BMessage* message = fDirectTarget->NextMessage();
 
-			Lock();
+			if (!locked)
+				Lock();
 
 			fLastMessage = message;
 
@@ -1224,18 +1264,33 @@ BLooper::task_looper()
 			message = fLastMessage;
 			fLastMessage = NULL;
 
-			// Unlock the looper
-			Unlock();
-
-			// Delete the current message (fLastMessage)
-			if (message != NULL)
-				delete message;
-
 			// Are any messages on the port?
 			if (port_count(fMsgPort) > 0) {
 				// Do outer loop
 				dispatchNextMessage = false;
 			}
+
+			locked = false;
+#if DEBUG < 1
+			// As long as no other thread is waiting for the lock, we keep the
+			// looper locked for the next message instead of going through
+			// Lock() again, which has to acquire the global looper list lock.
+			// Messages whose source is waiting for a reply are deleted
+			// unlocked as before, since that sends the reply.
+			if (dispatchNextMessage && message != NULL
+				&& fOwnerCount == 1 && atomic_get(&fAtomicCount) == 1
+				&& !message->IsSourceWaiting()) {
+				locked = true;
+			}
+#endif
+
+			// Unlock the looper
+			if (!locked)
+				Unlock();
+
+			// Delete the current message (fLastMessage)
+			if (message != NULL)
+				delete message;
 		}
 	}
 	PRINT(("BLooper::task_looper() done\n"));
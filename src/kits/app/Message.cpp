@@ -80,10 +80,30 @@ extern "C" {
 
 
 BBlockCache* BMessage::sMsgCache = NULL;
+static BBlockCache* sStorageCache = NULL;
 port_id BMessage::sReplyPorts[sNumReplyPorts];
 int32 BMessage::sReplyPortInUse[sNumReplyPorts];
 
 
+static const size_t kInlineDataSize = MESSAGE_STORAGE_BLOCK_SIZE
+	- sizeof(BMessage::message_header)
+	- MESSAGE_INLINE_FIELD_COUNT * sizeof(BMessage::field_header);
+
+
+static inline BMessage::field_header*
+inline_fields(BMessage::message_header* header)
+{
+	return (BMessage::field_header*)(header + 1);
+}
+
+
+static inline uint8*
+inline_data(BMessage::message_header* header)
+{
+	return (uint8*)(inline_fields(header) + MESSAGE_INLINE_FIELD_COUNT);
+}
+
+
 template<typename Type>
 static void
 print_to_stream_type(uint8* pointer)
@@ -138,6 +158,11 @@ handle_reply(port_id replyPort, int32* _code, bigtime_t timeout,
 		return result < 0 ? result : B_ERROR;
 	}
 
+	// let the reply reference the buffer instead of copying it once more
+	result = BMessage::Private(reply).AdoptFlatBuffer(buffer, size);
+	if (result == B_OK)
+		return B_OK;
+
 	result = reply->Unflatten(buffer);
 	free(buffer);
 	return result;
@@ -196,8 +221,7 @@ BMessage::operator=(const BMessage& other)
 
 	_Clear();
 
-	fHeader = (message_header*)malloc(sizeof(message_header));
-	if (fHeader == NULL)
+	if (_AllocateHeader() != B_OK)
 		return *this;
 
 	if (other.fHeader == NULL)
@@ -215,7 +239,7 @@ BMessage::operator=(const BMessage& other)
 	if (fHeader->field_count > 0) {
 		size_t fieldsSize = fHeader->field_count * sizeof(field_header);
 		if (other.fFields != NULL)
-			fFields = (field_header*)malloc(fieldsSize);
+			_AllocateFields(fHeader->field_count);
 
 		if (fFields == NULL) {
 			fHeader->field_count = 0;
@@ -226,20 +250,17 @@ BMessage::operator=(const BMessage& other)
 
 	if (fHeader->data_size > 0) {
 		if (other.fData != NULL)
-			fData = (uint8*)malloc(fHeader->data_size);
+			_AllocateData(fHeader->data_size);
 
 		if (fData == NULL) {
 			fHeader->field_count = 0;
-			free(fFields);
-			fFields = NULL;
+			_FreeFields();
 		} else if (other.fData != NULL)
 			memcpy(fData, other.fData, fHeader->data_size);
 	}
 
 	fHeader->what = what = other.what;
 	fHeader->message_area = -1;
-	fFieldsAvailable = 0;
-	fDataAvailable = 0;
 
 	return *this;
 }
@@ -355,6 +376,7 @@ BMessage::_InitCommon(bool initHeader)
 
 	fFieldsAvailable = 0;
 	fDataAvailable = 0;
+	fStorageFlags = 0;
 
 	fOriginal = NULL;
 	fQueueLink = NULL;
@@ -373,9 +395,9 @@ BMessage::_InitHeader()
 {
 	DEBUG_FUNCTION_ENTER;
 	if (fHeader == NULL) {
-		fHeader = (message_header*)malloc(sizeof(message_header));
-		if (fHeader == NULL)
-			return B_NO_MEMORY;
+		status_t result = _AllocateHeader();
+		if (result != B_OK)
+			return result;
 	}
 
 	memset(fHeader, 0, sizeof(message_header) - sizeof(fHeader->hash_table));
@@ -411,24 +433,178 @@ BMessage::_Clear()
 
 		if (fHeader->message_area >= 0)
 			_Dereference();
+	}
+
+	_FreeFields();
+	_FreeData();
+
+	if (fHeader != NULL) {
+		if ((fStorageFlags & MESSAGE_STORAGE_BLOCK) == 0)
+			free(fHeader);
+		else if (sStorageCache != NULL)
+			sStorageCache->Save(fHeader, MESSAGE_STORAGE_BLOCK_SIZE);
+		else
+			free(fHeader);
 
-		free(fHeader);
 		fHeader = NULL;
 	}
 
-	free(fFields);
-	fFields = NULL;
-	free(fData);
-	fData = NULL;
-
+	fStorageFlags = 0;
 	fArchivingPointer = NULL;
 
+	delete fOriginal;
+	fOriginal = NULL;
+
+	return B_OK;
+}
+
+
+status_t
+BMessage::_AllocateHeader()
+{
+	fStorageFlags = 0;
+
+	if (sStorageCache != NULL) {
+		fHeader = (message_header*)sStorageCache->Get(
+			MESSAGE_STORAGE_BLOCK_SIZE);
+		if (fHeader != NULL) {
+			fStorageFlags = MESSAGE_STORAGE_BLOCK;
+			return B_OK;
+		}
+	}
+
+	fHeader = (message_header*)malloc(sizeof(message_header));
+	if (fHeader == NULL)
+		return B_NO_MEMORY;
+
+	return B_OK;
+}
+
+
+status_t
+BMessage::_AllocateFields(uint32 count)
+{
+	// fFields must not be owned by us at this point
+	if ((fStorageFlags & MESSAGE_STORAGE_BLOCK) != 0
+		&& count <= MESSAGE_INLINE_FIELD_COUNT) {
+		fFields = inline_fields(fHeader);
+		fFieldsAvailable = MESSAGE_INLINE_FIELD_COUNT - count;
+		fStorageFlags |= MESSAGE_STORAGE_INLINE_FIELDS;
+		return B_OK;
+	}
+
 	fFieldsAvailable = 0;
+	fFields = (field_header*)malloc(count * sizeof(field_header));
+	if (fFields == NULL)
+		return B_NO_MEMORY;
+
+	return B_OK;
+}
+
+
+status_t
+BMessage::_AllocateData(size_t size)
+{
+	// fData must not be owned by us at this point
+	if ((fStorageFlags & MESSAGE_STORAGE_BLOCK) != 0
+		&& size <= kInlineDataSize) {
+		fData = inline_data(fHeader);
+		fDataAvailable = kInlineDataSize - size;
+		fStorageFlags |= MESSAGE_STORAGE_INLINE_DATA;
+		return B_OK;
+	}
+
 	fDataAvailable = 0;
+	fData = (uint8*)malloc(size);
+	if (fData == NULL)
+		return B_NO_MEMORY;
 
-	delete fOriginal;
-	fOriginal = NULL;
+	return B_OK;
+}
+
+
+void
+BMessage::_FreeFields()
+{
+	if ((fStorageFlags
+			& (MESSAGE_STORAGE_INLINE_FIELDS | MESSAGE_STORAGE_ADOPTED)) == 0) {
+		free(fFields);
+	}
 
+	fStorageFlags &= ~MESSAGE_STORAGE_INLINE_FIELDS;
+	fFields = NULL;
+	fFieldsAvailable = 0;
+}
+
+
+void
+BMessage::_FreeData()
+{
+	if ((fStorageFlags
+			& (MESSAGE_STORAGE_INLINE_DATA | MESSAGE_STORAGE_ADOPTED)) == 0) {
+		free(fData);
+	}
+
+	fStorageFlags &= ~MESSAGE_STORAGE_INLINE_DATA;
+	fData = NULL;
+	fDataAvailable = 0;
+}
+
+
+/*!	Makes this message use the given flattened message \a buffer as its
+	storage instead of copying it like Unflatten() does. The buffer must have
+	been allocated with malloc(); on success the message takes over ownership
+	of it, on failure the buffer remains the caller's.
+	The fields and data stay in the buffer until the message is modified the
+	first time, at which point _CopyForWrite() moves them to their own
+	allocations.
+*/
+status_t
+BMessage::_AdoptFlatBuffer(void* buffer, size_t size)
+{
+	DEBUG_FUNCTION_ENTER;
+	if (buffer == NULL || size < sizeof(message_header))
+		return B_BAD_VALUE;
+
+	message_header* header = (message_header*)buffer;
+	if (header->format != MESSAGE_FORMAT_HAIKU
+		|| (header->flags & MESSAGE_FLAG_VALID) == 0
+		|| (header->flags & MESSAGE_FLAG_PASS_BY_AREA) != 0
+		|| header->hash_table_size != MESSAGE_BODY_HASH_TABLE_SIZE) {
+		return B_BAD_VALUE;
+	}
+
+	size_t available = size - sizeof(message_header);
+	if (header->field_count > available / sizeof(field_header))
+		return B_BAD_VALUE;
+
+	size_t fieldsSize = header->field_count * sizeof(field_header);
+	if (header->data_size > available - fieldsSize)
+		return B_BAD_VALUE;
+
+	field_header* fields = (field_header*)(header + 1);
+	for (uint32 i = 0; i < header->field_count; i++) {
+		field_header* field = &fields[i];
+		if ((field->next_field >= 0
+				&& (uint32)field->next_field > header->field_count)
+			|| (field->offset + field->name_length + field->data_size
+				> header->data_size)) {
+			return B_BAD_VALUE;
+		}
+	}
+
+	_Clear();
+
+	fHeader = header;
+	fHeader->message_area = -1;
+	fStorageFlags = MESSAGE_STORAGE_ADOPTED;
+
+	if (fHeader->field_count > 0)
+		fFields = fields;
+	if (fHeader->data_size > 0)
+		fData = (uint8*)fields + fieldsSize;
+
+	what = fHeader->what;
 	return B_OK;
 }
 
@@ -769,12 +945,9 @@ BMessage::Rename(const char* oldEntry, const char* newEntry)
 	if (fHeader == NULL)
 		return B_NO_INIT;
 
-	status_t result;
-	if (fHeader->message_area >= 0) {
-		result = _CopyForWrite();
-		if (result != B_OK)
-			return result;
-	}
+	status_t result = _CopyForWrite();
+	if (result != B_OK)
+		return result;
 
 	uint32 hash = _HashName(oldEntry) % fHeader->hash_table_size;
 	int32* nextField = &fHeader->hash_table[hash];
@@ -1216,35 +1389,59 @@ BMessage::_CopyForWrite()
 	if (fHeader == NULL)
 		return B_NO_INIT;
 
-	field_header* newFields = NULL;
-	uint8* newData = NULL;
+	if (fHeader->message_area < 0
+		&& (fStorageFlags & MESSAGE_STORAGE_ADOPTED) == 0) {
+		// we already own our fields and data
+		return B_OK;
+	}
+
+	// fFields and fData currently point into the message area or the
+	// adopted buffer
+	field_header* oldFields = fFields;
+	uint8* oldData = fData;
+	uint32 oldStorageFlags = fStorageFlags;
+	fFields = NULL;
+	fData = NULL;
+	fStorageFlags &= ~MESSAGE_STORAGE_ADOPTED;
 
 	if (fHeader->field_count > 0) {
-		size_t fieldsSize = fHeader->field_count * sizeof(field_header);
-		newFields = (field_header*)malloc(fieldsSize);
-		if (newFields == NULL)
+		if (_AllocateFields(fHeader->field_count) != B_OK) {
+			fFields = oldFields;
+			fData = oldData;
+			fStorageFlags = oldStorageFlags;
 			return B_NO_MEMORY;
+		}
 
-		memcpy(newFields, fFields, fieldsSize);
+		memcpy(fFields, oldFields,
+			fHeader->field_count * sizeof(field_header));
 	}
 
 	if (fHeader->data_size > 0) {
-		newData = (uint8*)malloc(fHeader->data_size);
-		if (newData == NULL) {
-			free(newFields);
+		if (_AllocateData(fHeader->data_size) != B_OK) {
+			_FreeFields();
+			fFields = oldFields;
+			fData = oldData;
+			fStorageFlags = oldStorageFlags;
 			return B_NO_MEMORY;
 		}
 
-		memcpy(newData, fData, fHeader->data_size);
+		memcpy(fData, oldData, fHeader->data_size);
 	}
 
-	_Dereference();
+	if (fHeader->message_area >= 0) {
+		delete_area(fHeader->message_area);
+		fHeader->message_area = -1;
+	}
 
-	fFieldsAvailable = 0;
-	fDataAvailable = 0;
+	if ((oldStorageFlags & MESSAGE_STORAGE_ADOPTED) != 0) {
+		// the header stays at the start of the adopted buffer, but we no
+		// longer need the rest of it
+		message_header* header = (message_header*)realloc(fHeader,
+			sizeof(message_header));
+		if (header != NULL)
+			fHeader = header;
+	}
 
-	fFields = newFields;
-	fData = newData;
 	return B_OK;
 }
 
@@ -1310,8 +1507,7 @@ BMessage::Unflatten(BDataIO* stream)
 
 	_Clear();
 
-	fHeader = (message_header*)malloc(sizeof(message_header));
-	if (fHeader == NULL)
+	if (_AllocateHeader() != B_OK)
 		return B_NO_MEMORY;
 
 	fHeader->format = format;
@@ -1338,8 +1534,7 @@ BMessage::Unflatten(BDataIO* stream)
 
 		if (fHeader->field_count > 0) {
 			ssize_t fieldsSize = fHeader->field_count * sizeof(field_header);
-			fFields = (field_header*)malloc(fieldsSize);
-			if (fFields == NULL) {
+			if (_AllocateFields(fHeader->field_count) != B_OK) {
 				_InitHeader();
 				return B_NO_MEMORY;
 			}
@@ -1350,10 +1545,8 @@ BMessage::Unflatten(BDataIO* stream)
 		}
 
 		if (fHeader->data_size > 0) {
-			fData = (uint8*)malloc(fHeader->data_size);
-			if (fData == NULL) {
-				free(fFields);
-				fFields = NULL;
+			if (_AllocateData(fHeader->data_size) != B_OK) {
+				_FreeFields();
 				_InitHeader();
 				return B_NO_MEMORY;
 			}
@@ -1574,15 +1767,33 @@ BMessage::_ResizeData(uint32 offset, int32 change)
 			return B_OK;
 		}
 
-		// We need to grow the buffer. We try to optimize reallocations by
-		// preallocating space for more fields.
-		size_t size = fHeader->data_size * 2;
-		size = min_c(size, fHeader->data_size + MAX_DATA_PREALLOCATION);
+		if (fData == NULL && fHeader->data_size == 0
+			&& (fStorageFlags & MESSAGE_STORAGE_BLOCK) != 0
+			&& (size_t)change <= kInlineDataSize) {
+			// start out using the data space of the storage block
+			_AllocateData(change);
+			fHeader->data_size += change;
+			return B_OK;
+		}
+
+		// We need to grow the buffer. The buffer is grown geometrically so
+		// that filling large messages doesn't result in quadratic copying.
+		size_t size = fHeader->data_size + fHeader->data_size / 2;
 		size = max_c(size, fHeader->data_size + change);
 
-		uint8* newData = (uint8*)realloc(fData, size);
-		if (size > 0 && newData == NULL)
-			return B_NO_MEMORY;
+		uint8* newData;
+		if ((fStorageFlags & MESSAGE_STORAGE_INLINE_DATA) != 0) {
+			newData = (uint8*)malloc(size);
+			if (newData == NULL)
+				return B_NO_MEMORY;
+
+			memcpy(newData, fData, fHeader->data_size);
+			fStorageFlags &= ~MESSAGE_STORAGE_INLINE_DATA;
+		} else {
+			newData = (uint8*)realloc(fData, size);
+			if (size > 0 && newData == NULL)
+				return B_NO_MEMORY;
+		}
 
 		fData = newData;
 		if (offset < fHeader->data_size) {
@@ -1601,7 +1812,9 @@ BMessage::_ResizeData(uint32 offset, int32 change)
 		fHeader->data_size += change;
 		fDataAvailable -= change;
 
-		if (fDataAvailable > MAX_DATA_PREALLOCATION) {
+		if ((fStorageFlags & MESSAGE_STORAGE_INLINE_DATA) == 0
+			&& fDataAvailable > MAX_DATA_PREALLOCATION
+			&& fDataAvailable > fHeader->data_size) {
 			ssize_t available = MAX_DATA_PREALLOCATION / 2;
 			ssize_t size = fHeader->data_size + available;
 			uint8* newData = (uint8*)realloc(fData, size);
@@ -1682,16 +1895,33 @@ BMessage::_AddField(const char* name, type_code type, bool isFixedSize,
 		return B_NO_INIT;
 
 	if (fFieldsAvailable <= 0) {
-		uint32 count = fHeader->field_count * 2 + 1;
-		count = min_c(count, fHeader->field_count + MAX_FIELD_PREALLOCATION);
-
-		field_header* newFields = (field_header*)realloc(fFields,
-			count * sizeof(field_header));
-		if (count > 0 && newFields == NULL)
-			return B_NO_MEMORY;
+		if (fFields == NULL && fHeader->field_count == 0
+			&& (fStorageFlags & MESSAGE_STORAGE_BLOCK) != 0) {
+			// start out using the field slots of the storage block
+			_AllocateFields(0);
+		} else {
+			uint32 count = fHeader->field_count * 2 + 1;
+
+			field_header* newFields;
+			if ((fStorageFlags & MESSAGE_STORAGE_INLINE_FIELDS) != 0) {
+				newFields = (field_header*)malloc(
+					count * sizeof(field_header));
+				if (newFields == NULL)
+					return B_NO_MEMORY;
+
+				memcpy(newFields, fFields,
+					fHeader->field_count * sizeof(field_header));
+				fStorageFlags &= ~MESSAGE_STORAGE_INLINE_FIELDS;
+			} else {
+				newFields = (field_header*)realloc(fFields,
+					count * sizeof(field_header));
+				if (count > 0 && newFields == NULL)
+					return B_NO_MEMORY;
+			}
 
-		fFields = newFields;
-		fFieldsAvailable = count - fHeader->field_count;
+			fFields = newFields;
+			fFieldsAvailable = count - fHeader->field_count;
+		}
 	}
 
 	uint32 hash = _HashName(name) % fHeader->hash_table_size;
@@ -1757,7 +1987,9 @@ BMessage::_RemoveField(field_header* field)
 	fHeader->field_count--;
 	fFieldsAvailable++;
 
-	if (fFieldsAvailable > MAX_FIELD_PREALLOCATION) {
+	if ((fStorageFlags & MESSAGE_STORAGE_INLINE_FIELDS) == 0
+		&& fFieldsAvailable > MAX_FIELD_PREALLOCATION
+		&& fFieldsAvailable > fHeader->field_count) {
 		ssize_t available = MAX_FIELD_PREALLOCATION / 2;
 		size = (fHeader->field_count + available) * sizeof(field_header);
 		field_header* newFields = (field_header*)realloc(fFields, size);
@@ -1788,12 +2020,9 @@ BMessage::AddData(const char* name, type_code type, const void* data,
 	if (fHeader == NULL)
 		return B_NO_INIT;
 
-	status_t result;
-	if (fHeader->message_area >= 0) {
-		result = _CopyForWrite();
-		if (result != B_OK)
-			return result;
-	}
+	status_t result = _CopyForWrite();
+	if (result != B_OK)
+		return result;
 
 	field_header* field = NULL;
 	result = _FindField(name, type, &field);
@@ -1853,12 +2082,9 @@ BMessage::RemoveData(const char* name, int32 index)
 	if (fHeader == NULL)
 		return B_NO_INIT;
 
-	status_t result;
-	if (fHeader->message_area >= 0) {
-		result = _CopyForWrite();
-		if (result != B_OK)
-			return result;
-	}
+	status_t result = _CopyForWrite();
+	if (result != B_OK)
+		return result;
 
 	field_header* field = NULL;
 	result = _FindField(name, B_ANY_TYPE, &field);
@@ -1906,12 +2132,9 @@ BMessage::RemoveName(const char* name)
 	if (fHeader == NULL)
 		return B_NO_INIT;
 
-	status_t result;
-	if (fHeader->message_area >= 0) {
-		result = _CopyForWrite();
-		if (result != B_OK)
-			return result;
-	}
+	status_t result = _CopyForWrite();
+	if (result != B_OK)
+		return result;
 
 	field_header* field = NULL;
 	result = _FindField(name, B_ANY_TYPE, &field);
@@ -1975,12 +2198,9 @@ BMessage::ReplaceData(const char* name, type_code type, int32 index,
 	if (numBytes <= 0 || data == NULL)
 		return B_BAD_VALUE;
 
-	status_t result;
-	if (fHeader->message_area >= 0) {
-		result = _CopyForWrite();
-		if (result != B_OK)
-			return result;
-	}
+	status_t result = _CopyForWrite();
+	if (result != B_OK)
+		return result;
 
 	field_header* field = NULL;
 	result = _FindField(name, type, &field);
@@ -2052,6 +2272,8 @@ BMessage::_StaticInit()
 	sReplyPortInUse[2] = 0;
 
 	sMsgCache = new BBlockCache(20, sizeof(BMessage), B_OBJECT_CACHE);
+	sStorageCache = new BBlockCache(20, MESSAGE_STORAGE_BLOCK_SIZE,
+		B_MALLOC_CACHE);
 }
 
 
@@ -2090,6 +2312,11 @@ BMessage::_StaticCacheCleanup()
 	DEBUG_FUNCTION_ENTER2;
 	delete sMsgCache;
 	sMsgCache = NULL;
+
+	// Messages still alive after this point free their storage blocks
+	// directly, which works since the cache allocates them via malloc().
+	delete sStorageCache;
+	sStorageCache = NULL;
 }
 
 
@@ -2246,8 +2473,9 @@ BMessage::_SendMessage(port_id port, team_id portOwner, int32 token,
 			char(what >> 24), char(what >> 16), char(what >> 8), (char)what);
 
 		// this is a local message transmission
-		direct->AddMessage(copy);
-		if (direct->Queue()->IsNextMessage(copy) && port_count(port) <= 0) {
+		bool wasEmpty;
+		if (direct->AddMessage(copy, &wasEmpty) && wasEmpty
+			&& port_count(port) <= 0) {
 			// there is currently no message waiting, and we need to wakeup the
 			// looper
 			write_port_etc(port, 0, NULL, 0, B_RELATIVE_TIMEOUT, 0);
@@ -2929,7 +2929,7 @@ BWindow::_DequeueAll()
 	for (int32 i = 0; i < count; i++) {
 		BMessage* message = MessageFromPort(0);
 		if (message != NULL)
-			fDirectTarget->Queue()->AddMessage(message);
+			_AddMessagePriv(message);
 	}
 }
 
@@ -2979,7 +2979,7 @@ BWindow::task_looper()
 		while (!fTerminating && dispatchNextMessage) {
 			// Get next message from queue (assign to fLastMessage after
 			// locking)
-			BMessage* message = fDirectTarget->Queue()->NextMessage();
+			BMessage* message = fDirectTarget->NextMessage();
 
 			// Lock the looper
 			if (!Lock()) {
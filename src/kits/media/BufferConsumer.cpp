@@ -28,11 +28,14 @@
 
 
 #include "BufferCache.h"
+#include "BufferRing.h"
 #include <BufferConsumer.h>
 
 #include <stdlib.h>
 #include <string.h>
 
+#include <new>
+
 #include <AutoDeleter.h>
 #include <BufferProducer.h>
 #include <BufferGroup.h>
@@ -50,6 +53,7 @@ BBufferConsumer::~BBufferConsumer()
 	CALLED();
 	delete fBufferCache;
 	delete fDeleteBufferGroup;
+	delete fBufferRings;
 }
 
 
@@ -89,7 +93,8 @@ BBufferConsumer::BBufferConsumer(media_type consumerType)
 	BMediaNode("called by BBufferConsumer"),
 	fConsumerType(consumerType),
 	fBufferCache(new BPrivate::BufferCache),
-	fDeleteBufferGroup(0)
+	fDeleteBufferGroup(0),
+	fBufferRings(new(std::nothrow) BPrivate::BufferRingList)
 {
 	CALLED();
 
@@ -378,21 +383,51 @@ BBufferConsumer::HandleMessage(int32 message, const void* data, size_t size)
 		{
 			const consumer_buffer_received_command* command
 				= static_cast<const consumer_buffer_received_command*>(data);
+			_ReceiveBuffer(command->buffer, command->header);
+			return B_OK;
+		}
 
-			BBuffer* buffer = fBufferCache->GetBuffer(command->buffer,
-				command->header.source_port);
-			if (buffer == NULL) {
-				ERROR("BBufferConsumer::CONSUMER_BUFFER_RECEIVED can't"
-					"find the buffer\n");
-			} else {
-				buffer->SetHeader(&command->header);
+		case CONSUMER_CREATE_BUFFER_RING:
+		{
+			const consumer_create_buffer_ring_request* request
+				= static_cast<const consumer_create_buffer_ring_request*>(data);
+			consumer_create_buffer_ring_reply reply;
+
+			status_t status = B_NO_MEMORY;
+			BPrivate::BufferRing* ring = new(std::nothrow) BPrivate::BufferRing(
+				request->source, request->destination);
+			if (ring != NULL && fBufferRings != NULL)
+				status = ring->Create();
+
+			if (status == B_OK) {
+				reply.area = ring->Area();
+				fBufferRings->Add(ring);
+			} else
+				delete ring;
 
-				PRINT(4, "calling BBufferConsumer::BufferReceived buffer %ld "
-					"at perf %Ld and TimeSource()->Now() is %Ld\n",
-					buffer->Header()->buffer, buffer->Header()->start_time,
-					TimeSource()->Now());
+			request->SendReply(status, &reply, sizeof(reply));
+			return B_OK;
+		}
 
-				BufferReceived(buffer);
+		case CONSUMER_BUFFER_RING_NOTIFY:
+		{
+			const consumer_buffer_ring_notify_command* command
+				= static_cast<const consumer_buffer_ring_notify_command*>(data);
+			BPrivate::BufferRing* ring = fBufferRings != NULL
+				? fBufferRings->Find(command->destination) : NULL;
+			if (ring == NULL)
+				return B_OK;
+
+			_DrainBufferRing(ring, BPrivate::BufferRing::kSize);
+
+			if (!ring->IsEmpty()) {
+				// The producer keeps filling the ring. Let the other messages
+				// in, and continue afterwards; the producer won't notify us
+				// again until the ring has been empty.
+				consumer_buffer_ring_notify_command again = *command;
+				if (write_port_etc(ControlPort(), CONSUMER_BUFFER_RING_NOTIFY,
+						&again, sizeof(again), B_RELATIVE_TIMEOUT, 0) != B_OK)
+					_DrainBufferRing(ring, INT32_MAX);
 			}
 			return B_OK;
 		}
@@ -426,6 +461,19 @@ BBufferConsumer::HandleMessage(int32 message, const void* data, size_t size)
 		case CONSUMER_DISCONNECTED:
 		{
 			const consumer_disconnected_request *request = static_cast<const consumer_disconnected_request *>(data);
+
+			// The producer has already stopped using the ring, take the
+			// buffers it left there.
+			if (fBufferRings != NULL) {
+				BPrivate::BufferRing* ring = fBufferRings->Remove(
+					request->source, request->destination);
+				if (ring != NULL) {
+					ring->Close();
+					_DrainBufferRing(ring, INT32_MAX);
+					ring->ReleaseReference();
+				}
+			}
+
 			// We no longer need to cache the buffers requested by the other end
 			// of this port.
 			fBufferCache->FlushCacheForPort(request->source.port);
@@ -486,6 +534,37 @@ BBufferConsumer::SeekTagRequested(const media_destination &destination,
 // #pragma mark - private BBufferConsumer
 
 
+void
+BBufferConsumer::_ReceiveBuffer(media_buffer_id bufferID,
+	const media_header& header)
+{
+	BBuffer* buffer = fBufferCache->GetBuffer(bufferID, header.source_port);
+	if (buffer == NULL) {
+		ERROR("BBufferConsumer::_ReceiveBuffer can't find the buffer\n");
+		return;
+	}
+
+	buffer->SetHeader(&header);
+
+	PRINT(4, "calling BBufferConsumer::BufferReceived buffer %ld "
+		"at perf %Ld and TimeSource()->Now() is %Ld\n",
+		buffer->Header()->buffer, buffer->Header()->start_time,
+		TimeSource()->Now());
+
+	BufferReceived(buffer);
+}
+
+
+void
+BBufferConsumer::_DrainBufferRing(BPrivate::BufferRing* ring, int32 maxCount)
+{
+	media_buffer_id bufferID;
+	media_header header;
+	for (int32 i = 0; i < maxCount && ring->Pop(bufferID, header); i++)
+		_ReceiveBuffer(bufferID, header);
+}
+
+
 /*
 not implemented:
 BBufferConsumer::BBufferConsumer()
@@ -5,11 +5,16 @@
  */
 
 
+#include <new>
+
 #include <Buffer.h>
 #include <BufferConsumer.h>
 #include <BufferGroup.h>
 #include <BufferProducer.h>
 
+#include <AutoLocker.h>
+
+#include "BufferRing.h"
 #include "MediaDebug.h"
 #include "DataExchange.h"
 #include "MediaMisc.h"
@@ -21,6 +26,7 @@
 BBufferProducer::~BBufferProducer()
 {
 	CALLED();
+	delete fBufferRings;
 }
 
 
@@ -58,7 +64,8 @@ BBufferProducer::BBufferProducer(media_type producer_type)
 	fProducerType(producer_type),
 	fInitialLatency(0),
 	fInitialFlags(0),
-	fDelay(0)
+	fDelay(0),
+	fBufferRings(new(std::nothrow) BPrivate::BufferRingList)
 {
 	CALLED();
 
@@ -150,6 +157,28 @@ BBufferProducer::HandleMessage(int32 message, const void* data, size_t size)
 			return B_OK;
 		}
 
+		case PRODUCER_SET_BUFFER_RING:
+		{
+			const producer_set_buffer_ring_request* request
+				= static_cast<const producer_set_buffer_ring_request*>(data);
+			producer_set_buffer_ring_reply reply;
+
+			status_t status = B_NO_MEMORY;
+			BPrivate::BufferRing* ring = new(std::nothrow) BPrivate::BufferRing(
+				request->source, request->destination);
+			if (ring != NULL && fBufferRings != NULL)
+				status = ring->Clone(request->area);
+
+			if (status == B_OK) {
+				AutoLocker<BPrivate::BufferRingList> locker(fBufferRings);
+				fBufferRings->Add(ring);
+			} else
+				delete ring;
+
+			request->SendReply(status, &reply, sizeof(reply));
+			return B_OK;
+		}
+
 		case PRODUCER_FORMAT_SUGGESTION_REQUESTED:
 		{
 			const producer_format_suggestion_requested_request* request
@@ -205,6 +234,16 @@ BBufferProducer::HandleMessage(int32 message, const void* data, size_t size)
 			const producer_disconnect_request* request
 				= static_cast<const producer_disconnect_request*>(data);
 			producer_disconnect_reply reply;
+			if (fBufferRings != NULL) {
+				// wakes up a SendBuffer() waiting for room in the ring
+				AutoLocker<BPrivate::BufferRingList> locker(fBufferRings);
+				BPrivate::BufferRing* ring = fBufferRings->Remove(
+					request->source, request->destination);
+				if (ring != NULL) {
+					ring->Close();
+					ring->ReleaseReference();
+				}
+			}
 			Disconnect(request->source, request->destination);
 			request->SendReply(B_OK, &reply, sizeof(reply));
 			return B_OK;
@@ -447,6 +486,29 @@ BBufferProducer::SendBuffer(BBuffer* buffer, const media_source& source,
 
 	//printf("BBufferProducer::SendBuffer     node %2ld, buffer %2ld, start_time %12Ld with lateness %6Ld\n", ID(), buffer->Header()->buffer, command.header.start_time, TimeSource()->Now() - command.header.start_time);
 
+	if (fBufferRings != NULL) {
+		// Use the ring shared with the consumer, if there is one. If it has
+		// been closed, the port is used again. The list isn't kept locked
+		// while waiting for room in the ring, so that the connection can
+		// still be disconnected.
+		BReference<BPrivate::BufferRing> ring;
+		{
+			AutoLocker<BPrivate::BufferRingList> locker(fBufferRings);
+			ring.SetTo(fBufferRings->Find(destination));
+		}
+		if (ring.Get() != NULL) {
+			status_t status = ring->Push(command.buffer, command.header);
+			if (status != B_MEDIA_BAD_DESTINATION && status != B_BAD_PORT_ID)
+				return status;
+
+			AutoLocker<BPrivate::BufferRingList> locker(fBufferRings);
+			if (fBufferRings->Remove(ring.Get()))
+				ring->ReleaseReference();
+			if (status == B_BAD_PORT_ID)
+				return status;
+		}
+	}
+
 	return SendToPort(destination.port, CONSUMER_BUFFER_RECEIVED, &command,
 		sizeof(command));
 }
@@ -0,0 +1,337 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	A shared memory ring to pass buffers from a producer to a consumer.
+
+	The consumer creates the ring when the two are connected, and the producer
+	clones it. BBufferProducer::SendBuffer() then puts the buffer ID and header
+	into the ring instead of writing them to the consumer's port. Only when the
+	ring goes from empty to non-empty, a message is written to the consumer's
+	port to wake it up; the consumer then takes all buffers out of the ring.
+
+	There is one reader and one writer per ring. Only the writer increases
+	the count of used entries and only the reader decreases it, and each of
+	them only touches the entries on its side of the count.
+
+	When the ring is full, the producer waits on a semaphore the consumer
+	created along with the ring. The consumer releases it when it takes a
+	buffer out while the producer is waiting, or when it closes the ring.
+	If the consumer's team goes away, so does the semaphore.
+*/
+
+
+#include "BufferRing.h"
+
+#include <string.h>
+
+#include <AutoLocker.h>
+#include <OS.h>
+
+#include "DataExchange.h"
+#include "MediaDebug.h"
+
+
+namespace BPrivate {
+
+
+static const uint32 kBufferRingMagic = 'bfrg';
+static const bigtime_t kFullRingTimeout = 15000000;
+	// like the timeout for writing to a port
+
+
+struct buffer_ring_entry {
+	media_buffer_id			buffer;
+	media_header			header;
+};
+
+struct buffer_ring_data {
+	uint32					magic;
+	int32					size;
+	int32					count;
+	int32					closed;
+	int32					waiting;
+	sem_id					space_semaphore;
+	buffer_ring_entry		entries[BufferRing::kSize];
+};
+
+
+static size_t
+buffer_ring_area_size()
+{
+	return (sizeof(buffer_ring_data) + B_PAGE_SIZE - 1) & ~(B_PAGE_SIZE - 1);
+}
+
+
+BufferRing::BufferRing(const media_source& source,
+	const media_destination& destination)
+	:
+	fArea(-1),
+	fData(NULL),
+	fSource(source),
+	fDestination(destination),
+	fPushLock("buffer ring push"),
+	fSpaceSemaphore(-1),
+	fOwnsSemaphore(false),
+	fIndex(0),
+	fNotifyPending(false)
+{
+}
+
+
+BufferRing::~BufferRing()
+{
+	if (fOwnsSemaphore) {
+		Close();
+		delete_sem(fSpaceSemaphore);
+	}
+	if (fArea >= 0)
+		delete_area(fArea);
+}
+
+
+/*!	Creates the ring, to be called by the consumer. */
+status_t
+BufferRing::Create()
+{
+	void* address;
+	fArea = create_area("buffer ring", &address, B_ANY_ADDRESS,
+		buffer_ring_area_size(), B_FULL_LOCK,
+		B_READ_AREA | B_WRITE_AREA | B_CLONEABLE_AREA);
+	if (fArea < 0)
+		return fArea;
+
+	fSpaceSemaphore = create_sem(0, "buffer ring space");
+	if (fSpaceSemaphore < 0)
+		return fSpaceSemaphore;
+	fOwnsSemaphore = true;
+
+	fData = (buffer_ring_data*)address;
+	fData->magic = kBufferRingMagic;
+	fData->size = kSize;
+	fData->count = 0;
+	fData->closed = 0;
+	fData->waiting = 0;
+	fData->space_semaphore = fSpaceSemaphore;
+	return B_OK;
+}
+
+
+/*!	Maps the consumer's ring, to be called by the producer. */
+status_t
+BufferRing::Clone(area_id area)
+{
+	void* address;
+	fArea = clone_area("buffer ring clone", &address, B_ANY_ADDRESS,
+		B_READ_AREA | B_WRITE_AREA, area);
+	if (fArea < 0)
+		return fArea;
+
+	area_info info;
+	status_t status = get_area_info(fArea, &info);
+	if (status != B_OK)
+		return status;
+
+	fData = (buffer_ring_data*)address;
+	if (info.size < sizeof(buffer_ring_data) || fData->magic != kBufferRingMagic
+		|| fData->size != kSize) {
+		return B_BAD_DATA;
+	}
+
+	fSpaceSemaphore = fData->space_semaphore;
+	return B_OK;
+}
+
+
+/*!	Adds the buffer to the ring. If the ring is full, this waits until the
+	consumer has made room, as writing to its full port would.
+	Returns \c B_MEDIA_BAD_DESTINATION without having added the buffer if the
+	ring has been closed, or if the consumer is gone; the buffer should then
+	be written to the consumer's port instead. Returns \c B_BAD_PORT_ID if the
+	consumer's port is gone after the buffer was added; the ring is closed
+	then as well.
+	May be called from any thread, but senders to the same ring are
+	serialized.
+*/
+status_t
+BufferRing::Push(media_buffer_id buffer, const media_header& header)
+{
+	AutoLocker<BLocker> locker(fPushLock);
+
+	bigtime_t timeout = system_time() + kFullRingTimeout;
+	while (true) {
+		if (atomic_get(&fData->closed) != 0)
+			return B_MEDIA_BAD_DESTINATION;
+		if (atomic_get(&fData->count) < kSize)
+			break;
+
+		// the consumer might not have been woken up yet
+		if (fNotifyPending && _Notify() == B_BAD_PORT_ID)
+			continue;
+
+		// Announce that we are waiting before looking at the count again, so
+		// that the consumer cannot make room without seeing it.
+		atomic_set(&fData->waiting, 1);
+		if (atomic_get(&fData->count) < kSize
+			|| atomic_get(&fData->closed) != 0) {
+			continue;
+		}
+
+		status_t status = acquire_sem_etc(fSpaceSemaphore, 1,
+			B_ABSOLUTE_TIMEOUT, timeout);
+		if (status == B_TIMED_OUT)
+			return B_TIMED_OUT;
+		if (status == B_BAD_SEM_ID) {
+			// the consumer's team is gone
+			Close();
+		}
+	}
+
+	buffer_ring_entry& entry = fData->entries[fIndex];
+	entry.buffer = buffer;
+	entry.header = header;
+	fIndex = (fIndex + 1) % kSize;
+
+	// atomic_add() orders the entry's stores before the count's
+	if (atomic_add(&fData->count, 1) == 0 || fNotifyPending) {
+		status_t status = _Notify();
+		if (status == B_BAD_PORT_ID)
+			return status;
+	}
+
+	return B_OK;
+}
+
+
+bool
+BufferRing::Pop(media_buffer_id& _buffer, media_header& _header)
+{
+	if (atomic_get(&fData->count) == 0)
+		return false;
+
+	const buffer_ring_entry& entry = fData->entries[fIndex];
+	_buffer = entry.buffer;
+	_header = entry.header;
+	fIndex = (fIndex + 1) % kSize;
+
+	// the producer may reuse the entry from here on
+	atomic_add(&fData->count, -1);
+	if (atomic_get_and_set(&fData->waiting, 0) != 0)
+		release_sem_etc(fSpaceSemaphore, 1, B_DO_NOT_RESCHEDULE);
+	return true;
+}
+
+
+bool
+BufferRing::IsEmpty() const
+{
+	return atomic_get(&fData->count) == 0;
+}
+
+
+/*!	Tells the producer not to use the ring anymore. It will then write to the
+	consumer's port again. A producer waiting for room is woken up.
+*/
+void
+BufferRing::Close()
+{
+	if (fData == NULL)
+		return;
+
+	atomic_set(&fData->closed, 1);
+	if (fSpaceSemaphore >= 0)
+		release_sem_etc(fSpaceSemaphore, 1, B_DO_NOT_RESCHEDULE);
+}
+
+
+/*!	Wakes up the consumer. If its port is gone, the consumer is, too, and the
+	ring is closed.
+*/
+status_t
+BufferRing::_Notify()
+{
+	consumer_buffer_ring_notify_command command;
+	command.destination = fDestination;
+
+	status_t status = SendToPort(fDestination.port,
+		CONSUMER_BUFFER_RING_NOTIFY, &command, sizeof(command));
+	fNotifyPending = status != B_OK && status != B_BAD_PORT_ID;
+	if (status == B_BAD_PORT_ID)
+		Close();
+
+	return status;
+}
+
+
+// #pragma mark -
+
+
+BufferRingList::BufferRingList()
+	:
+	fLock("buffer rings"),
+	fRings(4, false)
+{
+}
+
+
+BufferRingList::~BufferRingList()
+{
+	for (int32 i = 0; BufferRing* ring = fRings.ItemAt(i); i++)
+		ring->ReleaseReference();
+}
+
+
+/*!	Adds the ring, and releases any previous one for the same connection.
+	The list takes over the caller's reference to the ring.
+	The producer needs to lock the list, since buffers may be sent from any
+	of its threads; it acquires a reference to a ring it found before it
+	unlocks the list again. The consumer only uses it from its control thread.
+*/
+void
+BufferRingList::Add(BufferRing* ring)
+{
+	BufferRing* previous = Remove(ring->Source(), ring->Destination());
+	if (previous != NULL)
+		previous->ReleaseReference();
+	fRings.AddItem(ring);
+}
+
+
+BufferRing*
+BufferRingList::Remove(const media_source& source,
+	const media_destination& destination)
+{
+	for (int32 i = 0; BufferRing* ring = fRings.ItemAt(i); i++) {
+		if (ring->Source() == source && ring->Destination() == destination)
+			return fRings.RemoveItemAt(i);
+	}
+
+	return NULL;
+}
+
+
+/*!	Removes the ring if it's still in the list. On success, the caller gets
+	the list's reference to it.
+*/
+bool
+BufferRingList::Remove(BufferRing* ring)
+{
+	return fRings.RemoveItem(ring);
+}
+
+
+BufferRing*
+BufferRingList::Find(const media_destination& destination) const
+{
+	for (int32 i = 0; BufferRing* ring = fRings.ItemAt(i); i++) {
+		if (ring->Destination() == destination)
+			return ring;
+	}
+
+	return NULL;
+}
+
+
+}	// namespace BPrivate
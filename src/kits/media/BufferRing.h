@@ -0,0 +1,91 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef _BUFFER_RING_H_
+#define _BUFFER_RING_H_
+
+
+#include <Locker.h>
+#include <MediaDefs.h>
+#include <ObjectList.h>
+#include <Referenceable.h>
+
+
+namespace BPrivate {
+
+
+struct buffer_ring_data;
+
+
+class BufferRing : public BReferenceable {
+public:
+	static	const int32			kSize = 64;
+
+								BufferRing(const media_source& source,
+									const media_destination& destination);
+								~BufferRing();
+
+			status_t			Create();
+			status_t			Clone(area_id area);
+
+			area_id				Area() const
+									{ return fArea; }
+			const media_source&	Source() const
+									{ return fSource; }
+			const media_destination& Destination() const
+									{ return fDestination; }
+
+	// producer side
+			status_t			Push(media_buffer_id buffer,
+									const media_header& header);
+
+	// consumer side
+			bool				Pop(media_buffer_id& _buffer,
+									media_header& _header);
+			bool				IsEmpty() const;
+			void				Close();
+
+private:
+			status_t			_Notify();
+
+private:
+			area_id				fArea;
+			buffer_ring_data*	fData;
+			media_source		fSource;
+			media_destination	fDestination;
+			BLocker				fPushLock;
+			sem_id				fSpaceSemaphore;
+			bool				fOwnsSemaphore;
+			int32				fIndex;
+			bool				fNotifyPending;
+};
+
+
+class BufferRingList {
+public:
+								BufferRingList();
+								~BufferRingList();
+
+			bool				Lock()
+									{ return fLock.Lock(); }
+			void				Unlock()
+									{ fLock.Unlock(); }
+
+			void				Add(BufferRing* ring);
+			BufferRing*			Remove(const media_source& source,
+									const media_destination& destination);
+			bool				Remove(BufferRing* ring);
+			BufferRing*			Find(const media_destination& destination)
+									const;
+
+private:
+			BLocker				fLock;
+			BObjectList<BufferRing> fRings;
+};
+
+
+}	// namespace BPrivate
+
+
+#endif	// _BUFFER_RING_H_
@@ -10,24 +10,85 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <Autolock.h>
+
 #include "MediaDebug.h"
 
+
+static const int32 kMinReadAhead = 4;
+static const int32 kInitialReadAhead = 10;
+static const bigtime_t kReadAheadTime = 500000;
+	// how far the chunks read ahead should reach at the consumer's rate
+
+
+ChunkQueue::ChunkQueue()
+	:
+	fHead(0),
+	fTail(0)
+{
+}
+
+
+int32
+ChunkQueue::Count()
+{
+	return (atomic_get(&fTail) - atomic_get(&fHead) + kSize) % kSize;
+}
+
+
+bool
+ChunkQueue::Push(chunk_buffer* chunk)
+{
+	int32 tail = atomic_get(&fTail);
+	int32 next = (tail + 1) % kSize;
+	if (next == atomic_get(&fHead))
+		return false;
+
+	fEntries[tail] = chunk;
+	atomic_set(&fTail, next);
+		// publishes the entry
+	return true;
+}
+
+
+chunk_buffer*
+ChunkQueue::Pop()
+{
+	int32 head = atomic_get(&fHead);
+	if (head == atomic_get(&fTail))
+		return NULL;
+
+	chunk_buffer* chunk = fEntries[head];
+	atomic_set(&fHead, (head + 1) % kSize);
+		// hands the entry back to the producer
+	return chunk;
+}
+
+
 // #pragma mark -
 
 
-ChunkCache::ChunkCache(sem_id waitSem, size_t maxBytes)
+ChunkCache::ChunkCache(sem_id waitSem, rtm_pool* pool, size_t maxBytes)
 	:
 	BLocker("media chunk cache"),
-	fWaitSem(waitSem)
+	fRealTimePool(pool),
+	fWaitSem(waitSem),
+	fMaxBytes(maxBytes),
+	fUsedBytes(0),
+	fWaiting(0),
+	fReadAhead(kInitialReadAhead),
+	fLastConsumed(0),
+	fConsumeInterval(0)
 {
-	rtm_create_pool(&fRealTimePool, maxBytes, "media chunk cache");
-	fMaxBytes = rtm_available(fRealTimePool);
 }
 
 
 ChunkCache::~ChunkCache()
 {
-	rtm_delete_pool(fRealTimePool);
+	while (chunk_buffer* chunk = fChunkCache.Pop())
+		_FreeChunk(chunk);
+	while (chunk_buffer* chunk = fUnusedChunks.Pop())
+		_FreeChunk(chunk);
 }
 
 
@@ -41,118 +102,218 @@ ChunkCache::InitCheck() const
 }
 
 
+/*!	Called by the stream's consumer with the cache locked. */
 void
 ChunkCache::MakeEmpty()
 {
 	ASSERT(IsLocked());
 
-	while (!fChunkCache.empty()) {
-		RecycleChunk(fChunkCache.front());
-		fChunkCache.pop();
-	}
-	
+	while (chunk_buffer* chunk = fChunkCache.Pop())
+		RecycleChunk(chunk);
+
+	// the time until the next chunk is consumed says nothing about the rate
+	fLastConsumed = 0;
+
 	release_sem(fWaitSem);
 }
 
 
+/*!	Called by the extractor thread. If there is no space left, the next
+	consumed chunk wakes the thread up again.
+*/
 bool
-ChunkCache::SpaceLeft() const
+ChunkCache::SpaceLeft()
 {
-	ASSERT(IsLocked());
+	if (_SpaceLeft())
+		return true;
 
-	if (fChunkCache.size() >= CACHE_MAX_ENTRIES) {
-		return false;
-	}
+	atomic_set(&fWaiting, 1);
 
-	// If there is no more memory we are likely to fail soon after
-	return sizeof(chunk_buffer) + 2048 < rtm_available(fRealTimePool);
+	// a chunk might have been consumed in the meantime
+	return _SpaceLeft();
 }
 
 
+/*!	Called by the stream's consumer. Returns the next chunk, and reads it
+	directly, if the cache is drained.
+*/
 chunk_buffer*
 ChunkCache::NextChunk(Reader* reader, void* cookie)
 {
-	ASSERT(IsLocked());
+	chunk_buffer* chunk = fChunkCache.Pop();
+	_UpdateReadAhead(chunk == NULL);
 
-	chunk_buffer* chunk = NULL;
+	if (chunk == NULL) {
+		BAutolock _(this);
 
-	if (fChunkCache.empty()) {
-		TRACE("ChunkCache is empty, going direct to reader\n");
-		if (ReadNextChunk(reader, cookie)) {
-			return NextChunk(reader, cookie);
+		// the extractor thread might have added one while we waited
+		chunk = fChunkCache.Pop();
+		if (chunk == NULL) {
+			TRACE("ChunkCache is empty, going direct to reader\n");
+			chunk = _ReadChunk(reader, cookie);
 		}
-	} else {
-		chunk = fChunkCache.front();
-		fChunkCache.pop();
-		
-		release_sem(fWaitSem);
 	}
 
+	if (atomic_get_and_set(&fWaiting, 0) != 0)
+		release_sem(fWaitSem);
+
 	return chunk;
 }
 
 
-/*	Moves the specified chunk to the unused list.
-	This means the chunk data can be overwritten again.
+/*!	Called by the stream's consumer. Keeps the chunk and its buffer for
+	reuse, unless the stream has used up its share of the pool.
 */
 void
 ChunkCache::RecycleChunk(chunk_buffer* chunk)
 {
-	ASSERT(IsLocked());
-
-	rtm_free(chunk->buffer);
-	chunk->capacity = 0;
-	chunk->size = 0;
-	chunk->buffer = NULL;
-	fUnusedChunks.push_back(chunk);
+	if (_OverBudget() || !fUnusedChunks.Push(chunk))
+		_FreeChunk(chunk);
 }
 
 
+/*!	Called by the extractor thread with the cache locked. */
 bool
 ChunkCache::ReadNextChunk(Reader* reader, void* cookie)
 {
 	ASSERT(IsLocked());
 
+	if (fChunkCache.Count() >= ChunkQueue::kMaxEntries)
+		return false;
+
+	chunk_buffer* chunk = _ReadChunk(reader, cookie);
+	if (chunk == NULL) {
+		atomic_set(&fWaiting, 1);
+		return false;
+	}
+
+	// the consumer may take the chunk as soon as it is added
+	status_t status = chunk->status;
+
+	fChunkCache.Push(chunk);
+		// can't fail, only this thread adds chunks
+
+	if (status != B_OK) {
+		// there is nothing more to read before the next seek
+		atomic_set(&fWaiting, 1);
+		return false;
+	}
+
+	return true;
+}
+
+
+chunk_buffer*
+ChunkCache::_ReadChunk(Reader* reader, void* cookie)
+{
+	ASSERT(IsLocked());
+
 	// retrieve chunk buffer
-	chunk_buffer* chunk = NULL;
-	if (fUnusedChunks.empty()) {
+	chunk_buffer* chunk = fUnusedChunks.Pop();
+	if (chunk == NULL) {
 		// allocate a new one
 		chunk = (chunk_buffer*)rtm_alloc(fRealTimePool, sizeof(chunk_buffer));
 		if (chunk == NULL) {
 			ERROR("RTM Pool empty allocating chunk buffer structure");
-			return false;
+			return NULL;
 		}
-		
+
 		chunk->size = 0;
 		chunk->capacity = 0;
 		chunk->buffer = NULL;
-
-	} else {
-		chunk = fUnusedChunks.front();
-		fUnusedChunks.pop_front();
+		atomic_add(&fUsedBytes, sizeof(chunk_buffer));
 	}
 
 	const void* buffer;
 	size_t bufferSize;
 	chunk->status = reader->GetNextChunk(cookie, &buffer, &bufferSize,
 		&chunk->header);
-	if (chunk->status == B_OK) {
-		if (chunk->capacity < bufferSize) {
-			// adapt buffer size
-			rtm_free(chunk->buffer);
-			chunk->capacity = (bufferSize + 2047) & ~2047;
-			chunk->buffer = rtm_alloc(fRealTimePool, chunk->capacity);
-			if (chunk->buffer == NULL) {
-				rtm_free(chunk);
-				ERROR("RTM Pool empty allocating chunk buffer\n");
-				return false;
-			}
+	if (chunk->status != B_OK) {
+		chunk->size = 0;
+		return chunk;
+	}
+
+	if (chunk->capacity < bufferSize) {
+		// adapt buffer size
+		rtm_free(chunk->buffer);
+		atomic_add(&fUsedBytes, -(int32)chunk->capacity);
+
+		chunk->capacity = (bufferSize + 2047) & ~2047;
+		chunk->buffer = rtm_alloc(fRealTimePool, chunk->capacity);
+		if (chunk->buffer == NULL) {
+			chunk->capacity = 0;
+			_FreeChunk(chunk);
+			ERROR("RTM Pool empty allocating chunk buffer\n");
+			return NULL;
 		}
+		atomic_add(&fUsedBytes, chunk->capacity);
+	}
+
+	memcpy(chunk->buffer, buffer, bufferSize);
+	chunk->size = bufferSize;
+	return chunk;
+}
+
+
+void
+ChunkCache::_FreeChunk(chunk_buffer* chunk)
+{
+	atomic_add(&fUsedBytes, -(int32)(chunk->capacity + sizeof(chunk_buffer)));
+	rtm_free(chunk->buffer);
+	rtm_free(chunk);
+}
+
+
+/*!	A stream may use more than its share of the pool, as long as the other
+	streams could still get theirs.
+*/
+bool
+ChunkCache::_OverBudget()
+{
+	return (size_t)atomic_get(&fUsedBytes) >= fMaxBytes
+		&& rtm_available(fRealTimePool) < fMaxBytes;
+}
+
+
+bool
+ChunkCache::_SpaceLeft()
+{
+	if (fChunkCache.Count() >= atomic_get(&fReadAhead) || _OverBudget())
+		return false;
+
+	// If there is no more memory we are likely to fail soon after
+	return sizeof(chunk_buffer) + 2048 < rtm_available(fRealTimePool);
+}
+
 
-		memcpy(chunk->buffer, buffer, bufferSize);
-		chunk->size = bufferSize;
+/*!	Adapts the number of chunks to read ahead to the rate at which the
+	consumer takes them. An empty cache doubles it right away, more than
+	needed only lowers it gradually.
+*/
+void
+ChunkCache::_UpdateReadAhead(bool underrun)
+{
+	bigtime_t now = system_time();
+	if (fLastConsumed > 0) {
+		bigtime_t interval = now - fLastConsumed;
+		fConsumeInterval = fConsumeInterval > 0
+			? (fConsumeInterval * 7 + interval) / 8 : interval;
+	}
+	fLastConsumed = now;
+
+	int32 readAhead = fReadAhead;
+		// only this thread changes it
+	if (underrun)
+		readAhead *= 2;
+	else if (fConsumeInterval > 0) {
+		int32 wanted = (int32)min_c(kReadAheadTime / fConsumeInterval,
+			(bigtime_t)ChunkQueue::kMaxEntries);
+		if (wanted > readAhead)
+			readAhead = wanted;
+		else if (wanted < readAhead)
+			readAhead--;
 	}
 
-	fChunkCache.push(chunk);
-	return chunk->status == B_OK;
+	atomic_set(&fReadAhead,
+		max_c(kMinReadAhead, min_c(readAhead, ChunkQueue::kMaxEntries)));
 }
@@ -9,8 +9,6 @@
 #include <Locker.h>
 #include <MediaDefs.h>
 #include <RealtimeAlloc.h>
-#include <queue>
-#include <deque>
 
 #include "ReaderPlugin.h"
 
@@ -18,8 +16,6 @@
 namespace BPrivate {
 namespace media {
 
-// Limit to 10 entries, we might want to instead limit to a length of time
-#define CACHE_MAX_ENTRIES 10
 
 struct chunk_buffer {
 	void*			buffer;
@@ -29,29 +25,90 @@ struct chunk_buffer {
 	status_t		status;
 };
 
-typedef std::queue<chunk_buffer*> ChunkQueue;
-typedef std::deque<chunk_buffer*> ChunkList;
 
+/*!	A bounded FIFO of chunks for exactly one thread adding and one thread
+	removing chunks. Neither ever has to wait for the other.
+*/
+class ChunkQueue {
+public:
+	static	const int32			kMaxEntries = 64;
+
+public:
+								ChunkQueue();
+
+			int32				Count();
+
+			bool				Push(chunk_buffer* chunk);
+			chunk_buffer*		Pop();
+
+private:
+	static	const int32			kSize = kMaxEntries + 1;
+									// one entry stays unused, so that
+									// a full queue differs from an empty one
+
+			int32				fHead;
+				// written by the consumer only
+			int32				fTail;
+				// written by the producer only
+			chunk_buffer*		fEntries[kSize];
+};
+
+
+/*!	Caches the chunks of one stream, which the MediaExtractor's thread reads
+	ahead of the stream's consumer.
+
+	The extractor thread adds chunks, and the thread reading the stream takes
+	them out again, both without locking. The lock (the ChunkCache itself) only
+	serializes the accesses to the stream's reader cookie: reading ahead,
+	reading directly when the cache is drained, and seeking. So a consumer
+	that falls behind leaves its own cache full, but neither blocks the other
+	streams, nor does the extractor thread block it.
+
+	The chunk buffers come from a realtime pool shared by all streams of the
+	file. Each stream may use its share of the pool, and more, as long as
+	plenty of the pool is still free. Consumed chunks are kept with their
+	buffers for reuse.
+
+	How many chunks are read ahead follows the consumer's rate: enough to
+	cover kReadAheadTime, and more whenever the consumer finds the cache
+	empty.
+*/
 class ChunkCache : public BLocker {
 public:
-								ChunkCache(sem_id waitSem, size_t maxBytes);
+								ChunkCache(sem_id waitSem, rtm_pool* pool,
+									size_t maxBytes);
 								~ChunkCache();
 
 			status_t			InitCheck() const;
 
 			void				MakeEmpty();
-			bool				SpaceLeft() const;
+			bool				SpaceLeft();
 
 			chunk_buffer*		NextChunk(Reader* reader, void* cookie);
 			void				RecycleChunk(chunk_buffer* chunk);
 			bool				ReadNextChunk(Reader* reader, void* cookie);
 
+private:
+			chunk_buffer*		_ReadChunk(Reader* reader, void* cookie);
+			void				_FreeChunk(chunk_buffer* chunk);
+			bool				_OverBudget();
+			bool				_SpaceLeft();
+			void				_UpdateReadAhead(bool underrun);
+
 private:
 			rtm_pool*			fRealTimePool;
 			sem_id				fWaitSem;
 			size_t				fMaxBytes;
+			int32				fUsedBytes;
+			int32				fWaiting;
+
 			ChunkQueue			fChunkCache;
-			ChunkList			fUnusedChunks;
+			ChunkQueue			fUnusedChunks;
+				// consumed chunks, in the opposite direction
+
+			int32				fReadAhead;
+			bigtime_t			fLastConsumed;
+			bigtime_t			fConsumeInterval;
 };
 
 
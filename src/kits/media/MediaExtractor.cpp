@@ -25,6 +25,7 @@
 
 
 static const size_t kMaxCacheBytes = 3 * 1024 * 1024;
+	// per stream; the streams share a pool of that much memory each
 
 
 class MediaExtractorChunkProvider : public ChunkProvider {
@@ -57,7 +58,8 @@ MediaExtractor::MediaExtractor(BDataIO* source, int32 flags)
 	fExtractorThread(-1),
 	fReader(NULL),
 	fStreamInfo(NULL),
-	fStreamCount(0)
+	fStreamCount(0),
+	fChunkPool(NULL)
 {
 	_Init(source, flags);
 }
@@ -84,6 +86,14 @@ MediaExtractor::_Init(BDataIO* source, int32 flags)
 	if (fInitStatus != B_OK)
 		return;
 
+	rtm_create_pool(&fChunkPool, kMaxCacheBytes * max_c(fStreamCount, 1),
+		"media chunk cache");
+	if (fChunkPool == NULL) {
+		fStreamCount = 0;
+		fInitStatus = B_NO_MEMORY;
+		return;
+	}
+
 	fStreamInfo = new stream_info[fStreamCount];
 
 	// initialize stream infos
@@ -94,7 +104,7 @@ MediaExtractor::_Init(BDataIO* source, int32 flags)
 		fStreamInfo[i].infoBuffer = 0;
 		fStreamInfo[i].infoBufferSize = 0;
 		fStreamInfo[i].chunkCache
-			= new ChunkCache(fExtractorWaitSem, kMaxCacheBytes);
+			= new ChunkCache(fExtractorWaitSem, fChunkPool, kMaxCacheBytes);
 		fStreamInfo[i].lastChunk = NULL;
 		fStreamInfo[i].encodedFormat.Clear();
 
@@ -155,12 +165,15 @@ MediaExtractor::~MediaExtractor()
 		if (fStreamInfo[i].hasCookie)
 			fReader->FreeCookie(fStreamInfo[i].cookie);
 
+		_RecycleLastChunk(fStreamInfo[i]);
 		delete fStreamInfo[i].chunkCache;
 	}
 
 	gPluginManager.DestroyReader(fReader);
 
 	delete[] fStreamInfo;
+	if (fChunkPool != NULL)
+		rtm_delete_pool(fChunkPool);
 	// fSource is owned by the BMediaFile
 }
 
@@ -302,8 +315,6 @@ MediaExtractor::GetNextChunk(int32 stream, const void** _chunkBuffer,
 	return fReader->GetNextChunk(fStreamInfo[stream].cookie, _chunkBuffer,
 		_chunkSize, mediaHeader);
 #else
-	BAutolock _(info.chunkCache);
-
 	_RecycleLastChunk(info);
 
 	// Retrieve next chunk - read it directly, if the cache is drained
@@ -460,10 +471,16 @@ MediaExtractor::_ExtractorThread()
 					continue;
 				}
 
+				// A full cache doesn't keep the other streams from being
+				// filled; its consumer wakes us up when it needs more.
+				if (!info.chunkCache->SpaceLeft()) {
+					streamsFilled++;
+					continue;
+				}
+
 				BAutolock _(info.chunkCache);
 
-				if (!info.chunkCache->SpaceLeft()
-					|| !info.chunkCache->ReadNextChunk(fReader, info.cookie))
+				if (!info.chunkCache->ReadNextChunk(fReader, info.cookie))
 					streamsFilled++;
 			}
 		} while (streamsFilled < fStreamCount);
@@ -58,6 +58,7 @@ char __dont_remove_copyright_from_binary[] = "Copyright (c) 2002-2006 Marcus "
 #include <TimeSource.h>
 
 #include <new>
+#include <stdlib.h>
 
 #include <AppMisc.h>
 #include <DataExchange.h>
@@ -164,6 +165,43 @@ public:
 
 static MediaRosterUndertaker sMediaRosterUndertaker;
 
+
+/*!	Lets the producer pass its buffers to the consumer through a shared ring
+	instead of the consumer's port. Nodes that don't support it keep using
+	the port.
+*/
+static void
+set_up_buffer_ring(const media_source& source,
+	const media_destination& destination)
+{
+	if (getenv("MEDIA_NO_BUFFER_RINGS") != NULL)
+		return;
+
+	consumer_create_buffer_ring_request request1;
+	consumer_create_buffer_ring_reply reply1;
+	request1.source = source;
+	request1.destination = destination;
+	status_t status = QueryPort(destination.port, CONSUMER_CREATE_BUFFER_RING,
+		&request1, sizeof(request1), &reply1, sizeof(reply1));
+	if (status != B_OK) {
+		TRACE("set_up_buffer_ring: consumer doesn't support buffer rings: "
+			"%s\n", strerror(status));
+		return;
+	}
+
+	producer_set_buffer_ring_request request2;
+	producer_set_buffer_ring_reply reply2;
+	request2.area = reply1.area;
+	request2.source = source;
+	request2.destination = destination;
+	status = QueryPort(source.port, PRODUCER_SET_BUFFER_RING, &request2,
+		sizeof(request2), &reply2, sizeof(reply2));
+	if (status != B_OK) {
+		TRACE("set_up_buffer_ring: producer doesn't support buffer rings: "
+			"%s\n", strerror(status));
+	}
+}
+
 }	// namespace media
 }	// namespace BPrivate
 
@@ -1177,6 +1215,8 @@ BMediaRoster::Connect(const media_source& from, const media_destination& to,
 	out_output->format = reply4.input.format;
 	strcpy(out_output->name, reply5.name);
 
+	set_up_buffer_ring(out_output->source, out_output->destination);
+
 	// the connection is now made
 	PRINT_FORMAT("   format", *io_format);
 	PRINT_INPUT("   input", *out_input);
@@ -12,6 +12,7 @@
 #include <File.h>
 
 #include <package/Context.h>
+#include <package/RepositoryCacheIndex.h>
 
 
 namespace BPackageKit {
@@ -46,6 +47,10 @@ ActivateRepositoryCacheJob::Execute()
 
 	// TODO: propagate some repository attributes to file attributes
 
+	// The index only speeds up lookups, so it's fine if creating it fails.
+	BEntry cacheEntry(&fTargetDirectory, fRepositoryName.String());
+	RepositoryCacheIndex::Write(cacheEntry);
+
 	return B_OK;
 }
 
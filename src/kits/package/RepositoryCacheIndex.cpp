@@ -0,0 +1,686 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include <package/RepositoryCacheIndex.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <map>
+#include <new>
+#include <vector>
+
+#include <Path.h>
+
+#include <package/hpkg/RepositoryContentHandler.h>
+#include <package/hpkg/RepositoryReaderImpl.h>
+#include <package/hpkg/StandardErrorOutput.h>
+#include <package/PackageInfo.h>
+#include <package/PackageInfoContentHandler.h>
+#include <package/PackageRoster.h>
+
+
+namespace BPackageKit {
+
+namespace BPrivate {
+
+
+using BHPKG::BPrivate::RepositoryReaderImpl;
+
+
+// The index is created on and for the machine it is used on, so everything
+// is in host byte order.
+static const uint32 kIndexMagic = 'hpri';
+static const uint32 kIndexVersion = 1;
+static const char* const kIndexSuffix = ".index";
+
+
+struct repository_cache_index_header {
+	uint32	magic;
+	uint32	version;
+	uint64	cache_size;
+	int64	cache_modification_time;
+	uint32	package_count;
+	uint32	resolvable_count;
+	uint32	packages_offset;
+	uint32	resolvables_offset;
+	uint32	providers_offset;
+	uint32	providers_count;
+	uint32	strings_offset;
+	uint32	strings_size;
+};
+
+
+struct repository_cache_index_package {
+	uint64	offset;
+	uint32	size;
+		// location of the package in the cache's package attributes section
+	uint32	name;
+	uint32	version;
+	uint32	summary;
+	uint32	description;
+	uint32	provides;
+		// string offsets; provides is a '\n' separated list of
+		// "<name> = <version>" for searching
+};
+
+
+struct repository_cache_index_resolvable {
+	uint32	name;
+	uint32	first_provider;
+	uint32	provider_count;
+};
+
+
+static status_t
+get_index_path(const BEntry& cacheEntry, BPath& _path)
+{
+	status_t error = cacheEntry.GetPath(&_path);
+	if (error != B_OK)
+		return error;
+
+	BString path(_path.Path());
+	path << kIndexSuffix;
+	return _path.SetTo(path.String());
+}
+
+
+// #pragma mark - IndexWriter
+
+
+/*!	Collects the packages of a repository cache and writes the index. */
+struct IndexWriter : BHPKG::BRepositoryContentHandler {
+	IndexWriter(RepositoryReaderImpl& reader, BHPKG::BErrorOutput* errorOutput)
+		:
+		fReader(reader),
+		fPackageInfo(),
+		fPackageInfoContentHandler(fPackageInfo, errorOutput)
+	{
+		// the empty string
+		fStrings.push_back('\0');
+	}
+
+	virtual status_t HandlePackage(const char* packageName)
+	{
+		fPackageInfo.Clear();
+		return B_OK;
+	}
+
+	virtual status_t HandlePackageAttribute(
+		const BHPKG::BPackageInfoAttributeValue& value)
+	{
+		return fPackageInfoContentHandler.HandlePackageAttribute(value);
+	}
+
+	virtual status_t HandlePackageDone(const char* packageName)
+	{
+		status_t error = fPackageInfo.InitCheck();
+		if (error != B_OK)
+			return error;
+
+		try {
+			uint32 packageIndex = fPackages.size();
+			repository_cache_index_package package;
+			package.offset = fReader.CurrentPackageOffset();
+			package.size = fReader.CurrentPackageSize();
+			package.name = _AddString(fPackageInfo.Name());
+			package.version = _AddString(fPackageInfo.Version().ToString());
+			package.summary = _AddString(fPackageInfo.Summary());
+			package.description = _AddString(fPackageInfo.Description());
+
+			BString provides;
+			const BObjectList<BPackageResolvable>& providesList
+				= fPackageInfo.ProvidesList();
+			for (int32 i = 0; i < providesList.CountItems(); i++) {
+				const BPackageResolvable* resolvable = providesList.ItemAt(i);
+				if (i > 0)
+					provides << '\n';
+				provides << resolvable->Name();
+				if (resolvable->Version().InitCheck() == B_OK)
+					provides << " = " << resolvable->Version().ToString();
+
+				fProviders[resolvable->Name()].push_back(packageIndex);
+			}
+			package.provides = _AddString(provides);
+
+			fPackages.push_back(package);
+		} catch (std::bad_alloc&) {
+			return B_NO_MEMORY;
+		}
+
+		return B_OK;
+	}
+
+	virtual status_t HandleRepositoryInfo(
+		const BRepositoryInfo& repositoryInfo)
+	{
+		return B_OK;
+	}
+
+	virtual void HandleErrorOccurred()
+	{
+	}
+
+	status_t Write(const struct stat& cacheStat, const char* path)
+	{
+		// sort the packages by name, keeping the cache's order otherwise
+		std::vector<uint32> order(fPackages.size());
+		for (uint32 i = 0; i < order.size(); i++)
+			order[i] = i;
+		std::stable_sort(order.begin(), order.end(), NameLess(this));
+
+		std::vector<uint32> newIndices(order.size());
+		std::vector<repository_cache_index_package> packages(order.size());
+		for (uint32 i = 0; i < order.size(); i++) {
+			packages[i] = fPackages[order[i]];
+			newIndices[order[i]] = i;
+		}
+
+		// the resolvables are sorted by name already
+		std::vector<repository_cache_index_resolvable> resolvables;
+		std::vector<uint32> providers;
+		for (ProviderMap::iterator it = fProviders.begin();
+				it != fProviders.end(); ++it) {
+			repository_cache_index_resolvable resolvable;
+			resolvable.name = _AddString(it->first);
+			resolvable.first_provider = providers.size();
+			resolvable.provider_count = it->second.size();
+			for (size_t i = 0; i < it->second.size(); i++)
+				providers.push_back(newIndices[it->second[i]]);
+			std::sort(providers.begin() + resolvable.first_provider,
+				providers.end());
+			resolvables.push_back(resolvable);
+		}
+
+		repository_cache_index_header header;
+		memset(&header, 0, sizeof(header));
+		header.magic = kIndexMagic;
+		header.version = kIndexVersion;
+		header.cache_size = cacheStat.st_size;
+		header.cache_modification_time = cacheStat.st_mtime;
+		header.package_count = packages.size();
+		header.resolvable_count = resolvables.size();
+		header.packages_offset = sizeof(header);
+		header.resolvables_offset = header.packages_offset
+			+ packages.size() * sizeof(repository_cache_index_package);
+		header.providers_offset = header.resolvables_offset
+			+ resolvables.size() * sizeof(repository_cache_index_resolvable);
+		header.providers_count = providers.size();
+		header.strings_offset = header.providers_offset
+			+ providers.size() * sizeof(uint32);
+		header.strings_size = fStrings.size();
+
+		// Write to a temporary file and move it into place, so readers never
+		// see a partial index.
+		BString tempPath(path);
+		tempPath << '.' << getpid();
+		FILE* file = fopen(tempPath.String(), "w");
+		if (file == NULL)
+			return errno;
+
+		bool written = fwrite(&header, sizeof(header), 1, file) == 1
+			&& _Write(file, packages) && _Write(file, resolvables)
+			&& _Write(file, providers) && _Write(file, fStrings);
+		if (fclose(file) != 0)
+			written = false;
+
+		if (!written || rename(tempPath.String(), path) != 0) {
+			status_t error = written ? errno : B_IO_ERROR;
+			unlink(tempPath.String());
+			return error;
+		}
+
+		return B_OK;
+	}
+
+private:
+	typedef std::map<BString, uint32> StringMap;
+	typedef std::map<BString, std::vector<uint32> > ProviderMap;
+
+	struct NameLess {
+		NameLess(IndexWriter* writer)
+			:
+			fWriter(writer)
+		{
+		}
+
+		bool operator()(uint32 a, uint32 b) const
+		{
+			const char* strings = &fWriter->fStrings[0];
+			return strcmp(strings + fWriter->fPackages[a].name,
+				strings + fWriter->fPackages[b].name) < 0;
+		}
+
+		IndexWriter*	fWriter;
+	};
+
+	uint32 _AddString(const BString& string)
+	{
+		StringMap::iterator it = fStringOffsets.find(string);
+		if (it != fStringOffsets.end())
+			return it->second;
+
+		if (string.IsEmpty())
+			return 0;
+
+		uint32 offset = fStrings.size();
+		fStrings.insert(fStrings.end(), string.String(),
+			string.String() + string.Length() + 1);
+		fStringOffsets[string] = offset;
+		return offset;
+	}
+
+	template<typename Type>
+	static bool _Write(FILE* file, const std::vector<Type>& data)
+	{
+		return data.empty()
+			|| fwrite(&data[0], sizeof(Type), data.size(), file)
+				== data.size();
+	}
+
+private:
+	RepositoryReaderImpl&		fReader;
+	BPackageInfo				fPackageInfo;
+	BPackageInfoContentHandler	fPackageInfoContentHandler;
+	std::vector<repository_cache_index_package> fPackages;
+	std::vector<char>			fStrings;
+	StringMap					fStringOffsets;
+	ProviderMap					fProviders;
+};
+
+
+// #pragma mark - PackageInfoReader
+
+
+/*!	Reads the BPackageInfo of a single package. */
+struct PackageInfoReader : BHPKG::BRepositoryContentHandler {
+	PackageInfoReader(BPackageInfo& packageInfo,
+		BHPKG::BErrorOutput* errorOutput)
+		:
+		fPackageInfo(packageInfo),
+		fPackageInfoContentHandler(packageInfo, errorOutput)
+	{
+	}
+
+	virtual status_t HandlePackage(const char* packageName)
+	{
+		fPackageInfo.Clear();
+		return B_OK;
+	}
+
+	virtual status_t HandlePackageAttribute(
+		const BHPKG::BPackageInfoAttributeValue& value)
+	{
+		return fPackageInfoContentHandler.HandlePackageAttribute(value);
+	}
+
+	virtual status_t HandlePackageDone(const char* packageName)
+	{
+		return fPackageInfo.InitCheck();
+	}
+
+	virtual status_t HandleRepositoryInfo(
+		const BRepositoryInfo& repositoryInfo)
+	{
+		return B_OK;
+	}
+
+	virtual void HandleErrorOccurred()
+	{
+	}
+
+private:
+	BPackageInfo&				fPackageInfo;
+	BPackageInfoContentHandler	fPackageInfoContentHandler;
+};
+
+
+// #pragma mark - RepositoryCacheIndex
+
+
+RepositoryCacheIndex::RepositoryCacheIndex()
+	:
+	fCacheEntry(),
+	fAddress(NULL),
+	fSize(0),
+	fHeader(NULL),
+	fErrorOutput(NULL),
+	fReader(NULL)
+{
+}
+
+
+RepositoryCacheIndex::~RepositoryCacheIndex()
+{
+	Unset();
+}
+
+
+/*static*/ status_t
+RepositoryCacheIndex::Write(const BEntry& cacheEntry)
+{
+	BPath cachePath;
+	BPath indexPath;
+	status_t error = cacheEntry.GetPath(&cachePath);
+	if (error == B_OK)
+		error = get_index_path(cacheEntry, indexPath);
+	if (error != B_OK)
+		return error;
+
+	int fd = open(cachePath.Path(), O_RDONLY);
+	if (fd < 0)
+		return errno;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0) {
+		error = errno;
+		close(fd);
+		return error;
+	}
+
+	BHPKG::BStandardErrorOutput errorOutput;
+	RepositoryReaderImpl reader(&errorOutput);
+	error = reader.Init(fd, true);
+	if (error != B_OK)
+		return error;
+
+	IndexWriter writer(reader, &errorOutput);
+	error = reader.ParseContent(&writer);
+	if (error != B_OK)
+		return error;
+
+	try {
+		return writer.Write(st, indexPath.Path());
+	} catch (std::bad_alloc&) {
+		return B_NO_MEMORY;
+	}
+}
+
+
+status_t
+RepositoryCacheIndex::SetTo(const BEntry& cacheEntry)
+{
+	Unset();
+
+	struct stat cacheStat;
+	status_t error = cacheEntry.GetStat(&cacheStat);
+	if (error != B_OK)
+		return error;
+
+	BPath indexPath;
+	error = get_index_path(cacheEntry, indexPath);
+	if (error != B_OK)
+		return error;
+
+	int fd = open(indexPath.Path(), O_RDONLY);
+	if (fd < 0)
+		return errno;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(*fHeader)) {
+		close(fd);
+		return B_BAD_DATA;
+	}
+
+	void* address = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (address == MAP_FAILED)
+		return errno;
+
+	fAddress = address;
+	fSize = st.st_size;
+	const repository_cache_index_header* header
+		= (const repository_cache_index_header*)address;
+
+	// check the header and that all tables lie within the file
+	if (header->magic != kIndexMagic || header->version != kIndexVersion) {
+		Unset();
+		return B_BAD_DATA;
+	}
+
+	if (header->cache_size != (uint64)cacheStat.st_size
+		|| header->cache_modification_time != cacheStat.st_mtime) {
+		Unset();
+		return B_MISMATCHED_VALUES;
+	}
+
+	if (header->packages_offset != sizeof(*header)
+		|| header->resolvables_offset != header->packages_offset
+			+ (uint64)header->package_count
+				* sizeof(repository_cache_index_package)
+		|| header->providers_offset != header->resolvables_offset
+			+ (uint64)header->resolvable_count
+				* sizeof(repository_cache_index_resolvable)
+		|| header->strings_offset != header->providers_offset
+			+ (uint64)header->providers_count * sizeof(uint32)
+		|| header->strings_size == 0
+		|| (uint64)header->strings_offset + header->strings_size != fSize
+		|| ((const char*)address)[fSize - 1] != '\0') {
+		Unset();
+		return B_BAD_DATA;
+	}
+
+	fCacheEntry = cacheEntry;
+	fHeader = header;
+	return B_OK;
+}
+
+
+status_t
+RepositoryCacheIndex::SetTo(const BString& repositoryName)
+{
+	// the user cache has precedence
+	BPackageRoster roster;
+	BPath path;
+	status_t error = roster.GetUserRepositoryCachePath(&path);
+	if (error == B_OK)
+		error = path.Append(repositoryName.String());
+	if (error == B_OK && !BEntry(path.Path()).Exists()) {
+		error = roster.GetCommonRepositoryCachePath(&path);
+		if (error == B_OK)
+			error = path.Append(repositoryName.String());
+	}
+	if (error != B_OK)
+		return error;
+
+	return SetTo(BEntry(path.Path()));
+}
+
+
+void
+RepositoryCacheIndex::Unset()
+{
+	delete fReader;
+	fReader = NULL;
+	delete fErrorOutput;
+	fErrorOutput = NULL;
+
+	if (fAddress != NULL)
+		munmap(fAddress, fSize);
+
+	fAddress = NULL;
+	fSize = 0;
+	fHeader = NULL;
+	fCacheEntry.Unset();
+}
+
+
+uint32
+RepositoryCacheIndex::CountPackages() const
+{
+	return fHeader != NULL ? fHeader->package_count : 0;
+}
+
+
+const char*
+RepositoryCacheIndex::PackageNameAt(uint32 index) const
+{
+	const repository_cache_index_package* package = _PackageAt(index);
+	return package != NULL ? _String(package->name) : NULL;
+}
+
+
+const char*
+RepositoryCacheIndex::PackageVersionAt(uint32 index) const
+{
+	const repository_cache_index_package* package = _PackageAt(index);
+	return package != NULL ? _String(package->version) : NULL;
+}
+
+
+const char*
+RepositoryCacheIndex::PackageSummaryAt(uint32 index) const
+{
+	const repository_cache_index_package* package = _PackageAt(index);
+	return package != NULL ? _String(package->summary) : NULL;
+}
+
+
+const char*
+RepositoryCacheIndex::PackageDescriptionAt(uint32 index) const
+{
+	const repository_cache_index_package* package = _PackageAt(index);
+	return package != NULL ? _String(package->description) : NULL;
+}
+
+
+bool
+RepositoryCacheIndex::PackageMatches(uint32 index,
+	const char* searchString) const
+{
+	const repository_cache_index_package* package = _PackageAt(index);
+	if (package == NULL)
+		return false;
+
+	return strcasestr(_String(package->name), searchString) != NULL
+		|| strcasestr(_String(package->summary), searchString) != NULL
+		|| strcasestr(_String(package->description), searchString) != NULL
+		|| strcasestr(_String(package->provides), searchString) != NULL;
+}
+
+
+int32
+RepositoryCacheIndex::FindPackage(const char* name) const
+{
+	// binary search for the first package not less than the name
+	uint32 lower = 0;
+	uint32 upper = CountPackages();
+	while (lower < upper) {
+		uint32 mid = lower + (upper - lower) / 2;
+		if (strcmp(PackageNameAt(mid), name) < 0)
+			lower = mid + 1;
+		else
+			upper = mid;
+	}
+
+	if (lower < CountPackages() && strcmp(PackageNameAt(lower), name) == 0)
+		return lower;
+	return -1;
+}
+
+
+uint32
+RepositoryCacheIndex::FindProviders(const char* resolvableName,
+	const uint32*& _packages) const
+{
+	if (fHeader == NULL)
+		return 0;
+
+	const repository_cache_index_resolvable* resolvables
+		= (const repository_cache_index_resolvable*)
+			((const uint8*)fAddress + fHeader->resolvables_offset);
+	uint32 lower = 0;
+	uint32 upper = fHeader->resolvable_count;
+	while (lower < upper) {
+		uint32 mid = lower + (upper - lower) / 2;
+		if (strcmp(_String(resolvables[mid].name), resolvableName) < 0)
+			lower = mid + 1;
+		else
+			upper = mid;
+	}
+
+	if (lower == fHeader->resolvable_count
+		|| strcmp(_String(resolvables[lower].name), resolvableName) != 0) {
+		return 0;
+	}
+
+	const repository_cache_index_resolvable& resolvable = resolvables[lower];
+	if ((uint64)resolvable.first_provider + resolvable.provider_count
+			> fHeader->providers_count) {
+		return 0;
+	}
+
+	_packages = (const uint32*)((const uint8*)fAddress
+		+ fHeader->providers_offset) + resolvable.first_provider;
+	return resolvable.provider_count;
+}
+
+
+status_t
+RepositoryCacheIndex::GetPackageInfo(uint32 index, BPackageInfo& _info)
+{
+	const repository_cache_index_package* package = _PackageAt(index);
+	if (package == NULL)
+		return B_BAD_INDEX;
+
+	// open the cache on first use
+	if (fReader == NULL) {
+		BPath cachePath;
+		status_t error = fCacheEntry.GetPath(&cachePath);
+		if (error != B_OK)
+			return error;
+
+		fErrorOutput = new(std::nothrow) BHPKG::BStandardErrorOutput;
+		if (fErrorOutput == NULL)
+			return B_NO_MEMORY;
+
+		fReader = new(std::nothrow) RepositoryReaderImpl(fErrorOutput);
+		if (fReader == NULL)
+			return B_NO_MEMORY;
+
+		error = fReader->Init(cachePath.Path());
+		if (error != B_OK) {
+			delete fReader;
+			fReader = NULL;
+			return error;
+		}
+	}
+
+	PackageInfoReader packageInfoReader(_info, fErrorOutput);
+	return fReader->ParsePackage(package->offset, package->size,
+		&packageInfoReader);
+}
+
+
+const char*
+RepositoryCacheIndex::_String(uint32 offset) const
+{
+	if (offset >= fHeader->strings_size)
+		return "";
+	return (const char*)fAddress + fHeader->strings_offset + offset;
+}
+
+
+const repository_cache_index_package*
+RepositoryCacheIndex::_PackageAt(uint32 index) const
+{
+	if (fHeader == NULL || index >= fHeader->package_count)
+		return NULL;
+
+	return (const repository_cache_index_package*)
+		((const uint8*)fAddress + fHeader->packages_offset) + index;
+}
+
+
+}	// namespace BPrivate
+
+}	// namespace BPackageKit
@@ -0,0 +1,1336 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include <package/hpkg/PackageDelta.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <new>
+
+#include <ByteOrder.h>
+#include <DataIO.h>
+
+#include <AutoDeleter.h>
+#include <FdIO.h>
+#include <SHA256.h>
+#include <ZlibCompressionAlgorithm.h>
+#ifdef ZSTD_ENABLED
+#include <ZstdCompressionAlgorithm.h>
+#endif
+#include <util/OpenHashTable.h>
+
+#include <package/hpkg/ErrorOutput.h>
+#include <package/hpkg/HPKGDefsPrivate.h>
+#include <package/hpkg/PackageFileHeapReader.h>
+#include <package/hpkg/PackageReaderImpl.h>
+
+
+namespace BPackageKit {
+
+namespace BHPKG {
+
+namespace BPrivate {
+
+
+static const size_t kChunkSize = PackageFileHeapAccessorBase::kChunkSize;
+
+// content-defined segments: 2 KiB minimum, 8 KiB on average
+static const size_t kMinSegmentSize = 2 * 1024;
+static const size_t kMaxSegmentSize = 64 * 1024;
+static const uint64 kSegmentBoundaryMask = ((uint64(1) << 13) - 1) << 51;
+static const size_t kScanBufferSize = 4 * kMaxSegmentSize;
+
+static const size_t kPieceOverhead = 1 + 8 + 4;
+	// type, offset, size of a reference piece
+
+static const uint64 kNoMatch = ~(uint64)0;
+
+
+static void
+compute_digest(const void* data, size_t size, uint8* digest)
+{
+	SHA256 checksummer;
+	checksummer.Init();
+	checksummer.Update(data, size);
+	memcpy(digest, checksummer.Digest(), SHA_DIGEST_LENGTH);
+}
+
+
+static status_t
+create_compression_algorithm(uint32 compression, int32 level,
+	CompressionAlgorithmOwner*& _algorithm)
+{
+	switch (compression) {
+		case B_HPKG_COMPRESSION_ZLIB:
+			_algorithm = CompressionAlgorithmOwner::Create(
+				new(std::nothrow) BZlibCompressionAlgorithm,
+				new(std::nothrow) BZlibCompressionParameters(level));
+			break;
+#ifdef ZSTD_ENABLED
+		case B_HPKG_COMPRESSION_ZSTD:
+			_algorithm = CompressionAlgorithmOwner::Create(
+				new(std::nothrow) BZstdCompressionAlgorithm,
+				new(std::nothrow) BZstdCompressionParameters(level));
+			break;
+#endif
+		default:
+			return B_NOT_SUPPORTED;
+	}
+
+	if (_algorithm == NULL)
+		return B_NO_MEMORY;
+
+	if (_algorithm->algorithm == NULL || _algorithm->parameters == NULL) {
+		_algorithm->ReleaseReference();
+		_algorithm = NULL;
+		return B_NO_MEMORY;
+	}
+
+	return B_OK;
+}
+
+
+static status_t
+write_uint8(BDataIO* output, uint8 value)
+{
+	return output->WriteExactly(&value, sizeof(value));
+}
+
+
+static status_t
+write_uint32(BDataIO* output, uint32 value)
+{
+	value = B_HOST_TO_BENDIAN_INT32(value);
+	return output->WriteExactly(&value, sizeof(value));
+}
+
+
+static status_t
+write_uint64(BDataIO* output, uint64 value)
+{
+	value = B_HOST_TO_BENDIAN_INT64(value);
+	return output->WriteExactly(&value, sizeof(value));
+}
+
+
+// #pragma mark - DeltaPackage
+
+
+/*!	A package file and the information about its heap chunks the delta code
+	needs.
+*/
+class DeltaPackage {
+public:
+	DeltaPackage(BErrorOutput* errorOutput)
+		:
+		fErrorOutput(errorOutput),
+		fReader(errorOutput),
+		fSize(0),
+		fCompression(B_HPKG_COMPRESSION_NONE),
+		fChunkCount(0)
+	{
+	}
+
+	status_t Init(const char* fileName)
+	{
+		int fd = open(fileName, O_RDONLY);
+		if (fd < 0) {
+			int openError = errno;
+			fErrorOutput->PrintError("Error: Failed to open package file "
+				"\"%s\": %s\n", fileName, strerror(openError));
+			return openError;
+		}
+
+		BFdIO* file = new(std::nothrow) BFdIO(fd, true);
+		if (file == NULL) {
+			close(fd);
+			return B_NO_MEMORY;
+		}
+
+		hpkg_header header;
+		status_t error = fReader.Init(file, true, 0, &header);
+		if (error != B_OK)
+			return error;
+
+		fSize = B_BENDIAN_TO_HOST_INT64(header.total_size);
+		fCompression = B_BENDIAN_TO_HOST_INT16(header.heap_compression);
+		fChunkCount = (HeapReader()->UncompressedHeapSize() + kChunkSize - 1)
+			/ kChunkSize;
+
+		// The file must consist of the header, the chunks, and the chunk size
+		// table only, or we can't rebuild it.
+		uint64 chunkSizeTableSize
+			= fCompression != B_HPKG_COMPRESSION_NONE && fChunkCount > 0
+				? (fChunkCount - 1) * 2 : 0;
+		if (HeapOffset() > kChunkSize
+			|| HeapOffset() + HeapReader()->CompressedHeapSize()
+				+ chunkSizeTableSize != fSize) {
+			fErrorOutput->PrintError("Error: Unsupported layout of package "
+				"file \"%s\"\n", fileName);
+			return B_NOT_SUPPORTED;
+		}
+
+		return B_OK;
+	}
+
+	BPositionIO* File() const
+	{
+		return fReader.PackageFile();
+	}
+
+	PackageFileHeapReader* HeapReader() const
+	{
+		return fReader.RawHeapReader();
+	}
+
+	uint64 Size() const
+	{
+		return fSize;
+	}
+
+	uint32 Compression() const
+	{
+		return fCompression;
+	}
+
+	uint64 HeapOffset() const
+	{
+		return HeapReader()->HeapOffset();
+	}
+
+	uint64 ChunkCount() const
+	{
+		return fChunkCount;
+	}
+
+	uint64 ChunkOffset(uint64 chunkIndex) const
+	{
+		return HeapOffset() + HeapReader()->Offsets()[chunkIndex];
+	}
+
+	size_t CompressedChunkSize(uint64 chunkIndex) const
+	{
+		uint64 end = chunkIndex + 1 < fChunkCount
+			? HeapReader()->Offsets()[chunkIndex + 1]
+			: HeapReader()->CompressedHeapSize();
+		return end - HeapReader()->Offsets()[chunkIndex];
+	}
+
+	size_t ChunkSize(uint64 chunkIndex) const
+	{
+		return std::min((uint64)kChunkSize,
+			HeapReader()->UncompressedHeapSize() - chunkIndex * kChunkSize);
+	}
+
+	status_t ReadCompressedChunk(uint64 chunkIndex, void* buffer) const
+	{
+		return File()->ReadAtExactly(ChunkOffset(chunkIndex), buffer,
+			CompressedChunkSize(chunkIndex));
+	}
+
+	status_t ComputeChecksum(void* buffer, uint8* digest) const
+	{
+		SHA256 checksummer;
+		checksummer.Init();
+
+		for (uint64 offset = 0; offset < fSize;) {
+			size_t toRead = std::min((uint64)kChunkSize, fSize - offset);
+			status_t error = File()->ReadAtExactly(offset, buffer, toRead);
+			if (error != B_OK)
+				return error;
+
+			checksummer.Update(buffer, toRead);
+			offset += toRead;
+		}
+
+		memcpy(digest, checksummer.Digest(), SHA_DIGEST_LENGTH);
+		return B_OK;
+	}
+
+private:
+	BErrorOutput*		fErrorOutput;
+	PackageReaderImpl	fReader;
+	uint64				fSize;
+	uint32				fCompression;
+	uint64				fChunkCount;
+};
+
+
+// #pragma mark - PackageDeltaWriter helpers
+
+
+struct PackageDeltaWriter::Segment {
+	uint64	offset;
+	uint64	oldOffset;
+		// kNoMatch, if the old package doesn't contain the segment
+	uint32	size;
+};
+
+
+struct PackageDeltaWriter::Piece {
+	uint8	type;
+	uint64	offset;
+		// the offset in the old heap for a reference, in the chunk for data
+	uint32	size;
+};
+
+
+struct PackageDeltaWriter::DigestEntry {
+	uint8			digest[SHA_DIGEST_LENGTH];
+	uint64			offset;
+	DigestEntry*	next;
+};
+
+
+struct PackageDeltaWriter::DigestHashDefinition {
+	typedef const uint8*	KeyType;
+	typedef	DigestEntry		ValueType;
+
+	size_t HashKey(const uint8* key) const
+	{
+		size_t hash;
+		memcpy(&hash, key, sizeof(hash));
+		return hash;
+	}
+
+	size_t Hash(const DigestEntry* value) const
+	{
+		return HashKey(value->digest);
+	}
+
+	bool Compare(const uint8* key, const DigestEntry* value) const
+	{
+		return memcmp(key, value->digest, SHA_DIGEST_LENGTH) == 0;
+	}
+
+	DigestEntry*& GetLink(DigestEntry* value) const
+	{
+		return value->next;
+	}
+};
+
+
+struct PackageDeltaWriter::DigestTable
+	: BOpenHashTable<DigestHashDefinition> {
+
+	~DigestTable()
+	{
+		DigestEntry* entry = Clear(true);
+		while (entry != NULL) {
+			DigestEntry* next = entry->next;
+			delete entry;
+			entry = next;
+		}
+	}
+
+	status_t Add(const void* data, size_t size, uint64 offset)
+	{
+		DigestEntry* entry = new(std::nothrow) DigestEntry;
+		if (entry == NULL)
+			return B_NO_MEMORY;
+
+		compute_digest(data, size, entry->digest);
+		entry->offset = offset;
+
+		// keep the first occurrence
+		if (Lookup(entry->digest) != NULL) {
+			delete entry;
+			return B_OK;
+		}
+
+		status_t error = Insert(entry);
+		if (error != B_OK)
+			delete entry;
+		return error;
+	}
+
+	DigestEntry* Find(const void* data, size_t size) const
+	{
+		uint8 digest[SHA_DIGEST_LENGTH];
+		compute_digest(data, size, digest);
+		return Lookup(digest);
+	}
+};
+
+
+/*!	Splits a heap's uncompressed data into segments whose boundaries depend
+	on the content only, using a gear hash over the last 64 bytes.
+*/
+class PackageDeltaWriter::SegmentScanner {
+public:
+	SegmentScanner(PackageFileHeapReader* heapReader)
+		:
+		fHeapReader(heapReader),
+		fBuffer(NULL),
+		fBufferOffset(0),
+		fBufferSize(0),
+		fOffset(0)
+	{
+		// The table just needs to look random, and must not change for a
+		// given delta.
+		uint64 state = 0;
+		for (int32 i = 0; i < 256; i++) {
+			state += 0x9e3779b97f4a7c15ULL;
+			uint64 value = state;
+			value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+			value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+			fGearTable[i] = value ^ (value >> 31);
+		}
+	}
+
+	~SegmentScanner()
+	{
+		free(fBuffer);
+	}
+
+	status_t Init()
+	{
+		fBuffer = (uint8*)malloc(kScanBufferSize);
+		return fBuffer != NULL ? B_OK : B_NO_MEMORY;
+	}
+
+	/*!	Returns the next segment, or B_ENTRY_NOT_FOUND at the end of the heap.
+		The data remain valid until the next call.
+	*/
+	status_t NextSegment(uint64& _offset, const uint8*& _data, size_t& _size)
+	{
+		uint64 heapSize = fHeapReader->UncompressedHeapSize();
+		if (fOffset >= heapSize)
+			return B_ENTRY_NOT_FOUND;
+
+		// make sure the buffer contains a segment of the maximum size
+		size_t available = fBufferOffset + fBufferSize - fOffset;
+		uint64 bufferEnd = fBufferOffset + fBufferSize;
+		if (available < kMaxSegmentSize && bufferEnd < heapSize) {
+			memmove(fBuffer, fBuffer + (fOffset - fBufferOffset), available);
+			size_t toRead = std::min((uint64)(kScanBufferSize - available),
+				heapSize - bufferEnd);
+			status_t error = fHeapReader->ReadData(bufferEnd,
+				fBuffer + available, toRead);
+			if (error != B_OK)
+				return error;
+
+			fBufferOffset = fOffset;
+			fBufferSize = available + toRead;
+			available = fBufferSize;
+		}
+
+		const uint8* data = fBuffer + (fOffset - fBufferOffset);
+		size_t size = _SegmentSize(data, available);
+
+		_offset = fOffset;
+		_data = data;
+		_size = size;
+		fOffset += size;
+		return B_OK;
+	}
+
+private:
+	size_t _SegmentSize(const uint8* data, size_t size) const
+	{
+		if (size <= kMinSegmentSize)
+			return size;
+
+		size_t end = std::min(size, kMaxSegmentSize);
+		uint64 hash = 0;
+		for (size_t i = kMinSegmentSize; i < end; i++) {
+			hash = (hash << 1) + fGearTable[data[i]];
+			if ((hash & kSegmentBoundaryMask) == 0)
+				return i + 1;
+		}
+
+		return end;
+	}
+
+private:
+	PackageFileHeapReader*	fHeapReader;
+	uint8*					fBuffer;
+	uint64					fBufferOffset;
+	size_t					fBufferSize;
+	uint64					fOffset;
+	uint64					fGearTable[256];
+};
+
+
+// #pragma mark - PackageDeltaWriter
+
+
+PackageDeltaWriter::PackageDeltaWriter(BErrorOutput* errorOutput)
+	:
+	fErrorOutput(errorOutput),
+	fOldPackage(NULL),
+	fNewPackage(NULL),
+	fOldChunks(NULL),
+	fOldSegments(NULL),
+	fNewSegments(),
+	fNextSegment(0),
+	fPieces(),
+	fCompressedBuffer(NULL),
+	fUncompressedBuffer(NULL),
+	fRecompressedBuffer(NULL),
+	fCompressionAlgorithm(NULL),
+	fCompressionLevel(-1)
+{
+	memset(&fStatistics, 0, sizeof(fStatistics));
+}
+
+
+PackageDeltaWriter::~PackageDeltaWriter()
+{
+	if (fCompressionAlgorithm != NULL)
+		fCompressionAlgorithm->ReleaseReference();
+
+	free(fCompressedBuffer);
+	free(fUncompressedBuffer);
+	free(fRecompressedBuffer);
+
+	delete fOldChunks;
+	delete fOldSegments;
+	delete fOldPackage;
+	delete fNewPackage;
+}
+
+
+status_t
+PackageDeltaWriter::Create(const char* oldPackageFileName,
+	const char* newPackageFileName, const char* deltaFileName)
+{
+	status_t error = _Init(oldPackageFileName, newPackageFileName);
+	if (error != B_OK)
+		return error;
+
+	error = _IndexOldPackage();
+	if (error != B_OK)
+		return error;
+
+	error = _ScanNewPackage();
+	if (error != B_OK)
+		return error;
+
+	int fd = open(deltaFileName, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) {
+		int openError = errno;
+		fErrorOutput->PrintError("Error: Failed to create delta file \"%s\": "
+			"%s\n", deltaFileName, strerror(openError));
+		return openError;
+	}
+
+	BFdIO output(fd, true);
+	error = _WriteDelta(&output);
+	if (error != B_OK) {
+		fErrorOutput->PrintError("Error: Failed to write delta file \"%s\": "
+			"%s\n", deltaFileName, strerror(error));
+		unlink(deltaFileName);
+	}
+
+	return error;
+}
+
+
+status_t
+PackageDeltaWriter::_Init(const char* oldPackageFileName,
+	const char* newPackageFileName)
+{
+	fOldPackage = new(std::nothrow) DeltaPackage(fErrorOutput);
+	fNewPackage = new(std::nothrow) DeltaPackage(fErrorOutput);
+	fOldChunks = new(std::nothrow) DigestTable;
+	fOldSegments = new(std::nothrow) DigestTable;
+	fCompressedBuffer = malloc(kChunkSize);
+	fUncompressedBuffer = malloc(kChunkSize);
+	fRecompressedBuffer = malloc(kChunkSize);
+	if (fOldPackage == NULL || fNewPackage == NULL || fOldChunks == NULL
+		|| fOldSegments == NULL || fCompressedBuffer == NULL
+		|| fUncompressedBuffer == NULL || fRecompressedBuffer == NULL) {
+		return B_NO_MEMORY;
+	}
+
+	status_t error = fOldChunks->Init();
+	if (error == B_OK)
+		error = fOldSegments->Init();
+	if (error != B_OK)
+		return error;
+
+	error = fOldPackage->Init(oldPackageFileName);
+	if (error != B_OK)
+		return error;
+
+	return fNewPackage->Init(newPackageFileName);
+}
+
+
+status_t
+PackageDeltaWriter::_IndexOldPackage()
+{
+	// the compressed chunks
+	for (uint64 i = 0; i < fOldPackage->ChunkCount(); i++) {
+		status_t error = fOldPackage->ReadCompressedChunk(i,
+			fCompressedBuffer);
+		if (error == B_OK) {
+			error = fOldChunks->Add(fCompressedBuffer,
+				fOldPackage->CompressedChunkSize(i),
+				fOldPackage->ChunkOffset(i));
+		}
+		if (error != B_OK)
+			return error;
+	}
+
+	// the segments of the uncompressed heap
+	SegmentScanner scanner(fOldPackage->HeapReader());
+	status_t error = scanner.Init();
+	if (error != B_OK)
+		return error;
+
+	while (true) {
+		uint64 offset;
+		const uint8* data;
+		size_t size;
+		error = scanner.NextSegment(offset, data, size);
+		if (error != B_OK)
+			return error == B_ENTRY_NOT_FOUND ? B_OK : error;
+
+		error = fOldSegments->Add(data, size, offset);
+		if (error != B_OK)
+			return error;
+	}
+}
+
+
+status_t
+PackageDeltaWriter::_ScanNewPackage()
+{
+	SegmentScanner scanner(fNewPackage->HeapReader());
+	status_t error = scanner.Init();
+	if (error != B_OK)
+		return error;
+
+	while (true) {
+		Segment segment;
+		const uint8* data;
+		size_t size;
+		error = scanner.NextSegment(segment.offset, data, size);
+		if (error != B_OK)
+			return error == B_ENTRY_NOT_FOUND ? B_OK : error;
+
+		DigestEntry* entry = fOldSegments->Find(data, size);
+		segment.oldOffset = entry != NULL ? entry->offset : kNoMatch;
+		segment.size = size;
+		if (!fNewSegments.Add(segment))
+			return B_NO_MEMORY;
+	}
+}
+
+
+status_t
+PackageDeltaWriter::_WriteDelta(BPositionIO* output)
+{
+	// reserve space for the header, we write it last
+	hpkg_delta_header header;
+	memset(&header, 0, sizeof(header));
+	status_t error = output->WriteExactly(&header, sizeof(header));
+	if (error != B_OK)
+		return error;
+
+	// the new package's header
+	size_t heapOffset = fNewPackage->HeapOffset();
+	error = fNewPackage->File()->ReadAtExactly(0, fCompressedBuffer,
+		heapOffset);
+	if (error == B_OK)
+		error = output->WriteExactly(fCompressedBuffer, heapOffset);
+	if (error != B_OK)
+		return error;
+
+	// the chunks
+	for (uint64 i = 0; i < fNewPackage->ChunkCount(); i++) {
+		error = _WriteChunk(output, i);
+		if (error != B_OK)
+			return error;
+	}
+
+	// the header
+	off_t totalSize;
+	error = output->GetSize(&totalSize);
+	if (error != B_OK)
+		return error;
+
+	header.magic = B_HOST_TO_BENDIAN_INT32(B_HPKG_DELTA_MAGIC);
+	header.header_size = B_HOST_TO_BENDIAN_INT16(sizeof(header));
+	header.version = B_HOST_TO_BENDIAN_INT16(B_HPKG_DELTA_VERSION);
+	header.total_size = B_HOST_TO_BENDIAN_INT64(totalSize);
+
+	header.old_package_size = B_HOST_TO_BENDIAN_INT64(fOldPackage->Size());
+	error = fOldPackage->ComputeChecksum(fCompressedBuffer,
+		header.old_package_checksum);
+	if (error != B_OK)
+		return error;
+
+	header.new_package_size = B_HOST_TO_BENDIAN_INT64(fNewPackage->Size());
+	error = fNewPackage->ComputeChecksum(fCompressedBuffer,
+		header.new_package_checksum);
+	if (error != B_OK)
+		return error;
+
+	header.new_heap_offset = B_HOST_TO_BENDIAN_INT32(heapOffset);
+	header.heap_compression
+		= B_HOST_TO_BENDIAN_INT16(fNewPackage->Compression());
+	header.heap_compression_level
+		= B_HOST_TO_BENDIAN_INT16(std::max(fCompressionLevel, (int32)0));
+	header.heap_size_uncompressed = B_HOST_TO_BENDIAN_INT64(
+		fNewPackage->HeapReader()->UncompressedHeapSize());
+	header.heap_chunk_count
+		= B_HOST_TO_BENDIAN_INT64(fNewPackage->ChunkCount());
+
+	return output->WriteAtExactly(0, &header, sizeof(header));
+}
+
+
+status_t
+PackageDeltaWriter::_WriteChunk(BDataIO* output, uint64 chunkIndex)
+{
+	size_t compressedSize = fNewPackage->CompressedChunkSize(chunkIndex);
+	size_t size = fNewPackage->ChunkSize(chunkIndex);
+	status_t error = fNewPackage->ReadCompressedChunk(chunkIndex,
+		fCompressedBuffer);
+	if (error != B_OK)
+		return error;
+
+	BMallocIO command;
+
+	// Is the chunk in the old package as is?
+	if (DigestEntry* entry = fOldChunks->Find(fCompressedBuffer,
+			compressedSize)) {
+		write_uint8(&command, B_HPKG_DELTA_CHUNK_COPY);
+		write_uint64(&command, entry->offset);
+		write_uint32(&command, compressedSize);
+
+		fStatistics.copiedChunks++;
+		fStatistics.copiedBytes += compressedSize;
+		return output->WriteExactly(command.Buffer(), command.BufferLength());
+	}
+
+	// If we can rebuild the chunk from its uncompressed data, try to find
+	// those in the old package.
+	uint8 type = 0;
+	const void* data = NULL;
+	if (compressedSize == size) {
+		// the chunk is stored uncompressed
+		type = B_HPKG_DELTA_CHUNK_STORE;
+		data = fCompressedBuffer;
+	} else {
+		error = fNewPackage->HeapReader()->ReadData(chunkIndex * kChunkSize,
+			fUncompressedBuffer, size);
+		if (error != B_OK)
+			return error;
+
+		data = fUncompressedBuffer;
+		if (_Recompresses(data, size, fCompressedBuffer, compressedSize))
+			type = B_HPKG_DELTA_CHUNK_COMPRESS;
+	}
+
+	if (type != 0) {
+		error = _GetPieces(chunkIndex * kChunkSize, size);
+		if (error != B_OK)
+			return error;
+
+		size_t piecesSize = 4;
+		for (int32 i = 0; i < fPieces.Count(); i++) {
+			piecesSize += kPieceOverhead;
+			if (fPieces[i].type == B_HPKG_DELTA_PIECE_DATA)
+				piecesSize += fPieces[i].size;
+		}
+
+		if (piecesSize < compressedSize + 4) {
+			write_uint8(&command, type);
+			write_uint32(&command, fPieces.Count());
+			for (int32 i = 0; i < fPieces.Count(); i++) {
+				const Piece& piece = fPieces[i];
+				write_uint8(&command, piece.type);
+				if (piece.type == B_HPKG_DELTA_PIECE_REFERENCE) {
+					write_uint64(&command, piece.offset);
+					write_uint32(&command, piece.size);
+					fStatistics.referencedBytes += piece.size;
+				} else {
+					write_uint32(&command, piece.size);
+					command.WriteExactly((const uint8*)data + piece.offset,
+						piece.size);
+					fStatistics.dataBytes += piece.size;
+				}
+			}
+
+			fStatistics.rebuiltChunks++;
+			return output->WriteExactly(command.Buffer(),
+				command.BufferLength());
+		}
+	}
+
+	// store the compressed chunk
+	write_uint8(&command, B_HPKG_DELTA_CHUNK_LITERAL);
+	write_uint32(&command, compressedSize);
+	command.WriteExactly(fCompressedBuffer, compressedSize);
+
+	fStatistics.literalChunks++;
+	fStatistics.literalBytes += compressedSize;
+	return output->WriteExactly(command.Buffer(), command.BufferLength());
+}
+
+
+/*!	Returns whether compressing the given data results in exactly the given
+	compressed data.
+*/
+bool
+PackageDeltaWriter::_Recompresses(const void* data, size_t size,
+	const void* compressedData, size_t compressedSize)
+{
+	if (fCompressionLevel < 0) {
+		// The compression level isn't stored in the package. Find the one
+		// that reproduces this chunk, trying the default level first. If
+		// none does, the package has been compressed differently and we
+		// won't try again.
+		fCompressionLevel = 0;
+		for (int32 i = 0; i < B_HPKG_COMPRESSION_LEVEL_BEST; i++) {
+			int32 level = i == 0 ? B_HPKG_COMPRESSION_LEVEL_BEST
+				: B_HPKG_COMPRESSION_LEVEL_FASTEST + i - 1;
+			if (create_compression_algorithm(fNewPackage->Compression(), level,
+					fCompressionAlgorithm) != B_OK) {
+				return false;
+			}
+
+			fCompressionLevel = level;
+			if (_Recompresses(data, size, compressedData, compressedSize))
+				return true;
+
+			fCompressionAlgorithm->ReleaseReference();
+			fCompressionAlgorithm = NULL;
+			fCompressionLevel = 0;
+		}
+
+		return false;
+	}
+
+	if (fCompressionLevel == 0)
+		return false;
+
+	size_t recompressedSize;
+	status_t error = fCompressionAlgorithm->algorithm->CompressBuffer(data,
+		size, fRecompressedBuffer, size, recompressedSize,
+		fCompressionAlgorithm->parameters);
+	return error == B_OK && recompressedSize == compressedSize
+		&& memcmp(fRecompressedBuffer, compressedData, compressedSize) == 0;
+}
+
+
+/*!	Describes the given range of the new heap as pieces of the old heap and
+	data. Must be called with increasing offsets.
+*/
+status_t
+PackageDeltaWriter::_GetPieces(uint64 offset, size_t size)
+{
+	fPieces.MakeEmpty();
+
+	while (fNextSegment < fNewSegments.Count()
+		&& fNewSegments[fNextSegment].offset
+			+ fNewSegments[fNextSegment].size <= offset) {
+		fNextSegment++;
+	}
+
+	uint64 end = offset + size;
+	for (int32 i = fNextSegment; i < fNewSegments.Count()
+			&& fNewSegments[i].offset < end; i++) {
+		const Segment& segment = fNewSegments[i];
+		uint64 pieceStart = std::max(segment.offset, offset);
+		uint64 pieceEnd = std::min(segment.offset + segment.size, end);
+
+		Piece piece;
+		piece.size = pieceEnd - pieceStart;
+		if (segment.oldOffset != kNoMatch) {
+			piece.type = B_HPKG_DELTA_PIECE_REFERENCE;
+			piece.offset = segment.oldOffset + (pieceStart - segment.offset);
+		} else {
+			piece.type = B_HPKG_DELTA_PIECE_DATA;
+			piece.offset = pieceStart - offset;
+		}
+
+		// join with the previous piece, if contiguous
+		if (!fPieces.IsEmpty()) {
+			Piece& previous = fPieces[fPieces.Count() - 1];
+			if (previous.type == piece.type
+				&& previous.offset + previous.size == piece.offset) {
+				previous.size += piece.size;
+				continue;
+			}
+		}
+
+		if (!fPieces.Add(piece))
+			return B_NO_MEMORY;
+	}
+
+	return B_OK;
+}
+
+
+// #pragma mark - PackageDeltaApplier
+
+
+/*!	Buffered sequential reading of the delta file. */
+class PackageDeltaApplier::Input {
+public:
+	Input(BDataIO* file)
+		:
+		fFile(file),
+		fBuffer(NULL),
+		fBufferSize(0),
+		fPosition(0)
+	{
+	}
+
+	~Input()
+	{
+		free(fBuffer);
+	}
+
+	status_t Init()
+	{
+		fBuffer = (uint8*)malloc(kChunkSize);
+		return fBuffer != NULL ? B_OK : B_NO_MEMORY;
+	}
+
+	status_t Read(void* _buffer, size_t size)
+	{
+		uint8* buffer = (uint8*)_buffer;
+		while (size > 0) {
+			if (fPosition == fBufferSize) {
+				ssize_t bytesRead = fFile->Read(fBuffer, kChunkSize);
+				if (bytesRead < 0)
+					return bytesRead;
+				if (bytesRead == 0)
+					return B_BAD_DATA;
+				fBufferSize = bytesRead;
+				fPosition = 0;
+			}
+
+			size_t toCopy = std::min(size, fBufferSize - fPosition);
+			memcpy(buffer, fBuffer + fPosition, toCopy);
+			fPosition += toCopy;
+			buffer += toCopy;
+			size -= toCopy;
+		}
+
+		return B_OK;
+	}
+
+	status_t ReadUint8(uint8& _value)
+	{
+		return Read(&_value, sizeof(_value));
+	}
+
+	status_t ReadUint32(uint32& _value)
+	{
+		status_t error = Read(&_value, sizeof(_value));
+		_value = B_BENDIAN_TO_HOST_INT32(_value);
+		return error;
+	}
+
+	status_t ReadUint64(uint64& _value)
+	{
+		status_t error = Read(&_value, sizeof(_value));
+		_value = B_BENDIAN_TO_HOST_INT64(_value);
+		return error;
+	}
+
+private:
+	BDataIO*	fFile;
+	uint8*		fBuffer;
+	size_t		fBufferSize;
+	size_t		fPosition;
+};
+
+
+/*!	Writes the rebuilt package, keeping track of its size and checksum. */
+struct ChecksumOutput : BDataIO {
+	ChecksumOutput(BDataIO* output)
+		:
+		fOutput(output),
+		fSize(0)
+	{
+		fChecksummer.Init();
+	}
+
+	virtual ssize_t Write(const void* buffer, size_t size)
+	{
+		status_t error = fOutput->WriteExactly(buffer, size);
+		if (error != B_OK)
+			return error;
+
+		fChecksummer.Update(buffer, size);
+		fSize += size;
+		return size;
+	}
+
+	uint64 Size() const
+	{
+		return fSize;
+	}
+
+	const uint8* Digest()
+	{
+		return fChecksummer.Digest();
+	}
+
+private:
+	BDataIO*	fOutput;
+	SHA256		fChecksummer;
+	uint64		fSize;
+};
+
+
+PackageDeltaApplier::PackageDeltaApplier(BErrorOutput* errorOutput)
+	:
+	fErrorOutput(errorOutput),
+	fOldPackage(NULL),
+	fCompressedBuffer(NULL),
+	fUncompressedBuffer(NULL),
+	fOldChunkBuffer(NULL),
+	fOldChunkIndex(kNoMatch)
+{
+}
+
+
+PackageDeltaApplier::~PackageDeltaApplier()
+{
+	free(fCompressedBuffer);
+	free(fUncompressedBuffer);
+	free(fOldChunkBuffer);
+	delete fOldPackage;
+}
+
+
+status_t
+PackageDeltaApplier::Apply(const char* oldPackageFileName,
+	const char* deltaFileName, const char* newPackageFileName)
+{
+	fCompressedBuffer = malloc(kChunkSize);
+	fUncompressedBuffer = malloc(kChunkSize);
+	fOldChunkBuffer = malloc(kChunkSize);
+	if (fCompressedBuffer == NULL || fUncompressedBuffer == NULL
+		|| fOldChunkBuffer == NULL) {
+		return B_NO_MEMORY;
+	}
+
+	int fd = open(newPackageFileName, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) {
+		int openError = errno;
+		fErrorOutput->PrintError("Error: Failed to create package file "
+			"\"%s\": %s\n", newPackageFileName, strerror(openError));
+		return openError;
+	}
+
+	status_t error;
+	{
+		BFdIO output(fd, true);
+		error = _Apply(oldPackageFileName, deltaFileName, &output);
+	}
+
+	if (error != B_OK)
+		unlink(newPackageFileName);
+
+	return error;
+}
+
+
+status_t
+PackageDeltaApplier::_Apply(const char* oldPackageFileName,
+	const char* deltaFileName, BDataIO* _output)
+{
+	// open the delta and read the header
+	int deltaFD = open(deltaFileName, O_RDONLY);
+	if (deltaFD < 0) {
+		int openError = errno;
+		fErrorOutput->PrintError("Error: Failed to open delta file \"%s\": "
+			"%s\n", deltaFileName, strerror(openError));
+		return openError;
+	}
+
+	BFdIO deltaFile(deltaFD, true);
+	Input input(&deltaFile);
+	status_t error = input.Init();
+	if (error != B_OK)
+		return error;
+
+	hpkg_delta_header header;
+	error = input.Read(&header, sizeof(header));
+	if (error != B_OK
+		|| B_BENDIAN_TO_HOST_INT32(header.magic) != B_HPKG_DELTA_MAGIC
+		|| B_BENDIAN_TO_HOST_INT16(header.header_size) != sizeof(header)) {
+		fErrorOutput->PrintError("Error: \"%s\" is not a package delta "
+			"file\n", deltaFileName);
+		return B_BAD_DATA;
+	}
+
+	if (B_BENDIAN_TO_HOST_INT16(header.version) != B_HPKG_DELTA_VERSION) {
+		fErrorOutput->PrintError("Error: Unsupported package delta version "
+			"%u\n", B_BENDIAN_TO_HOST_INT16(header.version));
+		return B_MISMATCHED_VALUES;
+	}
+
+	// open the old package and check that it's the right one
+	fOldPackage = new(std::nothrow) DeltaPackage(fErrorOutput);
+	if (fOldPackage == NULL)
+		return B_NO_MEMORY;
+
+	error = fOldPackage->Init(oldPackageFileName);
+	if (error != B_OK)
+		return error;
+
+	uint8 digest[SHA_DIGEST_LENGTH];
+	uint64 oldPackageSize = B_BENDIAN_TO_HOST_INT64(header.old_package_size);
+	if (fOldPackage->Size() == oldPackageSize) {
+		error = fOldPackage->ComputeChecksum(fCompressedBuffer, digest);
+		if (error != B_OK)
+			return error;
+	}
+
+	if (fOldPackage->Size() != oldPackageSize
+		|| memcmp(digest, header.old_package_checksum, sizeof(digest)) != 0) {
+		fErrorOutput->PrintError("Error: The delta doesn't apply to package "
+			"file \"%s\"\n", oldPackageFileName);
+		return B_MISMATCHED_VALUES;
+	}
+
+	uint32 heapOffset = B_BENDIAN_TO_HOST_INT32(header.new_heap_offset);
+	uint16 compression = B_BENDIAN_TO_HOST_INT16(header.heap_compression);
+	int32 compressionLevel
+		= B_BENDIAN_TO_HOST_INT16(header.heap_compression_level);
+	uint64 heapSize = B_BENDIAN_TO_HOST_INT64(header.heap_size_uncompressed);
+	uint64 chunkCount = B_BENDIAN_TO_HOST_INT64(header.heap_chunk_count);
+	if (heapOffset > kChunkSize
+		|| chunkCount != (heapSize + kChunkSize - 1) / kChunkSize) {
+		return B_BAD_DATA;
+	}
+
+	CompressionAlgorithmOwner* compressionAlgorithm = NULL;
+	BReference<CompressionAlgorithmOwner> compressionAlgorithmReference;
+	if (compressionLevel != 0) {
+		error = create_compression_algorithm(compression, compressionLevel,
+			compressionAlgorithm);
+		if (error != B_OK)
+			return error;
+		compressionAlgorithmReference.SetTo(compressionAlgorithm, true);
+	}
+
+	// The chunk size table follows the chunks. The last chunk's size is
+	// implied.
+	uint16* chunkSizes = NULL;
+	if (compression != B_HPKG_COMPRESSION_NONE && chunkCount > 1) {
+		chunkSizes = (uint16*)malloc((chunkCount - 1) * sizeof(uint16));
+		if (chunkSizes == NULL)
+			return B_NO_MEMORY;
+	}
+	MemoryDeleter chunkSizesDeleter(chunkSizes);
+
+	ChecksumOutput output(_output);
+
+	// the header
+	error = input.Read(fCompressedBuffer, heapOffset);
+	if (error == B_OK)
+		error = output.WriteExactly(fCompressedBuffer, heapOffset);
+	if (error != B_OK)
+		return error;
+
+	// the chunks
+	for (uint64 i = 0; i < chunkCount; i++) {
+		size_t size = std::min((uint64)kChunkSize, heapSize - i * kChunkSize);
+
+		uint8 type;
+		error = input.ReadUint8(type);
+		if (error != B_OK)
+			return error;
+
+		const void* chunk = fCompressedBuffer;
+		size_t chunkSize = 0;
+		switch (type) {
+			case B_HPKG_DELTA_CHUNK_COPY:
+			{
+				uint64 offset;
+				uint32 compressedSize;
+				error = input.ReadUint64(offset);
+				if (error == B_OK)
+					error = input.ReadUint32(compressedSize);
+				if (error != B_OK)
+					return error;
+				if (compressedSize > size)
+					return B_BAD_DATA;
+
+				error = fOldPackage->File()->ReadAtExactly(offset,
+					fCompressedBuffer, compressedSize);
+				chunkSize = compressedSize;
+				break;
+			}
+
+			case B_HPKG_DELTA_CHUNK_LITERAL:
+			{
+				uint32 compressedSize;
+				error = input.ReadUint32(compressedSize);
+				if (error != B_OK)
+					return error;
+				if (compressedSize > size)
+					return B_BAD_DATA;
+
+				error = input.Read(fCompressedBuffer, compressedSize);
+				chunkSize = compressedSize;
+				break;
+			}
+
+			case B_HPKG_DELTA_CHUNK_STORE:
+				error = _ReadPieces(input, size);
+				chunk = fUncompressedBuffer;
+				chunkSize = size;
+				break;
+
+			case B_HPKG_DELTA_CHUNK_COMPRESS:
+				if (compressionAlgorithm == NULL)
+					return B_BAD_DATA;
+
+				error = _ReadPieces(input, size);
+				if (error != B_OK)
+					return error;
+
+				error = compressionAlgorithm->algorithm->CompressBuffer(
+					fUncompressedBuffer, size, fCompressedBuffer, size,
+					chunkSize, compressionAlgorithm->parameters);
+				if (error != B_OK) {
+					fErrorOutput->PrintError("Error: Failed to compress chunk "
+						"data: %s\n", strerror(error));
+				}
+				break;
+
+			default:
+				return B_BAD_DATA;
+		}
+
+		if (error == B_OK)
+			error = output.WriteExactly(chunk, chunkSize);
+		if (error != B_OK)
+			return error;
+
+		if (chunkSizes != NULL && i + 1 < chunkCount)
+			chunkSizes[i] = B_HOST_TO_BENDIAN_INT16(uint16(chunkSize - 1));
+	}
+
+	if (chunkSizes != NULL) {
+		error = output.WriteExactly(chunkSizes,
+			(chunkCount - 1) * sizeof(uint16));
+		if (error != B_OK)
+			return error;
+	}
+
+	// verify the result
+	if (output.Size() != B_BENDIAN_TO_HOST_INT64(header.new_package_size)
+		|| memcmp(output.Digest(), header.new_package_checksum,
+			SHA_DIGEST_LENGTH) != 0) {
+		fErrorOutput->PrintError("Error: The rebuilt package doesn't match "
+			"the delta's checksum\n");
+		return B_BAD_DATA;
+	}
+
+	return B_OK;
+}
+
+
+/*!	Reads the pieces of an uncompressed chunk of \a size bytes into
+	fUncompressedBuffer.
+*/
+status_t
+PackageDeltaApplier::_ReadPieces(Input& input, size_t size)
+{
+	uint32 count;
+	status_t error = input.ReadUint32(count);
+	if (error != B_OK)
+		return error;
+
+	size_t position = 0;
+	for (uint32 i = 0; i < count; i++) {
+		uint8 type;
+		uint64 offset = 0;
+		uint32 pieceSize;
+		error = input.ReadUint8(type);
+		if (error == B_OK && type == B_HPKG_DELTA_PIECE_REFERENCE)
+			error = input.ReadUint64(offset);
+		if (error == B_OK)
+			error = input.ReadUint32(pieceSize);
+		if (error != B_OK)
+			return error;
+
+		if (pieceSize > size - position)
+			return B_BAD_DATA;
+
+		uint8* buffer = (uint8*)fUncompressedBuffer + position;
+		switch (type) {
+			case B_HPKG_DELTA_PIECE_REFERENCE:
+				error = _ReadOldHeapData(offset, buffer, pieceSize);
+				break;
+			case B_HPKG_DELTA_PIECE_DATA:
+				error = input.Read(buffer, pieceSize);
+				break;
+			default:
+				return B_BAD_DATA;
+		}
+
+		if (error != B_OK)
+			return error;
+
+		position += pieceSize;
+	}
+
+	return position == size ? B_OK : B_BAD_DATA;
+}
+
+
+/*!	Reads data from the old package's uncompressed heap. The last chunk read
+	is cached, since consecutive pieces usually refer to the same chunk.
+*/
+status_t
+PackageDeltaApplier::_ReadOldHeapData(uint64 offset, void* _buffer,
+	size_t size)
+{
+	PackageFileHeapReader* heapReader = fOldPackage->HeapReader();
+	uint64 heapSize = heapReader->UncompressedHeapSize();
+	if (offset > heapSize || size > heapSize - offset)
+		return B_BAD_DATA;
+
+	uint8* buffer = (uint8*)_buffer;
+	while (size > 0) {
+		uint64 chunkIndex = offset / kChunkSize;
+		if (chunkIndex != fOldChunkIndex) {
+			fOldChunkIndex = kNoMatch;
+			status_t error = heapReader->ReadData(chunkIndex * kChunkSize,
+				fOldChunkBuffer, fOldPackage->ChunkSize(chunkIndex));
+			if (error != B_OK)
+				return error;
+			fOldChunkIndex = chunkIndex;
+		}
+
+		size_t inChunkOffset = offset - chunkIndex * kChunkSize;
+		size_t toCopy = std::min(size, kChunkSize - inChunkOffset);
+		memcpy(buffer, (uint8*)fOldChunkBuffer + inChunkOffset, toCopy);
+
+		buffer += toCopy;
+		offset += toCopy;
+		size -= toCopy;
+	}
+
+	return B_OK;
+}
+
+
+}	// namespace BPrivate
+
+}	// namespace BHPKG
+
+}	// namespace BPackageKit
@@ -0,0 +1,286 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include <package/hpkg/PackageFileHeapPrefetcher.h>
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <new>
+
+#include <DataIO.h>
+#include <package/hpkg/PackageFileHeapReader.h>
+
+
+namespace BPackageKit {
+
+namespace BHPKG {
+
+namespace BPrivate {
+
+
+static const size_t kChunkSize = PackageFileHeapAccessorBase::kChunkSize;
+static const int32 kSlotsPerThread = 4;
+
+
+struct PackageFileHeapPrefetcher::Slot {
+	uint64		chunkIndex;
+	void*		compressedData;
+	void*		uncompressedData;
+	status_t	status;
+	bool		reading;
+	bool		done;
+};
+
+
+inline PackageFileHeapPrefetcher::Slot&
+PackageFileHeapPrefetcher::_SlotFor(uint64 chunkIndex)
+{
+	return fSlots[chunkIndex % fSlotCount];
+}
+
+
+PackageFileHeapPrefetcher::PackageFileHeapPrefetcher(
+	PackageFileHeapReader* heapReader)
+	:
+	fHeapReader(heapReader),
+	fSlots(NULL),
+	fSlotCount(0),
+	fThreads(NULL),
+	fThreadCount(0),
+	fChunkCount(0),
+	fFirstChunk(0),
+	fNextChunkToRead(0),
+	fScheduledEnd(0),
+	fLastChunk(~(uint64)0),
+	fQuit(false)
+{
+	pthread_mutex_init(&fReadLock, NULL);
+	pthread_mutex_init(&fLock, NULL);
+	pthread_cond_init(&fChunkScheduledCondition, NULL);
+	pthread_cond_init(&fChunkDoneCondition, NULL);
+}
+
+
+PackageFileHeapPrefetcher::~PackageFileHeapPrefetcher()
+{
+	pthread_mutex_lock(&fLock);
+	fQuit = true;
+	pthread_cond_broadcast(&fChunkScheduledCondition);
+	pthread_mutex_unlock(&fLock);
+
+	for (int32 i = 0; i < fThreadCount; i++)
+		pthread_join(fThreads[i], NULL);
+	delete[] fThreads;
+
+	if (fSlots != NULL) {
+		for (int32 i = 0; i < fSlotCount; i++) {
+			free(fSlots[i].compressedData);
+			free(fSlots[i].uncompressedData);
+		}
+		delete[] fSlots;
+	}
+
+	pthread_cond_destroy(&fChunkDoneCondition);
+	pthread_cond_destroy(&fChunkScheduledCondition);
+	pthread_mutex_destroy(&fLock);
+	pthread_mutex_destroy(&fReadLock);
+}
+
+
+status_t
+PackageFileHeapPrefetcher::Init(int32 threadCount)
+{
+	if (threadCount <= 0)
+		threadCount = std::max(sysconf(_SC_NPROCESSORS_ONLN), 1L);
+
+	fChunkCount = (fHeapReader->UncompressedHeapSize() + kChunkSize - 1)
+		/ kChunkSize;
+
+	fThreads = new(std::nothrow) pthread_t[threadCount];
+	fSlots = new(std::nothrow) Slot[threadCount * kSlotsPerThread];
+	if (fThreads == NULL || fSlots == NULL)
+		return B_NO_MEMORY;
+
+	for (; fSlotCount < threadCount * kSlotsPerThread; fSlotCount++) {
+		Slot& slot = fSlots[fSlotCount];
+		slot.chunkIndex = 0;
+		slot.reading = false;
+		slot.done = false;
+		slot.compressedData = malloc(kChunkSize);
+		slot.uncompressedData = malloc(kChunkSize);
+		if (slot.compressedData == NULL || slot.uncompressedData == NULL) {
+			free(slot.compressedData);
+			free(slot.uncompressedData);
+			return B_NO_MEMORY;
+		}
+	}
+
+	for (; fThreadCount < threadCount; fThreadCount++) {
+		if (pthread_create(&fThreads[fThreadCount], NULL, &_ThreadEntry, this)
+				!= 0) {
+			break;
+		}
+	}
+
+	return fThreadCount > 0 ? B_OK : B_NO_MORE_THREADS;
+}
+
+
+status_t
+PackageFileHeapPrefetcher::ReadDataToOutput(off_t offset, size_t size,
+	BDataIO* output)
+{
+	if (size == 0)
+		return B_OK;
+
+	uint64 heapSize = fHeapReader->UncompressedHeapSize();
+	if (offset < 0 || (uint64)offset > heapSize || size > heapSize - offset)
+		return B_BAD_VALUE;
+
+	pthread_mutex_lock(&fReadLock);
+
+	uint64 chunkIndex = (uint64)offset / kChunkSize;
+	size_t inChunkOffset = (uint64)offset - chunkIndex * kChunkSize;
+	size_t remainingBytes = size;
+	status_t error = B_OK;
+
+	while (remainingBytes > 0) {
+		Slot* slot;
+		error = _GetChunk(chunkIndex, slot);
+		if (error != B_OK)
+			break;
+
+		// The slot stays ours until we ask for a chunk past it, so we don't
+		// need to hold the lock while writing.
+		size_t toWrite = std::min(kChunkSize - inChunkOffset, remainingBytes);
+		error = output->WriteExactly(
+			(uint8*)slot->uncompressedData + inChunkOffset, toWrite);
+		if (error != B_OK)
+			break;
+
+		remainingBytes -= toWrite;
+		chunkIndex++;
+		inChunkOffset = 0;
+	}
+
+	pthread_mutex_unlock(&fReadLock);
+	return error;
+}
+
+
+/*!	Moves the window of scheduled chunks to start at \a chunkIndex and waits
+	for that chunk to be decompressed.
+	The caller must hold fReadLock.
+*/
+status_t
+PackageFileHeapPrefetcher::_GetChunk(uint64 chunkIndex, Slot*& _slot)
+{
+	pthread_mutex_lock(&fLock);
+
+	bool sequential = chunkIndex == fLastChunk || chunkIndex == fLastChunk + 1;
+	fLastChunk = chunkIndex;
+
+	if (chunkIndex < fFirstChunk || chunkIndex >= fScheduledEnd) {
+		// Not in the window -- start a new one. The chunks scheduled so far
+		// are dropped, save for the ones already being read.
+		fFirstChunk = chunkIndex;
+		fNextChunkToRead = chunkIndex;
+		fScheduledEnd = chunkIndex;
+	} else {
+		fFirstChunk = chunkIndex;
+		fNextChunkToRead = std::max(fNextChunkToRead, chunkIndex);
+	}
+
+	// only read ahead, if it looks like it will pay off
+	_ScheduleChunks(chunkIndex + (sequential ? fSlotCount : 1));
+
+	Slot& slot = _SlotFor(chunkIndex);
+	while (!slot.done)
+		pthread_cond_wait(&fChunkDoneCondition, &fLock);
+	status_t error = slot.status;
+
+	pthread_mutex_unlock(&fLock);
+
+	if (error != B_OK)
+		return error;
+
+	_slot = &slot;
+	return B_OK;
+}
+
+
+/*!	Schedules the chunks up to \a endChunk (exclusively) as far as the window
+	allows. The caller must hold fLock.
+*/
+void
+PackageFileHeapPrefetcher::_ScheduleChunks(uint64 endChunk)
+{
+	endChunk = std::min(endChunk,
+		std::min(fChunkCount, fFirstChunk + fSlotCount));
+
+	bool scheduled = false;
+	while (fScheduledEnd < endChunk) {
+		Slot& slot = _SlotFor(fScheduledEnd);
+
+		// a dropped chunk may still be read into the slot
+		while (slot.reading)
+			pthread_cond_wait(&fChunkDoneCondition, &fLock);
+
+		slot.chunkIndex = fScheduledEnd++;
+		slot.done = false;
+		scheduled = true;
+	}
+
+	if (scheduled)
+		pthread_cond_broadcast(&fChunkScheduledCondition);
+}
+
+
+/*static*/ void*
+PackageFileHeapPrefetcher::_ThreadEntry(void* data)
+{
+	((PackageFileHeapPrefetcher*)data)->_Work();
+	return NULL;
+}
+
+
+void
+PackageFileHeapPrefetcher::_Work()
+{
+	pthread_mutex_lock(&fLock);
+
+	while (true) {
+		while (!fQuit && fNextChunkToRead >= fScheduledEnd)
+			pthread_cond_wait(&fChunkScheduledCondition, &fLock);
+		if (fQuit)
+			break;
+
+		uint64 chunkIndex = fNextChunkToRead++;
+		Slot& slot = _SlotFor(chunkIndex);
+		slot.reading = true;
+		pthread_mutex_unlock(&fLock);
+
+		status_t error = fHeapReader->ReadAndDecompressChunk(
+			(size_t)chunkIndex, slot.compressedData, slot.uncompressedData);
+
+		pthread_mutex_lock(&fLock);
+		slot.status = error;
+		slot.reading = false;
+		slot.done = true;
+		pthread_cond_broadcast(&fChunkDoneCondition);
+	}
+
+	pthread_mutex_unlock(&fLock);
+}
+
+
+}	// namespace BPrivate
+
+}	// namespace BHPKG
+
+}	// namespace BPackageKit
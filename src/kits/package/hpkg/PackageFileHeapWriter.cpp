@@ -6,6 +6,9 @@
 
 #include <package/hpkg/PackageFileHeapWriter.h>
 
+#include <pthread.h>
+#include <unistd.h>
+
 #include <algorithm>
 #include <new>
 
@@ -194,6 +197,207 @@ private:
 };
 
 
+struct PackageFileHeapWriter::CompressionJob {
+	void*		uncompressedData;
+	void*		compressedData;
+	size_t		uncompressedSize;
+	size_t		compressedSize;
+	status_t	status;
+	bool		done;
+};
+
+
+/*!	Compresses chunks on a number of threads. The chunks are queued and
+	written in heap order by the writer; only their compression happens in
+	parallel. The counters only ever increase, the job for counter value n is
+	fJobs[n % fJobCount]. fQueued and fWritten are only changed by the writer.
+*/
+struct PackageFileHeapWriter::CompressionWorkers {
+	CompressionWorkers(CompressionAlgorithmOwner* algorithm)
+		:
+		fAlgorithm(algorithm),
+		fJobs(NULL),
+		fJobCount(0),
+		fThreads(NULL),
+		fThreadCount(0),
+		fQueued(0),
+		fNextToCompress(0),
+		fWritten(0),
+		fQuit(false)
+	{
+		pthread_mutex_init(&fLock, NULL);
+		pthread_cond_init(&fJobQueuedCondition, NULL);
+		pthread_cond_init(&fJobDoneCondition, NULL);
+	}
+
+	~CompressionWorkers()
+	{
+		pthread_mutex_lock(&fLock);
+		fQuit = true;
+		pthread_cond_broadcast(&fJobQueuedCondition);
+		pthread_mutex_unlock(&fLock);
+
+		for (int32 i = 0; i < fThreadCount; i++)
+			pthread_join(fThreads[i], NULL);
+		delete[] fThreads;
+
+		for (int32 i = 0; i < fJobCount; i++) {
+			free(fJobs[i].uncompressedData);
+			free(fJobs[i].compressedData);
+		}
+		delete[] fJobs;
+
+		pthread_cond_destroy(&fJobDoneCondition);
+		pthread_cond_destroy(&fJobQueuedCondition);
+		pthread_mutex_destroy(&fLock);
+	}
+
+	status_t Init(int32 threadCount)
+	{
+		// two jobs per thread, so that the threads have something to do
+		// while the writer is busy writing
+		fJobs = new(std::nothrow) CompressionJob[threadCount * 2];
+		fThreads = new(std::nothrow) pthread_t[threadCount];
+		if (fJobs == NULL || fThreads == NULL)
+			return B_NO_MEMORY;
+
+		for (; fJobCount < threadCount * 2; fJobCount++) {
+			CompressionJob& job = fJobs[fJobCount];
+			job.uncompressedData = malloc(kChunkSize);
+			job.compressedData = malloc(kChunkSize);
+			if (job.uncompressedData == NULL || job.compressedData == NULL) {
+				free(job.uncompressedData);
+				free(job.compressedData);
+				return B_NO_MEMORY;
+			}
+		}
+
+		for (; fThreadCount < threadCount; fThreadCount++) {
+			if (pthread_create(&fThreads[fThreadCount], NULL, &_ThreadEntry,
+					this) != 0) {
+				break;
+			}
+		}
+
+		return fThreadCount > 0 ? B_OK : B_NO_MORE_THREADS;
+	}
+
+	bool HasQueuedJobs() const
+	{
+		return fQueued != fWritten;
+	}
+
+	bool IsFull() const
+	{
+		return fQueued - fWritten == (uint64)fJobCount;
+	}
+
+	CompressionJob& NextFreeJob()
+	{
+		return fJobs[fQueued % fJobCount];
+	}
+
+	void QueueJob()
+	{
+		pthread_mutex_lock(&fLock);
+		fJobs[fQueued % fJobCount].done = false;
+		fQueued++;
+		pthread_cond_signal(&fJobQueuedCondition);
+		pthread_mutex_unlock(&fLock);
+	}
+
+	CompressionJob* OldestJob(bool wait)
+	{
+		CompressionJob& job = fJobs[fWritten % fJobCount];
+
+		pthread_mutex_lock(&fLock);
+		while (wait && !job.done)
+			pthread_cond_wait(&fJobDoneCondition, &fLock);
+		bool done = job.done;
+		pthread_mutex_unlock(&fLock);
+
+		return done ? &job : NULL;
+	}
+
+	void JobWritten()
+	{
+		fWritten++;
+	}
+
+private:
+	static void* _ThreadEntry(void* data)
+	{
+		((CompressionWorkers*)data)->_Work();
+		return NULL;
+	}
+
+	void _Work()
+	{
+		pthread_mutex_lock(&fLock);
+
+		while (true) {
+			while (!fQuit && fNextToCompress == fQueued)
+				pthread_cond_wait(&fJobQueuedCondition, &fLock);
+			if (fQuit)
+				break;
+
+			CompressionJob& job = fJobs[fNextToCompress++ % fJobCount];
+			pthread_mutex_unlock(&fLock);
+
+			// Try to use compression only for data large enough.
+			if (job.uncompressedSize >= kCompressionSizeThreshold) {
+				job.status = fAlgorithm->algorithm->CompressBuffer(
+					job.uncompressedData, job.uncompressedSize,
+					job.compressedData, job.uncompressedSize,
+					job.compressedSize, fAlgorithm->parameters);
+			} else
+				job.status = B_BUFFER_OVERFLOW;
+
+			pthread_mutex_lock(&fLock);
+			job.done = true;
+			pthread_cond_broadcast(&fJobDoneCondition);
+		}
+
+		pthread_mutex_unlock(&fLock);
+	}
+
+private:
+	pthread_mutex_t				fLock;
+	pthread_cond_t				fJobQueuedCondition;
+	pthread_cond_t				fJobDoneCondition;
+	CompressionAlgorithmOwner*	fAlgorithm;
+	CompressionJob*				fJobs;
+	int32						fJobCount;
+	pthread_t*					fThreads;
+	int32						fThreadCount;
+	uint64						fQueued;
+	uint64						fNextToCompress;
+	uint64						fWritten;
+	bool						fQuit;
+};
+
+
+/*!	Makes the writer compress on its own thread for its lifetime. */
+struct PackageFileHeapWriter::WorkersSuspender {
+	WorkersSuspender(PackageFileHeapWriter* writer)
+		:
+		fWriter(writer),
+		fWorkers(writer->fCompressionWorkers)
+	{
+		fWriter->fCompressionWorkers = NULL;
+	}
+
+	~WorkersSuspender()
+	{
+		fWriter->fCompressionWorkers = fWorkers;
+	}
+
+private:
+	PackageFileHeapWriter*	fWriter;
+	CompressionWorkers*		fWorkers;
+};
+
+
 PackageFileHeapWriter::PackageFileHeapWriter(BErrorOutput* errorOutput,
 	BPositionIO* file, off_t heapOffset,
 	CompressionAlgorithmOwner* compressionAlgorithm,
@@ -205,7 +409,9 @@ PackageFileHeapWriter::PackageFileHeapWriter(BErrorOutput* errorOutput,
 	fCompressedDataBuffer(NULL),
 	fPendingDataSize(0),
 	fOffsets(),
-	fCompressionAlgorithm(compressionAlgorithm)
+	fCompressionAlgorithm(compressionAlgorithm),
+	fCompressionThreadCount(1),
+	fCompressionWorkers(NULL)
 {
 	if (fCompressionAlgorithm != NULL)
 		fCompressionAlgorithm->AcquireReference();
@@ -221,6 +427,13 @@ PackageFileHeapWriter::~PackageFileHeapWriter()
 }
 
 
+void
+PackageFileHeapWriter::SetCompressionThreadCount(int32 count)
+{
+	fCompressionThreadCount = count;
+}
+
+
 void
 PackageFileHeapWriter::Init()
 {
@@ -229,6 +442,20 @@ PackageFileHeapWriter::Init()
 	fCompressedDataBuffer = malloc(kChunkSize);
 	if (fPendingDataBuffer == NULL || fCompressedDataBuffer == NULL)
 		throw std::bad_alloc();
+
+	// start the compression threads, if we have more than one
+	int32 threadCount = fCompressionThreadCount;
+	if (threadCount <= 0)
+		threadCount = std::max(sysconf(_SC_NPROCESSORS_ONLN), 1L);
+
+	if (fCompressionAlgorithm != NULL && threadCount > 1) {
+		fCompressionWorkers = new CompressionWorkers(fCompressionAlgorithm);
+		if (fCompressionWorkers->Init(threadCount) != B_OK) {
+			// just compress on our own thread
+			delete fCompressionWorkers;
+			fCompressionWorkers = NULL;
+		}
+	}
 }
 
 
@@ -318,9 +545,15 @@ PackageFileHeapWriter::RemoveDataRanges(
 	// Before we begin flush any pending data, so we don't need any special
 	// handling and also can use the pending data buffer.
 	status_t status = _FlushPendingData();
+	if (status == B_OK && fCompressionWorkers != NULL)
+		status = _WriteQueuedChunks(true);
 	if (status != B_OK)
 		throw status_t(status);
 
+	// The algorithm below relies on chunks being written as soon as they are
+	// added, so they don't overwrite chunks that haven't been read yet.
+	WorkersSuspender workersSuspender(this);
+
 	// We potentially have to recompress all data from the first affected chunk
 	// to the end (minus the removed ranges, of course). As a basic algorithm we
 	// can use our usual data writing strategy, i.e. read a chunk, decompress it
@@ -440,6 +673,8 @@ PackageFileHeapWriter::Finish()
 {
 	// flush pending data, if any
 	status_t error = _FlushPendingData();
+	if (error == B_OK && fCompressionWorkers != NULL)
+		error = _WriteQueuedChunks(true);
 	if (error != B_OK)
 		return error;
 
@@ -481,6 +716,13 @@ status_t
 PackageFileHeapWriter::ReadAndDecompressChunk(size_t chunkIndex,
 	void* compressedDataBuffer, void* uncompressedDataBuffer)
 {
+	// make sure the chunk isn't still being compressed
+	if (fCompressionWorkers != NULL && fCompressionWorkers->HasQueuedJobs()) {
+		status_t error = _WriteQueuedChunks(true);
+		if (error != B_OK)
+			return error;
+	}
+
 	if (uint64(chunkIndex + 1) * kChunkSize > fUncompressedHeapSize) {
 		// The chunk has not been written to disk yet. Its data are still in the
 		// pending data buffer.
@@ -503,6 +745,9 @@ PackageFileHeapWriter::ReadAndDecompressChunk(size_t chunkIndex,
 void
 PackageFileHeapWriter::_Uninit()
 {
+	delete fCompressionWorkers;
+	fCompressionWorkers = NULL;
+
 	free(fPendingDataBuffer);
 	free(fCompressedDataBuffer);
 	fPendingDataBuffer = NULL;
@@ -516,6 +761,9 @@ PackageFileHeapWriter::_FlushPendingData()
 	if (fPendingDataSize == 0)
 		return B_OK;
 
+	if (fCompressionWorkers != NULL)
+		return _QueuePendingData();
+
 	status_t error = _WriteChunk(fPendingDataBuffer, fPendingDataSize, true);
 	if (error == B_OK)
 		fPendingDataSize = 0;
@@ -524,6 +772,73 @@ PackageFileHeapWriter::_FlushPendingData()
 }
 
 
+/*!	Hands the pending data over to the compression threads, and writes the
+	chunks that are done already.
+*/
+status_t
+PackageFileHeapWriter::_QueuePendingData()
+{
+	if (fCompressionWorkers->IsFull()) {
+		status_t error = _WriteCompressionJob(
+			*fCompressionWorkers->OldestJob(true));
+		fCompressionWorkers->JobWritten();
+		if (error != B_OK)
+			return error;
+	}
+
+	CompressionJob& job = fCompressionWorkers->NextFreeJob();
+	std::swap(job.uncompressedData, fPendingDataBuffer);
+	job.uncompressedSize = fPendingDataSize;
+	fCompressionWorkers->QueueJob();
+	fPendingDataSize = 0;
+
+	return _WriteQueuedChunks(false);
+}
+
+
+/*!	Writes the queued chunks in order, as long as they have been compressed.
+	If \a wait is \c true, waits for all of them to be compressed.
+*/
+status_t
+PackageFileHeapWriter::_WriteQueuedChunks(bool wait)
+{
+	while (fCompressionWorkers->HasQueuedJobs()) {
+		CompressionJob* job = fCompressionWorkers->OldestJob(wait);
+		if (job == NULL)
+			break;
+
+		status_t error = _WriteCompressionJob(*job);
+		fCompressionWorkers->JobWritten();
+		if (error != B_OK)
+			return error;
+	}
+
+	return B_OK;
+}
+
+
+status_t
+PackageFileHeapWriter::_WriteCompressionJob(CompressionJob& job)
+{
+	if (!fOffsets.Add(fCompressedHeapSize)) {
+		fErrorOutput->PrintError("Out of memory!\n");
+		return B_NO_MEMORY;
+	}
+
+	if (job.status != B_OK && job.status != B_BUFFER_OVERFLOW) {
+		fErrorOutput->PrintError("Failed to compress chunk data: %s\n",
+			strerror(job.status));
+		return job.status;
+	}
+
+	// only use compressed data when we've actually saved space
+	if (job.status == B_OK && job.compressedSize < job.uncompressedSize)
+		return _WriteDataUncompressed(job.compressedData, job.compressedSize);
+
+	return _WriteDataUncompressed(job.uncompressedData, job.uncompressedSize);
+}
+
+
 status_t
 PackageFileHeapWriter::_WriteChunk(const void* data, size_t size,
 	bool mayCompress)
@@ -27,6 +27,9 @@
 #include <package/hpkg/PackageData.h>
 #include <package/hpkg/PackageEntry.h>
 #include <package/hpkg/PackageEntryAttribute.h>
+#ifndef _KERNEL_MODE
+#	include <package/hpkg/PackageFileHeapPrefetcher.h>
+#endif
 
 
 namespace BPackageKit {
@@ -306,6 +309,7 @@ struct PackageReaderImpl::RootAttributeHandler : PackageAttributeHandler {
 PackageReaderImpl::PackageReaderImpl(BErrorOutput* errorOutput)
 	:
 	inherited("package", errorOutput),
+	fFlags(0),
 	fTOCSection("TOC")
 {
 }
@@ -349,6 +353,8 @@ status_t
 PackageReaderImpl::Init(BPositionIO* file, bool keepFile, uint32 flags,
 	hpkg_header* _header)
 {
+	fFlags = flags;
+
 	hpkg_header header;
 	status_t error = inherited::Init<hpkg_header, B_HPKG_MAGIC, B_HPKG_VERSION,
 		B_HPKG_MINOR_VERSION>(file, keepFile, header, flags);
@@ -531,6 +537,32 @@ PackageReaderImpl::ReadAttributeValue(uint8 type, uint8 encoding,
 }
 
 
+status_t
+PackageReaderImpl::CreateCachedHeapReader(PackageFileHeapReader* heapReader,
+	BAbstractBufferedDataReader*& _cachedReader)
+{
+#ifndef _KERNEL_MODE
+	if ((fFlags & B_HPKG_READER_READ_AHEAD) != 0) {
+		PackageFileHeapPrefetcher* prefetcher
+			= new(std::nothrow) PackageFileHeapPrefetcher(heapReader);
+		if (prefetcher == NULL)
+			return B_NO_MEMORY;
+
+		status_t error = prefetcher->Init();
+		if (error != B_OK) {
+			delete prefetcher;
+			return error;
+		}
+
+		_cachedReader = prefetcher;
+		return B_OK;
+	}
+#endif
+
+	return inherited::CreateCachedHeapReader(heapReader, _cachedReader);
+}
+
+
 status_t
 PackageReaderImpl::_GetTOCBuffer(size_t size, const void*& _buffer)
 {
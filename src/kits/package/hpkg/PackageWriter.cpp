@@ -19,10 +19,15 @@ namespace BHPKG {
 // #pragma mark - BPackageWriterParameters
 
 
+static const uint32 kCompressionMask = 0xffff;
+static const uint32 kThreadCountShift = 16;
+static const int32 kMaxThreadCount = 0xffff;
+
+
 BPackageWriterParameters::BPackageWriterParameters()
 	:
 	fFlags(0),
-	fCompression(B_HPKG_COMPRESSION_ZLIB),
+	fCompression(B_HPKG_COMPRESSION_ZLIB | (1 << kThreadCountShift)),
 	fCompressionLevel(B_HPKG_COMPRESSION_LEVEL_BEST)
 {
 }
@@ -50,14 +55,15 @@ BPackageWriterParameters::SetFlags(uint32 flags)
 uint32
 BPackageWriterParameters::Compression() const
 {
-	return fCompression;
+	return fCompression & kCompressionMask;
 }
 
 
 void
 BPackageWriterParameters::SetCompression(uint32 compression)
 {
-	fCompression = compression;
+	fCompression = (fCompression & ~kCompressionMask)
+		| (compression & kCompressionMask);
 }
 
 
@@ -75,6 +81,26 @@ BPackageWriterParameters::SetCompressionLevel(int32 compressionLevel)
 }
 
 
+int32
+BPackageWriterParameters::CompressionThreadCount() const
+{
+	return fCompression >> kThreadCountShift;
+}
+
+
+void
+BPackageWriterParameters::SetCompressionThreadCount(int32 count)
+{
+	if (count < 0)
+		count = 1;
+	else if (count > kMaxThreadCount)
+		count = kMaxThreadCount;
+
+	fCompression = (fCompression & kCompressionMask)
+		| ((uint32)count << kThreadCountShift);
+}
+
+
 // #pragma mark - BPackageWriter
 
 
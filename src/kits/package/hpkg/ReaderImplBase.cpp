@@ -1010,9 +1010,21 @@ ReaderImplBase::ParseStrings()
 status_t
 ReaderImplBase::ParsePackageAttributesSection(
 	AttributeHandlerContext* context, AttributeHandler* rootAttributeHandler)
+{
+	return ParsePackageAttributesSection(fPackageAttributesSection, context,
+		rootAttributeHandler);
+}
+
+
+/*!	Parses package attributes from the given section, which may also be a
+	part of the package attributes section sharing its strings.
+*/
+status_t
+ReaderImplBase::ParsePackageAttributesSection(PackageFileSection& section,
+	AttributeHandlerContext* context, AttributeHandler* rootAttributeHandler)
 {
 	// parse package attributes
-	SetCurrentSection(&fPackageAttributesSection);
+	SetCurrentSection(&section);
 
 	// init the attribute handler stack
 	rootAttributeHandler->SetLevel(0);
@@ -1022,12 +1034,10 @@ ReaderImplBase::ParsePackageAttributesSection(
 	bool sectionHandled;
 	status_t error = ParseAttributeTree(context, sectionHandled);
 	if (error == B_OK && sectionHandled) {
-		if (fPackageAttributesSection.currentOffset
-				< fPackageAttributesSection.uncompressedLength) {
+		if (section.currentOffset < section.uncompressedLength) {
 			fErrorOutput->PrintError("Error: %llu excess byte(s) in package "
 				"attributes section\n",
-				fPackageAttributesSection.uncompressedLength
-					- fPackageAttributesSection.currentOffset);
+				section.uncompressedLength - section.currentOffset);
 			error = B_BAD_DATA;
 		}
 	}
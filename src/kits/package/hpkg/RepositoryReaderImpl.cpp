@@ -20,6 +20,7 @@
 
 #include <FdIO.h>
 
+#include <package/hpkg/DataReader.h>
 #include <package/hpkg/HPKGDefsPrivate.h>
 #include <package/hpkg/RepositoryContentHandler.h>
 
@@ -42,6 +43,32 @@ static const size_t kMaxRepositoryInfoSize		= 1 * 1024 * 1024;
 static const size_t kMaxPackageAttributesSize	= 64 * 1024 * 1024;
 
 
+// #pragma mark - PackageAttributeHandler
+
+
+/*!	Records where the package's attributes end. */
+class RepositoryReaderImpl::PackageAttributeHandler
+	: public ReaderImplBase::PackageAttributeHandler {
+private:
+	typedef ReaderImplBase::PackageAttributeHandler super;
+public:
+	PackageAttributeHandler(RepositoryReaderImpl* reader)
+		:
+		fReader(reader)
+	{
+	}
+
+	virtual status_t NotifyDone(AttributeHandlerContext* context)
+	{
+		fReader->fPackageEndOffset = fReader->CurrentSection()->currentOffset;
+		return super::NotifyDone(context);
+	}
+
+private:
+	RepositoryReaderImpl*		fReader;
+};
+
+
 // #pragma mark - PackagesAttributeHandler
 
 
@@ -50,8 +77,10 @@ class RepositoryReaderImpl::PackagesAttributeHandler
 private:
 	typedef AttributeHandler super;
 public:
-	PackagesAttributeHandler(BRepositoryContentHandler* contentHandler)
+	PackagesAttributeHandler(RepositoryReaderImpl* reader,
+		BRepositoryContentHandler* contentHandler)
 		:
+		fReader(reader),
 		fContentHandler(contentHandler),
 		fPackageName(NULL)
 	{
@@ -67,6 +96,9 @@ public:
 				if (error != B_OK)
 					return error;
 
+				// the package starts where the previous one ended
+				fReader->fPackageOffset = fReader->fPackageEndOffset;
+
 				if (_handler != NULL) {
 					if (fContentHandler != NULL) {
 						error = fContentHandler->HandlePackage(value.string);
@@ -74,7 +106,8 @@ public:
 							return error;
 					}
 
-					*_handler = new(std::nothrow) PackageAttributeHandler;
+					*_handler = new(std::nothrow) PackageAttributeHandler(
+						fReader);
 					if (*_handler == NULL)
 						return B_NO_MEMORY;
 
@@ -116,6 +149,7 @@ private:
 	}
 
 private:
+	RepositoryReaderImpl*		fReader;
 	BRepositoryContentHandler*	fContentHandler;
 	const char*					fPackageName;
 };
@@ -170,7 +204,10 @@ private:
 
 RepositoryReaderImpl::RepositoryReaderImpl(BErrorOutput* errorOutput)
 	:
-	inherited("repository", errorOutput)
+	inherited("repository", errorOutput),
+	fPackageAttributesPrepared(false),
+	fPackageOffset(0),
+	fPackageEndOffset(0)
 {
 }
 
@@ -244,7 +281,23 @@ RepositoryReaderImpl::Init(BPositionIO* file, bool keepFile)
 	if (error != B_OK)
 		return error;
 
-	error = PrepareSection(fPackageAttributesSection);
+	// For now read only the strings of the package attributes section. The
+	// rest is read by ParseContent(), while ParsePackage() reads just the
+	// part it needs.
+	uint64 stringsLength = fPackageAttributesSection.stringsLength;
+	fPackageAttributesSection.data = new(std::nothrow) uint8[stringsLength];
+	if (fPackageAttributesSection.data == NULL)
+		return B_NO_MEMORY;
+
+	error = HeapReader()->ReadData(fPackageAttributesSection.offset,
+		fPackageAttributesSection.data, stringsLength);
+	if (error != B_OK)
+		return error;
+
+	fPackageAttributesSection.currentOffset = 0;
+	SetCurrentSection(&fPackageAttributesSection);
+	error = ParseStrings();
+	SetCurrentSection(NULL);
 	if (error != B_OK)
 		return error;
 
@@ -281,20 +334,97 @@ RepositoryReaderImpl::GetRepositoryInfo(BRepositoryInfo* _repositoryInfo) const
 status_t
 RepositoryReaderImpl::ParseContent(BRepositoryContentHandler* contentHandler)
 {
-	status_t result = contentHandler->HandleRepositoryInfo(fRepositoryInfo);
+	status_t result = _PreparePackageAttributesSection();
+	if (result != B_OK)
+		return result;
+
+	result = contentHandler->HandleRepositoryInfo(fRepositoryInfo);
 	if (result == B_OK) {
 		PackageContentHandlerAdapter contentHandlerAdapter(contentHandler);
 		AttributeHandlerContext context(ErrorOutput(),
 			contentHandler != NULL ? &contentHandlerAdapter : NULL,
 			B_HPKG_SECTION_PACKAGE_ATTRIBUTES,
 			MinorFormatVersion() > B_HPKG_REPO_MINOR_VERSION);
-		PackagesAttributeHandler rootAttributeHandler(contentHandler);
+		PackagesAttributeHandler rootAttributeHandler(this, contentHandler);
+		fPackageEndOffset = fPackageAttributesSection.stringsLength;
 		result = ParsePackageAttributesSection(&context, &rootAttributeHandler);
 	}
 	return result;
 }
 
 
+status_t
+RepositoryReaderImpl::ParsePackage(uint64 offset, uint64 size,
+	BRepositoryContentHandler* contentHandler)
+{
+	const PackageFileSection& packagesSection = fPackageAttributesSection;
+	if (size == 0 || offset < packagesSection.stringsLength
+		|| offset > packagesSection.uncompressedLength
+		|| size > packagesSection.uncompressedLength - offset) {
+		return B_BAD_VALUE;
+	}
+
+	// The package's part of the section, sharing the section's strings. A
+	// final 0 ends the top level attribute list.
+	PackageFileSection section("package attributes");
+	section.data = new(std::nothrow) uint8[size + 1];
+	if (section.data == NULL)
+		return B_NO_MEMORY;
+
+	if (fPackageAttributesPrepared) {
+		memcpy(section.data, packagesSection.data + offset, size);
+	} else {
+		status_t error = HeapReader()->ReadData(packagesSection.offset + offset,
+			section.data, size);
+		if (error != B_OK)
+			return error;
+	}
+	section.data[size] = 0;
+
+	section.uncompressedLength = size + 1;
+	section.offset = packagesSection.offset + offset;
+	section.currentOffset = 0;
+	section.stringsLength = 0;
+	section.stringsCount = packagesSection.stringsCount;
+	section.strings = packagesSection.strings;
+
+	PackageContentHandlerAdapter contentHandlerAdapter(contentHandler);
+	AttributeHandlerContext context(ErrorOutput(),
+		contentHandler != NULL ? &contentHandlerAdapter : NULL,
+		B_HPKG_SECTION_PACKAGE_ATTRIBUTES,
+		MinorFormatVersion() > B_HPKG_REPO_MINOR_VERSION);
+	PackagesAttributeHandler rootAttributeHandler(this, contentHandler);
+	fPackageEndOffset = offset;
+	status_t error = ParsePackageAttributesSection(section, &context,
+		&rootAttributeHandler);
+
+	section.strings = NULL;
+		// not ours
+	return error;
+}
+
+
+status_t
+RepositoryReaderImpl::_PreparePackageAttributesSection()
+{
+	if (fPackageAttributesPrepared)
+		return B_OK;
+
+	// Init() has read the strings only. Read everything now.
+	delete[] fPackageAttributesSection.strings;
+	fPackageAttributesSection.strings = NULL;
+	delete[] fPackageAttributesSection.data;
+	fPackageAttributesSection.data = NULL;
+
+	status_t error = PrepareSection(fPackageAttributesSection);
+	if (error != B_OK)
+		return error;
+
+	fPackageAttributesPrepared = true;
+	return B_OK;
+}
+
+
 }	// namespace BPrivate
 
 }	// namespace BHPKG
@@ -360,6 +360,8 @@ WriterImplBase::InitHeapReader(size_t headerSize)
 	// create heap writer
 	fHeapWriter = new PackageFileHeapWriter(fErrorOutput, fFile, headerSize,
 		compressionAlgorithm, decompressionAlgorithm);
+	fHeapWriter->SetCompressionThreadCount(
+		fParameters.CompressionThreadCount());
 	fHeapWriter->Init();
 
 	return B_OK;
@@ -10,7 +10,13 @@
 #include "LibsolvSolver.h"
 
 #include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <sys/utsname.h>
+#include <unistd.h>
 
 #include <new>
 
@@ -18,10 +24,18 @@
 #include <solv/poolarch.h>
 #include <solv/repo.h>
 #include <solv/repo_haiku.h>
+#include <solv/repo_solv.h>
+#include <solv/repo_write.h>
 #include <solv/selection.h>
 #include <solv/solverdebug.h>
 
+#include <Directory.h>
+#include <FindDirectory.h>
+#include <Path.h>
+
+#include <package/ChecksumAccessors.h>
 #include <package/PackageResolvableExpression.h>
+#include <package/PackageRoster.h>
 #include <package/RepositoryCache.h>
 #include <package/solver/SolverPackage.h>
 #include <package/solver/SolverPackageSpecifier.h>
@@ -38,6 +52,24 @@
 // abort()s. Obviously that isn't good behavior for a library.
 
 
+// The libsolv repositories built from repository caches are stored in the
+// user's cache directory, so they don't have to be built again as long as the
+// repository cache doesn't change. A file consists of a header followed by
+// the repository in libsolv's own format.
+static const char* const kCachedRepositoryDirectory = "package-solver";
+static const uint32 kCachedRepositoryMagic = 'hsrc';
+static const uint32 kCachedRepositoryVersion = 1;
+
+struct cached_repository_header {
+	uint32	magic;
+	uint32	version;
+	uint32	package_count;
+	uint32	reserved;
+	char	checksum[64];
+		// hex SHA-256 of the repository cache
+};
+
+
 BSolver*
 BPackageKit::create_solver()
 {
@@ -106,10 +138,22 @@ struct LibsolvSolver::RepositoryInfo {
 		fChangeCount = fRepository->ChangeCount();
 	}
 
+	const BString& CacheChecksum() const
+	{
+		return fCacheChecksum;
+	}
+
+	void SetCacheChecksum(const BString& checksum)
+	{
+		fCacheChecksum = checksum;
+	}
+
 private:
 	BSolverRepository*	fRepository;
 	Repo*				fSolvRepo;
 	uint64				fChangeCount;
+	BString				fCacheChecksum;
+		// of the repository cache with the repository's name, if any
 };
 
 
@@ -732,12 +776,14 @@ LibsolvSolver::_AddRepositories()
 		return B_OK;
 
 	// something has changed -- re-create the pool
+	bigtime_t startTime = system_time();
 	status_t error = _InitPool();
 	if (error != B_OK)
 		return error;
 
 	fInstalledRepository = NULL;
 
+	int32 cachedRepositoryCount = 0;
 	int32 repositoryCount = fRepositoryInfos.CountItems();
 	for (int32 i = 0; i < repositoryCount; i++) {
 		RepositoryInfo* repositoryInfo = fRepositoryInfos.ItemAt(i);
@@ -748,22 +794,17 @@ LibsolvSolver::_AddRepositories()
 		repo->priority = -1 - repository->Priority();
 		repo->appdata = (void*)repositoryInfo;
 
-		int32 packageCount = repository->CountPackages();
-		for (int32 k = 0; k < packageCount; k++) {
-			BSolverPackage* package = repository->PackageAt(k);
-			Id solvableId = repo_add_haiku_package_info(repo, package->Info(),
-				REPO_REUSE_REPODATA | REPO_NO_INTERNALIZE);
+		_UpdateCacheChecksum(repositoryInfo);
+		if (_LoadCachedRepository(repositoryInfo)) {
+			cachedRepositoryCount++;
+		} else {
+			error = _AddRepositoryPackages(repositoryInfo);
+			if (error != B_OK)
+				return error;
 
-			try {
-				fSolvablePackages[solvableId] = package;
-				fPackageSolvables[package] = solvableId;
-			} catch (std::bad_alloc&) {
-				return B_NO_MEMORY;
-			}
+			_StoreCachedRepository(repositoryInfo);
 		}
 
-		repo_internalize(repo);
-
 		if (repository->IsInstalled()) {
 			fInstalledRepository = repositoryInfo;
 			pool_set_installed(fPool, repo);
@@ -775,10 +816,236 @@ LibsolvSolver::_AddRepositories()
 	// create "provides" lookup
 	pool_createwhatprovides(fPool);
 
+	if (fDebugLevel > 0) {
+		printf("solver pool set up in %" B_PRId64 " us, %" B_PRId32 " of %"
+			B_PRId32 " repositories loaded from cache\n",
+			system_time() - startTime, cachedRepositoryCount, repositoryCount);
+	}
+
+	return B_OK;
+}
+
+
+status_t
+LibsolvSolver::_AddRepositoryPackages(RepositoryInfo* repositoryInfo)
+{
+	BSolverRepository* repository = repositoryInfo->Repository();
+	Repo* repo = repositoryInfo->SolvRepo();
+
+	int32 packageCount = repository->CountPackages();
+	for (int32 i = 0; i < packageCount; i++) {
+		BSolverPackage* package = repository->PackageAt(i);
+		Id solvableId = repo_add_haiku_package_info(repo, package->Info(),
+			REPO_REUSE_REPODATA | REPO_NO_INTERNALIZE);
+
+		try {
+			fSolvablePackages[solvableId] = package;
+			fPackageSolvables[package] = solvableId;
+		} catch (std::bad_alloc&) {
+			return B_NO_MEMORY;
+		}
+	}
+
+	repo_internalize(repo);
 	return B_OK;
 }
 
 
+/*!	Looks up the repository cache the repository's packages most likely
+	came from -- the one the package roster has for the repository's name --
+	and remembers its checksum. Since the repository might have been set up
+	or changed in other ways, the cached libsolv repo is still checked
+	against the repository's packages when it is loaded.
+*/
+void
+LibsolvSolver::_UpdateCacheChecksum(RepositoryInfo* repositoryInfo)
+{
+	repositoryInfo->SetCacheChecksum(BString());
+
+#ifdef HAIKU_TARGET_PLATFORM_HAIKU
+	BSolverRepository* repository = repositoryInfo->Repository();
+	if (repository->IsInstalled())
+		return;
+
+	// the user's cache takes precedence, like in
+	// BPackageRoster::GetRepositoryCache()
+	BPackageRoster roster;
+	BPath path;
+	BEntry entry;
+	if (roster.GetUserRepositoryCachePath(&path) == B_OK
+		&& path.Append(repository->Name()) == B_OK) {
+		entry.SetTo(path.Path());
+	}
+	if (!entry.Exists() && roster.GetCommonRepositoryCachePath(&path) == B_OK
+		&& path.Append(repository->Name()) == B_OK) {
+		entry.SetTo(path.Path());
+	}
+
+	BString checksum;
+	BPackageKit::BPrivate::GeneralFileChecksumAccessor checksumAccessor(entry);
+	if (entry.Exists() && checksumAccessor.GetChecksum(checksum) == B_OK)
+		repositoryInfo->SetCacheChecksum(checksum);
+#endif
+}
+
+
+/*!	Fills the repository's libsolv repo from the cached one, if there is one
+	for the repository's cache checksum.
+*/
+bool
+LibsolvSolver::_LoadCachedRepository(RepositoryInfo* repositoryInfo)
+{
+	BSolverRepository* repository = repositoryInfo->Repository();
+	const BString& checksum = repositoryInfo->CacheChecksum();
+	BPath path;
+	if (checksum.Length() != sizeof(cached_repository_header().checksum)
+		|| _GetCachedRepositoryPath(repositoryInfo, path) != B_OK) {
+		return false;
+	}
+
+	int fd = open(path.Path(), O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat st;
+	void* address = MAP_FAILED;
+	if (fstat(fd, &st) == 0
+		&& st.st_size > (off_t)sizeof(cached_repository_header)) {
+		address = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	}
+	close(fd);
+
+	if (address == MAP_FAILED)
+		return false;
+
+	const cached_repository_header* header
+		= (const cached_repository_header*)address;
+	int32 packageCount = repository->CountPackages();
+	bool loaded = false;
+	if (header->magic == kCachedRepositoryMagic
+		&& header->version == kCachedRepositoryVersion
+		&& header->package_count == (uint32)packageCount
+		&& memcmp(header->checksum, checksum.String(),
+			sizeof(header->checksum)) == 0) {
+		FILE* file = fmemopen((uint8*)address + sizeof(*header),
+			st.st_size - sizeof(*header), "r");
+		if (file != NULL) {
+			loaded = repo_add_solv(repositoryInfo->SolvRepo(), file, 0) == 0;
+			fclose(file);
+		}
+	}
+
+	munmap(address, st.st_size);
+
+	// The solvables are in the order of the repository's packages. Check the
+	// names and versions anyway, a mismatch would make us install the wrong
+	// packages.
+	Repo* repo = repositoryInfo->SolvRepo();
+	if (loaded && repo->nsolvables != packageCount)
+		loaded = false;
+
+	for (int32 i = 0; loaded && i < packageCount; i++) {
+		BSolverPackage* package = repository->PackageAt(i);
+		Id solvableId = repo->start + i;
+		Solvable* solvable = pool_id2solvable(fPool, solvableId);
+		BPackageVersion version;
+		if (solvable->repo != repo
+			|| package->Info().Name() != pool_id2str(fPool, solvable->name)
+			|| version.SetTo(pool_id2str(fPool, solvable->evr), true) != B_OK
+			|| version.Compare(package->Info().Version()) != 0) {
+			loaded = false;
+			break;
+		}
+
+		try {
+			fSolvablePackages[solvableId] = package;
+			fPackageSolvables[package] = solvableId;
+		} catch (std::bad_alloc&) {
+			loaded = false;
+		}
+	}
+
+	if (!loaded) {
+		for (int32 i = 0; i < packageCount; i++) {
+			BSolverPackage* package = repository->PackageAt(i);
+			PackageMap::iterator it = fPackageSolvables.find(package);
+			if (it != fPackageSolvables.end()) {
+				fSolvablePackages.erase(it->second);
+				fPackageSolvables.erase(it);
+			}
+		}
+
+		repo_empty(repo, 1);
+	}
+
+	return loaded;
+}
+
+
+/*!	Writes the repository's libsolv repo to the cache, if it has been built
+	from a repository cache.
+*/
+void
+LibsolvSolver::_StoreCachedRepository(RepositoryInfo* repositoryInfo)
+{
+	BSolverRepository* repository = repositoryInfo->Repository();
+	const BString& checksum = repositoryInfo->CacheChecksum();
+	BPath path;
+	if (checksum.Length() != sizeof(cached_repository_header().checksum)
+		|| _GetCachedRepositoryPath(repositoryInfo, path) != B_OK) {
+		return;
+	}
+
+	// write to a temporary file first, so a concurrent reader won't see a
+	// partial file
+	BString tempPath(path.Path());
+	tempPath << "." << getpid();
+
+	FILE* file = fopen(tempPath.String(), "w");
+	if (file == NULL)
+		return;
+
+	cached_repository_header header;
+	memset(&header, 0, sizeof(header));
+	header.magic = kCachedRepositoryMagic;
+	header.version = kCachedRepositoryVersion;
+	header.package_count = repository->CountPackages();
+	memcpy(header.checksum, checksum.String(), sizeof(header.checksum));
+
+	bool written = fwrite(&header, sizeof(header), 1, file) == 1
+		&& repo_write(repositoryInfo->SolvRepo(), file) == 0;
+	if (fclose(file) != 0)
+		written = false;
+
+	if (!written || rename(tempPath.String(), path.Path()) != 0)
+		unlink(tempPath.String());
+}
+
+
+status_t
+LibsolvSolver::_GetCachedRepositoryPath(RepositoryInfo* repositoryInfo,
+	BPath& _path) const
+{
+#ifdef HAIKU_TARGET_PLATFORM_HAIKU
+	status_t error = find_directory(B_USER_CACHE_DIRECTORY, &_path, true);
+	if (error == B_OK)
+		error = _path.Append(kCachedRepositoryDirectory);
+	if (error == B_OK)
+		error = create_directory(_path.Path(), 0755);
+	if (error != B_OK)
+		return error;
+
+	BString fileName = repositoryInfo->Repository()->Name();
+	fileName.ReplaceAll('/', '_');
+	fileName << ".solv";
+	return _path.Append(fileName);
+#else
+	// build tools don't keep a cache
+	return B_NOT_SUPPORTED;
+#endif
+}
+
+
 LibsolvSolver::RepositoryInfo*
 LibsolvSolver::_InstalledRepository() const
 {
@@ -24,6 +24,8 @@ namespace BPackageKit {
 	class BSolverPackage;
 }
 
+class BPath;
+
 
 class LibsolvSolver : public BSolver {
 public:
@@ -95,6 +97,17 @@ private:
 
 			bool				_HaveRepositoriesChanged() const;
 			status_t			_AddRepositories();
+			status_t			_AddRepositoryPackages(
+									RepositoryInfo* repositoryInfo);
+			void				_UpdateCacheChecksum(
+									RepositoryInfo* repositoryInfo);
+			bool				_LoadCachedRepository(
+									RepositoryInfo* repositoryInfo);
+			void				_StoreCachedRepository(
+									RepositoryInfo* repositoryInfo);
+			status_t			_GetCachedRepositoryPath(
+									RepositoryInfo* repositoryInfo,
+									BPath& _path) const;
 			RepositoryInfo*		_InstalledRepository() const;
 			RepositoryInfo*		_GetRepositoryInfo(
 									BSolverRepository* repository) const;
@@ -13,6 +13,10 @@
 #include <ctype.h>
 #include <cerrno>
 
+#if defined(__SSE2__)
+#	include <emmintrin.h>
+#endif
+
 #include <AutoDeleter.h>
 #include <DataIO.h>
 #include <UnicodeChar.h>
@@ -26,6 +30,9 @@
 namespace BPrivate {
 
 
+static const size_t kParseBufferSize = 16 * 1024;
+
+
 static bool
 b_jsonparse_is_hex(char c)
 {
@@ -47,7 +54,55 @@ b_jsonparse_all_hex(const char* c)
 }
 
 
-/*! This class carries state around the parsing process. */
+static bool
+b_jsonparse_is_number_char(char c)
+{
+	return isdigit(c) || c == '+' || c == '-' || c == 'e' || c == 'E'
+		|| c == '.';
+}
+
+
+/*! Returns the first character in the range that ends a run of plain string
+    content -- a quote, a backslash or a control character -- or \a end, if
+    there is none.
+*/
+
+static const char*
+b_jsonparse_find_string_special(const char* start, const char* end)
+{
+#if defined(__SSE2__)
+	const __m128i quote = _mm_set1_epi8('"');
+	const __m128i backslash = _mm_set1_epi8('\\');
+	const __m128i lastControl = _mm_set1_epi8(0x1f);
+
+	while (end - start >= 16) {
+		__m128i chunk = _mm_loadu_si128((const __m128i*)start);
+		__m128i special = _mm_or_si128(
+			_mm_or_si128(_mm_cmpeq_epi8(chunk, quote),
+				_mm_cmpeq_epi8(chunk, backslash)),
+			_mm_cmpeq_epi8(_mm_min_epu8(chunk, lastControl), chunk));
+		int mask = _mm_movemask_epi8(special);
+		if (mask != 0)
+			return start + __builtin_ctz(mask);
+		start += 16;
+	}
+#endif
+
+	for (; start < end; start++) {
+		uint8 c = static_cast<uint8>(*start);
+		if (c == '"' || c == '\\' || c < 0x20)
+			return start;
+	}
+
+	return end;
+}
+
+
+/*! This class carries state around the parsing process. The input is read
+    in blocks into a buffer, unless it is in memory already, in which case it
+    is used directly. The parse logic scans the buffered data in bulk where
+    it can.
+*/
 
 class JsonParseContext {
 public:
@@ -56,9 +111,29 @@ public:
 		fListener(listener),
 		fData(data),
 		fLineNumber(1), // 1 is the first line
-		fPushbackChar(0),
-		fHasPushbackChar(false)
+		fBuffer(NULL),
+		fPosition(NULL),
+		fEnd(NULL)
+	{
+	}
+
+
+	JsonParseContext(const char* data, size_t length,
+		BJsonEventListener* listener)
+		:
+		fListener(listener),
+		fData(NULL),
+		fLineNumber(1), // 1 is the first line
+		fBuffer(NULL),
+		fPosition(data),
+		fEnd(data + length)
+	{
+	}
+
+
+	~JsonParseContext()
 	{
+		free(fBuffer);
 	}
 
 
@@ -86,35 +161,90 @@ public:
 	}
 
 
-		// TODO; there is considerable opportunity for performance improvements
-		// here by buffering the input and then feeding it into the parse
-		// algorithm character by character.
-
 	status_t NextChar(char* buffer)
 	{
-
-		if (fHasPushbackChar) {
-			buffer[0] = fPushbackChar;
-			fHasPushbackChar = false;
-			return B_OK;
+		if (fPosition == fEnd) {
+			status_t result = FillBuffer();
+			if (result != B_OK)
+				return result;
 		}
 
-		return Data()->ReadExactly(buffer, 1);
+		buffer[0] = *fPosition++;
+		return B_OK;
 	}
 
 
+	/*! Returns the character last obtained from NextChar() to the input. */
+
 	void PushbackChar(char c)
 	{
-		fPushbackChar = c;
-		fHasPushbackChar = true;
+		fPosition--;
+	}
+
+
+	const char* Position() const
+	{
+		return fPosition;
+	}
+
+
+	const char* End() const
+	{
+		return fEnd;
+	}
+
+
+	void SetPosition(const char* position)
+	{
+		fPosition = position;
+	}
+
+
+	/*! The data between Position() and End() may only be modified by the
+		parse logic, if it has been read into the context's own buffer.
+	*/
+
+	bool IsBufferWritable() const
+	{
+		return fBuffer != NULL;
+	}
+
+
+	/*! Reads the next block of input into the buffer. This must only be
+		invoked once all the buffered data has been consumed. Like
+		BDataIO::ReadExactly(), it returns B_PARTIAL_READ at the end of the
+		input.
+	*/
+
+	status_t FillBuffer()
+	{
+		if (fData == NULL)
+			return B_PARTIAL_READ;
+
+		if (fBuffer == NULL) {
+			fBuffer = (char*)malloc(kParseBufferSize);
+			if (fBuffer == NULL)
+				return B_NO_MEMORY;
+		}
+
+		ssize_t bytesRead = fData->Read(fBuffer, kParseBufferSize);
+		if (bytesRead < 0)
+			return bytesRead;
+		if (bytesRead == 0)
+			return B_PARTIAL_READ;
+
+		fPosition = fBuffer;
+		fEnd = fBuffer + bytesRead;
+		return B_OK;
 	}
 
 private:
 	BJsonEventListener*		fListener;
 	BDataIO*				fData;
 	uint32					fLineNumber;
-	char					fPushbackChar;
-	bool					fHasPushbackChar;
+	char*					fBuffer;
+	const char*				fPosition;
+	const char*				fEnd;
 };
 
 
@@ -128,12 +258,10 @@ BJson::Parse(const BString& JSON, BMessage& message)
 status_t
 BJson::Parse(const char* JSON, size_t length, BMessage& message)
 {
-	BMemoryIO* input = new BMemoryIO(JSON, length);
-	ObjectDeleter<BMemoryIO> inputDeleter(input);
 	BJsonMessageWriter* writer = new BJsonMessageWriter(message);
 	ObjectDeleter<BJsonMessageWriter> writerDeleter(writer);
 
-	Parse(input, writer);
+	Parse(JSON, length, writer);
 	status_t result = writer->ErrorStatus();
 
 	return result;
@@ -155,6 +283,9 @@ BJson::Parse(const char* JSON, BMessage& message)
      - array start
      - object end
     Each event is sent to the listener to process as required.
+
+    The data is read in blocks, so more data than the JSON value itself may
+    be consumed from the stream.
 */
 
 void
@@ -166,6 +297,21 @@ BJson::Parse(BDataIO* data, BJsonEventListener* listener)
 }
 
 
+/*! As above, but for JSON data that is in memory already. The events for
+    strings without escape sequences refer to the data directly, so they are
+    not null-terminated; see BJsonEvent::ContentData() and
+    BJsonEvent::ContentLength().
+*/
+
+void
+BJson::Parse(const char* data, size_t length, BJsonEventListener* listener)
+{
+	JsonParseContext context(data, length, listener);
+	ParseAny(context);
+	listener->Complete();
+}
+
+
 // #pragma mark - Specific parse logic.
 
 
@@ -568,28 +714,63 @@ BJson::ParseStringEscapeSequence(JsonParseContext& jsonParseContext,
 }
 
 
+/*! The plain runs of the string are located in the buffered input in bulk.
+    Unless the string spans more than one buffer or contains escape sequences
+    it is passed on to the listener without copying it.
+*/
+
 bool
 BJson::ParseString(JsonParseContext& jsonParseContext,
 	json_event_type eventType)
 {
-	char c;
 	BString stringResult;
+	bool isAssembled = false;
 
 	while(true) {
-		if (!NextChar(jsonParseContext, &c))
-    		return false;
+		const char* start = jsonParseContext.Position();
+		const char* end = jsonParseContext.End();
+		const char* special = b_jsonparse_find_string_special(start, end);
+
+		if (special == end) {
+				// the string continues beyond the buffered data.
+			stringResult.Append(start, end - start);
+			isAssembled = true;
+			jsonParseContext.SetPosition(end);
+
+			char c;
+			if (!NextChar(jsonParseContext, &c))
+				return false;
+			jsonParseContext.PushbackChar(c);
+			continue;
+		}
 
-		switch (c) {
+		jsonParseContext.SetPosition(special + 1);
+
+		switch (*special) {
 			case '"':
 			{
 					// terminates the string assembled so far.
-				jsonParseContext.Listener()->Handle(
-					BJsonEvent(eventType, stringResult.String()));
+				if (isAssembled) {
+					stringResult.Append(start, special - start);
+					jsonParseContext.Listener()->Handle(
+						BJsonEvent(eventType, stringResult.String()));
+				} else if (jsonParseContext.IsBufferWritable()) {
+					// the quote is consumed, so it can be replaced with the
+					// terminating null
+					*const_cast<char*>(special) = '\0';
+					jsonParseContext.Listener()->Handle(
+						BJsonEvent(eventType, start));
+				} else {
+					jsonParseContext.Listener()->Handle(
+						BJsonEvent(eventType, start, special - start));
+				}
 				return true;
 			}
 
 			case '\\':
 			{
+				stringResult.Append(start, special - start);
+				isAssembled = true;
 				if (!ParseStringEscapeSequence(jsonParseContext,
 					stringResult)) {
 					return false;
@@ -599,20 +780,15 @@ BJson::ParseString(JsonParseContext& jsonParseContext,
 
 			default:
 			{
-				uint8 uc = static_cast<uint8>(c);
-
-				if(uc < 0x20) { // control characters are not allowed
-					BString errorMessage;
-					errorMessage.SetToFormat("illegal control character"
-						" [%" B_PRIu8 "] when parsing a string", uc);
-					jsonParseContext.Listener()->HandleError(B_BAD_DATA,
-						jsonParseContext.LineNumber(),
-						errorMessage.String());
-					return false;
-				}
-
-				stringResult.Append(&c, 1);
-				break;
+					// control characters are not allowed
+				BString errorMessage;
+				errorMessage.SetToFormat("illegal control character"
+					" [%" B_PRIu8 "] when parsing a string",
+					static_cast<uint8>(*special));
+				jsonParseContext.Listener()->HandleError(B_BAD_DATA,
+					jsonParseContext.LineNumber(),
+					errorMessage.String());
+				return false;
 			}
 		}
 	}
@@ -731,48 +907,47 @@ BJson::ParseNumber(JsonParseContext& jsonParseContext)
 	BString value;
 
 	while (true) {
+		const char* start = jsonParseContext.Position();
+		const char* end = jsonParseContext.End();
+		const char* position = start;
+
+		while (position < end && b_jsonparse_is_number_char(*position))
+			position++;
+
+		value.Append(start, position - start);
+		jsonParseContext.SetPosition(position);
+
+		if (position < end)
+			break;
+
 		char c;
 		status_t result = jsonParseContext.NextChar(&c);
 
-		switch (result) {
-			case B_OK:
-			{
-				if (isdigit(c)) {
-					value += c;
-					break;
-				}
-
-				if (NULL != strchr("+-eE.", c)) {
-					value += c;
-					break;
-				}
+		if (result == B_OK) {
+			jsonParseContext.PushbackChar(c);
+			continue;
+		}
 
-				jsonParseContext.PushbackChar(c);
-				// intentional fall through
-			}
-			case B_PARTIAL_READ:
-			{
-				errno = 0;
+		if (result == B_PARTIAL_READ)
+			break;
 
-				if (!IsValidNumber(value)) {
-					jsonParseContext.Listener()->HandleError(B_BAD_DATA,
-						jsonParseContext.LineNumber(), "malformed number");
-					return false;
-				}
+		jsonParseContext.Listener()->HandleError(result, -1,
+			"io related read error");
+		return false;
+	}
 
-				jsonParseContext.Listener()->Handle(BJsonEvent(B_JSON_NUMBER,
-					value.String()));
+	errno = 0;
 
-				return true;
-			}
-			default:
-			{
-				jsonParseContext.Listener()->HandleError(result, -1,
-					"io related read error");
-				return false;
-			}
-		}
+	if (!IsValidNumber(value)) {
+		jsonParseContext.Listener()->HandleError(B_BAD_DATA,
+			jsonParseContext.LineNumber(), "malformed number");
+		return false;
 	}
+
+	jsonParseContext.Listener()->Handle(BJsonEvent(B_JSON_NUMBER,
+		value.String()));
+
+	return true;
 }
 
 } // namespace BPrivate
@@ -8,6 +8,7 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 
 #include <String.h>
 
@@ -16,6 +17,22 @@ BJsonEvent::BJsonEvent(json_event_type eventType, const char* content)
 	:
 	fEventType(eventType),
 	fContent(content),
+	fContentLength(-1),
+	fOwnedContent(NULL)
+{
+}
+
+
+/*! The content is referenced, not copied; it only needs to be terminated, if
+    the listener asks for it by calling Content().
+*/
+
+BJsonEvent::BJsonEvent(json_event_type eventType, const char* content,
+	size_t length)
+	:
+	fEventType(eventType),
+	fContent(content),
+	fContentLength(length),
 	fOwnedContent(NULL)
 {
 }
@@ -25,6 +42,7 @@ BJsonEvent::BJsonEvent(const char* content)
 	:
 	fEventType(B_JSON_STRING),
 	fContent(content),
+	fContentLength(-1),
 	fOwnedContent(NULL)
 {
 }
@@ -33,6 +51,7 @@ BJsonEvent::BJsonEvent(const char* content)
 BJsonEvent::BJsonEvent(double content) {
 	fEventType = B_JSON_NUMBER;
 	fContent = NULL;
+	fContentLength = -1;
 
 	int actualLength = snprintf(0, 0, "%f", content) + 1;
 	char* buffer = (char*) malloc(sizeof(char) * actualLength);
@@ -51,6 +70,7 @@ BJsonEvent::BJsonEvent(double content) {
 BJsonEvent::BJsonEvent(int64 content) {
 	fEventType = B_JSON_NUMBER;
 	fContent = NULL;
+	fContentLength = -1;
 	fOwnedContent = NULL;
 
 	static const char* zeroValue = "0";
@@ -87,6 +107,7 @@ BJsonEvent::BJsonEvent(json_event_type eventType)
 	:
 	fEventType(eventType),
 	fContent(NULL),
+	fContentLength(-1),
 	fOwnedContent(NULL)
 {
 }
@@ -108,6 +129,46 @@ BJsonEvent::EventType() const
 
 const char*
 BJsonEvent::Content() const
+{
+	if (NULL != fOwnedContent)
+		return fOwnedContent;
+
+	if (fContentLength >= 0 && NULL != fContent) {
+		// the content is a view into the parsed data; copy it in order to
+		// terminate it
+		char* buffer = (char*) malloc(fContentLength + 1);
+
+		if (buffer == NULL) {
+			fprintf(stderr, "memory exhaustion\n");
+				// given the risk, this is the only sensible thing to do here.
+			exit(EXIT_FAILURE);
+		}
+
+		memcpy(buffer, fContent, fContentLength);
+		buffer[fContentLength] = '\0';
+		fOwnedContent = buffer;
+		return fOwnedContent;
+	}
+
+	return fContent;
+}
+
+
+size_t
+BJsonEvent::ContentLength() const
+{
+	if (fContentLength >= 0)
+		return fContentLength;
+
+	const char* content = Content();
+	if (NULL == content)
+		return 0;
+	return strlen(content);
+}
+
+
+const char*
+BJsonEvent::ContentData() const
 {
 	if (NULL != fOwnedContent)
 		return fOwnedContent;
@@ -1,5 +1,5 @@
 /*
- * Copyright 2013, Haiku, Inc. All Rights Reserved.
+ * Copyright 2013-2026, Haiku, Inc. All Rights Reserved.
  * Distributed under the terms of the MIT License.
  *
  * Authors:
@@ -10,6 +10,7 @@
 #include <CopyEngine.h>
 
 #include <errno.h>
+#include <malloc.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -23,6 +24,10 @@
 #include <SymLink.h>
 #include <TypeConstants.h>
 
+#include <AutoLocker.h>
+
+#include "EntryOperationWorkerPool.h"
+
 
 namespace BPrivate {
 
@@ -31,6 +36,125 @@ static const size_t kDefaultBufferSize = 1024 * 1024;
 static const size_t kSmallBufferSize = 64 * 1024;
 
 
+// #pragma mark - Copier
+
+
+struct BCopyEngine::Copier : EntryOperationWorkerPool {
+	Copier(BCopyEngine* engine)
+		:
+		fEngine(engine)
+	{
+		// worker 0 is the calling thread, which uses the engine's buffer
+		fBuffers[0] = engine->fBuffer;
+		fBufferSizes[0] = engine->fBufferSize;
+		for (int32 i = 1; i < kMaxWorkers; i++) {
+			fBuffers[i] = NULL;
+			fBufferSizes[i] = 0;
+		}
+	}
+
+	~Copier()
+	{
+		for (int32 i = 1; i < kMaxWorkers; i++)
+			free(fBuffers[i]);
+	}
+
+	virtual void ProcessJob(Directory* parent, const char* sourcePath,
+		const char* destPath, int32 worker)
+	{
+		if (fBuffers[worker] == NULL) {
+			status_t error = _AllocateBuffer(fBuffers[worker],
+				fBufferSizes[worker]);
+			if (error != B_OK) {
+				JobDone(parent, fEngine->_HandleEntryError(sourcePath, error,
+					"Failed to allocate buffer\n"));
+				return;
+			}
+		}
+
+		BDirectory sourceDir;
+		bool done;
+		status_t error = fEngine->_CopyNode(sourcePath, destPath,
+			fBuffers[worker], fBufferSizes[worker], sourceDir, done);
+		if (done) {
+			JobDone(parent, error);
+			return;
+		}
+
+		if (sourceDir.InitCheck() != B_OK) {
+			// not a directory
+			fEngine->_EntryFinished(sourcePath, B_OK);
+			JobDone(parent, B_OK);
+			return;
+		}
+
+		// add jobs for the directory's entries -- the directory's job is done
+		// when theirs are
+		Directory* directory = AddDirectory(parent, sourcePath, destPath);
+		if (directory == NULL) {
+			JobDone(parent, fEngine->_HandleEntryError(sourcePath, B_NO_MEMORY,
+				"Failed to allocate directory \"%s\"\n", sourcePath));
+			return;
+		}
+
+		char buffer[sizeof(dirent) + B_FILE_NAME_LENGTH];
+		dirent *entry = (dirent*)buffer;
+		while (!IsCanceled(directory)
+			&& sourceDir.GetNextDirents(entry, sizeof(buffer), 1) == 1) {
+			if (strcmp(entry->d_name, ".") == 0
+				|| strcmp(entry->d_name, "..") == 0) {
+				continue;
+			}
+
+			// construct new entry paths
+			BPath sourceEntryPath;
+			error = sourceEntryPath.SetTo(sourcePath, entry->d_name);
+			if (error != B_OK) {
+				fEngine->_NotifyError(error, "Failed to construct entry path "
+					"from dir \"%s\" and name \"%s\": %s\n", sourcePath,
+					entry->d_name, strerror(error));
+				break;
+			}
+
+			BPath destEntryPath;
+			error = destEntryPath.SetTo(destPath, entry->d_name);
+			if (error != B_OK) {
+				fEngine->_NotifyError(error, "Failed to construct entry path "
+					"from dir \"%s\" and name \"%s\": %s\n", destPath,
+					entry->d_name, strerror(error));
+				break;
+			}
+
+			error = AddJob(directory, sourceEntryPath.Path(),
+				destEntryPath.Path(), worker);
+			if (error != B_OK) {
+				fEngine->_NotifyError(error, "Failed to copy \"%s\": %s\n",
+					sourceEntryPath.Path(), strerror(error));
+				break;
+			}
+		}
+
+		JobDone(directory, error);
+	}
+
+	virtual status_t FinishDirectory(Directory* directory)
+	{
+		fEngine->_EntryFinished(directory->sourcePath, B_OK);
+		return B_OK;
+	}
+
+	virtual bool EntryFailed(const char* path, status_t error)
+	{
+		return fEngine->_EntryFinished(path, error);
+	}
+
+private:
+	BCopyEngine*	fEngine;
+	char*			fBuffers[kMaxWorkers];
+	size_t			fBufferSizes[kMaxWorkers];
+};
+
+
 // #pragma mark - BCopyEngine
 
 
@@ -39,14 +163,15 @@ BCopyEngine::BCopyEngine(uint32 flags)
 	fController(NULL),
 	fFlags(flags),
 	fBuffer(NULL),
-	fBufferSize(0)
+	fBufferSize(0),
+	fCopier(NULL)
 {
 }
 
 
 BCopyEngine::~BCopyEngine()
 {
-	delete[] fBuffer;
+	free(fBuffer);
 }
 
 
@@ -98,17 +223,9 @@ BCopyEngine::RemoveFlags(uint32 flags)
 status_t
 BCopyEngine::CopyEntry(const Entry& sourceEntry, const Entry& destEntry)
 {
-	if (fBuffer == NULL) {
-		fBuffer = new(std::nothrow) char[kDefaultBufferSize];
-		if (fBuffer == NULL) {
-			fBuffer = new(std::nothrow) char[kSmallBufferSize];
-			if (fBuffer == NULL) {
-				_NotifyError(B_NO_MEMORY, "Failed to allocate buffer");
-				return B_NO_MEMORY;
-			}
-			fBufferSize = kSmallBufferSize;
-		} else
-			fBufferSize = kDefaultBufferSize;
+	if (fBuffer == NULL && _AllocateBuffer(fBuffer, fBufferSize) != B_OK) {
+		_NotifyError(B_NO_MEMORY, "Failed to allocate buffer");
+		return B_NO_MEMORY;
 	}
 
 	BPath sourcePathBuffer;
@@ -123,15 +240,116 @@ BCopyEngine::CopyEntry(const Entry& sourceEntry, const Entry& destEntry)
 	if (error != B_OK)
 		return error;
 
-	return _CopyEntry(sourcePath, destPath);
+	// only start the threads when there is a tree to copy
+	struct stat sourceStat;
+	if ((fFlags & COPY_RECURSIVELY) == 0 || (fFlags & COPY_CONCURRENTLY) == 0
+		|| lstat(sourcePath, &sourceStat) != 0
+		|| !S_ISDIR(sourceStat.st_mode)) {
+		return _CopyEntry(sourcePath, destPath);
+	}
+
+	Copier copier(this);
+	error = copier.Init();
+	if (error != B_OK) {
+		_NotifyError(error, "Failed to initialize the copy threads: %s\n",
+			strerror(error));
+		return error;
+	}
+
+	fCopier = &copier;
+	error = copier.Run(sourcePath, destPath);
+	fCopier = NULL;
+
+	return error;
+}
+
+
+/*static*/ status_t
+BCopyEngine::_AllocateBuffer(char*& _buffer, size_t& _size)
+{
+	// page aligned, so the file systems can transfer the data directly
+	_buffer = (char*)memalign(B_PAGE_SIZE, kDefaultBufferSize);
+	if (_buffer != NULL) {
+		_size = kDefaultBufferSize;
+		return B_OK;
+	}
+
+	_buffer = (char*)memalign(B_PAGE_SIZE, kSmallBufferSize);
+	if (_buffer != NULL) {
+		_size = kSmallBufferSize;
+		return B_OK;
+	}
+
+	return B_NO_MEMORY;
 }
 
 
 status_t
 BCopyEngine::_CopyEntry(const char* sourcePath, const char* destPath)
 {
+	BDirectory sourceDir;
+	bool done;
+	status_t error = _CopyNode(sourcePath, destPath, fBuffer, fBufferSize,
+		sourceDir, done);
+	if (done)
+		return error;
+
+	// recurse
+	if ((fFlags & COPY_RECURSIVELY) != 0 && sourceDir.InitCheck() == B_OK) {
+		char buffer[sizeof(dirent) + B_FILE_NAME_LENGTH];
+		dirent *entry = (dirent*)buffer;
+		while (sourceDir.GetNextDirents(entry, sizeof(buffer), 1) == 1) {
+			if (strcmp(entry->d_name, ".") == 0
+				|| strcmp(entry->d_name, "..") == 0) {
+				continue;
+			}
+
+			// construct new entry paths
+			BPath sourceEntryPath;
+			error = sourceEntryPath.SetTo(sourcePath, entry->d_name);
+			if (error != B_OK) {
+				return _HandleEntryError(sourcePath, error,
+					"Failed to construct entry path from dir \"%s\" and name "
+					"\"%s\": %s\n", sourcePath, entry->d_name, strerror(error));
+			}
+
+			BPath destEntryPath;
+			error = destEntryPath.SetTo(destPath, entry->d_name);
+			if (error != B_OK) {
+				return _HandleEntryError(sourcePath, error,
+					"Failed to construct entry path from dir \"%s\" and name "
+					"\"%s\": %s\n", destPath, entry->d_name, strerror(error));
+			}
+
+			// copy the entry
+			error = _CopyEntry(sourceEntryPath.Path(), destEntryPath.Path());
+			if (error != B_OK) {
+				if (_EntryFinished(sourcePath, error))
+					return B_OK;
+				return error;
+			}
+		}
+	}
+
+	_EntryFinished(sourcePath, B_OK);
+	return B_OK;
+}
+
+
+/*!	Copies the entry itself, i.e. everything but a directory's entries.
+	If \a _done is set to \c true, the entry has been dealt with completely
+	and the returned error is the one of the entry. Otherwise the caller has
+	to copy a directory's entries and call _EntryFinished(). \a sourceDir is
+	only initialized for a directory.
+*/
+status_t
+BCopyEngine::_CopyNode(const char* sourcePath, const char* destPath,
+	char* buffer, size_t bufferSize, BDirectory& sourceDir, bool& _done)
+{
+	_done = true;
+
 	// apply entry filter
-	if (fController != NULL && !fController->EntryStarted(sourcePath))
+	if (!_EntryStarted(sourcePath))
 		return B_OK;
 
 	// stat source
@@ -180,7 +398,6 @@ BCopyEngine::_CopyEntry(const char* sourcePath, const char* destPath)
 	// open source node
 	BNode _sourceNode;
 	BFile sourceFile;
-	BDirectory sourceDir;
 	BNode* sourceNode = NULL;
 	status_t error;
 
@@ -230,18 +447,17 @@ BCopyEngine::_CopyEntry(const char* sourcePath, const char* destPath)
 			destNode = &destFile;
 
 			// copy file contents
-			error = _CopyFileData(sourcePath, sourceFile, destPath, destFile);
+			error = _CopyFileData(sourcePath, sourceFile, destPath, destFile,
+				buffer, bufferSize);
 			if (error != B_OK) {
-				if (fController != NULL
-					&& fController->EntryFinished(sourcePath, error)) {
+				if (_EntryFinished(sourcePath, error))
 					return B_OK;
-				}
 				return error;
 			}
 		} else if (S_ISLNK(sourceStat.st_mode)) {
 			// read symlink
-			char* linkTo = fBuffer;
-			ssize_t bytesRead = readlink(sourcePath, linkTo, fBufferSize - 1);
+			char* linkTo = buffer;
+			ssize_t bytesRead = readlink(sourcePath, linkTo, bufferSize - 1);
 			if (bytesRead < 0) {
 				return _HandleEntryError(sourcePath, errno,
 					"Failed to read symlink \"%s\": %s\n", sourcePath,
@@ -267,12 +483,11 @@ BCopyEngine::_CopyEntry(const char* sourcePath, const char* destPath)
 		}
 
 		// copy attributes (before setting the permissions!)
-		error = _CopyAttributes(sourcePath, *sourceNode, destPath, *destNode);
+		error = _CopyAttributes(sourcePath, *sourceNode, destPath, *destNode,
+			buffer, bufferSize);
 		if (error != B_OK) {
-			if (fController != NULL
-				&& fController->EntryFinished(sourcePath, error)) {
+			if (_EntryFinished(sourcePath, error))
 				return B_OK;
-			}
 			return error;
 		}
 
@@ -289,59 +504,19 @@ BCopyEngine::_CopyEntry(const char* sourcePath, const char* destPath)
 	// the destination node is no longer needed
 	destNode->Unset();
 
-	// recurse
-	if ((fFlags & COPY_RECURSIVELY) != 0 && S_ISDIR(sourceStat.st_mode)) {
-		char buffer[sizeof(dirent) + B_FILE_NAME_LENGTH];
-		dirent *entry = (dirent*)buffer;
-		while (sourceDir.GetNextDirents(entry, sizeof(buffer), 1) == 1) {
-			if (strcmp(entry->d_name, ".") == 0
-				|| strcmp(entry->d_name, "..") == 0) {
-				continue;
-			}
-
-			// construct new entry paths
-			BPath sourceEntryPath;
-			error = sourceEntryPath.SetTo(sourcePath, entry->d_name);
-			if (error != B_OK) {
-				return _HandleEntryError(sourcePath, error,
-					"Failed to construct entry path from dir \"%s\" and name "
-					"\"%s\": %s\n", sourcePath, entry->d_name, strerror(error));
-			}
-
-			BPath destEntryPath;
-			error = destEntryPath.SetTo(destPath, entry->d_name);
-			if (error != B_OK) {
-				return _HandleEntryError(sourcePath, error,
-					"Failed to construct entry path from dir \"%s\" and name "
-					"\"%s\": %s\n", destPath, entry->d_name, strerror(error));
-			}
-
-			// copy the entry
-			error = _CopyEntry(sourceEntryPath.Path(), destEntryPath.Path());
-			if (error != B_OK) {
-				if (fController != NULL
-					&& fController->EntryFinished(sourcePath, error)) {
-					return B_OK;
-				}
-				return error;
-			}
-		}
-	}
-
-	if (fController != NULL)
-		fController->EntryFinished(sourcePath, B_OK);
+	_done = false;
 	return B_OK;
 }
 
 
 status_t
 BCopyEngine::_CopyFileData(const char* sourcePath, BFile& source,
-	const char* destPath, BFile& destination)
+	const char* destPath, BFile& destination, char* buffer, size_t bufferSize)
 {
 	off_t offset = 0;
 	while (true) {
 		// read
-		ssize_t bytesRead = source.ReadAt(offset, fBuffer, fBufferSize);
+		ssize_t bytesRead = source.ReadAt(offset, buffer, bufferSize);
 		if (bytesRead < 0) {
 			_NotifyError(bytesRead, "Failed to read from file \"%s\": %s\n",
 				sourcePath, strerror(bytesRead));
@@ -352,7 +527,7 @@ BCopyEngine::_CopyFileData(const char* sourcePath, BFile& source,
 			return B_OK;
 
 		// write
-		ssize_t bytesWritten = destination.WriteAt(offset, fBuffer, bytesRead);
+		ssize_t bytesWritten = destination.WriteAt(offset, buffer, bytesRead);
 		if (bytesWritten < 0) {
 			_NotifyError(bytesWritten, "Failed to write to file \"%s\": %s\n",
 				destPath, strerror(bytesWritten));
@@ -372,7 +547,7 @@ BCopyEngine::_CopyFileData(const char* sourcePath, BFile& source,
 
 status_t
 BCopyEngine::_CopyAttributes(const char* sourcePath, BNode& source,
-	const char* destPath, BNode& destination)
+	const char* destPath, BNode& destination, char* buffer, size_t bufferSize)
 {
 	char attrName[B_ATTR_NAME_LENGTH];
 	while (source.GetNextAttrName(attrName) == B_OK) {
@@ -386,9 +561,7 @@ BCopyEngine::_CopyAttributes(const char* sourcePath, BNode& source,
 		}
 
 		// filter
-		if (fController != NULL
-			&& !fController->AttributeStarted(sourcePath, attrName,
-				attrInfo.type)) {
+		if (!_AttributeStarted(sourcePath, attrName, attrInfo.type)) {
 			if (error != B_OK) {
 				_NotifyError(error, "Failed to get info of attribute \"%s\" "
 					"of file \"%s\": %s\n", attrName, sourcePath,
@@ -412,13 +585,13 @@ BCopyEngine::_CopyAttributes(const char* sourcePath, BNode& source,
 		// go at least once through the loop, so that an empty attribute will be
 		// created as well
 		do {
-			size_t toRead = fBufferSize;
+			size_t toRead = bufferSize;
 			if ((off_t)toRead > bytesLeft)
 				toRead = bytesLeft;
 
 			// read
 			ssize_t bytesRead = source.ReadAttr(attrName, attrInfo.type,
-				offset, fBuffer, toRead);
+				offset, buffer, toRead);
 			if (bytesRead < 0) {
 				error = _HandleAttributeError(sourcePath, attrName,
 					attrInfo.type, bytesRead, "Failed to read attribute \"%s\" "
@@ -434,7 +607,7 @@ BCopyEngine::_CopyAttributes(const char* sourcePath, BNode& source,
 
 			// write
 			ssize_t bytesWritten = destination.WriteAttr(attrName,
-				attrInfo.type, offset, fBuffer, bytesRead);
+				attrInfo.type, offset, buffer, bytesRead);
 			if (bytesWritten < 0) {
 				error = _HandleAttributeError(sourcePath, attrName,
 					attrInfo.type, bytesWritten, "Failed to write attribute "
@@ -449,16 +622,60 @@ BCopyEngine::_CopyAttributes(const char* sourcePath, BNode& source,
 			offset += bytesRead;
 		} while (bytesLeft > 0);
 
-		if (fController != NULL) {
-			fController->AttributeFinished(sourcePath, attrName, attrInfo.type,
-				B_OK);
-		}
+		_AttributeFinished(sourcePath, attrName, attrInfo.type, B_OK);
 	}
 
 	return B_OK;
 }
 
 
+bool
+BCopyEngine::_EntryStarted(const char* path)
+{
+	if (fController == NULL)
+		return true;
+
+	AutoLocker<BLocker> locker(fCopier != NULL ? &fCopier->Lock() : NULL);
+	return fController->EntryStarted(path);
+}
+
+
+bool
+BCopyEngine::_EntryFinished(const char* path, status_t error)
+{
+	if (fController == NULL)
+		return false;
+
+	AutoLocker<BLocker> locker(fCopier != NULL ? &fCopier->Lock() : NULL);
+	return fController->EntryFinished(path, error);
+}
+
+
+bool
+BCopyEngine::_AttributeStarted(const char* path, const char* attribute,
+	uint32 attributeType)
+{
+	if (fController == NULL)
+		return true;
+
+	AutoLocker<BLocker> locker(fCopier != NULL ? &fCopier->Lock() : NULL);
+	return fController->AttributeStarted(path, attribute, attributeType);
+}
+
+
+bool
+BCopyEngine::_AttributeFinished(const char* path, const char* attribute,
+	uint32 attributeType, status_t error)
+{
+	if (fController == NULL)
+		return false;
+
+	AutoLocker<BLocker> locker(fCopier != NULL ? &fCopier->Lock() : NULL);
+	return fController->AttributeFinished(path, attribute, attributeType,
+		error);
+}
+
+
 void
 BCopyEngine::_NotifyError(status_t error, const char* format, ...)
 {
@@ -478,6 +695,8 @@ BCopyEngine::_NotifyErrorVarArgs(status_t error, const char* format,
 	if (fController != NULL) {
 		BString message;
 		message.SetToFormatVarArgs(format, args);
+
+		AutoLocker<BLocker> locker(fCopier != NULL ? &fCopier->Lock() : NULL);
 		fController->ErrorOccurred(message, error);
 	}
 }
@@ -495,7 +714,7 @@ BCopyEngine::_HandleEntryError(const char* path, status_t error,
 	_NotifyErrorVarArgs(error, format, args);
 	va_end(args);
 
-	if (fController->EntryFinished(path, error))
+	if (_EntryFinished(path, error))
 		return B_OK;
 	return error;
 }
@@ -513,7 +732,7 @@ BCopyEngine::_HandleAttributeError(const char* path, const char* attribute,
 	_NotifyErrorVarArgs(error, format, args);
 	va_end(args);
 
-	if (fController->AttributeFinished(path, attribute, attributeType, error))
+	if (_AttributeFinished(path, attribute, attributeType, error))
 		return B_OK;
 	return error;
 }
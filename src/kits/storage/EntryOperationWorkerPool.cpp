@@ -0,0 +1,258 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include "EntryOperationWorkerPool.h"
+
+#include <new>
+
+#include <AutoLocker.h>
+
+
+namespace BPrivate {
+
+
+static const int32 kMaxQueuedJobs = 4096;
+	// When that many jobs are queued, a thread adding another one processes
+	// it right away. That bounds the memory used for huge directories.
+
+
+EntryOperationWorkerPool::EntryOperationWorkerPool()
+	:
+	fLock("entry operation worker pool"),
+	fJobSemaphore(-1),
+	fJobs(),
+	fQueuedJobs(0),
+	fWorkerCount(0),
+	fNextWorker(0),
+	fError(B_OK),
+	fCanceled(false)
+{
+}
+
+
+EntryOperationWorkerPool::~EntryOperationWorkerPool()
+{
+	while (Job* job = fJobs.RemoveHead())
+		delete job;
+
+	if (fJobSemaphore >= 0)
+		delete_sem(fJobSemaphore);
+}
+
+
+status_t
+EntryOperationWorkerPool::Init()
+{
+	status_t error = fLock.InitCheck();
+	if (error != B_OK)
+		return error;
+
+	fJobSemaphore = create_sem(0, "entry operation jobs");
+	if (fJobSemaphore < 0)
+		return fJobSemaphore;
+
+	return B_OK;
+}
+
+
+status_t
+EntryOperationWorkerPool::Run(const char* sourcePath, const char* destPath)
+{
+	// The entries are mostly small files, so the threads mostly wait for I/O.
+	// Use more threads than there are CPUs.
+	int32 workerCount = kMaxWorkers;
+	system_info info;
+	if (get_system_info(&info) == B_OK
+		&& (int32)info.cpu_count * 2 < workerCount) {
+		workerCount = max_c((int32)info.cpu_count * 2, 2);
+	}
+
+	// the calling thread is worker 0
+	fWorkerCount = 1;
+	fNextWorker = 1;
+	for (int32 i = 1; i < workerCount; i++) {
+		thread_id thread = spawn_thread(&_WorkerThread,
+			"entry operation worker", B_NORMAL_PRIORITY, this);
+		if (thread < 0)
+			break;
+		fThreads[fWorkerCount++] = thread;
+	}
+
+	for (int32 i = 1; i < fWorkerCount; i++)
+		resume_thread(fThreads[i]);
+
+	ProcessJob(NULL, sourcePath, destPath, 0);
+	_Work(0);
+
+	for (int32 i = 1; i < fWorkerCount; i++) {
+		status_t result;
+		wait_for_thread(fThreads[i], &result);
+	}
+
+	return fError;
+}
+
+
+EntryOperationWorkerPool::Directory*
+EntryOperationWorkerPool::AddDirectory(Directory* parent,
+	const char* sourcePath, const char* destPath)
+{
+	Directory* directory = new(std::nothrow) Directory;
+	if (directory == NULL)
+		return NULL;
+
+	directory->parent = parent;
+	directory->sourcePath = sourcePath;
+	directory->destPath = destPath;
+	directory->pendingJobs = 1;
+	directory->finished = false;
+	return directory;
+}
+
+
+status_t
+EntryOperationWorkerPool::AddJob(Directory* directory, const char* sourcePath,
+	const char* destPath, int32 worker)
+{
+	atomic_add(&directory->pendingJobs, 1);
+
+	if (atomic_get(&fQueuedJobs) >= kMaxQueuedJobs) {
+		ProcessJob(directory, sourcePath, destPath, worker);
+		return B_OK;
+	}
+
+	Job* job = new(std::nothrow) Job;
+	if (job == NULL) {
+		// can't drop to 0, since the caller's job is still pending
+		atomic_add(&directory->pendingJobs, -1);
+		return B_NO_MEMORY;
+	}
+
+	job->directory = directory;
+	job->sourcePath = sourcePath;
+	job->destPath = destPath;
+
+	fLock.Lock();
+	fJobs.Add(job);
+	atomic_add(&fQueuedJobs, 1);
+	fLock.Unlock();
+
+	release_sem(fJobSemaphore);
+	return B_OK;
+}
+
+
+void
+EntryOperationWorkerPool::JobDone(Directory* directory, status_t error)
+{
+	while (true) {
+		if (error != B_OK)
+			_Fail(directory, error);
+
+		if (directory == NULL)
+			break;
+
+		if (atomic_add(&directory->pendingJobs, -1) > 1)
+			return;
+
+		// That was the directory's last pending job. Unless some of its
+		// entries have been skipped, finish it.
+		error = IsCanceled(directory) ? B_OK : FinishDirectory(directory);
+
+		Directory* parent = directory->parent;
+		delete directory;
+		directory = parent;
+	}
+
+	// The root entry's job is done and with it all others. Wake up the
+	// workers, so they notice.
+	release_sem_etc(fJobSemaphore, fWorkerCount, 0);
+}
+
+
+bool
+EntryOperationWorkerPool::IsCanceled(Directory* directory)
+{
+	AutoLocker<BLocker> locker(fLock);
+
+	if (fCanceled)
+		return true;
+
+	for (; directory != NULL; directory = directory->parent) {
+		if (directory->finished)
+			return true;
+	}
+
+	return false;
+}
+
+
+/*static*/ status_t
+EntryOperationWorkerPool::_WorkerThread(void* data)
+{
+	EntryOperationWorkerPool* self = (EntryOperationWorkerPool*)data;
+	self->_Work(atomic_add(&self->fNextWorker, 1));
+	return B_OK;
+}
+
+
+void
+EntryOperationWorkerPool::_Work(int32 worker)
+{
+	while (true) {
+		status_t error;
+		do {
+			error = acquire_sem(fJobSemaphore);
+		} while (error == B_INTERRUPTED);
+
+		if (error != B_OK)
+			return;
+
+		fLock.Lock();
+		Job* job = fJobs.RemoveTail();
+			// depth first, so fewer directories are open at a time
+		fLock.Unlock();
+
+		if (job == NULL)
+			return;
+
+		atomic_add(&fQueuedJobs, -1);
+
+		if (IsCanceled(job->directory))
+			JobDone(job->directory, B_OK);
+		else {
+			ProcessJob(job->directory, job->sourcePath, job->destPath,
+				worker);
+		}
+
+		delete job;
+	}
+}
+
+
+void
+EntryOperationWorkerPool::_Fail(Directory* directory, status_t error)
+{
+	AutoLocker<BLocker> locker(fLock);
+
+	for (; directory != NULL; directory = directory->parent) {
+		if (directory->finished) {
+			// the directory has failed already
+			return;
+		}
+
+		directory->finished = true;
+		if (EntryFailed(directory->sourcePath, error))
+			return;
+	}
+
+	if (fError == B_OK)
+		fError = error;
+	fCanceled = true;
+}
+
+
+} // namespace BPrivate
@@ -0,0 +1,112 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef _ENTRY_OPERATION_WORKER_POOL_H
+#define _ENTRY_OPERATION_WORKER_POOL_H
+
+
+#include <Locker.h>
+#include <OS.h>
+#include <String.h>
+
+#include <util/DoublyLinkedList.h>
+
+
+namespace BPrivate {
+
+
+/*!	Processes the entries of a directory tree on several threads.
+
+	Every entry is a job. Processing a directory's job adds jobs for the
+	directory's entries; the directory is finished (FinishDirectory()) when
+	all of them are done. An error an entry doesn't handle itself is passed to
+	its ancestor directories (EntryFailed()), innermost first, until one of
+	them handles it, just like the recursive engine implementations do. The
+	ancestors that don't handle it are not finished anymore and their
+	remaining entries are skipped. If no ancestor handles the error, the
+	whole operation is canceled and Run() returns the error.
+*/
+class EntryOperationWorkerPool {
+public:
+			struct Directory;
+
+	static	const int32			kMaxWorkers = 8;
+
+public:
+								EntryOperationWorkerPool();
+	virtual						~EntryOperationWorkerPool();
+
+			status_t			Init();
+
+			BLocker&			Lock()	{ return fLock; }
+
+			status_t			Run(const char* sourcePath,
+									const char* destPath);
+
+			Directory*			AddDirectory(Directory* parent,
+									const char* sourcePath,
+									const char* destPath);
+			status_t			AddJob(Directory* directory,
+									const char* sourcePath,
+									const char* destPath, int32 worker);
+			void				JobDone(Directory* directory,
+									status_t error);
+									// error is one of the job's entry that
+									// the entry didn't handle
+			bool				IsCanceled(Directory* directory);
+
+protected:
+	virtual	void				ProcessJob(Directory* directory,
+									const char* sourcePath,
+									const char* destPath, int32 worker) = 0;
+									// must call JobDone() eventually
+	virtual	status_t			FinishDirectory(Directory* directory) = 0;
+	virtual	bool				EntryFailed(const char* path,
+									status_t error) = 0;
+
+private:
+			struct Job;
+			typedef DoublyLinkedList<Job> JobList;
+
+private:
+	static	status_t			_WorkerThread(void* data);
+			void				_Work(int32 worker);
+			void				_Fail(Directory* directory, status_t error);
+
+private:
+			BLocker				fLock;
+			sem_id				fJobSemaphore;
+			JobList				fJobs;
+			int32				fQueuedJobs;
+			thread_id			fThreads[kMaxWorkers];
+			int32				fWorkerCount;
+			int32				fNextWorker;
+			status_t			fError;
+			bool				fCanceled;
+};
+
+
+struct EntryOperationWorkerPool::Directory {
+			Directory*			parent;
+			BString				sourcePath;
+			BString				destPath;
+			int32				pendingJobs;
+									// the directory's entries' jobs plus the
+									// one adding them
+			bool				finished;
+};
+
+
+struct EntryOperationWorkerPool::Job
+	: DoublyLinkedListLinkImpl<EntryOperationWorkerPool::Job> {
+			Directory*			directory;
+			BString				sourcePath;
+			BString				destPath;
+};
+
+
+} // namespace BPrivate
+
+
+#endif	// _ENTRY_OPERATION_WORKER_POOL_H
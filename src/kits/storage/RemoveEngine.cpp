@@ -1,5 +1,6 @@
 /*
  * Copyright 2013, Ingo Weinhold, ingo_weinhold@gmx.de.
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
  * Distributed under the terms of the MIT License.
  */
 
@@ -14,16 +15,118 @@
 #include <Entry.h>
 #include <Path.h>
 
+#include <AutoLocker.h>
+
+#include "EntryOperationWorkerPool.h"
+
 
 namespace BPrivate {
 
 
+// #pragma mark - Remover
+
+
+struct BRemoveEngine::Remover : EntryOperationWorkerPool {
+	Remover(BRemoveEngine* engine)
+		:
+		fEngine(engine)
+	{
+	}
+
+	virtual void ProcessJob(Directory* parent, const char* path,
+		const char*, int32 worker)
+	{
+		// apply entry filter
+		if (!fEngine->_EntryStarted(path)) {
+			JobDone(parent, B_OK);
+			return;
+		}
+
+		// stat entry
+		struct stat st;
+		if (lstat(path, &st) < 0) {
+			JobDone(parent, fEngine->_HandleEntryError(path, errno,
+				"Couldn't access \"%s\": %s\n", path, strerror(errno)));
+			return;
+		}
+
+		if (!S_ISDIR(st.st_mode)) {
+			JobDone(parent, fEngine->_RemoveNode(path, false));
+			return;
+		}
+
+		// open directory
+		BDirectory dirNode;
+		status_t error = dirNode.SetTo(path);
+		if (error != B_OK) {
+			JobDone(parent, fEngine->_HandleEntryError(path, error,
+				"Failed to open directory \"%s\": %s\n", path,
+				strerror(error)));
+			return;
+		}
+
+		// add jobs for the directory's entries -- the directory is removed
+		// when they are
+		Directory* directory = AddDirectory(parent, path, NULL);
+		if (directory == NULL) {
+			JobDone(parent, fEngine->_HandleEntryError(path, B_NO_MEMORY,
+				"Failed to allocate directory \"%s\"\n", path));
+			return;
+		}
+
+		char buffer[sizeof(dirent) + B_FILE_NAME_LENGTH];
+		dirent *entry = (dirent*)buffer;
+		while (!IsCanceled(directory)
+			&& dirNode.GetNextDirents(entry, sizeof(buffer), 1) == 1) {
+			if (strcmp(entry->d_name, ".") == 0
+				|| strcmp(entry->d_name, "..") == 0) {
+				continue;
+			}
+
+			// construct child entry path
+			BPath childPath;
+			error = childPath.SetTo(path, entry->d_name);
+			if (error != B_OK) {
+				fEngine->_NotifyError(error, "Failed to construct entry path "
+					"from dir \"%s\" and name \"%s\": %s\n", path,
+					entry->d_name, strerror(error));
+				break;
+			}
+
+			error = AddJob(directory, childPath.Path(), NULL, worker);
+			if (error != B_OK) {
+				fEngine->_NotifyError(error, "Failed to remove \"%s\": %s\n",
+					childPath.Path(), strerror(error));
+				break;
+			}
+		}
+
+		JobDone(directory, error);
+	}
+
+	virtual status_t FinishDirectory(Directory* directory)
+	{
+		return fEngine->_RemoveNode(directory->sourcePath, true);
+	}
+
+	virtual bool EntryFailed(const char* path, status_t error)
+	{
+		return fEngine->_EntryFinished(path, error);
+	}
+
+private:
+	BRemoveEngine*	fEngine;
+};
+
+
 // #pragma mark - BRemoveEngine
 
 
-BRemoveEngine::BRemoveEngine()
+BRemoveEngine::BRemoveEngine(uint32 flags)
 	:
-	fController(NULL)
+	fController(NULL),
+	fFlags(flags),
+	fRemover(NULL)
 {
 }
 
@@ -47,6 +150,37 @@ BRemoveEngine::SetController(BController* controller)
 }
 
 
+uint32
+BRemoveEngine::Flags() const
+{
+	return fFlags;
+}
+
+
+BRemoveEngine&
+BRemoveEngine::SetFlags(uint32 flags)
+{
+	fFlags = flags;
+	return *this;
+}
+
+
+BRemoveEngine&
+BRemoveEngine::AddFlags(uint32 flags)
+{
+	fFlags |= flags;
+	return *this;
+}
+
+
+BRemoveEngine&
+BRemoveEngine::RemoveFlags(uint32 flags)
+{
+	fFlags &= ~flags;
+	return *this;
+}
+
+
 status_t
 BRemoveEngine::RemoveEntry(const Entry& entry)
 {
@@ -56,7 +190,26 @@ BRemoveEngine::RemoveEntry(const Entry& entry)
 	if (error != B_OK)
 		return error;
 
-	return _RemoveEntry(path);
+	// only start the threads when there is a tree to remove
+	struct stat st;
+	if ((fFlags & REMOVE_CONCURRENTLY) == 0 || lstat(path, &st) != 0
+		|| !S_ISDIR(st.st_mode)) {
+		return _RemoveEntry(path);
+	}
+
+	Remover remover(this);
+	error = remover.Init();
+	if (error != B_OK) {
+		_NotifyError(error, "Failed to initialize the remove threads: %s\n",
+			strerror(error));
+		return error;
+	}
+
+	fRemover = &remover;
+	error = remover.Run(path, NULL);
+	fRemover = NULL;
+
+	return error;
 }
 
 
@@ -64,7 +217,7 @@ status_t
 BRemoveEngine::_RemoveEntry(const char* path)
 {
 	// apply entry filter
-	if (fController != NULL && !fController->EntryStarted(path))
+	if (!_EntryStarted(path))
 		return B_OK;
 
 	// stat entry
@@ -104,17 +257,21 @@ BRemoveEngine::_RemoveEntry(const char* path)
 			// remove the entry
 			error = _RemoveEntry(childPath.Path());
 			if (error != B_OK) {
-				if (fController != NULL
-					&& fController->EntryFinished(path, error)) {
+				if (_EntryFinished(path, error))
 					return B_OK;
-				}
 				return error;
 			}
 		}
 	}
 
-	// remove entry
-	if (S_ISDIR(st.st_mode)) {
+	return _RemoveNode(path, S_ISDIR(st.st_mode));
+}
+
+
+status_t
+BRemoveEngine::_RemoveNode(const char* path, bool isDirectory)
+{
+	if (isDirectory) {
 		if (rmdir(path) < 0) {
 			return _HandleEntryError(path, errno,
 				"Failed to remove \"%s\": %s\n", path, strerror(errno));
@@ -126,13 +283,45 @@ BRemoveEngine::_RemoveEntry(const char* path)
 		}
 	}
 
-	if (fController != NULL)
-		fController->EntryFinished(path, B_OK);
-
+	_EntryFinished(path, B_OK);
 	return B_OK;
 }
 
 
+bool
+BRemoveEngine::_EntryStarted(const char* path)
+{
+	if (fController == NULL)
+		return true;
+
+	AutoLocker<BLocker> locker(fRemover != NULL ? &fRemover->Lock() : NULL);
+	return fController->EntryStarted(path);
+}
+
+
+bool
+BRemoveEngine::_EntryFinished(const char* path, status_t error)
+{
+	if (fController == NULL)
+		return false;
+
+	AutoLocker<BLocker> locker(fRemover != NULL ? &fRemover->Lock() : NULL);
+	return fController->EntryFinished(path, error);
+}
+
+
+void
+BRemoveEngine::_NotifyError(status_t error, const char* format, ...)
+{
+	if (fController != NULL) {
+		va_list args;
+		va_start(args, format);
+		_NotifyErrorVarArgs(error, format, args);
+		va_end(args);
+	}
+}
+
+
 void
 BRemoveEngine::_NotifyErrorVarArgs(status_t error, const char* format,
 	va_list args)
@@ -140,6 +329,8 @@ BRemoveEngine::_NotifyErrorVarArgs(status_t error, const char* format,
 	if (fController != NULL) {
 		BString message;
 		message.SetToFormatVarArgs(format, args);
+
+		AutoLocker<BLocker> locker(fRemover != NULL ? &fRemover->Lock() : NULL);
 		fController->ErrorOccurred(message, error);
 	}
 }
@@ -157,7 +348,7 @@ BRemoveEngine::_HandleEntryError(const char* path, status_t error,
 	_NotifyErrorVarArgs(error, format, args);
 	va_end(args);
 
-	if (fController->EntryFinished(path, error))
+	if (_EntryFinished(path, error))
 		return B_OK;
 	return error;
 }
@@ -817,6 +817,56 @@ Database::GuessMimeType(const entry_ref *ref, BString *result)
 	return status;
 }
 
+// GuessMimeType
+/*!	\brief Guesses a MIME type for a regular file whose first bytes have
+	already been read by the caller.
+
+	This allows callers to do the file I/O without holding the database lock.
+	\a buffer should contain the first SniffBytesNeeded() bytes of \a file
+	(or less, if the file is shorter). Unlike GuessMimeType(const entry_ref*,
+	BString*), the entry is not checked for being a directory, symlink, or
+	meta MIME type.
+
+	\param ref The entry the data was read from, for the extension check.
+	\param file The opened file, passed on to the sniffer add-ons.
+	\param buffer Pointer to the data buffer.
+	\param length Size of the buffer in bytes.
+	\param result Pointer to a pre-allocated BString which is set to the
+		   resulting MIME type.
+	\return
+	- \c B_OK: success (even if the guess returned is "application/octet-stream")
+	- other error code: failure
+*/
+status_t
+Database::GuessMimeType(const entry_ref *ref, BFile *file, const void *buffer,
+	int32 length, BString *result)
+{
+	if (ref == NULL || buffer == NULL || result == NULL)
+		return B_BAD_VALUE;
+
+	status_t status = fSnifferRules.GuessMimeType(file, buffer, length,
+		result);
+	if (status == kMimeGuessFailureError)
+		status = fAssociatedTypes.GuessMimeType(ref, result);
+
+	if (status == kMimeGuessFailureError) {
+		result->SetTo(kGenericFileType);
+		status = B_OK;
+	}
+
+	return status;
+}
+
+
+/*!	\brief Returns the number of bytes at the start of a file that are needed
+	to evaluate all installed sniffer rules.
+*/
+ssize_t
+Database::SniffBytesNeeded()
+{
+	return fSnifferRules.MaxBytesNeeded();
+}
+
 // GuessMimeType
 /*!	\brief Guesses a MIME type for the supplied chunk of data.
 
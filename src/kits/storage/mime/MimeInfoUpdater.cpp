@@ -13,6 +13,7 @@
 
 #include <mime/MimeInfoUpdater.h>
 
+#include <new>
 #include <stdlib.h>
 
 #include <AppFileInfo.h>
@@ -22,6 +23,7 @@
 #include <MimeType.h>
 #include <String.h>
 
+#include <AutoDeleter.h>
 #include <AutoLocker.h>
 #include <mime/Database.h>
 #include <mime/database_support.h>
@@ -110,9 +112,18 @@ MimeInfoUpdater::Do(const entry_ref& entry, bool* _entryIsDir)
 
 	// guess the MIME type
 	BString type;
-	if (!err && (updateType || updateAppInfo)) {
-		AutoLocker<DatabaseLocker> databaseLocker(fDatabaseLocker);
-		err = fDatabase->GuessMimeType(&entry, &type);
+	if (!err && (updateType || updateAppInfo))
+		err = _GuessMimeType(entry, node, type);
+
+	// When forced to update all types, most files will usually keep the type
+	// they already have -- don't rewrite the attribute for those.
+	if (!err && updateType
+		&& fForce == B_UPDATE_MIME_INFO_FORCE_UPDATE_ALL) {
+		BString currentType;
+		if (node.ReadAttrString(kFileTypeAttr, &currentType) == B_OK
+			&& currentType == type) {
+			updateType = false;
+		}
 	}
 
 	// update the MIME type
@@ -256,6 +267,52 @@ MimeInfoUpdater::Do(const entry_ref& entry, bool* _entryIsDir)
 }
 
 
+/*!	Guesses the MIME type of the given entry like Database::GuessMimeType()
+	does, but only holds the database lock while the sniffer rules are
+	evaluated, not while the file is being read. This allows several updaters
+	to work in parallel.
+*/
+status_t
+MimeInfoUpdater::_GuessMimeType(const entry_ref& entry, BNode& node,
+	BString& type)
+{
+	// Anything but a regular file without a META:TYPE attribute doesn't need
+	// to be sniffed, let the database handle those cases.
+	struct stat st;
+	attr_info info;
+	if (node.GetStat(&st) != B_OK || !S_ISREG(st.st_mode)
+		|| node.GetAttrInfo(kTypeAttr, &info) == B_OK) {
+		AutoLocker<DatabaseLocker> databaseLocker(fDatabaseLocker);
+		return fDatabase->GuessMimeType(&entry, &type);
+	}
+
+	ssize_t bytesNeeded;
+	{
+		AutoLocker<DatabaseLocker> databaseLocker(fDatabaseLocker);
+		bytesNeeded = fDatabase->SniffBytesNeeded();
+	}
+	if (bytesNeeded < 0)
+		return bytesNeeded;
+
+	BFile file;
+	status_t status = file.SetTo(&entry, B_READ_ONLY);
+	if (status != B_OK)
+		return status;
+
+	char* buffer = new(std::nothrow) char[bytesNeeded];
+	if (buffer == NULL)
+		return B_NO_MEMORY;
+	ArrayDeleter<char> bufferDeleter(buffer);
+
+	ssize_t bytesRead = file.ReadAt(0, buffer, bytesNeeded);
+	if (bytesRead < 0)
+		return bytesRead;
+
+	AutoLocker<DatabaseLocker> databaseLocker(fDatabaseLocker);
+	return fDatabase->GuessMimeType(&entry, &file, buffer, bytesRead, &type);
+}
+
+
 } // namespace Mime
 } // namespace Storage
 } // namespace BPrivate
@@ -27,6 +27,7 @@
 #include <mime/MimeSniffer.h>
 #include <sniffer/Parser.h>
 #include <sniffer/Rule.h>
+#include <sniffer/RuleSet.h>
 #include <StorageDefs.h>
 #include <storage_support.h>
 #include <String.h>
@@ -58,6 +59,7 @@ using namespace BPrivate::Storage;
 //! Creates a new \c sniffer_rule object
 SnifferRules::sniffer_rule::sniffer_rule(Sniffer::Rule *rule)
 	: rule(rule)
+	, slot(-1)
 {
 }
 
@@ -254,6 +256,12 @@ SnifferRules::SetSnifferRule(const char *type, const char *rule)
 	// Remove any previous rule for this type
 	if (!err)
 		err = DeleteSnifferRule(type);
+	// Add it to the rule set
+	if (!err) {
+		item.slot = fRuleSet.AddRule(item.rule);
+		if (item.slot < 0)
+			err = item.slot;
+	}
 	// Insert the new rule at the proper position in
 	// the sorted rule list (remembering that our list
 	// is sorted in ascending order using
@@ -291,6 +299,8 @@ SnifferRules::DeleteSnifferRule(const char *type)
 	for (std::list<sniffer_rule>::iterator i = fRuleList.begin();
 		   i != fRuleList.end(); i++) {
 		if (i->type == type) {
+			fRuleSet.RemoveRule(i->slot);
+			delete i->rule;
 			fRuleList.erase(i);
 			break;
 		}
@@ -329,6 +339,7 @@ status_t
 SnifferRules::BuildRuleList()
 {
 	fRuleList.clear();
+	fRuleSet.MakeEmpty();
 
 	ssize_t maxBytesNeeded = 0;
 	ssize_t bytesNeeded = 0;
@@ -448,6 +459,12 @@ SnifferRules::GuessMimeType(BFile* file, const void *buffer, int32 length,
 	if (!fHaveDoneFullBuild)
 		err = BuildRuleList();
 
+	// find the rules that could possibly match, so that we don't need to
+	// sniff all of them
+	std::vector<bool> candidates;
+	if (!err)
+		fRuleSet.FindCandidates(buffer, length, candidates);
+
 	// first ask the MIME sniffer for a suitable type
 	float addonPriority = -1;
 	BMimeType mimeType;
@@ -471,6 +488,9 @@ SnifferRules::GuessMimeType(BFile* file, const void *buffer, int32 length,
 					return B_OK;
 				}
 
+				if (i->slot >= 0 && !candidates[i->slot])
+					continue;
+
 				if (i->rule->Sniff(&data)) {
 					type->SetTo(i->type.c_str());
 					return B_OK;
@@ -570,7 +590,8 @@ SnifferRules::ProcessType(const char *type, ssize_t *bytesNeeded)
 		// Note the bytes needed
 		*bytesNeeded = rule.rule->BytesNeeded();
 
-		// Add the rule to the list
+		// Add the rule to the rule set and the list
+		rule.slot = fRuleSet.AddRule(rule.rule);
 		rule.type = type;
 		rule.rule_string = str.String();
 		fRuleList.push_back(rule);
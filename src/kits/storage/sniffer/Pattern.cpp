@@ -110,6 +110,31 @@ Pattern::BytesNeeded() const
 	return result;
 }
 
+/*! \brief Returns the first byte of the pattern that is not masked at all,
+	i.e. one that has to be found in the data when searching over \a range.
+
+	Returns false if there is no such byte.
+*/
+bool
+Pattern::GetAnchor(Range range, bool caseInsensitive, Anchor *anchor) const
+{
+	if (InitCheck() != B_OK || range.InitCheck() != B_OK || range.Start() < 0
+		|| !anchor) {
+		return false;
+	}
+
+	for (uint i = 0; i < fString.length(); i++) {
+		if ((uint8)fMask[i] == 0xff) {
+			anchor->start = range.Start() + i;
+			anchor->end = range.End() + i;
+			anchor->value = (uint8)fString[i];
+			anchor->caseInsensitive = caseInsensitive;
+			return true;
+		}
+	}
+	return false;
+}
+
 //#define OPTIMIZATION_IS_FOR_CHUMPS
 #if OPTIMIZATION_IS_FOR_CHUMPS
 bool
@@ -91,6 +91,30 @@ PatternList::BytesNeeded() const
 	return result;	
 }
 
+/*! \brief Collects one anchor per pattern in the list. At least one of them
+	is found in any data the list matches.
+
+	Returns false if a pattern has no anchor; the list can't be ruled out
+	without sniffing it then.
+*/
+bool
+PatternList::GetAnchors(std::vector<Anchor> &anchors) const
+{
+	if (InitCheck() != B_OK)
+		return false;
+
+	std::vector<Pattern*>::const_iterator i;
+	for (i = fList.begin(); i != fList.end(); i++) {
+		if (*i) {
+			Anchor anchor;
+			if (!(*i)->GetAnchor(fRange, fCaseInsensitive, &anchor))
+				return false;
+			anchors.push_back(anchor);
+		}
+	}
+	return true;
+}
+
 void
 PatternList::Add(Pattern *pattern) {
 	if (pattern)
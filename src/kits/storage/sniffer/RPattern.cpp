@@ -71,4 +71,13 @@ RPattern::BytesNeeded() const
 	return result;	
 }
 
+//! Returns the anchor of the object's pattern over the object's range
+bool
+RPattern::GetAnchor(bool caseInsensitive, Anchor *anchor) const
+{
+	if (InitCheck() != B_OK)
+		return false;
+	return fPattern->GetAnchor(fRange, caseInsensitive, anchor);
+}
+
 
@@ -8,6 +8,7 @@
 */
 
 #include <sniffer/Err.h>
+#include <sniffer/Pattern.h>
 #include <sniffer/RPattern.h>
 #include <sniffer/RPatternList.h>
 #include <DataIO.h>
@@ -84,6 +85,27 @@ RPatternList::BytesNeeded() const
 	return result;
 }
 	
+/*! \brief Collects one anchor per rpattern in the list. At least one of them
+	is found in any data the list matches.
+
+	Returns false if an rpattern has no anchor; the list can't be ruled out
+	without sniffing it then.
+*/
+bool
+RPatternList::GetAnchors(std::vector<Anchor> &anchors) const
+{
+	std::vector<RPattern*>::const_iterator i;
+	for (i = fList.begin(); i != fList.end(); i++) {
+		if (*i) {
+			Anchor anchor;
+			if (!(*i)->GetAnchor(fCaseInsensitive, &anchor))
+				return false;
+			anchors.push_back(anchor);
+		}
+	}
+	return true;
+}
+
 void
 RPatternList::Add(RPattern *rpattern) {
 	if (rpattern)
@@ -9,6 +9,7 @@
 
 #include <sniffer/Err.h>
 #include <sniffer/DisjList.h>
+#include <sniffer/Pattern.h>
 #include <sniffer/Rule.h>
 #include <DataIO.h>
 #include <stdio.h>
@@ -84,6 +85,45 @@ Rule::BytesNeeded() const
 }
 
 
+/*! \brief Returns a set of anchors one of which is found in any data the
+	rule matches.
+
+	The anchors are taken from the conjunct that is cheapest to look for, i.e.
+	the one whose anchors cover the fewest possible offsets. Returns false if
+	no conjunct has a complete set of anchors; the rule can't be ruled out
+	without sniffing it then.
+*/
+bool
+Rule::GetAnchors(std::vector<Anchor> &anchors) const
+{
+	if (InitCheck() != B_OK)
+		return false;
+
+	bool found = false;
+	int64 bestCost = 0;
+	std::vector<DisjList*>::const_iterator i;
+	for (i = fConjList->begin(); i != fConjList->end(); i++) {
+		if (!*i)
+			continue;
+
+		std::vector<Anchor> candidate;
+		if (!(*i)->GetAnchors(candidate))
+			continue;
+
+		int64 cost = 0;
+		std::vector<Anchor>::const_iterator anchor;
+		for (anchor = candidate.begin(); anchor != candidate.end(); anchor++)
+			cost += (int64)anchor->end - anchor->start + 1;
+
+		if (!found || cost < bestCost) {
+			anchors.swap(candidate);
+			bestCost = cost;
+			found = true;
+		}
+	}
+	return found;
+}
+
 void
 Rule::Unset() {
  	if (fConjList){
@@ -0,0 +1,263 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	\file RuleSet.cpp
+	MIME sniffer rule set implementation
+*/
+
+
+#include <sniffer/RuleSet.h>
+
+#include <string.h>
+
+#include <algorithm>
+#include <new>
+
+#include <sniffer/Pattern.h>
+#include <sniffer/Rule.h>
+
+
+using namespace BPrivate::Storage::Sniffer;
+
+
+static uint8
+other_case(uint8 value)
+{
+	if ('A' <= value && value <= 'Z')
+		return value - 'A' + 'a';
+	if ('a' <= value && value <= 'z')
+		return value - 'a' + 'A';
+	return value;
+}
+
+
+/*!	\class RuleSet
+	\brief Indexes a set of sniffer rules, so that all of them can be checked
+	against a data buffer in one pass.
+
+	For every rule, the set stores the anchors of one of its conjuncts (see
+	Rule::GetAnchors()): bytes at least one of which must be present in the
+	data for the rule to be able to match. Anchors at a fixed offset -- the
+	common "[0] 'magic'" case -- are kept in a table sorted by offset and
+	byte value, so that they can be looked up for all rules at once. Anchors
+	that may appear anywhere within a range are searched for with memchr().
+
+	FindCandidates() only rules out rules that can't match. The rules that
+	remain must still be sniffed the usual way, but that is usually only a
+	handful of them instead of all installed rules.
+
+	Rules are identified by a slot number that remains valid until the rule is
+	removed again, so that single rules can be added and removed without
+	rebuilding the whole set.
+*/
+
+
+RuleSet::RuleSet()
+{
+}
+
+
+RuleSet::~RuleSet()
+{
+}
+
+
+/*!	\brief Adds the given rule to the set.
+
+	The rule itself is not referenced after this call; it is only needed to
+	compute its anchors.
+
+	\return The slot the rule has been assigned, or an error code.
+*/
+int32
+RuleSet::AddRule(const Rule* rule)
+{
+	if (rule == NULL)
+		return B_BAD_VALUE;
+
+	std::vector<Anchor> anchors;
+	bool anchored = rule->GetAnchors(anchors);
+
+	int32 slot = -1;
+	try {
+		std::vector<bool>::iterator unused = std::find(fSlotsUsed.begin(),
+			fSlotsUsed.end(), false);
+		slot = unused - fSlotsUsed.begin();
+		if (unused == fSlotsUsed.end())
+			fSlotsUsed.push_back(true);
+		else
+			*unused = true;
+
+		if (!anchored) {
+			fUnanchoredSlots.push_back(slot);
+			return slot;
+		}
+
+		for (std::vector<Anchor>::const_iterator i = anchors.begin();
+				i != anchors.end(); i++) {
+			uint8 otherValue = i->caseInsensitive
+				? other_case(i->value) : i->value;
+
+			if (i->start == i->end) {
+				_AddFixedAnchor(i->start, i->value, slot);
+				if (otherValue != i->value)
+					_AddFixedAnchor(i->start, otherValue, slot);
+			} else {
+				ranged_anchor anchor;
+				anchor.start = i->start;
+				anchor.end = i->end;
+				anchor.value = i->value;
+				anchor.otherValue = otherValue;
+				anchor.slot = slot;
+				fRangedAnchors.push_back(anchor);
+			}
+		}
+
+		_RebuildOffsetIndex();
+	} catch (std::bad_alloc&) {
+		if (slot >= 0)
+			RemoveRule(slot);
+		return B_NO_MEMORY;
+	}
+
+	return slot;
+}
+
+
+//! Removes the rule in the given slot from the set.
+void
+RuleSet::RemoveRule(int32 slot)
+{
+	if (slot < 0 || slot >= CountSlots() || !fSlotsUsed[slot])
+		return;
+
+	fSlotsUsed[slot] = false;
+
+	fUnanchoredSlots.erase(std::remove(fUnanchoredSlots.begin(),
+		fUnanchoredSlots.end(), slot), fUnanchoredSlots.end());
+
+	size_t count = 0;
+	for (size_t i = 0; i < fFixedAnchors.size(); i++) {
+		if (fFixedAnchors[i].slot != slot)
+			fFixedAnchors[count++] = fFixedAnchors[i];
+	}
+	fFixedAnchors.resize(count);
+
+	count = 0;
+	for (size_t i = 0; i < fRangedAnchors.size(); i++) {
+		if (fRangedAnchors[i].slot != slot)
+			fRangedAnchors[count++] = fRangedAnchors[i];
+	}
+	fRangedAnchors.resize(count);
+
+	_RebuildOffsetIndex();
+}
+
+
+void
+RuleSet::MakeEmpty()
+{
+	fSlotsUsed.clear();
+	fUnanchoredSlots.clear();
+	fFixedAnchors.clear();
+	fOffsetIndex.clear();
+	fRangedAnchors.clear();
+}
+
+
+/*!	\brief Determines the rules that might match the given data.
+
+	\a candidates is resized to CountSlots() and an element is set to \c true
+	for each slot whose rule might match. Rules whose slot is \c false are
+	guaranteed not to match \a buffer.
+*/
+void
+RuleSet::FindCandidates(const void* _buffer, size_t length,
+	std::vector<bool>& candidates) const
+{
+	const uint8* buffer = (const uint8*)_buffer;
+	candidates.assign(fSlotsUsed.size(), false);
+
+	for (std::vector<int32>::const_iterator i = fUnanchoredSlots.begin();
+			i != fUnanchoredSlots.end(); i++) {
+		candidates[*i] = true;
+	}
+
+	// look up the byte at each offset any of the rules is interested in
+	for (std::vector<offset_group>::const_iterator group
+				= fOffsetIndex.begin();
+			group != fOffsetIndex.end(); group++) {
+		if ((size_t)group->offset >= length)
+			break;
+
+		fixed_anchor key;
+		key.offset = group->offset;
+		key.value = buffer[group->offset];
+
+		std::vector<fixed_anchor>::const_iterator first
+			= fFixedAnchors.begin() + group->first;
+		std::vector<fixed_anchor>::const_iterator last
+			= first + group->count;
+		std::pair<std::vector<fixed_anchor>::const_iterator,
+			std::vector<fixed_anchor>::const_iterator> range
+				= std::equal_range(first, last, key);
+		for (; range.first != range.second; range.first++)
+			candidates[range.first->slot] = true;
+	}
+
+	// search the ranges of the remaining anchors
+	for (std::vector<ranged_anchor>::const_iterator anchor
+				= fRangedAnchors.begin();
+			anchor != fRangedAnchors.end(); anchor++) {
+		if (candidates[anchor->slot] || anchor->start < 0
+			|| (size_t)anchor->start >= length) {
+			continue;
+		}
+
+		size_t end = std::min((size_t)anchor->end + 1, length);
+		size_t size = end - anchor->start;
+		if (memchr(buffer + anchor->start, anchor->value, size) != NULL
+			|| (anchor->otherValue != anchor->value
+				&& memchr(buffer + anchor->start, anchor->otherValue, size)
+					!= NULL)) {
+			candidates[anchor->slot] = true;
+		}
+	}
+}
+
+
+void
+RuleSet::_AddFixedAnchor(int32 offset, uint8 value, int32 slot)
+{
+	fixed_anchor anchor;
+	anchor.offset = offset;
+	anchor.value = value;
+	anchor.slot = slot;
+
+	// keep the table sorted, so that FindCandidates() can use binary search
+	fFixedAnchors.insert(std::upper_bound(fFixedAnchors.begin(),
+		fFixedAnchors.end(), anchor), anchor);
+}
+
+
+//! Recomputes the ranges of fFixedAnchors that share the same offset.
+void
+RuleSet::_RebuildOffsetIndex()
+{
+	fOffsetIndex.clear();
+
+	for (size_t i = 0; i < fFixedAnchors.size(); i++) {
+		if (fOffsetIndex.empty()
+			|| fOffsetIndex.back().offset != fFixedAnchors[i].offset) {
+			offset_group group;
+			group.offset = fFixedAnchors[i].offset;
+			group.first = i;
+			group.count = 0;
+			fOffsetIndex.push_back(group);
+		}
+		fOffsetIndex.back().count++;
+	}
+}
@@ -0,0 +1,84 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef _COMPRESSION_CONTEXT_POOL_H_
+#define _COMPRESSION_CONTEXT_POOL_H_
+
+
+#include <pthread.h>
+
+#include <SupportDefs.h>
+
+
+namespace BPrivate {
+
+
+/*!	Keeps a few (de)compression contexts around for reuse.
+
+	Setting up a context allocates its tables and windows, which for small
+	buffers costs more than the actual (de)compression. Get() returns a pooled
+	context, or \c NULL, if there is none, in which case the caller creates
+	one. Put() returns the context to the pool; if the pool is full, the
+	context is deleted. The pool can be used from several threads at once.
+*/
+template<typename Context, void (*DeleteContext)(Context*)>
+class CompressionContextPool {
+public:
+	static	const int32			kMaxContexts = 8;
+
+public:
+	CompressionContextPool()
+		:
+		fCount(0)
+	{
+		pthread_mutex_init(&fLock, NULL);
+	}
+
+	~CompressionContextPool()
+	{
+		while (fCount > 0)
+			DeleteContext(fContexts[--fCount]);
+
+		pthread_mutex_destroy(&fLock);
+	}
+
+	Context* Get()
+	{
+		Context* context = NULL;
+
+		pthread_mutex_lock(&fLock);
+		if (fCount > 0)
+			context = fContexts[--fCount];
+		pthread_mutex_unlock(&fLock);
+
+		return context;
+	}
+
+	void Put(Context* context)
+	{
+		if (context == NULL)
+			return;
+
+		pthread_mutex_lock(&fLock);
+		if (fCount < kMaxContexts) {
+			fContexts[fCount++] = context;
+			context = NULL;
+		}
+		pthread_mutex_unlock(&fLock);
+
+		if (context != NULL)
+			DeleteContext(context);
+	}
+
+private:
+			pthread_mutex_t		fLock;
+			Context*			fContexts[kMaxContexts];
+			int32				fCount;
+};
+
+
+} // namespace BPrivate
+
+
+#endif	// _COMPRESSION_CONTEXT_POOL_H_
@@ -197,6 +197,25 @@ JobQueue::CountJobs() const
 }
 
 
+/*!	Returns the number of queued jobs that have no pending dependencies, and
+	could thus be run right away.
+*/
+size_t
+JobQueue::CountRunnableJobs() const
+{
+	BAutolock locker(fLock);
+
+	// runnable jobs are sorted first
+	size_t count = 0;
+	for (JobPriorityQueue::const_iterator iterator = fQueuedJobs->begin();
+			iterator != fQueuedJobs->end() && (*iterator)->IsRunnable();
+			iterator++) {
+		count++;
+	}
+	return count;
+}
+
+
 void
 JobQueue::Close()
 {
@@ -7,6 +7,7 @@
 #include <ZlibCompressionAlgorithm.h>
 
 #include <errno.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include <algorithm>
@@ -22,6 +23,14 @@
 #	define B_ZLIB_COMPRESSION_SUPPORT 1
 #endif
 
+#ifdef B_ZLIB_COMPRESSION_SUPPORT
+#	include <pthread.h>
+
+#	include <OS.h>
+
+#	include "CompressionContextPool.h"
+#endif
+
 
 static const size_t kMinBufferSize		= 1024;
 static const size_t kMaxBufferSize		= 1024 * 1024;
@@ -46,6 +55,7 @@ BZlibCompressionParameters::BZlibCompressionParameters(
 	BCompressionParameters(),
 	fCompressionLevel(compressionLevel),
 	fBufferSize(kDefaultBufferSize),
+	fWorkerCount(0),
 	fGzipFormat(false)
 {
 }
@@ -98,6 +108,20 @@ BZlibCompressionParameters::SetGzipFormat(bool gzipFormat)
 }
 
 
+int32
+BZlibCompressionParameters::WorkerCount() const
+{
+	return fWorkerCount;
+}
+
+
+void
+BZlibCompressionParameters::SetWorkerCount(int32 count)
+{
+	fWorkerCount = std::max(count, (int32)0);
+}
+
+
 // #pragma mark - BZlibDecompressionParameters
 
 
@@ -306,6 +330,418 @@ private:
 };
 
 
+// #pragma mark - buffer compression
+
+
+#ifdef B_ZLIB_COMPRESSION_SUPPORT
+
+
+static const size_t kBlockSize				= 128 * 1024;
+static const size_t kDictionarySize			= 32 * 1024;
+static const int32 kMaxBlockCompressionThreads	= 32;
+static const size_t kMaxStreamChunkSize			= (uInt)-1;
+	// z_stream's avail_in and avail_out are only 32 bit wide
+
+
+struct DeflateContext {
+	z_stream	stream;
+	int			compressionLevel;
+};
+
+
+static void
+delete_deflate_context(DeflateContext* context)
+{
+	deflateEnd(&context->stream);
+	delete context;
+}
+
+
+static void
+delete_inflate_context(z_stream* stream)
+{
+	inflateEnd(stream);
+	delete stream;
+}
+
+
+static BPrivate::CompressionContextPool<DeflateContext,
+	&delete_deflate_context> sDeflateContexts;
+static BPrivate::CompressionContextPool<z_stream, &delete_inflate_context>
+	sInflateContexts;
+
+
+/*!	Returns a context for a raw deflate stream. The callers write the zlib or
+	gzip header and trailer themselves, so that they can compress the data in
+	independent blocks.
+*/
+static DeflateContext*
+get_deflate_context(int compressionLevel)
+{
+	DeflateContext* context = sDeflateContexts.Get();
+	if (context != NULL) {
+		if (deflateReset(&context->stream) == Z_OK
+			&& (context->compressionLevel == compressionLevel
+				|| deflateParams(&context->stream, compressionLevel,
+					Z_DEFAULT_STRATEGY) == Z_OK)) {
+			context->compressionLevel = compressionLevel;
+			return context;
+		}
+
+		delete_deflate_context(context);
+	}
+
+	context = new(std::nothrow) DeflateContext;
+	if (context == NULL)
+		return NULL;
+
+	memset(&context->stream, 0, sizeof(context->stream));
+	context->compressionLevel = compressionLevel;
+
+	// 8 is zlib's default memory level, as compress2() uses it
+	if (deflateInit2(&context->stream, compressionLevel, Z_DEFLATED,
+			-MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+		delete context;
+		return NULL;
+	}
+
+	return context;
+}
+
+
+/*!	Compresses \a size bytes at \a offset of \a data to raw deflate data.
+	Unless \a last, the block is ended with a sync flush, so it can be followed
+	by the next one. The preceding data are used as the dictionary, so the
+	compression ratio is almost the same as when compressing all data at once.
+*/
+static status_t
+deflate_block(const uint8* data, size_t offset, size_t size, bool last,
+	int compressionLevel, uint8* output, size_t outputSize,
+	size_t& _compressedSize)
+{
+	DeflateContext* context = get_deflate_context(compressionLevel);
+	if (context == NULL)
+		return B_NO_MEMORY;
+
+	z_stream& stream = context->stream;
+
+	int zlibError = Z_OK;
+	if (offset > 0) {
+		size_t dictionarySize = std::min(offset, kDictionarySize);
+		zlibError = deflateSetDictionary(&stream,
+			(const Bytef*)data + offset - dictionarySize, dictionarySize);
+	}
+
+	status_t error = B_OK;
+	size_t inputLeft = size;
+	size_t outputLeft = outputSize;
+	stream.next_in = (Bytef*)data + offset;
+	stream.avail_in = 0;
+	stream.next_out = (Bytef*)output;
+	stream.avail_out = 0;
+
+	if (zlibError == Z_OK) {
+		// Like compress2(), feed buffers of 4 GB or more in pieces. The
+		// block is only flushed once all of it has been passed in.
+		while (true) {
+			if (stream.avail_in == 0) {
+				stream.avail_in = std::min(inputLeft, kMaxStreamChunkSize);
+				inputLeft -= stream.avail_in;
+			}
+			if (stream.avail_out == 0) {
+				stream.avail_out = std::min(outputLeft, kMaxStreamChunkSize);
+				outputLeft -= stream.avail_out;
+			}
+
+			int flush = Z_NO_FLUSH;
+			if (inputLeft == 0)
+				flush = last ? Z_FINISH : Z_SYNC_FLUSH;
+
+			zlibError = deflate(&stream, flush);
+			if (zlibError != Z_OK
+				|| (stream.avail_out == 0 && outputLeft == 0)
+				|| (flush == Z_SYNC_FLUSH && stream.avail_in == 0
+					&& stream.avail_out != 0)) {
+				break;
+			}
+		}
+
+		if (last ? zlibError != Z_STREAM_END
+				: zlibError != Z_OK || stream.avail_out == 0) {
+			error = zlibError == Z_OK || zlibError == Z_BUF_ERROR
+				? B_BUFFER_OVERFLOW : B_ERROR;
+		}
+	} else
+		error = B_ERROR;
+
+	_compressedSize = outputSize - outputLeft - stream.avail_out;
+
+	sDeflateContexts.Put(context);
+	return error;
+}
+
+
+/*!	Computes the checksum of the gzip or zlib format, in pieces, since zlib's
+	functions take a 32 bit size only.
+*/
+static uLong
+compute_checksum(const uint8* data, size_t size, bool gzipFormat)
+{
+	uLong checksum = gzipFormat ? crc32(0, NULL, 0) : adler32(0, NULL, 0);
+	while (size > 0) {
+		uInt chunkSize = std::min(size, kMaxStreamChunkSize);
+		checksum = gzipFormat
+			? crc32(checksum, data, chunkSize)
+			: adler32(checksum, data, chunkSize);
+		data += chunkSize;
+		size -= chunkSize;
+	}
+
+	return checksum;
+}
+
+
+/*!	Compresses the blocks of a buffer on several threads. Each block is
+	compressed into a buffer of its own along with its checksum. The blocks
+	are concatenated afterwards.
+*/
+struct BlockCompressor {
+	struct Block {
+		uint8*		data;
+		size_t		size;
+		uLong		checksum;
+		status_t	error;
+	};
+
+	BlockCompressor(const uint8* input, size_t inputSize,
+		int compressionLevel, bool gzipFormat)
+		:
+		fInput(input),
+		fInputSize(inputSize),
+		fCompressionLevel(compressionLevel),
+		fGzipFormat(gzipFormat),
+		fBlocks(NULL),
+		fBlockCount((inputSize + kBlockSize - 1) / kBlockSize),
+		fNextBlock(0)
+	{
+	}
+
+	~BlockCompressor()
+	{
+		if (fBlocks != NULL) {
+			for (int32 i = 0; i < fBlockCount; i++)
+				free(fBlocks[i].data);
+			delete[] fBlocks;
+		}
+	}
+
+	status_t Run(int32 threadCount)
+	{
+		fBlocks = new(std::nothrow) Block[fBlockCount];
+		if (fBlocks == NULL)
+			return B_NO_MEMORY;
+
+		for (int32 i = 0; i < fBlockCount; i++) {
+			fBlocks[i].data = NULL;
+			fBlocks[i].error = B_OK;
+		}
+
+		// the calling thread compresses, too
+		threadCount = std::min(threadCount,
+			std::min(fBlockCount, kMaxBlockCompressionThreads));
+		pthread_t threads[kMaxBlockCompressionThreads];
+		int32 spawnedCount = 0;
+		for (; spawnedCount < threadCount - 1; spawnedCount++) {
+			if (pthread_create(&threads[spawnedCount], NULL, &_ThreadEntry,
+					this) != 0) {
+				break;
+			}
+		}
+
+		_Work();
+
+		for (int32 i = 0; i < spawnedCount; i++)
+			pthread_join(threads[i], NULL);
+
+		for (int32 i = 0; i < fBlockCount; i++) {
+			if (fBlocks[i].error != B_OK)
+				return fBlocks[i].error;
+		}
+
+		return B_OK;
+	}
+
+	status_t Assemble(uint8* output, size_t outputSize,
+		size_t& _compressedSize, uLong& _checksum)
+	{
+		size_t compressedSize = 0;
+		uLong checksum = fGzipFormat ? crc32(0, NULL, 0) : adler32(0, NULL, 0);
+
+		for (int32 i = 0; i < fBlockCount; i++) {
+			const Block& block = fBlocks[i];
+			if (block.size > outputSize - compressedSize)
+				return B_BUFFER_OVERFLOW;
+
+			memcpy(output + compressedSize, block.data, block.size);
+			compressedSize += block.size;
+
+			z_off_t blockSize = _BlockSize(i);
+			checksum = fGzipFormat
+				? crc32_combine(checksum, block.checksum, blockSize)
+				: adler32_combine(checksum, block.checksum, blockSize);
+		}
+
+		_compressedSize = compressedSize;
+		_checksum = checksum;
+		return B_OK;
+	}
+
+private:
+	static void* _ThreadEntry(void* data)
+	{
+		((BlockCompressor*)data)->_Work();
+		return NULL;
+	}
+
+	void _Work()
+	{
+		int32 index;
+		while ((index = atomic_add(&fNextBlock, 1)) < fBlockCount) {
+			Block& block = fBlocks[index];
+			size_t offset = index * kBlockSize;
+			size_t size = _BlockSize(index);
+			const Bytef* data = (const Bytef*)fInput + offset;
+
+			block.checksum = compute_checksum(data, size, fGzipFormat);
+
+			// a sync flush adds an empty stored block of at most 6 bytes
+			size_t capacity = compressBound(size) + 16;
+			block.data = (uint8*)malloc(capacity);
+			if (block.data == NULL) {
+				block.error = B_NO_MEMORY;
+				continue;
+			}
+
+			block.error = deflate_block(fInput, offset, size,
+				index == fBlockCount - 1, fCompressionLevel, block.data,
+				capacity, block.size);
+		}
+	}
+
+	size_t _BlockSize(int32 index) const
+	{
+		return std::min(kBlockSize, fInputSize - index * kBlockSize);
+	}
+
+private:
+	const uint8*	fInput;
+	size_t			fInputSize;
+	int				fCompressionLevel;
+	bool			fGzipFormat;
+	Block*			fBlocks;
+	int32			fBlockCount;
+	int32			fNextBlock;
+};
+
+
+static void
+write_uint32(uint8* buffer, uint32 value, bool bigEndian)
+{
+	for (int i = 0; i < 4; i++) {
+		buffer[bigEndian ? 3 - i : i] = (uint8)value;
+		value >>= 8;
+	}
+}
+
+
+/*!	Writes the header deflate() would write for the given format and level.
+	Returns the header's size.
+*/
+static size_t
+write_header(uint8* buffer, int compressionLevel, bool gzipFormat)
+{
+	if (compressionLevel < 0)
+		compressionLevel = 6;
+
+	if (gzipFormat) {
+		static const uint8 kGzipHeader[10] = {
+			0x1f, 0x8b, Z_DEFLATED, 0, 0, 0, 0, 0, 0, 3 /* Unix */
+		};
+		memcpy(buffer, kGzipHeader, sizeof(kGzipHeader));
+		if (compressionLevel == 9)
+			buffer[8] = 2;
+		else if (compressionLevel < 2)
+			buffer[8] = 4;
+		return sizeof(kGzipHeader);
+	}
+
+	uint32 levelFlags = 3;
+	if (compressionLevel < 2)
+		levelFlags = 0;
+	else if (compressionLevel < 6)
+		levelFlags = 1;
+	else if (compressionLevel == 6)
+		levelFlags = 2;
+
+	uint32 header = ((Z_DEFLATED + ((MAX_WBITS - 8) << 4)) << 8)
+		| (levelFlags << 6);
+	header += 31 - header % 31;
+	buffer[0] = (uint8)(header >> 8);
+	buffer[1] = (uint8)header;
+	return 2;
+}
+
+
+static status_t
+compress_buffer(const uint8* input, size_t inputSize, uint8* output,
+	size_t outputSize, int compressionLevel, bool gzipFormat,
+	int32 workerCount, size_t& _compressedSize)
+{
+	const size_t kMaxHeaderSize = 10;
+	const size_t trailerSize = gzipFormat ? 8 : 4;
+	if (outputSize < kMaxHeaderSize + trailerSize)
+		return B_BUFFER_OVERFLOW;
+
+	size_t headerSize = write_header(output, compressionLevel, gzipFormat);
+	uint8* data = output + headerSize;
+	size_t dataCapacity = outputSize - headerSize - trailerSize;
+	size_t dataSize;
+	uLong checksum;
+
+	if (workerCount > 1 && inputSize > kBlockSize) {
+		BlockCompressor compressor(input, inputSize, compressionLevel,
+			gzipFormat);
+		status_t error = compressor.Run(workerCount);
+		if (error == B_OK) {
+			error = compressor.Assemble(data, dataCapacity, dataSize,
+				checksum);
+		}
+		if (error != B_OK)
+			return error;
+	} else {
+		status_t error = deflate_block(input, 0, inputSize, true,
+			compressionLevel, data, dataCapacity, dataSize);
+		if (error != B_OK)
+			return error;
+
+		checksum = compute_checksum(input, inputSize, gzipFormat);
+	}
+
+	uint8* trailer = data + dataSize;
+	if (gzipFormat) {
+		write_uint32(trailer, checksum, false);
+		write_uint32(trailer + 4, (uint32)inputSize, false);
+	} else
+		write_uint32(trailer, checksum, true);
+
+	_compressedSize = headerSize + dataSize + trailerSize;
+	return B_OK;
+}
+
+
+#endif	// B_ZLIB_COMPRESSION_SUPPORT
+
+
 // #pragma mark - BZlibCompressionAlgorithm
 
 
@@ -373,18 +809,18 @@ BZlibCompressionAlgorithm::CompressBuffer(const void* input,
 #ifdef B_ZLIB_COMPRESSION_SUPPORT
 	const BZlibCompressionParameters* zlibParameters
 		= dynamic_cast<const BZlibCompressionParameters*>(parameters);
-	int compressionLevel = zlibParameters != NULL
-		? zlibParameters->CompressionLevel()
-		: B_ZLIB_COMPRESSION_DEFAULT;
-
-	uLongf bytesUsed = outputSize;
-	int zlibError = compress2((Bytef*)output, &bytesUsed, (const Bytef*)input,
-		(uLong)inputSize, compressionLevel);
-	if (zlibError != Z_OK)
-		return _TranslateZlibError(zlibError);
+	int compressionLevel = B_ZLIB_COMPRESSION_DEFAULT;
+	bool gzipFormat = false;
+	int32 workerCount = 0;
+	if (zlibParameters != NULL) {
+		compressionLevel = zlibParameters->CompressionLevel();
+		gzipFormat = zlibParameters->IsGzipFormat();
+		workerCount = zlibParameters->WorkerCount();
+	}
 
-	_compressedSize = (size_t)bytesUsed;
-	return B_OK;
+	return compress_buffer((const uint8*)input, inputSize, (uint8*)output,
+		outputSize, compressionLevel, gzipFormat, workerCount,
+		_compressedSize);
 #else
 	return B_NOT_SUPPORTED;
 #endif
@@ -396,6 +832,73 @@ BZlibCompressionAlgorithm::DecompressBuffer(const void* input,
 	size_t inputSize, void* output, size_t outputSize,
 	size_t& _uncompressedSize, const BDecompressionParameters* parameters)
 {
+#ifdef B_ZLIB_COMPRESSION_SUPPORT
+	z_stream* stream = sInflateContexts.Get();
+	if (stream != NULL) {
+		if (inflateReset(stream) != Z_OK) {
+			delete_inflate_context(stream);
+			stream = NULL;
+		}
+	}
+
+	if (stream == NULL) {
+		stream = new(std::nothrow) z_stream;
+		if (stream == NULL)
+			return B_NO_MEMORY;
+
+		memset(stream, 0, sizeof(*stream));
+
+		// auto-detect zlib/gzip header
+		int zlibError = inflateInit2(stream, 32 + MAX_WBITS);
+		if (zlibError != Z_OK) {
+			delete stream;
+			return _TranslateZlibError(zlibError);
+		}
+	}
+
+	// inflate() refuses a NULL output buffer, even if it is empty
+	uint8 dummy;
+	size_t inputLeft = inputSize;
+	size_t outputLeft = outputSize;
+	stream->next_in = (Bytef*)input;
+	stream->avail_in = 0;
+	stream->next_out = outputSize > 0 ? (Bytef*)output : &dummy;
+	stream->avail_out = 0;
+
+	// like uncompress(), feed buffers of 4 GB or more in pieces
+	int zlibError;
+	do {
+		if (stream->avail_in == 0) {
+			stream->avail_in = std::min(inputLeft, kMaxStreamChunkSize);
+			inputLeft -= stream->avail_in;
+		}
+		if (stream->avail_out == 0) {
+			stream->avail_out = std::min(outputLeft, kMaxStreamChunkSize);
+			outputLeft -= stream->avail_out;
+		}
+
+		zlibError = inflate(stream, Z_NO_FLUSH);
+	} while (zlibError == Z_OK
+		&& (stream->avail_in != 0 || inputLeft != 0)
+		&& (stream->avail_out != 0 || outputLeft != 0));
+
+	size_t bytesUsed = outputSize - outputLeft - stream->avail_out;
+	bool outputFull = stream->avail_out == 0 && outputLeft == 0;
+
+	sInflateContexts.Put(stream);
+
+	if (zlibError != Z_STREAM_END) {
+		// like uncompress(), report a truncated input as bad data
+		if (zlibError == Z_OK || zlibError == Z_BUF_ERROR)
+			return outputFull ? B_BUFFER_OVERFLOW : B_BAD_DATA;
+		if (zlibError == Z_NEED_DICT)
+			return B_BAD_DATA;
+		return _TranslateZlibError(zlibError);
+	}
+
+	_uncompressedSize = bytesUsed;
+	return B_OK;
+#else
 	uLongf bytesUsed = outputSize;
 	int zlibError = uncompress((Bytef*)output, &bytesUsed, (const Bytef*)input,
 		(uLong)inputSize);
@@ -404,6 +907,7 @@ BZlibCompressionAlgorithm::DecompressBuffer(const void* input,
 
 	_uncompressedSize = (size_t)bytesUsed;
 	return B_OK;
+#endif
 }
 
 
@@ -26,6 +26,15 @@
 #	define B_ZSTD_COMPRESSION_SUPPORT 1
 #endif
 
+// compressing with worker threads requires the advanced API of zstd 1.4
+#if defined(B_ZSTD_COMPRESSION_SUPPORT) && ZSTD_VERSION_NUMBER >= 10400
+#	define B_ZSTD_WORKER_SUPPORT 1
+#endif
+
+#ifdef B_ZSTD_COMPRESSION_SUPPORT
+#	include "CompressionContextPool.h"
+#endif
+
 
 static const size_t kMinBufferSize		= 1024;
 static const size_t kMaxBufferSize		= 1024 * 1024;
@@ -41,6 +50,57 @@ sanitize_buffer_size(size_t size)
 }
 
 
+#ifdef B_ZSTD_COMPRESSION_SUPPORT
+
+
+static void
+delete_compression_context(ZSTD_CCtx* context)
+{
+	ZSTD_freeCCtx(context);
+}
+
+
+static void
+delete_decompression_context(ZSTD_DCtx* context)
+{
+	ZSTD_freeDCtx(context);
+}
+
+
+// The contexts used by CompressBuffer() and DecompressBuffer(). The streams
+// have their own.
+static BPrivate::CompressionContextPool<ZSTD_CCtx, &delete_compression_context>
+	sCompressionContexts;
+static BPrivate::CompressionContextPool<ZSTD_DCtx,
+	&delete_decompression_context> sDecompressionContexts;
+
+
+#endif	// B_ZSTD_COMPRESSION_SUPPORT
+
+
+#ifdef B_ZSTD_WORKER_SUPPORT
+
+
+static size_t
+set_compression_parameters(ZSTD_CCtx* context, int32 compressionLevel,
+	int32 workerCount)
+{
+	size_t zstdError = ZSTD_CCtx_setParameter(context,
+		ZSTD_c_compressionLevel, compressionLevel);
+	if (ZSTD_isError(zstdError))
+		return zstdError;
+
+	// This fails, if libzstd has been built without thread support. The data
+	// are compressed on the calling thread then.
+	ZSTD_CCtx_setParameter(context, ZSTD_c_nbWorkers,
+		std::max(workerCount, (int32)0));
+	return 0;
+}
+
+
+#endif	// B_ZSTD_WORKER_SUPPORT
+
+
 // #pragma mark - BZstdCompressionParameters
 
 
@@ -49,7 +109,8 @@ BZstdCompressionParameters::BZstdCompressionParameters(
 	:
 	BCompressionParameters(),
 	fCompressionLevel(compressionLevel),
-	fBufferSize(kDefaultBufferSize)
+	fBufferSize(kDefaultBufferSize),
+	fWorkerCount(0)
 {
 }
 
@@ -87,6 +148,20 @@ BZstdCompressionParameters::SetBufferSize(size_t size)
 }
 
 
+int32
+BZstdCompressionParameters::WorkerCount() const
+{
+	return fWorkerCount;
+}
+
+
+void
+BZstdCompressionParameters::SetWorkerCount(int32 count)
+{
+	fWorkerCount = std::max(count, (int32)0);
+}
+
+
 // #pragma mark - BZstdDecompressionParameters
 
 
@@ -132,12 +207,22 @@ struct BZstdCompressionAlgorithm::CompressionStrategy {
 		const BZstdCompressionParameters* parameters)
 	{
 		int32 compressionLevel = B_ZSTD_COMPRESSION_DEFAULT;
+		int32 workerCount = 0;
 		if (parameters != NULL) {
 			compressionLevel = parameters->CompressionLevel();
+			workerCount = parameters->WorkerCount();
 		}
 
 		*stream = ZSTD_createCStream();
+		if (*stream == NULL)
+			return (size_t)-ZSTD_error_memory_allocation;
+
+#ifdef B_ZSTD_WORKER_SUPPORT
+		return set_compression_parameters(*stream, compressionLevel,
+			workerCount);
+#else
 		return ZSTD_initCStream(*stream, compressionLevel);
+#endif
 	}
 
 	static void Uninit(ZSTD_CStream *stream)
@@ -148,10 +233,26 @@ struct BZstdCompressionAlgorithm::CompressionStrategy {
 	static size_t Process(ZSTD_CStream *stream, ZSTD_inBuffer *input,
 		ZSTD_outBuffer *output, bool flush)
 	{
+#ifdef B_ZSTD_WORKER_SUPPORT
+		if (flush)
+			return ZSTD_compressStream2(stream, output, input, ZSTD_e_flush);
+
+		size_t result = ZSTD_compressStream2(stream, output, input,
+			ZSTD_e_continue);
+		if (!ZSTD_isError(result) && input->pos == 0 && output->pos == 0) {
+			// All workers are busy and their input buffers are full. Flushing
+			// waits for them, so we always make progress, as the streams
+			// require.
+			result = ZSTD_compressStream2(stream, output, input,
+				ZSTD_e_flush);
+		}
+		return result;
+#else
 		if (flush)
 			return ZSTD_flushStream(stream, output);
 		else
 			return ZSTD_compressStream(stream, output, input);
+#endif
 	}
 };
 
@@ -378,8 +479,27 @@ BZstdCompressionAlgorithm::CompressBuffer(const void* input,
 		? zstdParameters->CompressionLevel()
 		: B_ZSTD_COMPRESSION_DEFAULT;
 
-	size_t zstdError = ZSTD_compress(output, outputSize, input,
+	ZSTD_CCtx* context = sCompressionContexts.Get();
+	if (context == NULL) {
+		context = ZSTD_createCCtx();
+		if (context == NULL)
+			return B_NO_MEMORY;
+	}
+
+#ifdef B_ZSTD_WORKER_SUPPORT
+	size_t zstdError = set_compression_parameters(context, compressionLevel,
+		zstdParameters != NULL ? zstdParameters->WorkerCount() : 0);
+	if (!ZSTD_isError(zstdError)) {
+		zstdError = ZSTD_compress2(context, output, outputSize, input,
+			inputSize);
+	}
+#else
+	size_t zstdError = ZSTD_compressCCtx(context, output, outputSize, input,
 		inputSize, compressionLevel);
+#endif
+
+	sCompressionContexts.Put(context);
+
 	if (ZSTD_isError(zstdError))
 		return _TranslateZstdError(zstdError);
 
@@ -397,8 +517,22 @@ BZstdCompressionAlgorithm::DecompressBuffer(const void* input,
 	size_t& _uncompressedSize, const BDecompressionParameters* parameters)
 {
 #ifdef ZSTD_ENABLED
+#ifdef B_ZSTD_COMPRESSION_SUPPORT
+	ZSTD_DCtx* context = sDecompressionContexts.Get();
+	if (context == NULL) {
+		context = ZSTD_createDCtx();
+		if (context == NULL)
+			return B_NO_MEMORY;
+	}
+
+	size_t zstdError = ZSTD_decompressDCtx(context, output, outputSize, input,
+		inputSize);
+
+	sDecompressionContexts.Put(context);
+#else
 	size_t zstdError = ZSTD_decompress(output, outputSize, input,
 		inputSize);
+#endif
 	if (ZSTD_isError(zstdError))
 		return _TranslateZstdError(zstdError);
 
@@ -426,6 +560,8 @@ BZstdCompressionAlgorithm::_TranslateZstdError(size_t error)
 			return B_BAD_VALUE;
 		case ZSTD_error_dstSize_tooSmall:
 			return B_BUFFER_OVERFLOW;
+		case ZSTD_error_memory_allocation:
+			return B_NO_MEMORY;
 		default:
 			return B_ERROR;
 	}
@@ -0,0 +1,225 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include "IdentifySource.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+
+namespace BPrivate {
+
+
+static const size_t kBufferSize = 16 * 1024;
+	// enough for the headers of all formats we know
+
+
+struct format_signature {
+	const char*	mimeType;
+	size_t		offset;
+	const char*	bytes;
+	size_t		length;
+};
+
+// Only formats whose translators reject anything not starting with the
+// signature may be listed here.
+static const format_signature kSignatures[] = {
+	{ "image/x-be-bitmap", 0, "bits", 4 },
+	{ "image/jpeg", 0, "\xff\xd8\xff", 3 },
+	{ "image/png", 0, "\x89PNG", 4 },
+	{ "image/x-png", 0, "\x89PNG", 4 },
+	{ "image/gif", 0, "GIF8", 4 },
+	{ "image/bmp", 0, "BM", 2 },
+	{ "image/x-bmp", 0, "BM", 2 },
+	{ "image/tiff", 0, "II*\0", 4 },
+	{ "image/tiff", 0, "MM\0*", 4 },
+	{ "image/tiff", 0, "II+\0", 4 },
+	{ "image/tiff", 0, "MM\0+", 4 },
+	{ "image/webp", 8, "WEBP", 4 },
+	{ "image/vnd.adobe.photoshop", 0, "8BPS", 4 },
+	{ "image/exr", 0, "\x76\x2f\x31\x01", 4 },
+	{ "image/icns", 0, "icns", 4 },
+};
+static const int32 kSignatureCount
+	= sizeof(kSignatures) / sizeof(kSignatures[0]);
+
+
+IdentifySource::IdentifySource(BPositionIO* source)
+	:
+	fSource(source),
+	fBuffer(NULL),
+	fBufferSize(0),
+	fComplete(false),
+	fPosition(0),
+	fStatus(B_OK)
+{
+	off_t position = source->Seek(0, SEEK_SET);
+	if (position != 0) {
+		fStatus = position < 0 ? (status_t)position : B_IO_ERROR;
+		return;
+	}
+
+	fBuffer = (uint8*)malloc(kBufferSize);
+	if (fBuffer == NULL)
+		return;
+
+	// If the source can't be read this way, all reads go to it directly,
+	// and no translator is skipped.
+	ssize_t bytesRead = source->ReadAt(0, fBuffer, kBufferSize);
+	if (bytesRead >= 0) {
+		fBufferSize = bytesRead;
+		fComplete = fBufferSize < kBufferSize;
+	}
+}
+
+
+IdentifySource::~IdentifySource()
+{
+	free(fBuffer);
+}
+
+
+status_t
+IdentifySource::InitCheck() const
+{
+	return fStatus;
+}
+
+
+/*!	Returns whether any of the given formats could be the source's.
+*/
+bool
+IdentifySource::MayBeAnyOf(const translation_format* formats,
+	int32 formatsCount) const
+{
+	if (formats == NULL || formatsCount <= 0
+		|| (fBufferSize == 0 && !fComplete))
+		return true;
+
+	for (int32 i = 0; i < formatsCount && formats[i].type; i++) {
+		if (_MayBe(formats[i].MIME))
+			return true;
+	}
+
+	return false;
+}
+
+
+ssize_t
+IdentifySource::ReadAt(off_t position, void* buffer, size_t size)
+{
+	if (position < 0)
+		return B_BAD_VALUE;
+
+	size_t bytesRead = 0;
+	if (position < (off_t)fBufferSize) {
+		bytesRead = min_c(size, fBufferSize - (size_t)position);
+		memcpy(buffer, fBuffer + position, bytesRead);
+		if (bytesRead == size || fComplete)
+			return bytesRead;
+	} else if (fComplete)
+		return 0;
+
+	ssize_t result = fSource->ReadAt(position + bytesRead,
+		(uint8*)buffer + bytesRead, size - bytesRead);
+	if (result < 0)
+		return bytesRead > 0 ? (ssize_t)bytesRead : result;
+
+	return bytesRead + result;
+}
+
+
+ssize_t
+IdentifySource::WriteAt(off_t position, const void* buffer, size_t size)
+{
+	return B_NOT_ALLOWED;
+}
+
+
+off_t
+IdentifySource::Seek(off_t position, uint32 seekMode)
+{
+	switch (seekMode) {
+		case SEEK_SET:
+			break;
+		case SEEK_CUR:
+			position += fPosition;
+			break;
+		case SEEK_END:
+		{
+			off_t size;
+			status_t status = GetSize(&size);
+			if (status != B_OK)
+				return status;
+
+			position += size;
+			break;
+		}
+		default:
+			return B_BAD_VALUE;
+	}
+
+	if (position < 0)
+		return B_BAD_VALUE;
+
+	fPosition = position;
+	return fPosition;
+}
+
+
+off_t
+IdentifySource::Position() const
+{
+	return fPosition;
+}
+
+
+status_t
+IdentifySource::SetSize(off_t size)
+{
+	return B_NOT_ALLOWED;
+}
+
+
+status_t
+IdentifySource::GetSize(off_t* _size) const
+{
+	if (fComplete) {
+		*_size = fBufferSize;
+		return B_OK;
+	}
+
+	return fSource->GetSize(_size);
+}
+
+
+/*!	Returns \c false only if the format has known signatures, and the source
+	starts with none of them.
+*/
+bool
+IdentifySource::_MayBe(const char* mimeType) const
+{
+	bool known = false;
+
+	for (int32 i = 0; i < kSignatureCount; i++) {
+		const format_signature& signature = kSignatures[i];
+		if (strcasecmp(signature.mimeType, mimeType) != 0)
+			continue;
+
+		known = true;
+		if (signature.offset + signature.length <= fBufferSize
+			&& memcmp(fBuffer + signature.offset, signature.bytes,
+				signature.length) == 0)
+			return true;
+	}
+
+	return !known;
+}
+
+
+}	// namespace BPrivate
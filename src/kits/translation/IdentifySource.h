@@ -0,0 +1,64 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef IDENTIFY_SOURCE_H
+#define IDENTIFY_SOURCE_H
+
+
+#include <DataIO.h>
+#include <TranslationDefs.h>
+
+
+namespace BPrivate {
+
+
+/*!	The source stream as the translators see it while they identify it.
+
+	The beginning of the source is read only once, and all translators read
+	their headers from that buffer, while everything beyond it is read from
+	the source. The source itself is only accessed with ReadAt(), so several
+	translators could even read at the same time.
+
+	The buffer also tells which translators can be skipped: those whose input
+	formats all have a well-known signature, none of which the source starts
+	with.
+*/
+class IdentifySource : public BPositionIO {
+public:
+								IdentifySource(BPositionIO* source);
+	virtual						~IdentifySource();
+
+			status_t			InitCheck() const;
+
+			bool				MayBeAnyOf(const translation_format* formats,
+									int32 formatsCount) const;
+
+	virtual	ssize_t				ReadAt(off_t position, void* buffer,
+									size_t size);
+	virtual	ssize_t				WriteAt(off_t position, const void* buffer,
+									size_t size);
+
+	virtual	off_t				Seek(off_t position, uint32 seekMode);
+	virtual	off_t				Position() const;
+
+	virtual	status_t			SetSize(off_t size);
+	virtual	status_t			GetSize(off_t* _size) const;
+
+private:
+			bool				_MayBe(const char* mimeType) const;
+
+private:
+			BPositionIO*		fSource;
+			uint8*				fBuffer;
+			size_t				fBufferSize;
+			bool				fComplete;
+			off_t				fPosition;
+			status_t			fStatus;
+};
+
+
+}	// namespace BPrivate
+
+
+#endif	// IDENTIFY_SOURCE_H
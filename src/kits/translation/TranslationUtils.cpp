@@ -259,13 +259,44 @@ BTranslationUtils::GetBitmap(const entry_ref *kRef, BTranslatorRoster *roster)
 		// Translate the data in bitmapFile using the BTranslatorRoster roster
 }
 
+// ---------------------------------------------------------------
+// GetBitmap
+//
+// Returns a BBitmap object for the bitmap file with the entry_ref
+// kRef, which the caller is going to scale down to sizeHint. The
+// user has to delete this object.
+//
+// Preconditions:
+//
+// Parameters: kRef, the entry_ref for the bitmap file
+//             sizeHint, the bounds the bitmap will be scaled to
+//             roster, BTranslatorRoster used to do the translation
+//
+// Postconditions:
+//
+// Returns: NULL, if the file couldn't be opened or couldn't
+//                be translated to a BBitmap
+//          BBitmap * to the bitmap file referenced by kRef, at
+//                least as large as sizeHint, unless the image
+//                is smaller
+// ---------------------------------------------------------------
+BBitmap *
+BTranslationUtils::GetBitmap(const entry_ref *kRef, const BRect &sizeHint,
+	BTranslatorRoster *roster)
+{
+	BFile bitmapFile(kRef, B_READ_ONLY);
+	if (bitmapFile.InitCheck() != B_OK)
+		return NULL;
+
+	return GetBitmap(&bitmapFile, sizeHint, roster);
+		// Translate the data in bitmapFile using the BTranslatorRoster roster
+}
+
 // ---------------------------------------------------------------
 // GetBitmap
 //
 // Returns a BBitmap object from the BPositionIO *stream. The
-// user must delete the returned object. This GetBitmap function
-// is used by the other GetBitmap functions to do all of the
-// "real" work.
+// user must delete the returned object.
 //
 // Preconditions:
 //
@@ -279,6 +310,41 @@ BTranslationUtils::GetBitmap(const entry_ref *kRef, BTranslatorRoster *roster)
 // ---------------------------------------------------------------
 BBitmap *
 BTranslationUtils::GetBitmap(BPositionIO *stream, BTranslatorRoster *roster)
+{
+	return GetBitmap(stream, BRect(), roster);
+}
+
+// ---------------------------------------------------------------
+// GetBitmap
+//
+// Returns a BBitmap object from the BPositionIO *stream, which
+// the caller is going to scale down to sizeHint, for example to
+// show a thumbnail of it. The user must delete the returned
+// object. This GetBitmap function is used by the other GetBitmap
+// functions to do all of the "real" work.
+//
+// The translator may decode the image at a reduced size then,
+// which is usually a lot faster. The bitmap is not scaled to
+// sizeHint exactly. Translators that don't support this return
+// the image at its full size.
+//
+// Preconditions:
+//
+// Parameters: stream, the stream with bitmap data in it
+//             sizeHint, the bounds the bitmap will be scaled to,
+//                       an invalid BRect for the full size
+//             roster, BTranslatorRoster used to do the translation
+//
+// Postconditions:
+//
+// Returns: NULL, if the stream couldn't be translated to a BBitmap
+//          BBitmap * for the bitmap data from pio if successful,
+//                at least as large as sizeHint, unless the image
+//                is smaller
+// ---------------------------------------------------------------
+BBitmap *
+BTranslationUtils::GetBitmap(BPositionIO *stream, const BRect &sizeHint,
+	BTranslatorRoster *roster)
 {
 	if (stream == NULL)
 		return NULL;
@@ -292,9 +358,16 @@ BTranslationUtils::GetBitmap(BPositionIO *stream, BTranslatorRoster *roster)
 
 	// Translate the file from whatever format it is in the file
 	// to the type format so that it can be stored in a BBitmap
+	BMessage ioExtension;
+	if (sizeHint.IsValid()
+		&& ioExtension.AddRect(B_TRANSLATOR_EXT_BITMAP_SIZE_HINT, sizeHint)
+			!= B_OK)
+		return NULL;
+
 	BBitmapStream bitmapStream;
-	if (roster->Translate(stream, NULL, NULL, &bitmapStream,
-		B_TRANSLATOR_BITMAP) < B_OK)
+	if (roster->Translate(stream, NULL,
+			sizeHint.IsValid() ? &ioExtension : NULL, &bitmapStream,
+			B_TRANSLATOR_BITMAP) < B_OK)
 		return NULL;
 
 	// Detach the BBitmap from the BBitmapStream so the user
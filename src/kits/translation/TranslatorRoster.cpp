@@ -35,6 +35,7 @@
 #include <syscalls.h>
 
 #include "FuncTranslator.h"
+#include "IdentifySource.h"
 #include "TranslatorRosterPrivate.h"
 
 
@@ -66,6 +67,7 @@ char B_TRANSLATOR_EXT_FRAME[]				= "/frame";
 char B_TRANSLATOR_EXT_BITMAP_RECT[]			= "bits/Rect";
 char B_TRANSLATOR_EXT_BITMAP_COLOR_SPACE[]	= "bits/space";
 char B_TRANSLATOR_EXT_BITMAP_PALETTE[]		= "bits/palette";
+char B_TRANSLATOR_EXT_BITMAP_SIZE_HINT[]	= "bits/sizeHint";
 char B_TRANSLATOR_EXT_SOUND_CHANNEL[]		= "nois/channel";
 char B_TRANSLATOR_EXT_SOUND_MONO[]			= "nois/mono";
 char B_TRANSLATOR_EXT_SOUND_MARKER[]		= "nois/marker";
@@ -713,28 +715,35 @@ BTranslatorRoster::Private::StoreTranslators(BMessage& archive)
 }
 
 
+/*!	Asks all translators that could handle \a source which fits best.
+	The roster is not locked while they do, so that several threads can
+	identify their sources at the same time.
+*/
 status_t
 BTranslatorRoster::Private::Identify(BPositionIO* source,
 	BMessage* ioExtension, uint32 hintType, const char* hintMIME,
 	uint32 wantType, translator_info* _info)
 {
-	BAutolock locker(this);
+	BPrivate::IdentifySource identifySource(source);
+	status_t status = identifySource.InitCheck();
+	if (status != B_OK)
+		return status;
 
-	_RescanChanged();
+	TranslatorList candidates;
+	status = _AcquireCandidates(identifySource, candidates);
+	if (status != B_OK)
+		return status;
 
-	TranslatorMap::const_iterator iterator = fTranslators.begin();
 	BMessage baseExtension;
 	if (ioExtension != NULL)
 		baseExtension = *ioExtension;
 
 	float bestWeight = 0.0f;
 
-	while (iterator != fTranslators.end()) {
-		BTranslator& translator = *iterator->second.translator;
+	for (size_t i = 0; i < candidates.size(); i++) {
+		BTranslator& translator = *candidates[i].second;
 
-		off_t pos = source->Seek(0, SEEK_SET);
-		if (pos != 0)
-			return pos < 0 ? (status_t)pos : B_IO_ERROR;
+		identifySource.Seek(0, SEEK_SET);
 
 		int32 formatsCount = 0;
 		const translation_format* formats = translator.InputFormats(
@@ -744,22 +753,22 @@ BTranslatorRoster::Private::Identify(BPositionIO* source,
 
 		BMessage extension(baseExtension);
 		translator_info info;
-		if (translator.Identify(source, format, &extension, &info, wantType)
-				== B_OK) {
+		if (translator.Identify(&identifySource, format, &extension, &info,
+				wantType) == B_OK) {
 			float weight = info.quality * info.capability;
 			if (weight > bestWeight) {
 				if (ioExtension != NULL)
 					*ioExtension = extension;
 				bestWeight = weight;
 
-				info.translator = iterator->first;
+				info.translator = candidates[i].first;
 				memcpy(_info, &info, sizeof(translator_info));
 			}
 		}
-
-		iterator++;
 	}
 
+	_ReleaseCandidates(candidates);
+
 	if (bestWeight > 0.0f)
 		return B_OK;
 
@@ -772,26 +781,29 @@ BTranslatorRoster::Private::GetTranslators(BPositionIO* source,
 	BMessage* ioExtension, uint32 hintType, const char* hintMIME,
 	uint32 wantType, translator_info** _info, int32* _numInfo)
 {
-	BAutolock locker(this);
+	BPrivate::IdentifySource identifySource(source);
+	status_t status = identifySource.InitCheck();
+	if (status != B_OK)
+		return status;
 
-	_RescanChanged();
+	TranslatorList candidates;
+	status = _AcquireCandidates(identifySource, candidates);
+	if (status != B_OK)
+		return status;
 
-	int32 arraySize = fTranslators.size();
-	translator_info* array = new (std::nothrow) translator_info[arraySize];
-	if (array == NULL)
+	translator_info* array
+		= new (std::nothrow) translator_info[candidates.size()];
+	if (array == NULL) {
+		_ReleaseCandidates(candidates);
 		return B_NO_MEMORY;
+	}
 
-	TranslatorMap::const_iterator iterator = fTranslators.begin();
 	int32 count = 0;
 
-	while (iterator != fTranslators.end()) {
-		BTranslator& translator = *iterator->second.translator;
+	for (size_t i = 0; i < candidates.size(); i++) {
+		BTranslator& translator = *candidates[i].second;
 
-		off_t pos = source->Seek(0, SEEK_SET);
-		if (pos != 0) {
-			delete[] array;
-			return pos < 0 ? status_t(pos) : B_IO_ERROR;
-		}
+		identifySource.Seek(0, SEEK_SET);
 
 		int32 formatsCount = 0;
 		const translation_format* formats = translator.InputFormats(
@@ -800,15 +812,15 @@ BTranslatorRoster::Private::GetTranslators(BPositionIO* source,
 			hintType, hintMIME);
 
 		translator_info info;
-		if (translator.Identify(source, format, ioExtension, &info, wantType)
-				== B_OK) {
-			info.translator = iterator->first;
+		if (translator.Identify(&identifySource, format, ioExtension, &info,
+				wantType) == B_OK) {
+			info.translator = candidates[i].first;
 			array[count++] = info;
 		}
-
-		iterator++;
 	}
 
+	_ReleaseCandidates(candidates);
+
 	*_info = array;
 	*_numInfo = count;
 	qsort(array, count, sizeof(translator_info),
@@ -927,6 +939,53 @@ BTranslatorRoster::Private::_RescanChanged()
 }
 
 
+/*!
+	Collects the translators that might be able to identify \a source, and
+	acquires them, so that they can be used with the roster unlocked.
+*/
+status_t
+BTranslatorRoster::Private::_AcquireCandidates(
+	const BPrivate::IdentifySource& source, TranslatorList& candidates)
+{
+	BAutolock locker(this);
+
+	_RescanChanged();
+
+	try {
+		candidates.reserve(fTranslators.size());
+	} catch (...) {
+		return B_NO_MEMORY;
+	}
+
+	TranslatorMap::const_iterator iterator = fTranslators.begin();
+	while (iterator != fTranslators.end()) {
+		BTranslator* translator = iterator->second.translator;
+
+		int32 formatsCount = 0;
+		const translation_format* formats = translator->InputFormats(
+			&formatsCount);
+		if (source.MayBeAnyOf(formats, formatsCount)) {
+			translator->Acquire();
+			candidates.push_back(std::make_pair(iterator->first, translator));
+		}
+
+		iterator++;
+	}
+
+	return B_OK;
+}
+
+
+void
+BTranslatorRoster::Private::_ReleaseCandidates(TranslatorList& candidates)
+{
+	for (size_t i = 0; i < candidates.size(); i++)
+		candidates[i].second->Release();
+
+	candidates.clear();
+}
+
+
 /*!
 	Tests if the hints provided for a source stream are compatible to
 	the formats the translator exports.
@@ -1669,6 +1728,111 @@ BTranslatorRoster::Translate(translator_id id, BPositionIO* source,
 }
 
 
+struct batch_translation {
+	BTranslatorRoster*	roster;
+	BPositionIO**		sources;
+	BPositionIO**		destinations;
+	int32				count;
+	BMessage*			ioExtension;
+	uint32				wantOutType;
+	status_t*			results;
+	int32				nextIndex;
+	int32				error;
+};
+
+
+static status_t
+batch_translation_worker(void* _batch)
+{
+	batch_translation& batch = *(batch_translation*)_batch;
+
+	while (true) {
+		int32 index = atomic_add(&batch.nextIndex, 1);
+		if (index >= batch.count)
+			break;
+
+		BMessage extension;
+		if (batch.ioExtension != NULL)
+			extension = *batch.ioExtension;
+
+		status_t status = batch.roster->Translate(batch.sources[index], NULL,
+			&extension, batch.destinations[index], batch.wantOutType);
+		if (batch.results != NULL)
+			batch.results[index] = status;
+		if (status != B_OK)
+			atomic_test_and_set(&batch.error, status, B_OK);
+	}
+
+	return B_OK;
+}
+
+
+/*!
+	Translates each of the \a sources to the respective destination, like
+	Translate() would do, but with one thread per CPU. Every translation
+	starts with a copy of \a ioExtension, which is not changed.
+
+	\param sources the data to be translated
+	\param destinations where the \a sources are translated to
+	\param count the number of sources and destinations
+	\param ioExtension the configuration data for the translators
+	\param wantOutType the desired output type - if zero, any type is okay.
+	\param _results if not \c NULL, the result of each translation is stored
+		there.
+
+	\return B_OK, if all translations were successful, or else the error of
+		one that failed.
+*/
+status_t
+BTranslatorRoster::TranslateBatch(BPositionIO** sources,
+	BPositionIO** destinations, int32 count, BMessage* ioExtension,
+	uint32 wantOutType, status_t* _results)
+{
+	if (sources == NULL || destinations == NULL || count < 0)
+		return B_BAD_VALUE;
+
+	batch_translation batch;
+	batch.roster = this;
+	batch.sources = sources;
+	batch.destinations = destinations;
+	batch.count = count;
+	batch.ioExtension = ioExtension;
+	batch.wantOutType = wantOutType;
+	batch.results = _results;
+	batch.nextIndex = 0;
+	batch.error = B_OK;
+
+	const int32 kMaxWorkers = 16;
+	int32 workerCount = 1;
+	system_info info;
+	if (get_system_info(&info) == B_OK)
+		workerCount = min_c((int32)info.cpu_count, kMaxWorkers);
+	workerCount = min_c(workerCount, count);
+
+	// the calling thread is one of the workers
+	thread_id threads[kMaxWorkers];
+	int32 threadCount = 0;
+	for (int32 i = 1; i < workerCount; i++) {
+		thread_id thread = spawn_thread(&batch_translation_worker,
+			"batch translation", B_NORMAL_PRIORITY, &batch);
+		if (thread < 0)
+			break;
+
+		threads[threadCount++] = thread;
+		resume_thread(thread);
+	}
+
+	batch_translation_worker(&batch);
+
+	for (int32 i = 0; i < threadCount; i++) {
+		status_t result;
+		wait_for_thread(threads[i], &result);
+	}
+
+	return batch.error;
+}
+
+
 /*!
 	Creates a BView in \a _view for configuring the translator specified
 	by \a id. Not all translators support this, though.
@@ -21,6 +21,10 @@
 
 struct translator_data;
 
+namespace BPrivate {
+	class IdentifySource;
+}
+
 
 struct translator_item {
 	BTranslator*	translator;
@@ -35,6 +39,7 @@ typedef std::vector<node_ref> NodeRefList;
 typedef std::set<entry_ref> EntryRefSet;
 typedef std::map<image_id, int32> ImageMap;
 typedef std::map<BTranslator*, image_id> TranslatorImageMap;
+typedef std::vector<std::pair<translator_id, BTranslator*> > TranslatorList;
 
 
 class BTranslatorRoster::Private : public BHandler, public BLocker {
@@ -85,6 +90,12 @@ private:
 
 			void				_RescanChanged();
 
+			status_t			_AcquireCandidates(
+									const BPrivate::IdentifySource& source,
+									TranslatorList& candidates);
+			void				_ReleaseCandidates(
+									TranslatorList& candidates);
+
 			const translation_format* _CheckHints(
 									const translation_format* formats,
 									int32 formatsCount, uint32 hintType,
@@ -33,6 +33,10 @@ Job::Job(const char* name)
 	fDefaultPort(-1),
 	fToken((uint32)B_PREFERRED_TOKEN),
 	fLaunchStatus(B_NO_INIT),
+	fQueuedTime(0),
+	fStartTime(0),
+	fLaunchedTime(0),
+	fReadyTime(0),
 	fTarget(NULL),
 	fPendingLaunchDataReplies(0, false),
 	fTeamListener(NULL)
@@ -53,6 +57,10 @@ Job::Job(const Job& other)
 	fDefaultPort(-1),
 	fToken((uint32)B_PREFERRED_TOKEN),
 	fLaunchStatus(B_NO_INIT),
+	fQueuedTime(0),
+	fStartTime(0),
+	fLaunchedTime(0),
+	fReadyTime(0),
 	fTarget(other.Target()),
 	fPendingLaunchDataReplies(0, false)
 {
@@ -452,6 +460,61 @@ void
 Job::SetLaunching(bool launching)
 {
 	fLaunching = launching;
+
+	if (launching) {
+		MutexLocker locker(fLaunchStatusLock);
+		fQueuedTime = system_time();
+		fStartTime = 0;
+		fLaunchedTime = 0;
+		fReadyTime = 0;
+	}
+}
+
+
+//! Returns when the job was last put into the launch queue.
+bigtime_t
+Job::QueuedTime() const
+{
+	MutexLocker locker(fLaunchStatusLock);
+	return fQueuedTime;
+}
+
+
+//! Returns when a worker picked up the job, i.e. all requirements were met.
+bigtime_t
+Job::StartTime() const
+{
+	MutexLocker locker(fLaunchStatusLock);
+	return fStartTime;
+}
+
+
+//! Returns when the job's team has been created, or launching it failed.
+bigtime_t
+Job::LaunchedTime() const
+{
+	MutexLocker locker(fLaunchStatusLock);
+	return fLaunchedTime;
+}
+
+
+/*!	Returns when the job's application registered with the registrar, or
+	\c 0 if it hasn't (yet). Jobs that aren't applications never become ready.
+*/
+bigtime_t
+Job::ReadyTime() const
+{
+	MutexLocker locker(fLaunchStatusLock);
+	return fReadyTime;
+}
+
+
+void
+Job::SetReady()
+{
+	MutexLocker locker(fLaunchStatusLock);
+	if (fLaunchedTime != 0 && fReadyTime == 0)
+		fReadyTime = system_time();
 }
 
 
@@ -496,6 +559,10 @@ Job::Run()
 status_t
 Job::Execute()
 {
+	MutexLocker locker(fLaunchStatusLock);
+	fStartTime = system_time();
+	locker.Unlock();
+
 	status_t status = B_OK;
 	if (!IsRunning() || !IsService())
 		status = Launch();
@@ -561,6 +628,7 @@ Job::_SetLaunchStatus(status_t launchStatus)
 {
 	MutexLocker launchLocker(fLaunchStatusLock);
 	fLaunchStatus = launchStatus != B_NO_INIT ? launchStatus : B_ERROR;
+	fLaunchedTime = system_time();
 	launchLocker.Unlock();
 
 	_SendPendingLaunchDataReplies();
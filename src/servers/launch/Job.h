@@ -96,6 +96,12 @@ public:
 			bool				IsLaunching() const;
 			void				SetLaunching(bool launching);
 
+			bigtime_t			QueuedTime() const;
+			bigtime_t			StartTime() const;
+			bigtime_t			LaunchedTime() const;
+			bigtime_t			ReadyTime() const;
+			void				SetReady();
+
 			status_t			HandleGetLaunchData(BMessage* message);
 			status_t			GetMessenger(BMessenger& messenger);
 
@@ -137,7 +143,11 @@ private:
 			port_id				fDefaultPort;
 			uint32				fToken;
 			status_t			fLaunchStatus;
-			mutex				fLaunchStatusLock;
+	mutable	mutex				fLaunchStatusLock;
+			bigtime_t			fQueuedTime;
+			bigtime_t			fStartTime;
+			bigtime_t			fLaunchedTime;
+			bigtime_t			fReadyTime;
 			::Target*			fTarget;
 			::Condition*		fCondition;
 			BStringList			fPendingJobs;
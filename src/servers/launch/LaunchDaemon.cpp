@@ -564,6 +564,8 @@ LaunchDaemon::MessageReceived(BMessage* message)
 			}
 
 			if (job != NULL) {
+				job->SetReady();
+
 				// Update port info
 				app_info info;
 				status_t status = be_roster->GetRunningAppInfo(team, &info);
@@ -1241,6 +1243,12 @@ LaunchDaemon::_HandleGetLaunchJobInfo(BMessage* message)
 		info.SetBool("launched", job->IsLaunched());
 		info.SetBool("service", job->IsService());
 
+		// Launch timing, in system_time() units
+		info.SetInt64("queued_time", job->QueuedTime());
+		info.SetInt64("start_time", job->StartTime());
+		info.SetInt64("launch_time", job->LaunchedTime());
+		info.SetInt64("ready_time", job->ReadyTime());
+
 		if (job->Target() != NULL)
 			info.SetString("target", job->Target()->Name());
 
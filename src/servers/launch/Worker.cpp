@@ -6,6 +6,9 @@
 
 #include "Worker.h"
 
+#include <algorithm>
+#include <new>
+
 
 static const bigtime_t kWorkerTimeout = 1000000;
 	// One second until a worker thread quits without a job
@@ -13,6 +16,8 @@ static const bigtime_t kWorkerTimeout = 1000000;
 static const int32 kWorkerCountPerCPU = 3;
 
 static int32 sWorkerCount;
+static int32 sIdleWorkerCount;
+static int32 sMaxWorkerCount = kWorkerCountPerCPU;
 
 
 Worker::Worker(JobQueue& queue)
@@ -31,14 +36,11 @@ Worker::~Worker()
 status_t
 Worker::Init()
 {
-	fThread = spawn_thread(&Worker::_Process, Name(), B_NORMAL_PRIORITY,
-		this);
-	if (fThread < 0)
-		return fThread;
+	atomic_add(&sWorkerCount, 1);
 
-	status_t status = resume_thread(fThread);
-	if (status == B_OK)
-		atomic_add(&sWorkerCount, 1);
+	status_t status = _Start();
+	if (status != B_OK)
+		atomic_add(&sWorkerCount, -1);
 
 	return status;
 }
@@ -49,10 +51,14 @@ Worker::Process()
 {
 	while (true) {
 		BJob* job;
+		atomic_add(&sIdleWorkerCount, 1);
 		status_t status = fJobQueue.Pop(Timeout(), false, &job);
+		atomic_add(&sIdleWorkerCount, -1);
 		if (status != B_OK)
 			return status;
 
+		_StartWorkersIfNeeded();
+
 		status = Run(job);
 		if (status != B_OK) {
 			// TODO: proper error reporting on failed job!
@@ -84,6 +90,55 @@ Worker::Run(BJob* job)
 }
 
 
+/*!	Makes sure there is an idle worker for every job that could be run right
+	away, so that independent jobs are launched in parallel rather than one
+	after the other. Every worker calls this when it picks up a job; workers
+	that don't get any work quit after a timeout again.
+*/
+void
+Worker::_StartWorkersIfNeeded()
+{
+	int32 runnable = (int32)std::min(fJobQueue.CountRunnableJobs(),
+		(size_t)INT_MAX);
+
+	while (runnable > atomic_get(&sIdleWorkerCount)) {
+		// Take the new worker's slot before starting it, so that workers
+		// doing this at the same time cannot exceed the maximum together.
+		if (atomic_add(&sWorkerCount, 1) >= sMaxWorkerCount) {
+			atomic_add(&sWorkerCount, -1);
+			break;
+		}
+
+		Worker* worker = new(std::nothrow) Worker(fJobQueue);
+		if (worker == NULL || worker->_Start() != B_OK) {
+			delete worker;
+			atomic_add(&sWorkerCount, -1);
+			break;
+		}
+		runnable--;
+	}
+}
+
+
+/*!	Starts the worker's thread. The caller must already have counted it in
+	sWorkerCount; the thread removes it again when it quits.
+*/
+status_t
+Worker::_Start()
+{
+	fThread = spawn_thread(&Worker::_Process, Name(), B_NORMAL_PRIORITY,
+		this);
+	if (fThread < 0)
+		return fThread;
+
+	status_t status = resume_thread(fThread);
+	if (status != B_OK)
+		kill_thread(fThread);
+
+	return status;
+}
+
+
 /*static*/ status_t
 Worker::_Process(void* _self)
 {
@@ -91,6 +146,7 @@ Worker::_Process(void* _self)
 	status_t status = self->Process();
 	delete self;
 
+	atomic_add(&sWorkerCount, -1);
 	return status;
 }
 
@@ -100,13 +156,12 @@ Worker::_Process(void* _self)
 
 MainWorker::MainWorker(JobQueue& queue)
 	:
-	Worker(queue),
-	fMaxWorkerCount(kWorkerCountPerCPU)
+	Worker(queue)
 {
 	// TODO: keep track of workers, and quit them on destruction
 	system_info info;
 	if (get_system_info(&info) == B_OK)
-		fMaxWorkerCount = info.cpu_count * kWorkerCountPerCPU;
+		sMaxWorkerCount = info.cpu_count * kWorkerCountPerCPU;
 }
 
 
@@ -122,21 +177,3 @@ MainWorker::Name() const
 {
 	return "main worker";
 }
-
-
-status_t
-MainWorker::Run(BJob* job)
-{
-	int32 count = atomic_get(&sWorkerCount);
-
-	size_t jobCount = fJobQueue.CountJobs();
-	if (jobCount > INT_MAX)
-		jobCount = INT_MAX;
-
-	if ((int32)jobCount > count && count < fMaxWorkerCount) {
-		Worker* worker = new Worker(fJobQueue);
-		worker->Init();
-	}
-
-	return Worker::Run(job);
-}
@@ -27,7 +27,10 @@ protected:
 	virtual	const char*			Name() const;
 	virtual	status_t			Run(BJob* job);
 
+			void				_StartWorkersIfNeeded();
+
 private:
+			status_t			_Start();
 	static	status_t			_Process(void* self);
 
 protected:
@@ -43,10 +46,6 @@ public:
 protected:
 	virtual	bigtime_t			Timeout() const;
 	virtual	const char*			Name() const;
-	virtual	status_t			Run(BJob* job);
-
-private:
-			int32				fMaxWorkerCount;
 };
 
 
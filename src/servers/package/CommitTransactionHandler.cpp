@@ -14,6 +14,7 @@
 #include <pwd.h>
 
 #include <File.h>
+#include <OS.h>
 #include <Path.h>
 #include <SymLink.h>
 
@@ -36,6 +37,10 @@ using namespace BPackageKit::BPrivate;
 using BPackageKit::BTransactionIssue;
 
 
+// maximum number of threads extracting the writable files of packages
+static const int32 kMaxWritableFilesExtractorThreads = 8;
+
+
 // #pragma mark - TransactionIssueBuilder
 
 
@@ -106,6 +111,147 @@ private:
 };
 
 
+// #pragma mark - WritableFilesExtractor
+
+
+/*!	Extracts the global writable files of the packages to activate into the
+	writable-files directory. Extracting a package's files runs a process of
+	its own and is independent of the other packages, so up to
+	kMaxWritableFilesExtractorThreads packages are extracted concurrently.
+	Installing the extracted files is left to _AddGlobalWritableFiles(), which
+	finds them already in place.
+*/
+struct CommitTransactionHandler::WritableFilesExtractor {
+	WritableFilesExtractor(CommitTransactionHandler* handler)
+		:
+		fHandler(handler),
+		fJobs(20, true),
+		fNextJob(0),
+		fFailed(0),
+		fException(NULL)
+	{
+	}
+
+	~WritableFilesExtractor()
+	{
+		delete fException;
+	}
+
+	bool AddPackage(Package* package)
+	{
+		Job* job = new Job(package);
+		ObjectDeleter<Job> jobDeleter(job);
+
+		_GetGlobalWritableFileContentPaths(package, job->contentPaths);
+		if (job->contentPaths.IsEmpty())
+			return false;
+
+		if (!fJobs.AddItem(job))
+			throw std::bad_alloc();
+		jobDeleter.Detach();
+		return true;
+	}
+
+	int32 CountPackages() const
+	{
+		return fJobs.CountItems();
+	}
+
+	void Run()
+	{
+		int32 threadCount = kMaxWritableFilesExtractorThreads;
+		system_info info;
+		if (get_system_info(&info) == B_OK)
+			threadCount = min_c(threadCount, (int32)info.cpu_count);
+		threadCount = min_c(threadCount, fJobs.CountItems());
+
+		thread_id threads[kMaxWritableFilesExtractorThreads];
+		int32 spawnedCount = 0;
+		for (int32 i = 1; i < threadCount; i++) {
+			thread_id thread = spawn_thread(&_ExtractorThreadEntry,
+				"writable files extractor", B_NORMAL_PRIORITY, this);
+			if (thread < 0)
+				break;
+
+			threads[spawnedCount++] = thread;
+			resume_thread(thread);
+		}
+
+		_Extract();
+
+		for (int32 i = 0; i < spawnedCount; i++) {
+			status_t result;
+			wait_for_thread(threads[i], &result);
+		}
+
+		if (fFailed != 0) {
+			if (fException == NULL)
+				throw Exception(B_TRANSACTION_NO_MEMORY);
+			throw Exception(*fException);
+		}
+	}
+
+private:
+	struct Job {
+		Job(Package* package)
+			:
+			package(package),
+			contentPaths()
+		{
+		}
+
+		Package*	package;
+		BStringList	contentPaths;
+	};
+
+	typedef BObjectList<Job> JobList;
+
+private:
+	static status_t _ExtractorThreadEntry(void* data)
+	{
+		((WritableFilesExtractor*)data)->_Extract();
+		return B_OK;
+	}
+
+	void _Extract()
+	{
+		while (atomic_get(&fFailed) == 0) {
+			int32 index = atomic_add(&fNextJob, 1);
+			if (index >= fJobs.CountItems())
+				return;
+
+			Job* job = fJobs.ItemAt(index);
+			try {
+				BDirectory extractedFilesDirectory;
+				fHandler->_ExtractPackageContent(job->package,
+					job->contentPaths, fHandler->fWritableFilesDirectory,
+					extractedFilesDirectory);
+			} catch (Exception& exception) {
+				_SetFailed(new(std::nothrow) Exception(exception));
+			} catch (std::bad_alloc&) {
+				_SetFailed(NULL);
+			}
+		}
+	}
+
+	void _SetFailed(Exception* exception)
+	{
+		// only the first failure is reported
+		if (atomic_test_and_set(&fFailed, 1, 0) == 0)
+			fException = exception;
+		else
+			delete exception;
+	}
+
+private:
+	CommitTransactionHandler*	fHandler;
+	JobList						fJobs;
+	int32						fNextJob;
+	int32						fFailed;
+	Exception*					fException;
+};
+
+
 // #pragma mark - CommitTransactionHandler
 
 
@@ -540,6 +686,15 @@ CommitTransactionHandler::_RemovePackagesToDeactivate()
 }
 
 
+/*!	Moves the packages into the packages directory, and installs their users,
+	groups and global writable files.
+	Only extracting the writable files runs in parallel, as it is the only
+	step that takes long per package. Moving a package is a rename within
+	the volume. Installing the users, groups and extracted files writes to
+	shared files and directories, where the order of the packages decides
+	conflicts, and registers its changes with fFSTransaction for a
+	rollback, so it stays sequential.
+*/
 void
 CommitTransactionHandler::_AddPackagesToActivate()
 {
@@ -563,7 +718,6 @@ CommitTransactionHandler::_AddPackagesToActivate()
 		if (fPackagesAlreadyAdded.find(package)
 				!= fPackagesAlreadyAdded.end()) {
 			fAddedPackages.insert(package);
-			_PreparePackageToActivate(package);
 			continue;
 		}
 
@@ -604,9 +758,41 @@ CommitTransactionHandler::_AddPackagesToActivate()
 
 		// also add the package to the volume
 		fVolumeState->AddPackage(package);
+	}
+
+	// extract the global writable files of all packages at once
+	_ExtractGlobalWritableFiles();
+
+	for (int32 i = 0; i < count; i++)
+		_PreparePackageToActivate(fPackagesToActivate.ItemAt(i));
+}
+
 
-		_PreparePackageToActivate(package);
+void
+CommitTransactionHandler::_ExtractGlobalWritableFiles()
+{
+	WritableFilesExtractor extractor(this);
+	Package* firstPackage = NULL;
+
+	int32 count = fPackagesToActivate.CountItems();
+	for (int32 i = 0; i < count; i++) {
+		Package* package = fPackagesToActivate.ItemAt(i);
+		if (extractor.AddPackage(package) && firstPackage == NULL)
+			firstPackage = package;
 	}
+
+	if (firstPackage == NULL)
+		return;
+
+	_OpenWritableFilesDirectory(firstPackage);
+
+	bigtime_t startTime = system_time();
+	extractor.Run();
+
+	INFORM("CommitTransactionHandler::_ExtractGlobalWritableFiles(): "
+		"extracted the writable files of %" B_PRId32 " packages in %"
+		B_PRIdBIGTIME " us\n", extractor.CountPackages(),
+		system_time() - startTime);
 }
 
 
@@ -731,6 +917,29 @@ CommitTransactionHandler::_AddUser(Package* package, const BUser& user)
 }
 
 
+void
+CommitTransactionHandler::_OpenWritableFilesDirectory(Package* package)
+{
+	if (fWritableFilesDirectory.InitCheck() == B_OK)
+		return;
+
+	RelativePath directoryPath(kAdminDirectoryName,
+		kWritableFilesDirectoryName);
+	status_t error = _OpenPackagesSubDirectory(directoryPath, true,
+		fWritableFilesDirectory);
+
+	if (error != B_OK) {
+		throw Exception(B_TRANSACTION_FAILED_TO_OPEN_DIRECTORY)
+			.SetPath1(_GetPath(
+				FSUtils::Entry(fVolume->PackagesDirectoryRef(),
+					directoryPath.ToString()),
+				directoryPath.ToString()))
+			.SetPackageName(package->FileName())
+			.SetSystemError(error);
+	}
+}
+
+
 void
 CommitTransactionHandler::_AddGlobalWritableFiles(Package* package)
 {
@@ -738,11 +947,7 @@ CommitTransactionHandler::_AddGlobalWritableFiles(Package* package)
 	const BObjectList<BGlobalWritableFileInfo>& files
 		= package->Info().GlobalWritableFileInfos();
 	BStringList contentPaths;
-	for (int32 i = 0; const BGlobalWritableFileInfo* file = files.ItemAt(i);
-		i++) {
-		if (file->IsIncluded() && !contentPaths.Add(file->Path()))
-			throw std::bad_alloc();
-	}
+	_GetGlobalWritableFileContentPaths(package, contentPaths);
 
 	if (contentPaths.IsEmpty())
 		return;
@@ -760,24 +965,10 @@ CommitTransactionHandler::_AddGlobalWritableFiles(Package* package)
 	}
 
 	// Open writable-files directory in the administrative directory.
-	if (fWritableFilesDirectory.InitCheck() != B_OK) {
-		RelativePath directoryPath(kAdminDirectoryName,
-			kWritableFilesDirectoryName);
-		error = _OpenPackagesSubDirectory(directoryPath, true,
-			fWritableFilesDirectory);
-
-		if (error != B_OK) {
-			throw Exception(B_TRANSACTION_FAILED_TO_OPEN_DIRECTORY)
-				.SetPath1(_GetPath(
-					FSUtils::Entry(fVolume->PackagesDirectoryRef(),
-						directoryPath.ToString()),
-					directoryPath.ToString()))
-				.SetPackageName(package->FileName())
-				.SetSystemError(error);
-		}
-	}
+	_OpenWritableFilesDirectory(package);
 
-	// extract files into a subdir of the writable-files directory
+	// extract files into a subdir of the writable-files directory -- usually
+	// _ExtractGlobalWritableFiles() has done that already
 	BDirectory extractedFilesDirectory;
 	_ExtractPackageContent(package, contentPaths,
 		fWritableFilesDirectory, extractedFilesDirectory);
@@ -886,7 +1077,8 @@ CommitTransactionHandler::_AddGlobalWritableFileRecurse(Package* package,
 			"couldn't get stat for writable file, copying...\n");
 		FSTransaction::CreateOperation copyOperation(&fFSTransaction,
 			FSUtils::Entry(targetDirectory, targetName));
-		status_t error = BCopyEngine(BCopyEngine::COPY_RECURSIVELY)
+		status_t error = BCopyEngine(BCopyEngine::COPY_RECURSIVELY
+				| BCopyEngine::COPY_CONCURRENTLY)
 			.CopyEntry(
 				FSUtils::Entry(sourceDirectory, relativeSourcePath.Leaf()),
 				FSUtils::Entry(targetDirectory, targetName));
@@ -1451,7 +1643,8 @@ CommitTransactionHandler::_ExtractPackageContent(Package* package,
 
 	if (targetEntry.Exists()) {
 		// remove pre-existing
-		error = BRemoveEngine().RemoveEntry(FSUtils::Entry(targetEntry));
+		error = BRemoveEngine(BRemoveEngine::REMOVE_CONCURRENTLY)
+			.RemoveEntry(FSUtils::Entry(targetEntry));
 		if (error != B_OK) {
 			throw Exception(B_TRANSACTION_FAILED_TO_REMOVE_DIRECTORY)
 				.SetPath1(_GetPath(
@@ -1462,10 +1655,11 @@ CommitTransactionHandler::_ExtractPackageContent(Package* package,
 		}
 	}
 
+	// Note: This method may be invoked concurrently for different packages
+	// (cf. WritableFilesExtractor), so it doesn't register the subdirectory
+	// with fFSTransaction, but removes it itself on error. Since it is kept
+	// anyway once complete, that is all the transaction would do.
 	BDirectory& subDirectory = _extractedFilesDirectory;
-	FSTransaction::CreateOperation createSubDirectoryOperation(
-		&fFSTransaction,
-		FSUtils::Entry(targetDirectory, temporaryTargetName));
 	error = targetDirectory.CreateDirectory(temporaryTargetName,
 		&subDirectory);
 	if (error != B_OK) {
@@ -1477,43 +1671,43 @@ CommitTransactionHandler::_ExtractPackageContent(Package* package,
 			.SetSystemError(error);
 	}
 
-	createSubDirectoryOperation.Finished();
+	try {
+		// extract
+		NotOwningEntryRef packageRef(package->EntryRef());
 
-	// extract
-	NotOwningEntryRef packageRef(package->EntryRef());
+		int32 contentPathCount = contentPaths.CountStrings();
+		for (int32 i = 0; i < contentPathCount; i++) {
+			const char* contentPath = contentPaths.StringAt(i);
 
-	int32 contentPathCount = contentPaths.CountStrings();
-	for (int32 i = 0; i < contentPathCount; i++) {
-		const char* contentPath = contentPaths.StringAt(i);
+			error = FSUtils::ExtractPackageContent(FSUtils::Entry(packageRef),
+				contentPath, FSUtils::Entry(subDirectory));
+			if (error != B_OK) {
+				throw Exception(B_TRANSACTION_FAILED_TO_EXTRACT_PACKAGE_FILE)
+					.SetPath1(contentPath)
+					.SetPackageName(package->FileName())
+					.SetSystemError(error);
+			}
+		}
 
-		error = FSUtils::ExtractPackageContent(FSUtils::Entry(packageRef),
-			contentPath, FSUtils::Entry(subDirectory));
+		// tag all entries with the package attribute
+		_TagPackageEntriesRecursively(subDirectory, targetName, true);
+
+		// rename the subdirectory
+		error = targetEntry.Rename(targetName);
 		if (error != B_OK) {
-			throw Exception(B_TRANSACTION_FAILED_TO_EXTRACT_PACKAGE_FILE)
-				.SetPath1(contentPath)
+			throw Exception(B_TRANSACTION_FAILED_TO_MOVE_FILE)
+				.SetPath1(_GetPath(
+					FSUtils::Entry(targetDirectory, temporaryTargetName),
+					temporaryTargetName))
+				.SetPath2(targetName)
 				.SetPackageName(package->FileName())
 				.SetSystemError(error);
 		}
+	} catch (...) {
+		BRemoveEngine(BRemoveEngine::REMOVE_CONCURRENTLY).RemoveEntry(
+			FSUtils::Entry(targetDirectory, temporaryTargetName));
+		throw;
 	}
-
-	// tag all entries with the package attribute
-	_TagPackageEntriesRecursively(subDirectory, targetName, true);
-
-	// rename the subdirectory
-	error = targetEntry.Rename(targetName);
-	if (error != B_OK) {
-		throw Exception(B_TRANSACTION_FAILED_TO_MOVE_FILE)
-			.SetPath1(_GetPath(
-				FSUtils::Entry(targetDirectory, temporaryTargetName),
-				temporaryTargetName))
-			.SetPath2(targetName)
-			.SetPackageName(package->FileName())
-			.SetSystemError(error);
-	}
-
-	// keep the directory, regardless of whether the transaction is rolled
-	// back
-	createSubDirectoryOperation.Unregister();
 }
 
 
@@ -1813,6 +2007,20 @@ CommitTransactionHandler::_AddIssue(const TransactionIssueBuilder& builder)
 }
 
 
+/*static*/ void
+CommitTransactionHandler::_GetGlobalWritableFileContentPaths(Package* package,
+	BStringList& _contentPaths)
+{
+	const BObjectList<BGlobalWritableFileInfo>& files
+		= package->Info().GlobalWritableFileInfos();
+	for (int32 i = 0; const BGlobalWritableFileInfo* file = files.ItemAt(i);
+		i++) {
+		if (file->IsIncluded() && !_contentPaths.Add(file->Path()))
+			throw std::bad_alloc();
+	}
+}
+
+
 /*static*/ BString
 CommitTransactionHandler::_GetPath(const FSUtils::Entry& entry,
 	const BString& fallback)
@@ -65,6 +65,7 @@ private:
 			typedef FSUtils::RelativePath RelativePath;
 
 			struct TransactionIssueBuilder;
+			struct WritableFilesExtractor;
 
 private:
 			void				_GetPackagesToDeactivate(
@@ -76,10 +77,13 @@ private:
 			void				_RemovePackagesToDeactivate();
 			void				_AddPackagesToActivate();
 
+			void				_ExtractGlobalWritableFiles();
 			void				_PreparePackageToActivate(Package* package);
 			void				_AddGroup(Package* package,
 									const BString& groupName);
 			void				_AddUser(Package* package, const BUser& user);
+			void				_OpenWritableFilesDirectory(
+									Package* package);
 			void				_AddGlobalWritableFiles(Package* package);
 			void				_AddGlobalWritableFile(Package* package,
 									const BGlobalWritableFileInfo& file,
@@ -147,6 +151,10 @@ private:
 			void				_AddIssue(
 									const TransactionIssueBuilder& builder);
 
+	static	void				_GetGlobalWritableFileContentPaths(
+									Package* package,
+									BStringList& _contentPaths);
+
 	static	BString				_GetPath(const FSUtils::Entry& entry,
 									const BString& fallback);
 
@@ -75,8 +75,9 @@ public:
 		switch (fType) {
 			case TYPE_CREATE:
 			{
-				status_t error = BRemoveEngine().RemoveEntry(
-					Entry(fFromPath.c_str()));
+				status_t error = BRemoveEngine(
+						BRemoveEngine::REMOVE_CONCURRENTLY)
+					.RemoveEntry(Entry(fFromPath.c_str()));
 				if (error != B_OK) {
 					ERROR("Failed to remove \"%s\": %s\n", fFromPath.c_str(),
 						strerror(error));
@@ -91,7 +92,8 @@ public:
 
 				status_t error = BCopyEngine(
 						BCopyEngine::COPY_RECURSIVELY
-							| BCopyEngine::UNLINK_DESTINATION)
+							| BCopyEngine::UNLINK_DESTINATION
+							| BCopyEngine::COPY_CONCURRENTLY)
 					.CopyEntry(fToPath.c_str(), fFromPath.c_str());
 				if (error != B_OK) {
 					ERROR("Failed to copy \"%s\" to \"%s\": %s\n",
@@ -16,6 +16,9 @@
 
 #include <stdio.h>
 
+#include <algorithm>
+
+#include <Autolock.h>
 #include <Directory.h>
 #include <Message.h>
 #include <Path.h>
@@ -32,6 +35,12 @@ namespace BPrivate {
 namespace Storage {
 namespace Mime {
 
+static const int32 kMaxWorkerCount = 8;
+	// upper limit for the number of threads updating entries concurrently
+static const size_t kMaxQueuedEntries = 1024;
+	// if that many entries are waiting, directories are processed inline
+
+
 /*!	\class MimeUpdateThread
 	\brief RegistrarThread class implementing the common functionality of
 	update_mime_info() and create_app_meta_mime()
@@ -59,7 +68,12 @@ MimeUpdateThread::MimeUpdateThread(const char *name, int32 priority,
 	fRecursive(recursive),
 	fForce(force),
 	fReplyee(replyee),
-	fStatus(root ? B_OK : B_BAD_VALUE)
+	fStatus(root ? B_OK : B_BAD_VALUE),
+	fLock("mime update thread"),
+	fQueueSemaphore(-1),
+	fPendingEntries(0),
+	fWorkerCount(1),
+	fWorkerStatus(B_OK)
 {
 }
 
@@ -103,8 +117,12 @@ MimeUpdateThread::ThreadFunction()
 	// don't run into troubles
 	try {
 		// Do the updates
-		if (!err)
-			err = UpdateEntry(&fRoot);
+		if (!err) {
+			if (fRecursive && CanUpdateConcurrently())
+				err = UpdateConcurrently();
+			else
+				err = UpdateEntry(&fRoot);
+		}
 	} catch (...) {
 		err = B_ERROR;
 	}
@@ -135,6 +153,19 @@ MimeUpdateThread::ThreadFunction()
 }
 
 
+/*! \brief Returns whether DoMimeUpdate() may be called for several entries
+	at the same time.
+
+	If so, recursive updates are distributed over a number of worker threads.
+	The default implementation returns \c false.
+*/
+bool
+MimeUpdateThread::CanUpdateConcurrently() const
+{
+	return false;
+}
+
+
 /*! \brief Returns true if the given device supports attributes, false
 	if not (or if an error occurs while determining).
 
@@ -151,6 +182,8 @@ MimeUpdateThread::ThreadFunction()
 bool
 MimeUpdateThread::DeviceSupportsAttributes(dev_t device)
 {
+	BAutolock _(fLock);
+
 	// See if an entry for this device already exists
 	std::list< std::pair<dev_t,bool> >::iterator i;
 	for (i = fAttributeSupportList.begin();
@@ -234,6 +267,190 @@ MimeUpdateThread::UpdateEntry(const entry_ref *ref)
 	return err;
 }
 
+
+/*! \brief Recursively updates \c fRoot using a pool of worker threads.
+
+	The calling thread takes part in the work as well. Each directory found
+	adds its children to a shared queue that the workers pick up entries from.
+	The first error encountered stops the update, like it does in
+	UpdateEntry().
+*/
+status_t
+MimeUpdateThread::UpdateConcurrently()
+{
+	system_info info;
+	if (get_system_info(&info) == B_OK)
+		fWorkerCount = std::min((int32)info.cpu_count, kMaxWorkerCount);
+	if (fWorkerCount < 2)
+		return UpdateEntry(&fRoot);
+
+	fQueueSemaphore = create_sem(0, "mime update queue");
+	if (fQueueSemaphore < 0)
+		return UpdateEntry(&fRoot);
+
+	thread_info threadInfo;
+	int32 priority = B_NORMAL_PRIORITY;
+	if (get_thread_info(find_thread(NULL), &threadInfo) == B_OK)
+		priority = threadInfo.priority;
+
+	fWorkerStatus = B_OK;
+	QueueEntry(&fRoot);
+
+	thread_id threads[kMaxWorkerCount];
+	int32 threadCount = 0;
+	for (int32 i = 1; i < fWorkerCount; i++) {
+		thread_id thread = spawn_thread(&WorkerEntryFunction,
+			"mime update worker", priority, this);
+		if (thread < 0)
+			break;
+		threads[threadCount++] = thread;
+		resume_thread(thread);
+	}
+
+	Worker();
+
+	for (int32 i = 0; i < threadCount; i++) {
+		status_t result;
+		wait_for_thread(threads[i], &result);
+	}
+
+	delete_sem(fQueueSemaphore);
+	fQueueSemaphore = -1;
+
+	return fWorkerStatus;
+}
+
+
+status_t
+MimeUpdateThread::WorkerEntryFunction(void *data)
+{
+	return ((MimeUpdateThread*)data)->Worker();
+}
+
+
+/*! \brief Processes queued entries until all of them are done.
+*/
+status_t
+MimeUpdateThread::Worker()
+{
+	while (true) {
+		status_t err = acquire_sem(fQueueSemaphore);
+		if (err == B_INTERRUPTED)
+			continue;
+		if (err != B_OK)
+			return err;
+
+		entry_ref ref;
+		{
+			BAutolock _(fLock);
+			if (fQueue.empty()) {
+				// all entries are done
+				return B_OK;
+			}
+			ref = fQueue.front();
+			fQueue.pop_front();
+		}
+
+		// Once an error occurred, the remaining entries are just dropped
+		err = atomic_get(&fWorkerStatus);
+		if (!err) {
+			try {
+				err = UpdateQueuedEntry(&ref);
+			} catch (...) {
+				err = B_ERROR;
+			}
+		}
+
+		QueuedEntryDone(err);
+	}
+}
+
+
+/*! \brief Updates the given entry and queues its children, if it is a
+	directory.
+
+	This is the concurrent counterpart of UpdateEntry().
+*/
+status_t
+MimeUpdateThread::UpdateQueuedEntry(const entry_ref *ref)
+{
+	if (fShouldExit)
+		return B_CANCELED;
+
+	if (!device_is_root_device(ref->device)
+		&& !DeviceSupportsAttributes(ref->device)) {
+		return B_OK;
+	}
+
+	// R5 appears to ignore whether or not the update succeeds.
+	bool entryIsDir = false;
+	DoMimeUpdate(ref, &entryIsDir);
+	if (!entryIsDir)
+		return B_OK;
+
+	BDirectory dir;
+	status_t err = dir.SetTo(ref);
+	if (err != B_OK)
+		return err;
+
+	entry_ref childRef;
+	while ((err = dir.GetNextRef(&childRef)) == B_OK) {
+		bool queueFull;
+		{
+			BAutolock _(fLock);
+			queueFull = fQueue.size() >= kMaxQueuedEntries;
+		}
+
+		// Don't let the queue grow without bounds for huge directories;
+		// if the other workers are busy enough, just do the work here.
+		if (queueFull)
+			err = UpdateQueuedEntry(&childRef);
+		else
+			QueueEntry(&childRef);
+
+		if (err != B_OK)
+			return err;
+	}
+
+	// If we've come to the end of the directory listing, it's not an error.
+	if (err == B_ENTRY_NOT_FOUND)
+		err = B_OK;
+
+	return err;
+}
+
+
+void
+MimeUpdateThread::QueueEntry(const entry_ref *ref)
+{
+	atomic_add(&fPendingEntries, 1);
+
+	{
+		BAutolock _(fLock);
+		fQueue.push_back(*ref);
+	}
+
+	release_sem(fQueueSemaphore);
+}
+
+
+/*! \brief Must be called for each queued entry once it has been processed.
+
+	Records the first error that occurred, and wakes up all workers when the
+	last pending entry is done, so that they can quit.
+*/
+void
+MimeUpdateThread::QueuedEntryDone(status_t error)
+{
+	if (error != B_OK)
+		atomic_test_and_set(&fWorkerStatus, error, B_OK);
+
+	if (atomic_add(&fPendingEntries, -1) == 1) {
+		// the queue is empty now, and no one is going to add anything to it
+		release_sem_etc(fQueueSemaphore, fWorkerCount, 0);
+	}
+}
+
 }	// namespace Mime
 }	// namespace Storage
 }	// namespace BPrivate
@@ -11,8 +11,10 @@
 #define _MIME_UPDATE_THREAD_H
 
 #include <Entry.h>
+#include <Locker.h>
 #include <SupportDefs.h>
 
+#include <deque>
 #include <list>
 #include <utility>
 
@@ -39,6 +41,7 @@ public:
 protected:
 	virtual status_t ThreadFunction();
 	virtual status_t DoMimeUpdate(const entry_ref *entry, bool *entryIsDir) = 0;
+	virtual bool CanUpdateConcurrently() const;
 
 	Database* fDatabase;
 	const entry_ref fRoot;
@@ -52,8 +55,23 @@ private:
 	std::list< std::pair<dev_t, bool> > fAttributeSupportList;
 
 	status_t UpdateEntry(const entry_ref *ref);
-	
+
+	status_t UpdateConcurrently();
+	static status_t WorkerEntryFunction(void *data);
+	status_t Worker();
+	status_t UpdateQueuedEntry(const entry_ref *ref);
+	void QueueEntry(const entry_ref *ref);
+	void QueuedEntryDone(status_t error);
+
 	status_t fStatus;
+
+	BLocker fLock;
+		// guards fAttributeSupportList and fQueue
+	std::deque<entry_ref> fQueue;
+	sem_id fQueueSemaphore;
+	int32 fPendingEntries;
+	int32 fWorkerCount;
+	status_t fWorkerStatus;
 };
 
 }	// namespace Mime
@@ -50,6 +50,16 @@ UpdateMimeInfoThread::DoMimeUpdate(const entry_ref* entry, bool* _entryIsDir)
 }
 
 
+/*!	\brief The MimeInfoUpdater only holds the database lock while accessing
+	the database, so several entries can be updated at the same time.
+*/
+bool
+UpdateMimeInfoThread::CanUpdateConcurrently() const
+{
+	return true;
+}
+
+
 }	// namespace Mime
 }	// namespace Storage
 }	// namespace BPrivate
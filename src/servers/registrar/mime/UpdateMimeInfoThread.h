@@ -33,6 +33,7 @@ public:
 
 	virtual	status_t			DoMimeUpdate(const entry_ref* entry,
 									bool* _entryIsDir);
+	virtual	bool				CanUpdateConcurrently() const;
 
 private:
 			MimeInfoUpdater		fUpdater;
@@ -754,6 +754,7 @@ IORequest::Init(off_t offset, generic_size_t firstVecOffset,
 	fBuffer->SetVecs(firstVecOffset, vecs, count, length, flags);
 
 	fOwner = NULL;
+	fScheduledTime = 0;
 	fOffset = offset;
 	fLength = length;
 	fRelativeParentOffset = 0;
@@ -1404,6 +1405,7 @@ IORequest::Dump() const
 	kprintf("io_request at %p\n", this);
 
 	kprintf("  owner:             %p\n", fOwner);
+	kprintf("  scheduled:         %" B_PRId64 "\n", fScheduledTime);
 	kprintf("  parent:            %p\n", fParent);
 	kprintf("  status:            %s\n", strerror(fStatus));
 	kprintf("  mutex:             %p\n", &fLock);
@@ -0,0 +1,892 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	An I/O scheduler for devices that can process many requests at once.
+
+	Requests are queued per CPU by ScheduleRequest(), so that submitting
+	threads never contend for the scheduler lock. The scheduler thread moves
+	them to the request owner of their team, and passes operations to the
+	driver as long as there are free operations, instead of waiting for a
+	whole batch to finish like IOSchedulerSimple does.
+
+	Reads and VIP requests form the synchronous class, writes the asynchronous
+	one. Synchronous requests are preferred, but after kMaxSyncDispatches
+	in a row, an asynchronous one gets its turn. Within a class, the teams
+	share the bandwidth according to the I/O priority of their threads: each
+	team accumulates a virtual time that advances by the bytes dispatched for
+	it, scaled by its weight, and the team with the lowest virtual time goes
+	next. A request whose deadline has passed is dispatched before anything
+	else.
+*/
+
+
+#include "IOSchedulerDeadline.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include <cpu.h>
+#include <smp.h>
+#include <team.h>
+#include <thread.h>
+#include <util/AutoLock.h>
+
+#include "IOSchedulerRoster.h"
+
+
+//#define TRACE_IO_SCHEDULER
+#ifdef TRACE_IO_SCHEDULER
+#	define TRACE(x...) dprintf(x)
+#else
+#	define TRACE(x...) ;
+#endif
+
+
+static const bigtime_t kSyncDeadline = 100000;
+static const bigtime_t kAsyncDeadline = 1000000;
+static const int32 kMaxSyncDispatches = 16;
+
+
+struct IOSchedulerDeadline::TeamOwner : IORequestOwner {
+	IORequestList	async_requests;
+		// the synchronous ones are in IORequestOwner::requests
+	uint64			virtual_time;
+	TeamOwner*		team_link;
+
+			IORequestList&		Requests(int32 requestClass)
+									{ return requestClass == SYNC_CLASS
+										? requests : async_requests; }
+
+			bool				IsBusy() const
+									{ return IsActive()
+										|| !async_requests.IsEmpty(); }
+};
+
+
+struct IOSchedulerDeadline::TeamOwnerHashDefinition {
+	typedef team_id		KeyType;
+	typedef TeamOwner	ValueType;
+
+	size_t HashKey(team_id key) const			{ return key; }
+	size_t Hash(const TeamOwner* value) const	{ return value->team; }
+	bool Compare(team_id key, const TeamOwner* value) const
+		{ return value->team == key; }
+	TeamOwner*& GetLink(TeamOwner* value) const
+		{ return value->team_link; }
+};
+
+struct IOSchedulerDeadline::TeamOwnerHashTable
+		: BOpenHashTable<TeamOwnerHashDefinition, false> {
+};
+
+
+struct IOSchedulerDeadline::SubmissionQueue {
+	spinlock		lock;
+	IORequestList	requests;
+
+	SubmissionQueue()
+	{
+		B_INITIALIZE_SPINLOCK(&lock);
+	}
+} CACHE_LINE_ALIGN;
+
+
+IOSchedulerDeadline::IOSchedulerDeadline(DMAResource* resource)
+	:
+	IOScheduler(resource),
+	fSchedulerThread(-1),
+	fRequestNotifierThread(-1),
+	fSubmissionQueues(NULL),
+	fSubmissionQueueCount(0),
+	fAllocatedTeamOwners(NULL),
+	fAllocatedTeamOwnerCount(0),
+	fTeamOwners(NULL),
+	fBlockSize(0),
+	fQuantum(0),
+	fVirtualTime(0),
+	fPendingOperations(0),
+	fSyncDispatches(0),
+	fExpiredDispatches(0),
+	fTerminating(false)
+{
+	mutex_init(&fLock, "I/O scheduler");
+	B_INITIALIZE_SPINLOCK(&fFinisherLock);
+
+	fSchedulerCondition.Init(this, "I/O scheduler work");
+	fFinishedRequestCondition.Init(this, "I/O finished request");
+
+	memset(fDispatched, 0, sizeof(fDispatched));
+	memset(fLatencyHistogram, 0, sizeof(fLatencyHistogram));
+}
+
+
+IOSchedulerDeadline::~IOSchedulerDeadline()
+{
+	// shutdown threads
+	MutexLocker locker(fLock);
+	InterruptsSpinLocker finisherLocker(fFinisherLock);
+	fTerminating = true;
+
+	fSchedulerCondition.NotifyAll();
+	fFinishedRequestCondition.NotifyAll();
+
+	finisherLocker.Unlock();
+	locker.Unlock();
+
+	if (fSchedulerThread >= 0)
+		wait_for_thread(fSchedulerThread, NULL);
+
+	if (fRequestNotifierThread >= 0)
+		wait_for_thread(fRequestNotifierThread, NULL);
+
+	// destroy our belongings
+	mutex_lock(&fLock);
+	mutex_destroy(&fLock);
+
+	while (IOOperation* operation = fUnusedOperations.RemoveHead())
+		delete operation;
+
+	delete[] fSubmissionQueues;
+	delete fTeamOwners;
+	delete[] fAllocatedTeamOwners;
+}
+
+
+status_t
+IOSchedulerDeadline::Init(const char* name)
+{
+	status_t error = IOScheduler::Init(name);
+	if (error != B_OK)
+		return error;
+
+	size_t count = fDMAResource != NULL ? fDMAResource->BufferCount() : 16;
+	for (size_t i = 0; i < count; i++) {
+		IOOperation* operation = new(std::nothrow) IOOperation;
+		if (operation == NULL)
+			return B_NO_MEMORY;
+
+		fUnusedOperations.Add(operation);
+	}
+
+	if (fDMAResource != NULL)
+		fBlockSize = fDMAResource->BlockSize();
+	if (fBlockSize == 0)
+		fBlockSize = 512;
+
+	fQuantum = fBlockSize * 256;
+
+	fSubmissionQueueCount = smp_get_num_cpus();
+	fSubmissionQueues
+		= new(std::nothrow) SubmissionQueue[fSubmissionQueueCount];
+	if (fSubmissionQueues == NULL)
+		return B_NO_MEMORY;
+
+	fAllocatedTeamOwnerCount = team_max_teams();
+	fAllocatedTeamOwners
+		= new(std::nothrow) TeamOwner[fAllocatedTeamOwnerCount];
+	if (fAllocatedTeamOwners == NULL)
+		return B_NO_MEMORY;
+
+	for (int32 i = 0; i < fAllocatedTeamOwnerCount; i++) {
+		TeamOwner& owner = fAllocatedTeamOwners[i];
+		owner.team = -1;
+		owner.thread = -1;
+		owner.priority = B_NORMAL_PRIORITY;
+		owner.virtual_time = 0;
+		fUnusedTeamOwners.Add(&owner);
+	}
+
+	fTeamOwners = new(std::nothrow) TeamOwnerHashTable;
+	if (fTeamOwners == NULL)
+		return B_NO_MEMORY;
+
+	error = fTeamOwners->Init(fAllocatedTeamOwnerCount);
+	if (error != B_OK)
+		return error;
+
+	// start threads
+	char buffer[B_OS_NAME_LENGTH];
+	strlcpy(buffer, name, sizeof(buffer));
+	strlcat(buffer, " scheduler ", sizeof(buffer));
+	size_t nameLength = strlen(buffer);
+	snprintf(buffer + nameLength, sizeof(buffer) - nameLength, "%" B_PRId32,
+		fID);
+	fSchedulerThread = spawn_kernel_thread(&_SchedulerThread, buffer,
+		B_NORMAL_PRIORITY + 2, (void *)this);
+	if (fSchedulerThread < B_OK)
+		return fSchedulerThread;
+
+	strlcpy(buffer, name, sizeof(buffer));
+	strlcat(buffer, " notifier ", sizeof(buffer));
+	nameLength = strlen(buffer);
+	snprintf(buffer + nameLength, sizeof(buffer) - nameLength, "%" B_PRId32,
+		fID);
+	fRequestNotifierThread = spawn_kernel_thread(&_RequestNotifierThread,
+		buffer, B_NORMAL_PRIORITY + 2, (void *)this);
+	if (fRequestNotifierThread < B_OK)
+		return fRequestNotifierThread;
+
+	resume_thread(fSchedulerThread);
+	resume_thread(fRequestNotifierThread);
+
+	return B_OK;
+}
+
+
+status_t
+IOSchedulerDeadline::ScheduleRequest(IORequest* request)
+{
+	TRACE("%p->IOSchedulerDeadline::ScheduleRequest(%p)\n", this, request);
+
+	IOBuffer* buffer = request->Buffer();
+
+	// TODO: it would be nice to be able to lock the memory later, but we can't
+	// easily do it in the I/O scheduler without being able to asynchronously
+	// lock memory (via another thread or a dedicated call).
+
+	if (buffer->IsVirtual()) {
+		status_t status = buffer->LockMemory(request->TeamID(),
+			request->IsWrite());
+		if (status != B_OK) {
+			request->SetStatusAndNotify(status);
+			return status;
+		}
+	}
+
+	request->SetScheduledTime(system_time());
+
+	// The request may already be finished when we return from queuing it.
+	IOSchedulerRoster::Default()->Notify(IO_SCHEDULER_REQUEST_SCHEDULED, this,
+		request);
+
+	InterruptsLocker interruptsLocker;
+	SubmissionQueue& queue
+		= fSubmissionQueues[smp_get_current_cpu() % fSubmissionQueueCount];
+	SpinLocker queueLocker(queue.lock);
+	queue.requests.Add(request);
+	queueLocker.Unlock();
+	interruptsLocker.Unlock();
+
+	fSchedulerCondition.NotifyAll();
+
+	return B_OK;
+}
+
+
+/*!	Must be called with \c fLock held. Only requests none of which has been
+	passed to the driver yet can be aborted.
+*/
+void
+IOSchedulerDeadline::AbortRequest(IORequest* request, status_t status)
+{
+	TeamOwner* owner = static_cast<TeamOwner*>(request->Owner());
+	if (owner == NULL || request->RemainingBytes() != request->Length())
+		return;
+
+	// TODO: Abort requests that are already partially in progress, too.
+	owner->Requests(_RequestClass(request)).Remove(request);
+	request->SetOwner(NULL);
+
+	if (!owner->IsBusy()) {
+		fActiveTeamOwners.Remove(owner);
+		fUnusedTeamOwners.Add(owner);
+	}
+
+	request->SetStatusAndNotify(status);
+}
+
+
+void
+IOSchedulerDeadline::OperationCompleted(IOOperation* operation,
+	status_t status, generic_size_t transferredBytes)
+{
+	InterruptsSpinLocker _(fFinisherLock);
+
+	// finish operation only once
+	if (operation->Status() <= 0)
+		return;
+
+	operation->SetStatus(status);
+
+	// set the bytes transferred (of the net data)
+	generic_size_t partialBegin
+		= operation->OriginalOffset() - operation->Offset();
+	operation->SetTransferredBytes(
+		transferredBytes > partialBegin ? transferredBytes - partialBegin : 0);
+
+	fCompletedOperations.Add(operation);
+	fSchedulerCondition.NotifyAll();
+}
+
+
+void
+IOSchedulerDeadline::Dump() const
+{
+	kprintf("IOSchedulerDeadline at %p\n", this);
+	kprintf("  DMA resource:       %p\n", fDMAResource);
+	kprintf("  pending operations: %" B_PRId32 "\n", fPendingOperations);
+	kprintf("  virtual time:       %" B_PRIu64 "\n", fVirtualTime);
+	kprintf("  dispatched:         %" B_PRId64 " sync, %" B_PRId64 " async, %"
+		B_PRId64 " after their deadline\n", fDispatched[SYNC_CLASS],
+		fDispatched[ASYNC_CLASS], fExpiredDispatches);
+
+	kprintf("  active request owners:");
+	for (RequestOwnerList::ConstIterator it = fActiveTeamOwners.GetIterator();
+			IORequestOwner* owner = it.Next();) {
+		kprintf(" %p (team %" B_PRId32 ", vtime %" B_PRIu64 ")", owner,
+			owner->team, static_cast<TeamOwner*>(owner)->virtual_time);
+	}
+	kprintf("\n");
+
+	for (int32 requestClass = 0; requestClass < CLASS_COUNT; requestClass++) {
+		kprintf("  %s request latencies:\n",
+			requestClass == SYNC_CLASS ? "sync" : "async");
+		for (int32 i = 0; i < HISTOGRAM_BUCKETS; i++) {
+			uint32 count = fLatencyHistogram[requestClass][i];
+			if (count == 0)
+				continue;
+
+			kprintf("    %s %9" B_PRId64 " us: %" B_PRIu32 "\n",
+				i < HISTOGRAM_BUCKETS - 1 ? "<" : ">=",
+				i < HISTOGRAM_BUCKETS - 1 ? (int64)2 << i : (int64)1 << i,
+				count);
+		}
+	}
+}
+
+
+/*static*/ int32
+IOSchedulerDeadline::_RequestClass(IORequest* request)
+{
+	if (request->IsWrite() && (request->Flags() & B_VIP_IO_REQUEST) == 0)
+		return ASYNC_CLASS;
+	return SYNC_CLASS;
+}
+
+
+/*static*/ bigtime_t
+IOSchedulerDeadline::_Deadline(IORequest* request, int32 requestClass)
+{
+	// VIP requests are needed to free memory; they are always overdue
+	if ((request->Flags() & B_VIP_IO_REQUEST) != 0)
+		return request->ScheduledTime();
+
+	return request->ScheduledTime()
+		+ (requestClass == SYNC_CLASS ? kSyncDeadline : kAsyncDeadline);
+}
+
+
+/*!	Must not be called with the fLock held. */
+void
+IOSchedulerDeadline::_Finisher()
+{
+	while (true) {
+		InterruptsSpinLocker locker(fFinisherLock);
+		IOOperation* operation = fCompletedOperations.RemoveHead();
+		if (operation == NULL)
+			return;
+
+		locker.Unlock();
+
+		TRACE("IOSchedulerDeadline::_Finisher(): operation: %p\n", operation);
+
+		bool operationFinished = operation->Finish();
+
+		IOSchedulerRoster::Default()->Notify(IO_SCHEDULER_OPERATION_FINISHED,
+			this, operation->Parent(), operation);
+			// Notify for every time the operation is passed to the I/O hook,
+			// not only when it is fully finished.
+
+		if (!operationFinished) {
+			TRACE("  operation: %p not finished yet\n", operation);
+			MutexLocker _(fLock);
+			operation->SetTransferredBytes(0);
+			operation->Parent()->Owner()->operations.Add(operation);
+			fPendingOperations--;
+			continue;
+		}
+
+		// notify request and remove operation
+		IORequest* request = operation->Parent();
+
+		generic_size_t operationOffset
+			= operation->OriginalOffset() - request->Offset();
+		request->OperationFinished(operation, operation->Status(),
+			operation->TransferredBytes() < operation->OriginalLength(),
+			operation->Status() == B_OK
+				? operationOffset + operation->OriginalLength()
+				: operationOffset);
+
+		// recycle the operation
+		MutexLocker _(fLock);
+		if (fDMAResource != NULL)
+			fDMAResource->RecycleBuffer(operation->Buffer());
+
+		fPendingOperations--;
+		fUnusedOperations.Add(operation);
+
+		// If the request is done, we need to perform its notifications.
+		if (request->IsFinished()) {
+			if (request->Status() == B_OK && request->RemainingBytes() > 0) {
+				// The request has been processed OK so far, but it isn't really
+				// finished yet.
+				request->SetUnfinished();
+			} else
+				_RequestDone(request);
+		}
+	}
+}
+
+
+/*!	Called with \c fFinisherLock held.
+*/
+bool
+IOSchedulerDeadline::_FinisherWorkPending()
+{
+	return !fCompletedOperations.IsEmpty();
+}
+
+
+/*!	Moves the requests from the per-CPU submission queues to their owners.
+	Returns whether there were any.
+*/
+bool
+IOSchedulerDeadline::_FetchSubmittedRequests()
+{
+	bool fetched = false;
+
+	for (int32 i = 0; i < fSubmissionQueueCount; i++) {
+		SubmissionQueue& queue = fSubmissionQueues[i];
+		if (queue.requests.IsEmpty())
+			continue;
+
+		IORequestList requests;
+		InterruptsSpinLocker queueLocker(queue.lock);
+		requests.MoveFrom(&queue.requests);
+		queueLocker.Unlock();
+
+		MutexLocker locker(fLock);
+		while (IORequest* request = requests.RemoveHead()) {
+			_AddRequest(request);
+			fetched = true;
+		}
+	}
+
+	return fetched;
+}
+
+
+/*!	Must be called with \c fLock held. */
+void
+IOSchedulerDeadline::_AddRequest(IORequest* request)
+{
+	TeamOwner* owner = _GetTeamOwner(request->TeamID());
+	if (owner == NULL) {
+		panic("IOSchedulerDeadline: Out of request owners!\n");
+		request->SetStatusAndNotify(B_NO_MEMORY);
+		return;
+	}
+
+	bool wasBusy = owner->IsBusy();
+	request->SetOwner(owner);
+	owner->Requests(_RequestClass(request)).Add(request);
+
+	int32 priority = thread_get_io_priority(request->ThreadID());
+	if (priority >= 0)
+		owner->priority = priority;
+
+	if (!wasBusy) {
+		// A team that has been idle doesn't get to spend the bandwidth it
+		// didn't use in the meantime.
+		if (owner->virtual_time < fVirtualTime)
+			owner->virtual_time = fVirtualTime;
+		fActiveTeamOwners.Add(owner);
+	}
+}
+
+
+/*!	Must be called with \c fLock held. */
+IOSchedulerDeadline::TeamOwner*
+IOSchedulerDeadline::_GetTeamOwner(team_id team)
+{
+	// lookup in table
+	TeamOwner* owner = fTeamOwners->Lookup(team);
+	if (owner != NULL) {
+		if (!owner->IsBusy())
+			fUnusedTeamOwners.Remove(owner);
+		return owner;
+	}
+
+	// not in table -- take the owner that has been unused the longest
+	owner = static_cast<TeamOwner*>(fUnusedTeamOwners.RemoveHead());
+	if (owner == NULL)
+		return NULL;
+
+	if (owner->team >= 0)
+		fTeamOwners->RemoveUnchecked(owner);
+
+	owner->team = team;
+	owner->priority = B_NORMAL_PRIORITY;
+	owner->virtual_time = fVirtualTime;
+	fTeamOwners->InsertUnchecked(owner);
+
+	return owner;
+}
+
+
+/*!	Chooses the owner, and the class of its requests, that should be
+	dispatched next. Returns \c NULL, if there are no requests.
+	Must be called with \c fLock held.
+*/
+IOSchedulerDeadline::TeamOwner*
+IOSchedulerDeadline::_NextTeamOwner(int32& requestClass)
+{
+	bigtime_t now = system_time();
+
+	TeamOwner* expiredOwner = NULL;
+	int32 expiredClass = SYNC_CLASS;
+	bigtime_t earliestDeadline = now + 1;
+	TeamOwner* nextOwner[CLASS_COUNT] = { NULL, NULL };
+
+	for (RequestOwnerList::Iterator it = fActiveTeamOwners.GetIterator();
+			IORequestOwner* requestOwner = it.Next();) {
+		TeamOwner* owner = static_cast<TeamOwner*>(requestOwner);
+
+		// Unfinished operations of an earlier dispatch are always continued
+		// first.
+		if (!owner->operations.IsEmpty()) {
+			requestClass = SYNC_CLASS;
+			return owner;
+		}
+
+		for (int32 i = 0; i < CLASS_COUNT; i++) {
+			IORequest* request = owner->Requests(i).Head();
+			if (request == NULL)
+				continue;
+
+			// the requests of an owner are kept in FIFO order, so only the
+			// first one can be the most overdue
+			bigtime_t deadline = _Deadline(request, i);
+			if (deadline < earliestDeadline) {
+				earliestDeadline = deadline;
+				expiredOwner = owner;
+				expiredClass = i;
+			}
+
+			if (nextOwner[i] == NULL
+				|| owner->virtual_time < nextOwner[i]->virtual_time) {
+				nextOwner[i] = owner;
+			}
+		}
+	}
+
+	if (expiredOwner != NULL) {
+		fExpiredDispatches++;
+		requestClass = expiredClass;
+	} else if (nextOwner[SYNC_CLASS] != NULL
+		&& (nextOwner[ASYNC_CLASS] == NULL
+			|| fSyncDispatches < kMaxSyncDispatches)) {
+		requestClass = SYNC_CLASS;
+	} else if (nextOwner[ASYNC_CLASS] != NULL)
+		requestClass = ASYNC_CLASS;
+	else
+		return NULL;
+
+	if (requestClass == SYNC_CLASS)
+		fSyncDispatches++;
+	else
+		fSyncDispatches = 0;
+
+	return expiredOwner != NULL ? expiredOwner : nextOwner[requestClass];
+}
+
+
+/*!	Prepares up to a quantum of operations for the given owner and request
+	class, and charges them to the owner's virtual time. Returns \c false,
+	when no more operations can be prepared at the moment.
+	Must be called with \c fLock held.
+*/
+bool
+IOSchedulerDeadline::_PrepareRequestOperations(TeamOwner* owner,
+	int32 requestClass, IOOperationList& operations)
+{
+	off_t quantum = fQuantum;
+	off_t usedBandwidth = 0;
+	bool resourcesAvailable = true;
+
+	// There might still be unfinished operations.
+	while (quantum >= (off_t)fBlockSize) {
+		IOOperation* operation = owner->operations.RemoveHead();
+		if (operation == NULL)
+			break;
+
+		operations.Add(operation);
+		quantum -= operation->Length();
+		usedBandwidth += operation->Length();
+	}
+
+	IORequestList& requests = owner->Requests(requestClass);
+	while (resourcesAvailable && quantum >= (off_t)fBlockSize) {
+		IORequest* request = requests.Head();
+		if (request == NULL)
+			break;
+
+		if (fDMAResource != NULL) {
+			while (quantum >= (off_t)fBlockSize
+				&& request->RemainingBytes() > 0) {
+				IOOperation* operation = fUnusedOperations.RemoveHead();
+				if (operation == NULL) {
+					resourcesAvailable = false;
+					break;
+				}
+
+				status_t status = fDMAResource->TranslateNext(request,
+					operation, quantum);
+				if (status != B_OK) {
+					operation->SetParent(NULL);
+					fUnusedOperations.Add(operation);
+
+					// B_BUSY means some resource (DMABuffers or
+					// DMABounceBuffers) was temporarily unavailable. That's
+					// OK, we'll retry later.
+					if (status == B_BUSY)
+						resourcesAvailable = false;
+					else
+						AbortRequest(request, status);
+					break;
+				}
+
+				operations.Add(operation);
+				quantum -= operation->Length();
+				usedBandwidth += operation->Length();
+			}
+		} else {
+			// TODO: If the device has block size restrictions, we might need
+			// to use a bounce buffer.
+			IOOperation* operation = fUnusedOperations.RemoveHead();
+			if (operation == NULL) {
+				resourcesAvailable = false;
+				break;
+			}
+
+			status_t status = operation->Prepare(request);
+			if (status != B_OK) {
+				operation->SetParent(NULL);
+				fUnusedOperations.Add(operation);
+				AbortRequest(request, status);
+				continue;
+			}
+
+			operation->SetOriginalRange(request->Offset(), request->Length());
+			request->Advance(request->Length());
+
+			operations.Add(operation);
+			quantum -= operation->Length();
+			usedBandwidth += operation->Length();
+		}
+
+		if (request->Owner() == NULL) {
+			// the request has been aborted
+			continue;
+		}
+
+		if (request->RemainingBytes() == 0 || request->Status() <= 0) {
+			// If the request has been completed, move it to the completed
+			// list, so we don't pick it up again.
+			requests.Remove(request);
+			owner->completed_requests.Add(request);
+		} else if (resourcesAvailable && quantum >= (off_t)fBlockSize) {
+			// The request couldn't be translated any further, and neither be
+			// aborted; try again later.
+			resourcesAvailable = false;
+		}
+	}
+
+	// The owner usually is the one with the lowest virtual time, so its
+	// virtual time is the one newly active owners start with.
+	if (owner->virtual_time > fVirtualTime)
+		fVirtualTime = owner->virtual_time;
+
+	// Charge the owner for what it got; the lower its I/O priority, the
+	// faster its virtual time passes.
+	int32 weight = std::max(owner->priority, (int32)1);
+	owner->virtual_time += usedBandwidth * B_NORMAL_PRIORITY / weight;
+
+	fDispatched[requestClass] += usedBandwidth;
+
+	return resourcesAvailable;
+}
+
+
+/*!	Removes a finished request from its owner, and hands it over for
+	notification. Must be called with \c fLock held.
+*/
+void
+IOSchedulerDeadline::_RequestDone(IORequest* request)
+{
+	TeamOwner* owner = static_cast<TeamOwner*>(request->Owner());
+	if (owner->completed_requests.Contains(request))
+		owner->completed_requests.Remove(request);
+	else
+		owner->Requests(_RequestClass(request)).Remove(request);
+	request->SetOwner(NULL);
+
+	if (!owner->IsBusy()) {
+		fActiveTeamOwners.Remove(owner);
+		fUnusedTeamOwners.Add(owner);
+	}
+
+	_RecordLatency(request);
+
+	if (request->HasCallbacks()) {
+		// The request has callbacks that may take some time to perform, so
+		// we hand it over to the request notifier.
+		fFinishedRequests.Add(request);
+		fFinishedRequestCondition.NotifyAll();
+	} else {
+		// No callbacks -- finish the request right now.
+		IOSchedulerRoster::Default()->Notify(IO_SCHEDULER_REQUEST_FINISHED,
+			this, request);
+		request->NotifyFinished();
+	}
+}
+
+
+/*!	Adds the time since the request has been scheduled to the latency
+	histogram of its class. Bucket \c i counts the requests that took less
+	than 2^(i + 1) microseconds.
+*/
+void
+IOSchedulerDeadline::_RecordLatency(IORequest* request)
+{
+	bigtime_t latency = system_time() - request->ScheduledTime();
+
+	int32 bucket = 0;
+	while (latency > 1 && bucket < HISTOGRAM_BUCKETS - 1) {
+		latency >>= 1;
+		bucket++;
+	}
+
+	fLatencyHistogram[_RequestClass(request)][bucket]++;
+}
+
+
+status_t
+IOSchedulerDeadline::_Scheduler()
+{
+	while (!fTerminating) {
+		// Register with the condition variable before looking for work, so
+		// that we cannot miss any.
+		ConditionVariableEntry entry;
+		fSchedulerCondition.Add(&entry);
+
+		bool didWork = _FetchSubmittedRequests();
+
+		InterruptsSpinLocker finisherLocker(fFinisherLock);
+		if (_FinisherWorkPending()) {
+			finisherLocker.Unlock();
+			_Finisher();
+			didWork = true;
+		} else
+			finisherLocker.Unlock();
+
+		// Dispatch as much as we have operations for, without waiting for
+		// the previous ones to finish.
+		MutexLocker locker(fLock);
+
+		IOOperationList operations;
+		while (!fTerminating) {
+			int32 requestClass;
+			TeamOwner* owner = _NextTeamOwner(requestClass);
+			if (owner == NULL)
+				break;
+
+			if (!_PrepareRequestOperations(owner, requestClass, operations))
+				break;
+		}
+
+		int32 operationCount = 0;
+		for (IOOperationList::Iterator it = operations.GetIterator();
+				it.Next() != NULL;) {
+			operationCount++;
+		}
+		fPendingOperations += operationCount;
+
+		locker.Unlock();
+
+		while (IOOperation* operation = operations.RemoveHead()) {
+			TRACE("IOSchedulerDeadline::_Scheduler(): calling callback for "
+				"operation: %p\n", operation);
+
+			IOSchedulerRoster::Default()->Notify(IO_SCHEDULER_OPERATION_STARTED,
+				this, operation->Parent(), operation);
+
+			fIOCallback(fIOCallbackData, operation);
+
+			_Finisher();
+			didWork = true;
+		}
+
+		if (!didWork && !fTerminating)
+			entry.Wait(B_CAN_INTERRUPT);
+	}
+
+	return B_OK;
+}
+
+
+/*static*/ status_t
+IOSchedulerDeadline::_SchedulerThread(void *_self)
+{
+	IOSchedulerDeadline *self = (IOSchedulerDeadline *)_self;
+	return self->_Scheduler();
+}
+
+
+status_t
+IOSchedulerDeadline::_RequestNotifier()
+{
+	while (true) {
+		MutexLocker locker(fLock);
+
+		// get a request
+		IORequest* request = fFinishedRequests.RemoveHead();
+
+		if (request == NULL) {
+			if (fTerminating)
+				return B_OK;
+
+			ConditionVariableEntry entry;
+			fFinishedRequestCondition.Add(&entry);
+
+			locker.Unlock();
+
+			entry.Wait();
+			continue;
+		}
+
+		locker.Unlock();
+
+		IOSchedulerRoster::Default()->Notify(IO_SCHEDULER_REQUEST_FINISHED,
+			this, request);
+
+		// notify the request
+		request->NotifyFinished();
+	}
+
+	// never can get here
+	return B_OK;
+}
+
+
+/*static*/ status_t
+IOSchedulerDeadline::_RequestNotifierThread(void *_self)
+{
+	IOSchedulerDeadline *self = (IOSchedulerDeadline*)_self;
+	return self->_RequestNotifier();
+}
@@ -0,0 +1,108 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef IO_SCHEDULER_DEADLINE_H
+#define IO_SCHEDULER_DEADLINE_H
+
+
+#include <KernelExport.h>
+
+#include <condition_variable.h>
+#include <lock.h>
+#include <util/OpenHashTable.h>
+
+#include "dma_resources.h"
+#include "IOScheduler.h"
+
+
+class IOSchedulerDeadline : public IOScheduler {
+public:
+								IOSchedulerDeadline(DMAResource* resource);
+	virtual						~IOSchedulerDeadline();
+
+	virtual	status_t			Init(const char* name);
+
+	virtual	status_t			ScheduleRequest(IORequest* request);
+
+	virtual	void				AbortRequest(IORequest* request,
+									status_t status = B_CANCELED);
+	virtual	void				OperationCompleted(IOOperation* operation,
+									status_t status,
+									generic_size_t transferredBytes);
+									// called by the driver when the operation
+									// has been completed successfully or failed
+									// for some reason
+
+	virtual	void				Dump() const;
+
+private:
+			struct TeamOwner;
+			struct TeamOwnerHashDefinition;
+			struct TeamOwnerHashTable;
+			struct SubmissionQueue;
+
+			typedef DoublyLinkedList<IORequestOwner> RequestOwnerList;
+
+			enum {
+				SYNC_CLASS = 0,
+				ASYNC_CLASS,
+				CLASS_COUNT
+			};
+
+			enum {
+				HISTOGRAM_BUCKETS = 24
+					// the last bucket collects everything above 2^22 usecs
+			};
+
+	static	int32				_RequestClass(IORequest* request);
+	static	bigtime_t			_Deadline(IORequest* request,
+									int32 requestClass);
+
+			void				_Finisher();
+			bool				_FinisherWorkPending();
+			bool				_FetchSubmittedRequests();
+			void				_AddRequest(IORequest* request);
+			TeamOwner*			_GetTeamOwner(team_id team);
+			TeamOwner*			_NextTeamOwner(int32& requestClass);
+			bool				_PrepareRequestOperations(TeamOwner* owner,
+									int32 requestClass,
+									IOOperationList& operations);
+			void				_RequestDone(IORequest* request);
+			void				_RecordLatency(IORequest* request);
+			status_t			_Scheduler();
+	static	status_t			_SchedulerThread(void* self);
+			status_t			_RequestNotifier();
+	static	status_t			_RequestNotifierThread(void* self);
+
+private:
+			spinlock			fFinisherLock;
+			mutex				fLock;
+			thread_id			fSchedulerThread;
+			thread_id			fRequestNotifierThread;
+			SubmissionQueue*	fSubmissionQueues;
+			int32				fSubmissionQueueCount;
+			IORequestList		fFinishedRequests;
+			ConditionVariable	fSchedulerCondition;
+			ConditionVariable	fFinishedRequestCondition;
+			IOOperationList		fUnusedOperations;
+			IOOperationList		fCompletedOperations;
+			TeamOwner*			fAllocatedTeamOwners;
+			int32				fAllocatedTeamOwnerCount;
+			RequestOwnerList	fActiveTeamOwners;
+			RequestOwnerList	fUnusedTeamOwners;
+			TeamOwnerHashTable*	fTeamOwners;
+			generic_size_t		fBlockSize;
+			off_t				fQuantum;
+			uint64				fVirtualTime;
+			int32				fPendingOperations;
+			int32				fSyncDispatches;
+			int64				fDispatched[CLASS_COUNT];
+			int64				fExpiredDispatches;
+			uint32				fLatencyHistogram[CLASS_COUNT]
+									[HISTOGRAM_BUCKETS];
+	volatile bool				fTerminating;
+};
+
+
+#endif	// IO_SCHEDULER_DEADLINE_H
@@ -6,8 +6,14 @@
 
 #include "IOSchedulerRoster.h"
 
+#include <string.h>
+
+#include <driver_settings.h>
 #include <util/AutoLock.h>
 
+#include "IOSchedulerDeadline.h"
+#include "IOSchedulerSimple.h"
+
 
 /*static*/ IOSchedulerRoster IOSchedulerRoster::sDefaultInstance;
 
@@ -72,6 +78,25 @@ IOSchedulerRoster::NextID()
 }
 
 
+IOScheduler*
+IOSchedulerRoster::CreateScheduler(DMAResource* resource)
+{
+	bool useDeadline = false;
+	if (void* handle = load_driver_settings("kernel")) {
+		const char* scheduler = get_driver_parameter(handle, "io_scheduler",
+			NULL, NULL);
+		useDeadline = scheduler != NULL && strcmp(scheduler, "deadline") == 0;
+
+		unload_driver_settings(handle);
+	}
+
+	if (useDeadline)
+		return new(std::nothrow) IOSchedulerDeadline(resource);
+
+	return new(std::nothrow) IOSchedulerSimple(resource);
+}
+
+
 IOSchedulerRoster::IOSchedulerRoster()
 	:
 	fNextID(1),
@@ -48,6 +48,11 @@ public:
 
 			int32				NextID();
 
+			IOScheduler*		CreateScheduler(DMAResource* resource);
+									// creates an uninitialized scheduler of
+									// the type chosen by the "io_scheduler"
+									// kernel setting
+
 private:
 								IOSchedulerRoster();
 								~IOSchedulerRoster();
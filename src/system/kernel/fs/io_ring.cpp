@@ -0,0 +1,620 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	I/O rings: batched, asynchronous I/O for userland.
+
+	The submissions of a ring are executed by kernel threads that run in the
+	team that created the ring, so that they can use the team's file
+	descriptors and access its memory just like the syscall the operation
+	stands for. The threads are started on demand, up to the maximum number
+	of parallel operations the ring has been created with.
+*/
+
+
+#include <fs/io_ring.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <new>
+#include <signal.h>
+#include <string.h>
+
+#include <condition_variable.h>
+#include <fs/fd.h>
+#include <io_ring_defs.h>
+#include <kernel.h>
+#include <ksignal.h>
+#include <lock.h>
+#include <Referenceable.h>
+#include <team.h>
+#include <thread.h>
+#include <util/AutoLock.h>
+#include <vfs.h>
+#include <vm/vm.h>
+
+
+//#define TRACE_IO_RING
+#ifdef TRACE_IO_RING
+#	define TRACE(x...) dprintf("io_ring: " x)
+#else
+#	define TRACE(x...) do {} while (false)
+#endif
+
+
+static const uint32 kDefaultMaxWorkers = 16;
+
+
+struct IORing : BReferenceable {
+								IORing(team_id team);
+								~IORing();
+
+			status_t			Init(uint32 entries, uint32 maxWorkers,
+									void** _userAddress);
+
+			team_id				Team() const { return fTeam; }
+			area_id				UserArea() const { return fUserArea; }
+			uint32				MaxWorkers() const { return fMaxWorkers; }
+			uint32				CompletionEntries() const
+									{ return fCompletionMask + 1; }
+
+			int32				Submit(uint32 count);
+			status_t			WaitForCompletions(uint32 count, uint32 flags,
+									bigtime_t timeout);
+			void				Close();
+
+private:
+			uint32				_FreeCompletions() const;
+			void				_StartWorkersIfNeeded();
+			void				_Complete(const io_ring_submission& submission,
+									int64 result);
+
+	static	status_t			_WorkerEntry(void* data);
+			void				_Worker();
+
+private:
+			mutex				fLock;
+			ConditionVariable	fWorkCondition;
+			ConditionVariable	fCompletionCondition;
+			team_id				fTeam;
+			area_id				fArea;
+			area_id				fUserArea;
+			io_ring_header*		fHeader;
+			io_ring_submission*	fSubmissions;
+			io_ring_completion*	fCompletions;
+			uint32				fSubmissionMask;
+			uint32				fCompletionMask;
+			uint32				fSubmissionHead;
+			uint32				fCompletionTail;
+
+			io_ring_submission*	fPending;
+			uint32				fPendingHead;
+			uint32				fPendingCount;
+			uint32				fInFlight;
+				// pending and running operations
+
+			uint32				fMaxWorkers;
+			uint32				fWorkerCount;
+			uint32				fBusyWorkers;
+			bool				fClosing;
+};
+
+
+struct FDPutter {
+	FDPutter(file_descriptor* descriptor)
+		:
+		descriptor(descriptor)
+	{
+	}
+
+	~FDPutter()
+	{
+		if (descriptor != NULL)
+			put_fd(descriptor);
+	}
+
+	file_descriptor*	descriptor;
+};
+
+
+static uint32
+round_up_to_power_of_two(uint32 value)
+{
+	uint32 result = 1;
+	while (result < value)
+		result <<= 1;
+	return result;
+}
+
+
+static int64
+execute_submission(const io_ring_submission& submission)
+{
+	void* address = (void*)(addr_t)submission.address;
+	size_t length = (size_t)submission.length;
+
+	switch (submission.opcode) {
+		case IO_RING_OP_NOP:
+			return B_OK;
+		case IO_RING_OP_READ:
+			return _user_read(submission.fd, submission.offset, address,
+				length);
+		case IO_RING_OP_WRITE:
+			return _user_write(submission.fd, submission.offset, address,
+				length);
+		case IO_RING_OP_FSYNC:
+			return _user_fsync(submission.fd);
+		case IO_RING_OP_ACCEPT:
+			return _user_accept(submission.fd, (struct sockaddr*)address,
+				(socklen_t*)(addr_t)submission.extra);
+		case IO_RING_OP_SEND:
+			return _user_send(submission.fd, address, length,
+				submission.op_flags);
+		case IO_RING_OP_RECV:
+			return _user_recv(submission.fd, address, length,
+				submission.op_flags);
+	}
+
+	return B_BAD_VALUE;
+}
+
+
+// #pragma mark - IORing
+
+
+IORing::IORing(team_id team)
+	:
+	fTeam(team),
+	fArea(-1),
+	fUserArea(-1),
+	fHeader(NULL),
+	fPending(NULL),
+	fPendingHead(0),
+	fPendingCount(0),
+	fInFlight(0),
+	fMaxWorkers(0),
+	fWorkerCount(0),
+	fBusyWorkers(0),
+	fClosing(false)
+{
+	mutex_init(&fLock, "io ring");
+	fWorkCondition.Init(this, "io ring work");
+	fCompletionCondition.Init(this, "io ring completion");
+}
+
+
+IORing::~IORing()
+{
+	if (fArea >= 0)
+		delete_area(fArea);
+
+	delete[] fPending;
+	mutex_destroy(&fLock);
+}
+
+
+status_t
+IORing::Init(uint32 entries, uint32 maxWorkers, void** _userAddress)
+{
+	if (entries == 0 || entries > IO_RING_MAX_ENTRIES)
+		return B_BAD_VALUE;
+
+	uint32 submissionEntries = round_up_to_power_of_two(entries);
+	uint32 completionEntries = submissionEntries * 2;
+
+	if (maxWorkers == 0)
+		maxWorkers = kDefaultMaxWorkers;
+	fMaxWorkers = min_c(maxWorkers, IO_RING_MAX_WORKERS);
+
+	fPending = new(std::nothrow) io_ring_submission[completionEntries];
+	if (fPending == NULL)
+		return B_NO_MEMORY;
+
+	size_t submissionOffset = ROUNDUP(sizeof(io_ring_header), 64);
+	size_t completionOffset = submissionOffset
+		+ submissionEntries * sizeof(io_ring_submission);
+	size_t size = PAGE_ALIGN(completionOffset
+		+ completionEntries * sizeof(io_ring_completion));
+
+	// The area is wired, so that the kernel can access the queues at any
+	// time; the team gets a clone of it
+
+	virtual_address_restrictions virtualRestrictions = {};
+	virtualRestrictions.address_specification = B_ANY_KERNEL_ADDRESS;
+	physical_address_restrictions physicalRestrictions = {};
+	fArea = create_area_etc(B_SYSTEM_TEAM, "io ring", size, B_FULL_LOCK,
+		B_KERNEL_READ_AREA | B_KERNEL_WRITE_AREA, 0, 0, &virtualRestrictions,
+		&physicalRestrictions, (void**)&fHeader);
+	if (fArea < 0)
+		return fArea;
+
+	fSubmissionMask = submissionEntries - 1;
+	fCompletionMask = completionEntries - 1;
+	fSubmissionHead = 0;
+	fCompletionTail = 0;
+
+	memset(fHeader, 0, sizeof(io_ring_header));
+	fHeader->sq_mask = fSubmissionMask;
+	fHeader->sq_offset = submissionOffset;
+	fHeader->cq_mask = fCompletionMask;
+	fHeader->cq_offset = completionOffset;
+
+	fSubmissions = (io_ring_submission*)((uint8*)fHeader + submissionOffset);
+	fCompletions = (io_ring_completion*)((uint8*)fHeader + completionOffset);
+
+	fUserArea = vm_clone_area(fTeam, "io ring", _userAddress,
+		B_RANDOMIZED_ANY_ADDRESS, B_READ_AREA | B_WRITE_AREA,
+		REGION_NO_PRIVATE_MAP, fArea, true);
+	if (fUserArea < 0)
+		return fUserArea;
+
+	return B_OK;
+}
+
+
+/*!	Takes over up to \a count submissions from the submission queue, and
+	starts executing them.
+	Only as many submissions are taken as there are free entries in the
+	completion queue, so that every operation is guaranteed to find room for
+	its result.
+*/
+int32
+IORing::Submit(uint32 count)
+{
+	MutexLocker locker(fLock);
+
+	if (fClosing)
+		return B_FILE_ERROR;
+
+	// the application may write anything into the shared area, so we only
+	// trust our own copies of the indices
+	uint32 tail = atomic_get((int32*)&fHeader->sq_tail);
+	uint32 available = tail - fSubmissionHead;
+	if (available > fSubmissionMask + 1)
+		return B_BAD_VALUE;
+
+	count = min_c(count, min_c(available, _FreeCompletions()));
+
+	for (uint32 i = 0; i < count; i++) {
+		uint32 index = (fPendingHead + fPendingCount) & fCompletionMask;
+		fPending[index] = fSubmissions[fSubmissionHead & fSubmissionMask];
+		fPendingCount++;
+		fSubmissionHead++;
+	}
+
+	fInFlight += count;
+	atomic_set((int32*)&fHeader->sq_head, fSubmissionHead);
+
+	if (count > 0) {
+		_StartWorkersIfNeeded();
+		fWorkCondition.NotifyAll();
+	}
+
+	TRACE("submitted %" B_PRIu32 ", %" B_PRIu32 " in flight\n", count,
+		fInFlight);
+	return count;
+}
+
+
+//!	Waits until at least \a count completions are waiting in the queue.
+status_t
+IORing::WaitForCompletions(uint32 count, uint32 flags, bigtime_t timeout)
+{
+	MutexLocker locker(fLock);
+
+	if (count > fCompletionMask + 1)
+		return B_BAD_VALUE;
+
+	while (true) {
+		uint32 head = atomic_get((int32*)&fHeader->cq_head);
+		if (fCompletionTail - head >= count || fClosing)
+			return B_OK;
+
+		if (fInFlight == 0) {
+			// nothing that could ever complete
+			return B_BAD_VALUE;
+		}
+
+		ConditionVariableEntry entry;
+		fCompletionCondition.Add(&entry);
+		locker.Unlock();
+
+		status_t status = entry.Wait(flags | B_CAN_INTERRUPT, timeout);
+		if (status != B_OK)
+			return status;
+
+		locker.Lock();
+	}
+}
+
+
+void
+IORing::Close()
+{
+	MutexLocker locker(fLock);
+
+	fClosing = true;
+
+	// operations that haven't been started yet are dropped; those that are
+	// running will be finished by their workers
+	fInFlight -= fPendingCount;
+	fPendingCount = 0;
+
+	fWorkCondition.NotifyAll();
+	fCompletionCondition.NotifyAll(B_FILE_ERROR);
+
+	locker.Unlock();
+
+	// the team might already be gone, or have deleted its clone itself
+	vm_delete_area(fTeam, fUserArea, true);
+}
+
+
+uint32
+IORing::_FreeCompletions() const
+{
+	uint32 head = atomic_get((int32*)&fHeader->cq_head);
+	uint32 used = min_c(fCompletionTail - head, fCompletionMask + 1);
+
+	uint32 free = fCompletionMask + 1 - used;
+	return free > fInFlight ? free - fInFlight : 0;
+}
+
+
+void
+IORing::_StartWorkersIfNeeded()
+{
+	uint32 needed = min_c(fBusyWorkers + fPendingCount, fMaxWorkers);
+
+	while (fWorkerCount < needed) {
+		// the worker keeps a reference to the ring while it is running
+		AcquireReference();
+
+		thread_id thread = spawn_kernel_thread_etc(&_WorkerEntry,
+			"io ring worker", B_NORMAL_PRIORITY, this, fTeam);
+		if (thread < 0) {
+			ReleaseReference();
+			break;
+		}
+
+		fWorkerCount++;
+		resume_thread(thread);
+	}
+}
+
+
+void
+IORing::_Complete(const io_ring_submission& submission, int64 result)
+{
+	io_ring_completion& completion
+		= fCompletions[fCompletionTail & fCompletionMask];
+	completion.user_data = submission.user_data;
+	completion.result = result;
+
+	fCompletionTail++;
+	atomic_set((int32*)&fHeader->cq_tail, fCompletionTail);
+	fInFlight--;
+
+	fCompletionCondition.NotifyAll();
+}
+
+
+/*static*/ status_t
+IORing::_WorkerEntry(void* data)
+{
+	IORing* ring = (IORing*)data;
+	ring->_Worker();
+	ring->ReleaseReference();
+	return B_OK;
+}
+
+
+void
+IORing::_Worker()
+{
+	// The worker belongs to the application's team; only the team's death
+	// must interrupt it, other signals would never be handled
+	sigset_t signals = ~(sigset_t)0;
+	sigprocmask(SIG_SETMASK, &signals, NULL);
+
+	Thread* thread = thread_get_current_thread();
+	MutexLocker locker(fLock);
+
+	while (!fClosing) {
+		if ((thread->AllPendingSignals() & KILL_SIGNALS) != 0)
+			break;
+
+		if (fPendingCount == 0) {
+			ConditionVariableEntry entry;
+			fWorkCondition.Add(&entry);
+			locker.Unlock();
+
+			status_t status = entry.Wait(B_CAN_INTERRUPT);
+
+			locker.Lock();
+			if (status == B_INTERRUPTED)
+				break;
+			continue;
+		}
+
+		io_ring_submission submission = fPending[fPendingHead];
+		fPendingHead = (fPendingHead + 1) & fCompletionMask;
+		fPendingCount--;
+		fBusyWorkers++;
+		locker.Unlock();
+
+		int64 result = execute_submission(submission);
+
+		locker.Lock();
+		fBusyWorkers--;
+		if (fClosing)
+			break;
+
+		_Complete(submission, result);
+	}
+
+	fWorkerCount--;
+}
+
+
+// #pragma mark - file descriptor
+
+
+static status_t
+io_ring_close(struct file_descriptor* descriptor)
+{
+	IORing* ring = (IORing*)descriptor->cookie;
+	ring->Close();
+	return B_OK;
+}
+
+
+static void
+io_ring_free(struct file_descriptor* descriptor)
+{
+	IORing* ring = (IORing*)descriptor->cookie;
+	ring->ReleaseReference();
+}
+
+
+static struct fd_ops sIORingFDOps = {
+	NULL,	// fd_read
+	NULL,	// fd_write
+	NULL,	// fd_seek
+	NULL,	// fd_ioctl
+	NULL,	// fd_set_flags
+	NULL,	// fd_select
+	NULL,	// fd_deselect
+	NULL,	// fd_read_dir
+	NULL,	// fd_rewind_dir
+	NULL,	// fd_read_stat
+	NULL,	// fd_write_stat
+	&io_ring_close,
+	&io_ring_free
+};
+
+
+static status_t
+get_io_ring(int fd, file_descriptor*& descriptor, IORing*& ring)
+{
+	if (fd < 0)
+		return EBADF;
+
+	descriptor = get_fd(get_current_io_context(false), fd);
+	if (descriptor == NULL)
+		return EBADF;
+
+	if (descriptor->type != FDTYPE_IO_RING) {
+		put_fd(descriptor);
+		return B_BAD_VALUE;
+	}
+
+	ring = (IORing*)descriptor->cookie;
+	return B_OK;
+}
+
+
+// #pragma mark - syscalls
+
+
+int
+_user_create_io_ring(io_ring_params* userParams)
+{
+	io_ring_params params;
+	if (userParams == NULL || !IS_USER_ADDRESS(userParams)
+		|| user_memcpy(&params, userParams, sizeof(params)) != B_OK) {
+		return B_BAD_ADDRESS;
+	}
+
+	if (params.flags != 0)
+		return B_BAD_VALUE;
+
+	IORing* ring = new(std::nothrow) IORing(team_get_current_team_id());
+	if (ring == NULL)
+		return B_NO_MEMORY;
+	BReference<IORing> ringReference(ring, true);
+
+	void* address;
+	status_t status = ring->Init(params.submission_entries,
+		params.max_workers, &address);
+	if (status != B_OK) {
+		ring->Close();
+		return status;
+	}
+
+	params.submission_entries = ring->CompletionEntries() / 2;
+	params.completion_entries = ring->CompletionEntries();
+	params.max_workers = ring->MaxWorkers();
+	params.area = ring->UserArea();
+	params.address = address;
+
+	if (user_memcpy(userParams, &params, sizeof(params)) != B_OK) {
+		ring->Close();
+		return B_BAD_ADDRESS;
+	}
+
+	file_descriptor* descriptor = alloc_fd();
+	if (descriptor == NULL) {
+		ring->Close();
+		return B_NO_MEMORY;
+	}
+
+	descriptor->type = FDTYPE_IO_RING;
+	descriptor->ops = &sIORingFDOps;
+	descriptor->cookie = ring;
+	descriptor->open_mode = O_RDWR;
+
+	int fd = new_fd(get_current_io_context(false), descriptor);
+	if (fd < 0) {
+		ring->Close();
+		descriptor->ops = NULL;
+		put_fd(descriptor);
+		return fd;
+	}
+
+	// the descriptor owns the reference now
+	ringReference.Detach();
+
+	fd_set_close_on_exec(get_current_io_context(false), fd, true);
+	return fd;
+}
+
+
+/*!	Submits up to \a submitCount operations from the ring's submission queue,
+	and then waits until at least \a waitCount completions are available.
+	Returns the number of submitted operations.
+*/
+int32
+_user_io_ring_enter(int fd, uint32 submitCount, uint32 waitCount,
+	uint32 flags, bigtime_t timeout)
+{
+	file_descriptor* descriptor;
+	IORing* ring;
+	status_t status = get_io_ring(fd, descriptor, ring);
+	if (status != B_OK)
+		return status;
+	FDPutter _(descriptor);
+
+	// The workers run in the ring's team, and would use its descriptors and
+	// memory; a child that inherited the ring via fork() must not use it.
+	if (ring->Team() != team_get_current_team_id())
+		return B_NOT_ALLOWED;
+
+	int32 submitted = 0;
+	if (submitCount > 0) {
+		submitted = ring->Submit(submitCount);
+		if (submitted < 0)
+			return submitted;
+	}
+
+	if (waitCount > 0) {
+		flags &= B_RELATIVE_TIMEOUT | B_ABSOLUTE_TIMEOUT;
+		status = ring->WaitForCompletions(waitCount, flags, timeout);
+		if (status != B_OK && submitted == 0)
+			return status;
+	}
+
+	return submitted;
+}
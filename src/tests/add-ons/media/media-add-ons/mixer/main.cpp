@@ -265,7 +265,7 @@ MainWindow::MessageReceived(BMessage* message)
 			// FIXME handle gain
 			if (fInterpolate->Value() == B_CONTROL_ON) {
 				Interpolate sampler(media_raw_audio_format::B_AUDIO_FLOAT,
-					media_raw_audio_format::B_AUDIO_FLOAT);
+					media_raw_audio_format::B_AUDIO_FLOAT, irate);
 
 				// First call initializes the "old sample" in the interpolator.
 				// Since we do the interpolation on exactly one period of the
@@ -0,0 +1,178 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Measures how fast the mixer's inner loops are with each set of kernels
+	the CPU supports: a number of 44.1 kHz 16 bit stereo inputs is resampled
+	to 48 kHz, mixed, and converted to a 16 bit stereo output.
+*/
+
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <MediaDefs.h>
+#include <OS.h>
+
+#include <Interpolate.h>
+#include <MixerKernels.h>
+#include <Resampler.h>
+#include <WindowedSinc.h>
+
+
+extern const char* __progname;
+
+static const int32 kChannels = 2;
+static const int32 kInputFrames = 441;
+static const int32 kMixFrames = 480;
+	// 10 ms each
+static const int32 kIterations = 1000;
+static const int32 kAlgorithmCount = 3;
+static const char* const kAlgorithmNames[kAlgorithmCount] = {
+	"drop/repeat", "linear", "windowed sinc"
+};
+
+
+static Resampler*
+create_resampler(int32 algorithm, uint32 sourceFormat, uint32 destFormat,
+	int32 maxSourceCount)
+{
+	switch (algorithm) {
+		case 1:
+			return new Interpolate(sourceFormat, destFormat, maxSourceCount);
+		case 2:
+			return new WindowedSinc(sourceFormat, destFormat, maxSourceCount);
+		default:
+			return new Resampler(sourceFormat, destFormat);
+	}
+}
+
+
+/*!	Runs the mixer loop and returns the time it took. The output of the last
+	iteration is left in \a output.
+*/
+static bigtime_t
+run(int32 inputCount, int32 algorithm, const int16* input, int16* output)
+{
+	int32 resamplerCount = inputCount * kChannels;
+	Resampler** resamplers = new Resampler*[resamplerCount];
+	for (int32 i = 0; i < resamplerCount; i++) {
+		resamplers[i] = create_resampler(algorithm,
+			media_raw_audio_format::B_AUDIO_SHORT,
+			media_raw_audio_format::B_AUDIO_FLOAT, kInputFrames);
+	}
+	Resampler* outputResamplers[kChannels];
+	for (int32 i = 0; i < kChannels; i++) {
+		outputResamplers[i] = new Resampler(
+			media_raw_audio_format::B_AUDIO_FLOAT,
+			media_raw_audio_format::B_AUDIO_SHORT);
+	}
+
+	float* inputBuffer = new float[resamplerCount * kMixFrames];
+	float* mixBuffer = new float[kChannels * kMixFrames];
+	const mixer_kernels& kernels = get_mixer_kernels();
+	float gain = 1.0f / inputCount;
+
+	bigtime_t start = system_time();
+	for (int32 iteration = 0; iteration < kIterations; iteration++) {
+		// MixerInput::BufferReceived()
+		for (int32 i = 0; i < inputCount; i++) {
+			const int16* data = input + i * kInputFrames * kChannels;
+			for (int32 channel = 0; channel < kChannels; channel++) {
+				int32 index = i * kChannels + channel;
+				resamplers[index]->Resample(data + channel,
+					kChannels * sizeof(int16), kInputFrames,
+					inputBuffer + index * kMixFrames, sizeof(float),
+					kMixFrames, 1.0f);
+			}
+		}
+
+		// MixerCore::_MixThread()
+		memset(mixBuffer, 0, kChannels * kMixFrames * sizeof(float));
+		for (int32 channel = 0; channel < kChannels; channel++) {
+			for (int32 i = 0; i < inputCount; i++) {
+				kernels.mix(mixBuffer + channel * kMixFrames,
+					inputBuffer + (i * kChannels + channel) * kMixFrames, gain,
+					kMixFrames);
+			}
+			outputResamplers[channel]->Resample(
+				mixBuffer + channel * kMixFrames, sizeof(float), kMixFrames,
+				output + channel, kChannels * sizeof(int16), kMixFrames, 1.0f);
+		}
+	}
+	bigtime_t time = system_time() - start;
+
+	for (int32 i = 0; i < resamplerCount; i++)
+		delete resamplers[i];
+	delete[] resamplers;
+	for (int32 i = 0; i < kChannels; i++)
+		delete outputResamplers[i];
+	delete[] inputBuffer;
+	delete[] mixBuffer;
+
+	return time;
+}
+
+
+int
+main(int argc, char** argv)
+{
+	int32 inputCount = 16;
+	if (argc > 2 || (argc == 2 && (inputCount = atoi(argv[1])) <= 0)) {
+		fprintf(stderr, "usage: %s [input count]\n", __progname);
+		return 1;
+	}
+
+	int16* input = new int16[inputCount * kInputFrames * kChannels];
+	for (int32 i = 0; i < inputCount; i++) {
+		for (int32 frame = 0; frame < kInputFrames; frame++) {
+			for (int32 channel = 0; channel < kChannels; channel++) {
+				input[(i * kInputFrames + frame) * kChannels + channel]
+					= (int16)(20000 * sin(2 * M_PI * (220 + 110 * i + channel)
+						* frame / 44100.0));
+			}
+		}
+	}
+
+	int16 reference[kAlgorithmCount][kMixFrames * kChannels];
+	int16 output[kMixFrames * kChannels];
+
+	printf("%" B_PRId32 " inputs, %.0f ms of audio\n", inputCount,
+		kIterations * kMixFrames / 48.0);
+
+	int32 lastLevel = -1;
+	for (int32 level = MIXER_KERNELS_GENERIC; level <= MIXER_KERNELS_AVX2;
+			level++) {
+		select_mixer_kernels(level);
+		const mixer_kernels& kernels = get_mixer_kernels();
+		if (kernels.level == lastLevel)
+			break;
+		lastLevel = kernels.level;
+
+		for (int32 algorithm = 0; algorithm < kAlgorithmCount; algorithm++) {
+			int16* result = level == MIXER_KERNELS_GENERIC
+				? reference[algorithm] : output;
+			bigtime_t time = run(inputCount, algorithm, input, result);
+
+			int32 maxDifference = 0;
+			for (int32 i = 0; i < kMixFrames * kChannels; i++) {
+				int32 difference = abs(result[i] - reference[algorithm][i]);
+				if (difference > maxDifference)
+					maxDifference = difference;
+			}
+
+			printf("%-8s %-14s %8" B_PRId64 " us  %7.1fx real-time  "
+				"max. difference %" B_PRId32 "\n", kernels.name,
+				kAlgorithmNames[algorithm], time,
+				kIterations * kMixFrames * 1000000.0 / 48000 / time,
+				maxDifference);
+		}
+	}
+
+	delete[] input;
+	return 0;
+}
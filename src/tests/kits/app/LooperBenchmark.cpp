@@ -0,0 +1,132 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include <Looper.h>
+#include <Message.h>
+#include <Messenger.h>
+#include <OS.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+
+extern const char* __progname;
+
+static const int32 kDefaultMessageCount = 200000;
+static const int32 kMaxProducers = 8;
+
+static const uint32 kMsgCount = 'cnt ';
+
+
+class CountingLooper : public BLooper {
+public:
+	CountingLooper(sem_id doneSem, int32 expected)
+		:
+		BLooper("counting looper"),
+		fDoneSem(doneSem),
+		fExpected(expected),
+		fCount(0)
+	{
+	}
+
+	virtual void MessageReceived(BMessage* message)
+	{
+		if (message->what != kMsgCount) {
+			BLooper::MessageReceived(message);
+			return;
+		}
+
+		if (++fCount == fExpected)
+			release_sem(fDoneSem);
+	}
+
+private:
+	sem_id	fDoneSem;
+	int32	fExpected;
+	int32	fCount;
+};
+
+
+struct producer_args {
+	BMessenger	target;
+	int32		count;
+};
+
+
+static status_t
+producer_thread(void* _args)
+{
+	producer_args* args = (producer_args*)_args;
+	BMessage message(kMsgCount);
+
+	for (int32 i = 0; i < args->count; i++)
+		args->target.SendMessage(&message);
+
+	return B_OK;
+}
+
+
+static void
+run_benchmark(int32 producerCount, int32 messageCount)
+{
+	int32 perProducer = messageCount / producerCount;
+
+	sem_id doneSem = create_sem(0, "done");
+	CountingLooper* looper = new CountingLooper(doneSem,
+		perProducer * producerCount);
+	looper->Run();
+
+	producer_args args;
+	args.target = BMessenger(looper);
+	args.count = perProducer;
+
+	thread_id threads[kMaxProducers];
+	bigtime_t start = system_time();
+
+	for (int32 i = 0; i < producerCount; i++) {
+		threads[i] = spawn_thread(&producer_thread, "producer",
+			B_NORMAL_PRIORITY, &args);
+		resume_thread(threads[i]);
+	}
+
+	acquire_sem(doneSem);
+	bigtime_t time = system_time() - start;
+
+	for (int32 i = 0; i < producerCount; i++) {
+		status_t result;
+		wait_for_thread(threads[i], &result);
+	}
+
+	looper->Lock();
+	looper->Quit();
+	delete_sem(doneSem);
+
+	printf("%2" B_PRId32 " producers: %8" B_PRId32 " messages in %8" B_PRId64
+		" usecs, %10.0f messages/s\n", producerCount,
+		perProducer * producerCount, time,
+		time > 0 ? perProducer * producerCount * 1000000.0 / time : 0);
+}
+
+
+int
+main(int argc, char** argv)
+{
+	int32 messageCount = kDefaultMessageCount;
+	if (argc > 1)
+		messageCount = atol(argv[1]);
+	if (messageCount <= 0) {
+		fprintf(stderr, "usage: %s [message count]\n", __progname);
+		return 1;
+	}
+
+	static const int32 kProducerCounts[] = { 1, 2, 4, kMaxProducers };
+	for (size_t i = 0;
+			i < sizeof(kProducerCounts) / sizeof(kProducerCounts[0]); i++) {
+		run_benchmark(kProducerCounts[i], messageCount);
+	}
+
+	return 0;
+}
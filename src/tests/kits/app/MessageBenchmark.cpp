@@ -0,0 +1,143 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include <Message.h>
+#include <OS.h>
+#include <String.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+extern const char* __progname;
+
+static const int32 kDefaultIterations = 100000;
+
+
+static void
+add_fields(BMessage& message, int32 fieldCount)
+{
+	for (int32 i = 0; i < fieldCount; i++) {
+		char name[32];
+		snprintf(name, sizeof(name), "field%" B_PRId32, i);
+
+		switch (i % 3) {
+			case 0:
+				message.AddInt32(name, i);
+				break;
+			case 1:
+				message.AddString(name, "some string value");
+				break;
+			case 2:
+				message.AddRect(name, BRect(0, 0, i, i));
+				break;
+		}
+	}
+}
+
+
+static void
+print_result(const char* test, int32 fieldCount, int32 iterations,
+	bigtime_t time)
+{
+	printf("%-12s %4" B_PRId32 " fields: %8" B_PRId64 " usecs, %10.0f ops/s\n",
+		test, fieldCount, time, time > 0 ? iterations * 1000000.0 / time : 0);
+}
+
+
+static void
+benchmark_add(int32 fieldCount, int32 iterations)
+{
+	bigtime_t start = system_time();
+	for (int32 i = 0; i < iterations; i++) {
+		BMessage message('test');
+		add_fields(message, fieldCount);
+	}
+
+	print_result("add", fieldCount, iterations, system_time() - start);
+}
+
+
+static void
+benchmark_find(int32 fieldCount, int32 iterations)
+{
+	BMessage message('test');
+	add_fields(message, fieldCount);
+
+	char name[32];
+	snprintf(name, sizeof(name), "field%" B_PRId32, fieldCount - 1);
+
+	const void* data;
+	ssize_t size;
+	bigtime_t start = system_time();
+	for (int32 i = 0; i < iterations; i++) {
+		if (message.FindData(name, B_ANY_TYPE, &data, &size) != B_OK) {
+			fprintf(stderr, "%s: lookup of \"%s\" failed!\n", __progname,
+				name);
+			exit(1);
+		}
+	}
+
+	print_result("find", fieldCount, iterations, system_time() - start);
+}
+
+
+static void
+benchmark_flatten(int32 fieldCount, int32 iterations)
+{
+	BMessage message('test');
+	add_fields(message, fieldCount);
+
+	ssize_t size = message.FlattenedSize();
+	char* buffer = (char*)malloc(size);
+	if (buffer == NULL)
+		return;
+
+	bigtime_t start = system_time();
+	for (int32 i = 0; i < iterations; i++)
+		message.Flatten(buffer, size);
+
+	print_result("flatten", fieldCount, iterations, system_time() - start);
+
+	start = system_time();
+	for (int32 i = 0; i < iterations; i++) {
+		BMessage copy;
+		if (copy.Unflatten(buffer) != B_OK) {
+			fprintf(stderr, "%s: unflatten failed!\n", __progname);
+			exit(1);
+		}
+	}
+
+	print_result("unflatten", fieldCount, iterations, system_time() - start);
+	free(buffer);
+}
+
+
+int
+main(int argc, char** argv)
+{
+	int32 iterations = kDefaultIterations;
+	if (argc > 1)
+		iterations = atol(argv[1]);
+	if (iterations <= 0) {
+		fprintf(stderr, "usage: %s [iterations]\n", __progname);
+		return 1;
+	}
+
+	static const int32 kFieldCounts[] = { 1, 4, 16, 64 };
+	for (size_t i = 0; i < sizeof(kFieldCounts) / sizeof(kFieldCounts[0]);
+			i++) {
+		int32 fieldCount = kFieldCounts[i];
+		int32 count = iterations / fieldCount;
+
+		benchmark_add(fieldCount, count);
+		benchmark_find(fieldCount, iterations);
+		benchmark_flatten(fieldCount, count);
+	}
+
+	return 0;
+}
@@ -0,0 +1,404 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Measures how long it takes a buffer to get from a producer to a consumer,
+	and back to the producer's buffer group, once through the shared buffer
+	ring and once through the consumer's port.
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include <Application.h>
+#include <Buffer.h>
+#include <BufferConsumer.h>
+#include <BufferGroup.h>
+#include <BufferProducer.h>
+#include <MediaEventLooper.h>
+#include <MediaRoster.h>
+#include <TimeSource.h>
+
+
+static const int32 kIterations = 10000;
+static const size_t kBufferSize = 1024;
+
+
+static void
+init_format(media_format& format)
+{
+	format.type = B_MEDIA_RAW_AUDIO;
+	format.u.raw_audio = media_raw_audio_format::wildcard;
+	format.u.raw_audio.format = media_raw_audio_format::B_AUDIO_FLOAT;
+	format.u.raw_audio.channel_count = 2;
+	format.u.raw_audio.frame_rate = 48000;
+	format.u.raw_audio.byte_order = B_MEDIA_HOST_ENDIAN;
+	format.u.raw_audio.buffer_size = kBufferSize;
+}
+
+
+class Producer : public BBufferProducer, public BMediaEventLooper {
+public:
+	Producer()
+		:
+		BMediaNode("latency producer"),
+		BBufferProducer(B_MEDIA_RAW_AUDIO),
+		BMediaEventLooper()
+	{
+		fOutput.destination = media_destination::null;
+		init_format(fOutput.format);
+	}
+
+	bigtime_t* Measure(int32 count)
+	{
+		BBufferGroup group(kBufferSize, 1);
+		if (group.InitCheck() != B_OK)
+			return NULL;
+
+		bigtime_t* times = new bigtime_t[count];
+		for (int32 i = 0; i < count; i++) {
+			BBuffer* buffer = group.RequestBuffer(kBufferSize, 1000000);
+			if (buffer == NULL) {
+				delete[] times;
+				return NULL;
+			}
+
+			media_header* header = buffer->Header();
+			header->type = B_MEDIA_RAW_AUDIO;
+			header->size_used = kBufferSize;
+			header->start_time = 0;
+
+			bigtime_t start = system_time();
+			if (SendBuffer(buffer, fOutput.source, fOutput.destination)
+					!= B_OK) {
+				buffer->Recycle();
+				delete[] times;
+				return NULL;
+			}
+
+			// the group only has the one buffer, so this waits until the
+			// consumer has recycled it
+			buffer = group.RequestBuffer(kBufferSize, 1000000);
+			times[i] = system_time() - start;
+			if (buffer == NULL) {
+				delete[] times;
+				return NULL;
+			}
+			buffer->Recycle();
+		}
+
+		return times;
+	}
+
+	// BMediaNode
+	virtual BMediaAddOn* AddOn(int32* _internalID) const
+	{
+		return NULL;
+	}
+
+	virtual void NodeRegistered()
+	{
+		fOutput.node = Node();
+		fOutput.source.port = ControlPort();
+		fOutput.source.id = 0;
+		strcpy(fOutput.name, "latency output");
+		Run();
+	}
+
+	virtual status_t HandleMessage(int32 message, const void* data,
+		size_t size)
+	{
+		if (BBufferProducer::HandleMessage(message, data, size) == B_OK
+			|| BMediaEventLooper::HandleMessage(message, data, size) == B_OK) {
+			return B_OK;
+		}
+		return BMediaNode::HandleMessage(message, data, size);
+	}
+
+	// BMediaEventLooper
+	virtual void HandleEvent(const media_timed_event* event,
+		bigtime_t lateness, bool realTimeEvent)
+	{
+	}
+
+	// BBufferProducer
+	virtual status_t FormatSuggestionRequested(media_type type, int32 quality,
+		media_format* format)
+	{
+		init_format(*format);
+		return B_OK;
+	}
+
+	virtual status_t FormatProposal(const media_source& output,
+		media_format* format)
+	{
+		init_format(*format);
+		return B_OK;
+	}
+
+	virtual status_t FormatChangeRequested(const media_source& source,
+		const media_destination& destination, media_format* format,
+		int32* _deprecated)
+	{
+		return B_ERROR;
+	}
+
+	virtual status_t GetNextOutput(int32* cookie, media_output* _output)
+	{
+		if (*cookie != 0)
+			return B_BAD_INDEX;
+
+		*_output = fOutput;
+		(*cookie)++;
+		return B_OK;
+	}
+
+	virtual status_t DisposeOutputCookie(int32 cookie)
+	{
+		return B_OK;
+	}
+
+	virtual status_t SetBufferGroup(const media_source& source,
+		BBufferGroup* group)
+	{
+		return B_ERROR;
+	}
+
+	virtual status_t PrepareToConnect(const media_source& source,
+		const media_destination& destination, media_format* format,
+		media_source* _source, char* _name)
+	{
+		if (source != fOutput.source)
+			return B_MEDIA_BAD_SOURCE;
+
+		*_source = fOutput.source;
+		strcpy(_name, fOutput.name);
+		return B_OK;
+	}
+
+	virtual void Connect(status_t error, const media_source& source,
+		const media_destination& destination, const media_format& format,
+		char* _name)
+	{
+		if (error == B_OK) {
+			fOutput.destination = destination;
+			fOutput.format = format;
+		}
+	}
+
+	virtual void Disconnect(const media_source& source,
+		const media_destination& destination)
+	{
+		fOutput.destination = media_destination::null;
+	}
+
+	virtual void LateNoticeReceived(const media_source& source,
+		bigtime_t howLate, bigtime_t performanceTime)
+	{
+	}
+
+	virtual void EnableOutput(const media_source& source, bool enabled,
+		int32* _deprecated)
+	{
+	}
+
+private:
+	media_output	fOutput;
+};
+
+
+class Consumer : public BBufferConsumer, public BMediaEventLooper {
+public:
+	Consumer()
+		:
+		BMediaNode("latency consumer"),
+		BBufferConsumer(B_MEDIA_RAW_AUDIO),
+		BMediaEventLooper()
+	{
+		fInput.source = media_source::null;
+		init_format(fInput.format);
+	}
+
+	// BMediaNode
+	virtual BMediaAddOn* AddOn(int32* _internalID) const
+	{
+		return NULL;
+	}
+
+	virtual void NodeRegistered()
+	{
+		fInput.node = Node();
+		fInput.destination.port = ControlPort();
+		fInput.destination.id = 0;
+		strcpy(fInput.name, "latency input");
+		Run();
+	}
+
+	virtual status_t HandleMessage(int32 message, const void* data,
+		size_t size)
+	{
+		if (BBufferConsumer::HandleMessage(message, data, size) == B_OK
+			|| BMediaEventLooper::HandleMessage(message, data, size) == B_OK) {
+			return B_OK;
+		}
+		return BMediaNode::HandleMessage(message, data, size);
+	}
+
+	// BMediaEventLooper
+	virtual void HandleEvent(const media_timed_event* event,
+		bigtime_t lateness, bool realTimeEvent)
+	{
+	}
+
+	// BBufferConsumer
+	virtual status_t AcceptFormat(const media_destination& destination,
+		media_format* format)
+	{
+		return format->type == B_MEDIA_RAW_AUDIO ? B_OK : B_MEDIA_BAD_FORMAT;
+	}
+
+	virtual status_t GetNextInput(int32* cookie, media_input* _input)
+	{
+		if (*cookie != 0)
+			return B_BAD_INDEX;
+
+		*_input = fInput;
+		(*cookie)++;
+		return B_OK;
+	}
+
+	virtual void DisposeInputCookie(int32 cookie)
+	{
+	}
+
+	virtual void BufferReceived(BBuffer* buffer)
+	{
+		// hand it right back, only the transport is measured
+		buffer->Recycle();
+	}
+
+	virtual void ProducerDataStatus(const media_destination& destination,
+		int32 status, bigtime_t performanceTime)
+	{
+	}
+
+	virtual status_t GetLatencyFor(const media_destination& destination,
+		bigtime_t* _latency, media_node_id* _timeSource)
+	{
+		*_latency = 0;
+		*_timeSource = TimeSource()->ID();
+		return B_OK;
+	}
+
+	virtual status_t Connected(const media_source& source,
+		const media_destination& destination, const media_format& format,
+		media_input* _input)
+	{
+		fInput.source = source;
+		fInput.format = format;
+		*_input = fInput;
+		return B_OK;
+	}
+
+	virtual void Disconnected(const media_source& source,
+		const media_destination& destination)
+	{
+		fInput.source = media_source::null;
+	}
+
+	virtual status_t FormatChanged(const media_source& source,
+		const media_destination& destination, int32 changeTag,
+		const media_format& format)
+	{
+		return B_OK;
+	}
+
+private:
+	media_input		fInput;
+};
+
+
+static bool
+run(BMediaRoster* roster, Producer* producer, Consumer* consumer,
+	const char* name)
+{
+	media_output output;
+	media_input input;
+	int32 count;
+	if (roster->GetFreeOutputsFor(producer->Node(), &output, 1, &count) != B_OK
+		|| count != 1
+		|| roster->GetFreeInputsFor(consumer->Node(), &input, 1, &count)
+			!= B_OK
+		|| count != 1) {
+		fprintf(stderr, "could not get the nodes' inputs and outputs\n");
+		return false;
+	}
+
+	media_format format;
+	init_format(format);
+	status_t status = roster->Connect(output.source, input.destination,
+		&format, &output, &input);
+	if (status != B_OK) {
+		fprintf(stderr, "could not connect the nodes: %s\n", strerror(status));
+		return false;
+	}
+
+	bigtime_t* times = producer->Measure(kIterations);
+
+	roster->Disconnect(output.node.node, output.source, input.node.node,
+		input.destination);
+
+	if (times == NULL) {
+		fprintf(stderr, "%s: sending the buffers failed\n", name);
+		return false;
+	}
+
+	std::sort(times, times + kIterations);
+	printf("%-5s  min %5" B_PRIdBIGTIME " us  median %5" B_PRIdBIGTIME " us  "
+		"99%% %5" B_PRIdBIGTIME " us  max %6" B_PRIdBIGTIME " us\n", name,
+		times[0], times[kIterations / 2], times[kIterations * 99 / 100],
+		times[kIterations - 1]);
+
+	delete[] times;
+	return true;
+}
+
+
+int
+main()
+{
+	BApplication app("application/x-vnd.Haiku-BufferLatency");
+
+	status_t status;
+	BMediaRoster* roster = BMediaRoster::Roster(&status);
+	if (roster == NULL) {
+		fprintf(stderr, "media server not available: %s\n", strerror(status));
+		return 1;
+	}
+
+	Producer* producer = new Producer;
+	Consumer* consumer = new Consumer;
+	if (roster->RegisterNode(producer) != B_OK
+		|| roster->RegisterNode(consumer) != B_OK) {
+		fprintf(stderr, "could not register the nodes\n");
+		return 1;
+	}
+
+	printf("round trip of %" B_PRId32 " buffers\n", kIterations);
+
+	unsetenv("MEDIA_NO_BUFFER_RINGS");
+	bool success = run(roster, producer, consumer, "ring");
+
+	setenv("MEDIA_NO_BUFFER_RINGS", "1", 1);
+	success &= run(roster, producer, consumer, "port");
+
+	producer->Release();
+	consumer->Release();
+	return success ? 0 : 1;
+}
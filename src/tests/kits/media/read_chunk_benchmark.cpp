@@ -0,0 +1,191 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Measures how fast the chunks of all tracks of a file can be read with
+	BMediaTrack::ReadChunk(): from a single thread taking turns between the
+	tracks, from one thread per track, and from one thread per track while
+	the first track is read slowly, as a player's would be.
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <Entry.h>
+#include <MediaFile.h>
+#include <MediaTrack.h>
+#include <OS.h>
+
+
+extern const char* __progname;
+
+static const int32 kMaxTracks = 16;
+static const bigtime_t kSlowTrackDelay = 2000;
+
+static int32 sStopSlowTrack;
+
+
+struct track_reader {
+	BMediaTrack*	track;
+	bigtime_t		delay;
+	int64			bytes;
+	int64			chunks;
+	bigtime_t		time;
+	bool			done;
+};
+
+
+static bool
+read_chunk(track_reader& reader)
+{
+	char* buffer;
+	int32 size;
+	media_header header;
+	if (reader.track->ReadChunk(&buffer, &size, &header) != B_OK) {
+		reader.done = true;
+		return false;
+	}
+
+	reader.bytes += size;
+	reader.chunks++;
+
+	if (reader.delay > 0)
+		snooze(reader.delay);
+	return true;
+}
+
+
+static status_t
+read_track(void* data)
+{
+	track_reader& reader = *(track_reader*)data;
+
+	bigtime_t start = system_time();
+	while (read_chunk(reader)) {
+		if (reader.delay > 0 && atomic_get(&sStopSlowTrack) != 0)
+			break;
+	}
+	reader.time = system_time() - start;
+
+	return B_OK;
+}
+
+
+static void
+print_result(const char* name, track_reader* readers, int32 count,
+	bigtime_t time, int32 skip)
+{
+	int64 bytes = 0;
+	int64 chunks = 0;
+	for (int32 i = skip; i < count; i++) {
+		bytes += readers[i].bytes;
+		chunks += readers[i].chunks;
+	}
+
+	printf("%-12s %8" B_PRId64 " chunks  %7.1f MB/s  %9.0f chunks/s\n", name,
+		chunks, time > 0 ? (double)bytes / time : 0.0,
+		time > 0 ? chunks * 1000000.0 / time : 0.0);
+}
+
+
+static void
+benchmark(const entry_ref& ref, const char* name, bool threaded,
+	bigtime_t slowTrackDelay)
+{
+	BMediaFile file(&ref);
+	status_t status = file.InitCheck();
+	if (status != B_OK) {
+		fprintf(stderr, "%s: could not open file: %s\n", __progname,
+			strerror(status));
+		exit(1);
+	}
+
+	track_reader readers[kMaxTracks];
+	int32 count = min_c(file.CountTracks(), kMaxTracks);
+	for (int32 i = 0; i < count; i++) {
+		readers[i].track = file.TrackAt(i);
+		readers[i].delay = i == 0 ? slowTrackDelay : 0;
+		readers[i].bytes = 0;
+		readers[i].chunks = 0;
+		readers[i].time = 0;
+		readers[i].done = readers[i].track == NULL;
+	}
+
+	bigtime_t start = system_time();
+	bigtime_t time;
+
+	if (threaded) {
+		atomic_set(&sStopSlowTrack, 0);
+
+		thread_id threads[kMaxTracks];
+		for (int32 i = 0; i < count; i++) {
+			threads[i] = spawn_thread(&read_track, "track reader",
+				B_NORMAL_PRIORITY, &readers[i]);
+			resume_thread(threads[i]);
+		}
+
+		// The slow track is not waited for, its rate is given by the delay
+		int32 first = slowTrackDelay > 0 && count > 1 ? 1 : 0;
+		for (int32 i = first; i < count; i++) {
+			status_t result;
+			wait_for_thread(threads[i], &result);
+		}
+		time = system_time() - start;
+
+		atomic_set(&sStopSlowTrack, 1);
+		for (int32 i = 0; i < first; i++) {
+			status_t result;
+			wait_for_thread(threads[i], &result);
+		}
+
+		print_result(name, readers, count, time, first);
+	} else {
+		bool done;
+		do {
+			done = true;
+			for (int32 i = 0; i < count; i++) {
+				if (!readers[i].done && read_chunk(readers[i]))
+					done = false;
+			}
+		} while (!done);
+		time = system_time() - start;
+
+		print_result(name, readers, count, time, 0);
+	}
+
+	for (int32 i = 0; i < count; i++) {
+		if (readers[i].track != NULL)
+			file.ReleaseTrack(readers[i].track);
+	}
+}
+
+
+int
+main(int argc, char** argv)
+{
+	if (argc != 2) {
+		fprintf(stderr, "usage: %s <media-file>\n"
+			"Reads the chunks of all tracks of the file, and prints the "
+			"throughput.\n", __progname);
+		return 1;
+	}
+
+	entry_ref ref;
+	status_t status = get_ref_for_path(argv[1], &ref);
+	if (status != B_OK) {
+		fprintf(stderr, "%s: could not find \"%s\": %s\n", __progname,
+			argv[1], strerror(status));
+		return 1;
+	}
+
+	benchmark(ref, "sequential", false, 0);
+	benchmark(ref, "threaded", true, 0);
+	benchmark(ref, "slow track", true, kSlowTrackDelay);
+		// the other tracks only
+
+	return 0;
+}
@@ -0,0 +1,122 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+//!	Compares lookups in a repository cache with and without its index.
+
+
+#include <stdio.h>
+#include <string.h>
+
+#include <Entry.h>
+#include <OS.h>
+
+#include <package/PackageInfo.h>
+#include <package/RepositoryCache.h>
+#include <package/RepositoryCacheIndex.h>
+
+
+using namespace BPackageKit;
+using BPackageKit::BPrivate::RepositoryCacheIndex;
+
+
+extern const char* __progname;
+
+
+static void
+print_time(const char* test, bigtime_t time, uint32 found)
+{
+	printf("%-26s %9" B_PRId64 " usecs, %" B_PRIu32 " found\n", test, time,
+		found);
+}
+
+
+int
+main(int argc, const char** argv)
+{
+	if (argc != 4) {
+		fprintf(stderr, "usage: %s <repository cache> <package name> "
+			"<search string>\n", __progname);
+		return 1;
+	}
+
+	BEntry cacheEntry(argv[1]);
+	const char* packageName = argv[2];
+	const char* searchString = argv[3];
+
+	// create the index
+	bigtime_t startTime = system_time();
+	status_t error = RepositoryCacheIndex::Write(cacheEntry);
+	if (error != B_OK) {
+		fprintf(stderr, "%s: failed to write index: %s\n", __progname,
+			strerror(error));
+		return 1;
+	}
+	print_time("writing index", system_time() - startTime, 0);
+
+	// look up a package by reading the whole cache
+	startTime = system_time();
+	BRepositoryCache cache;
+	error = cache.SetTo(cacheEntry);
+	if (error != B_OK) {
+		fprintf(stderr, "%s: failed to read cache: %s\n", __progname,
+			strerror(error));
+		return 1;
+	}
+
+	uint32 found = 0;
+	BRepositoryCache::Iterator it = cache.GetIterator();
+	while (const BPackageInfo* info = it.Next()) {
+		if (info->Name() == packageName)
+			found++;
+	}
+	print_time("lookup, full parse", system_time() - startTime, found);
+
+	// scan all packages for the search string
+	startTime = system_time();
+	found = 0;
+	it = cache.GetIterator();
+	while (const BPackageInfo* info = it.Next()) {
+		if (info->Name().IFindFirst(searchString) >= 0
+			|| info->Summary().IFindFirst(searchString) >= 0
+			|| info->Description().IFindFirst(searchString) >= 0) {
+			found++;
+		}
+	}
+	print_time("scan, parsed cache", system_time() - startTime, found);
+
+	// look up the package through the index
+	startTime = system_time();
+	RepositoryCacheIndex index;
+	error = index.SetTo(cacheEntry);
+	if (error != B_OK) {
+		fprintf(stderr, "%s: failed to open index: %s\n", __progname,
+			strerror(error));
+		return 1;
+	}
+
+	found = 0;
+	for (int32 i = index.FindPackage(packageName);
+			i >= 0 && (uint32)i < index.CountPackages()
+				&& strcmp(index.PackageNameAt(i), packageName) == 0; i++) {
+		BPackageInfo info;
+		if (index.GetPackageInfo(i, info) == B_OK)
+			found++;
+	}
+	print_time("lookup, index", system_time() - startTime, found);
+
+	// scan the index for the search string
+	startTime = system_time();
+	RepositoryCacheIndex scanIndex;
+	error = scanIndex.SetTo(cacheEntry);
+	found = 0;
+	for (uint32 i = 0; error == B_OK && i < scanIndex.CountPackages(); i++) {
+		if (scanIndex.PackageMatches(i, searchString))
+			found++;
+	}
+	print_time("scan, index", system_time() - startTime, found);
+
+	return 0;
+}
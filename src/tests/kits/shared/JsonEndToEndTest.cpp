@@ -28,6 +28,8 @@ JsonEndToEndTest::~JsonEndToEndTest()
 }
 
 
+/*! The input is parsed both as a stream and from memory. */
+
 void
 JsonEndToEndTest::TestParseAndWrite(const char* input, const char* expectedOutput)
 {
@@ -50,6 +52,22 @@ JsonEndToEndTest::TestParseAndWrite(const char* input, const char* expectedOutpu
 	CPPUNIT_ASSERT_MESSAGE("expected did no equal actual output",
 		0 == strncmp(expectedOutput, (char*)outputData->Buffer(),
 			strlen(expectedOutput)));
+
+	BMallocIO* memoryOutputData = new BMallocIO();
+	ObjectDeleter<BMallocIO> memoryOutputDataDeleter(memoryOutputData);
+	BPrivate::BJsonTextWriter* memoryListener
+		= new BJsonTextWriter(memoryOutputData);
+	ObjectDeleter<BPrivate::BJsonTextWriter> memoryListenerDeleter(
+		memoryListener);
+
+// ----------------------
+	BPrivate::BJson::Parse(input, strlen(input), memoryListener);
+// ----------------------
+
+	CPPUNIT_ASSERT_EQUAL(B_OK, memoryListener->ErrorStatus());
+	CPPUNIT_ASSERT_MESSAGE("expected did no equal actual output from memory",
+		0 == strncmp(expectedOutput, (char*)memoryOutputData->Buffer(),
+			strlen(expectedOutput)));
 }
 
 
@@ -133,6 +151,27 @@ JsonEndToEndTest::TestObjectA()
 }
 
 
+/*! The strings are longer than the parser's buffer, so they have to be
+    assembled from several reads.
+*/
+
+void
+JsonEndToEndTest::TestStringLong()
+{
+	BString longString;
+	for (int32 i = 0; i < 5000; i++)
+		longString << "Lake Taupo " << i << "\\n";
+
+	BString input;
+	input << "[\"" << longString << "\", \"" << longString << "\\\"\"]";
+	BString expectedOutput;
+	expectedOutput << "[\"" << longString << "\",\"" << longString
+		<< "\\\"\"]";
+
+	TestParseAndWrite(input.String(), expectedOutput.String());
+}
+
+
 /*! This method will test an element being unterminated; such an object that
     is missing the terminating "}" symbol or a string that has no closing
     quote.  This is tested here because the writer
@@ -154,6 +193,19 @@ JsonEndToEndTest::TestUnterminated(const char *input)
 // ----------------------
 
 	CPPUNIT_ASSERT_EQUAL(B_BAD_DATA, listener->ErrorStatus());
+
+	BMallocIO* memoryOutputData = new BMallocIO();
+	ObjectDeleter<BMallocIO> memoryOutputDataDeleter(memoryOutputData);
+	BPrivate::BJsonTextWriter* memoryListener
+		= new BJsonTextWriter(memoryOutputData);
+	ObjectDeleter<BPrivate::BJsonTextWriter> memoryListenerDeleter(
+		memoryListener);
+
+// ----------------------
+	BPrivate::BJson::Parse(input, strlen(input), memoryListener);
+// ----------------------
+
+	CPPUNIT_ASSERT_EQUAL(B_BAD_DATA, memoryListener->ErrorStatus());
 }
 
 
@@ -195,6 +247,9 @@ JsonEndToEndTest::AddTests(BTestSuite& parent)
 		"JsonEndToEndTest::TestStringA2", &JsonEndToEndTest::TestStringA2));
 	suite.addTest(new CppUnit::TestCaller<JsonEndToEndTest>(
 		"JsonEndToEndTest::TestStringB", &JsonEndToEndTest::TestStringB));
+	suite.addTest(new CppUnit::TestCaller<JsonEndToEndTest>(
+		"JsonEndToEndTest::TestStringLong",
+		&JsonEndToEndTest::TestStringLong));
 	suite.addTest(new CppUnit::TestCaller<JsonEndToEndTest>(
 		"JsonEndToEndTest::TestArrayA", &JsonEndToEndTest::TestArrayA));
 	suite.addTest(new CppUnit::TestCaller<JsonEndToEndTest>(
@@ -25,6 +25,7 @@ public:
 			void				TestStringA();
 			void				TestStringA2();
 			void				TestStringB();
+			void				TestStringLong();
 			void				TestArrayA();
 			void				TestArrayB();
 			void				TestObjectA();
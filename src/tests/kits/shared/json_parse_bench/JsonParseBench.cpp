@@ -0,0 +1,236 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Times BJson::Parse() on JSON files, by default on the data HaikuDepot
+	caches from HaikuDepotServer. Each file is parsed from the decompressing
+	stream as HaikuDepot does, from a stream in memory, directly from memory,
+	and from a stream that returns a single byte per Read() call.
+*/
+
+
+#include <stdio.h>
+#include <string.h>
+
+#include <Directory.h>
+#include <Entry.h>
+#include <FindDirectory.h>
+#include <OS.h>
+#include <Path.h>
+
+#include <AutoDeleter.h>
+#include <DataIO.h>
+#include <FileIO.h>
+#include <Json.h>
+#include <JsonEventListener.h>
+#include <ZlibCompressionAlgorithm.h>
+
+
+extern const char* __progname;
+
+
+class CountingListener : public BJsonEventListener {
+public:
+	CountingListener()
+		:
+		fEventCount(0),
+		fContentLength(0),
+		fError(B_OK)
+	{
+	}
+
+	virtual bool Handle(const BJsonEvent& event)
+	{
+		fEventCount++;
+		if (event.EventType() == B_JSON_STRING
+			|| event.EventType() == B_JSON_OBJECT_NAME) {
+			fContentLength += event.ContentLength();
+		}
+		return true;
+	}
+
+	virtual void HandleError(status_t status, int32 line, const char* message)
+	{
+		fprintf(stderr, "%s: parse error at line %" B_PRId32 ": %s\n",
+			__progname, line, message);
+		fError = status;
+	}
+
+	virtual void Complete()
+	{
+	}
+
+	uint64 EventCount() const
+	{
+		return fEventCount;
+	}
+
+	status_t Error() const
+	{
+		return fError;
+	}
+
+private:
+	uint64		fEventCount;
+	uint64		fContentLength;
+	status_t	fError;
+};
+
+
+class ByteWiseIO : public BDataIO {
+public:
+	ByteWiseIO(BDataIO* data)
+		:
+		fData(data)
+	{
+	}
+
+	virtual ssize_t Read(void* buffer, size_t size)
+	{
+		return fData->Read(buffer, size > 0 ? 1 : 0);
+	}
+
+private:
+	BDataIO*	fData;
+};
+
+
+static status_t
+open_input(const char* path, BFileIO& file, BDataIO*& _input)
+{
+	_input = &file;
+	int length = strlen(path);
+	if (length < 3 || strcmp(path + length - 3, ".gz") != 0)
+		return B_OK;
+
+	return BZlibCompressionAlgorithm().CreateDecompressingInputStream(&file,
+		new BZlibDecompressionParameters(), _input);
+}
+
+
+static void
+report(const char* test, const CountingListener& listener, size_t size,
+	bigtime_t time)
+{
+	if (listener.Error() != B_OK) {
+		printf("  %-12s failed: %s\n", test, strerror(listener.Error()));
+		return;
+	}
+
+	printf("  %-12s %10" B_PRIu64 " events in %9" B_PRIdBIGTIME " us, "
+		"%7.1f MB/s\n", test, listener.EventCount(), time,
+		time > 0 ? (double)size / time : 0);
+}
+
+
+static void
+benchmark(const char* path)
+{
+	FILE* file = fopen(path, "rb");
+	if (file == NULL) {
+		fprintf(stderr, "%s: could not open \"%s\"\n", __progname, path);
+		return;
+	}
+
+	printf("%s:\n", path);
+
+	// read the decompressed data into memory
+	BMallocIO data;
+	{
+		BFileIO fileIO(file, true);
+		BDataIO* input;
+		if (open_input(path, fileIO, input) != B_OK) {
+			fprintf(stderr, "%s: could not decompress \"%s\"\n", __progname,
+				path);
+			return;
+		}
+		ObjectDeleter<BDataIO> inputDeleter(input != &fileIO ? input : NULL);
+
+		char buffer[64 * 1024];
+		ssize_t bytesRead;
+		while ((bytesRead = input->Read(buffer, sizeof(buffer))) > 0)
+			data.Write(buffer, bytesRead);
+	}
+
+	const char* json = (const char*)data.Buffer();
+	size_t size = data.BufferLength();
+
+	// as HaikuDepot does it, from the (decompressing) file stream
+	{
+		BFileIO fileIO(fopen(path, "rb"), true);
+		BDataIO* input;
+		if (open_input(path, fileIO, input) != B_OK)
+			return;
+		ObjectDeleter<BDataIO> inputDeleter(input != &fileIO ? input : NULL);
+
+		CountingListener listener;
+		bigtime_t startTime = system_time();
+		BJson::Parse(input, &listener);
+		report("file stream", listener, size, system_time() - startTime);
+	}
+
+	{
+		BMemoryIO memoryIO(json, size);
+		CountingListener listener;
+		bigtime_t startTime = system_time();
+		BJson::Parse(&memoryIO, &listener);
+		report("stream", listener, size, system_time() - startTime);
+	}
+
+	{
+		CountingListener listener;
+		bigtime_t startTime = system_time();
+		BJson::Parse(json, size, &listener);
+		report("memory", listener, size, system_time() - startTime);
+	}
+
+	{
+		BMemoryIO memoryIO(json, size);
+		ByteWiseIO byteWiseIO(&memoryIO);
+		CountingListener listener;
+		bigtime_t startTime = system_time();
+		BJson::Parse(&byteWiseIO, &listener);
+		report("byte-wise", listener, size, system_time() - startTime);
+	}
+}
+
+
+int
+main(int argc, char** argv)
+{
+	if (argc > 1) {
+		for (int i = 1; i < argc; i++)
+			benchmark(argv[i]);
+		return 0;
+	}
+
+	// by default use HaikuDepot's cached data
+	BPath path;
+	if (find_directory(B_USER_CACHE_DIRECTORY, &path) != B_OK
+		|| path.Append("HaikuDepot") != B_OK) {
+		return 1;
+	}
+
+	BDirectory directory(path.Path());
+	if (directory.InitCheck() != B_OK) {
+		fprintf(stderr, "usage: %s [<file.json[.gz]> ...]\n"
+			"Without arguments the files in \"%s\" are used.\n", __progname,
+			path.Path());
+		return 1;
+	}
+
+	BEntry entry;
+	while (directory.GetNextEntry(&entry) == B_OK) {
+		BPath entryPath;
+		if (entry.GetPath(&entryPath) != B_OK)
+			continue;
+
+		const char* name = entryPath.Leaf();
+		if (strstr(name, ".json") != NULL)
+			benchmark(entryPath.Path());
+	}
+
+	return 0;
+}
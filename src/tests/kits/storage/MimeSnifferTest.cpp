@@ -6,15 +6,22 @@
 #include <cppunit/TestSuite.h>
 #include <cppunit/TestCaller.h>
 #include <sniffer/Rule.h>
+#include <sniffer/RuleSet.h>
 #include <sniffer/Parser.h>
 #include <DataIO.h>
+#include <Directory.h>
+#include <Entry.h>
+#include <File.h>
 #include <Mime.h>
 #include <String.h>		// BString
 #include <TestUtils.h>
 
 #include <stdio.h>
+#include <stdlib.h>
 
 #include <iostream>
+#include <string>
+#include <vector>
 using std::cout;
 using std::endl;
 
@@ -32,6 +39,8 @@ MimeSnifferTest::Suite() {
 						   &MimeSnifferTest::ParserTest) );		
 	suite->addTest( new TC("Mime Sniffer::Sniffer Test",
 						   &MimeSnifferTest::SnifferTest) );		
+	suite->addTest( new TC("Mime Sniffer::Rule Set Test",
+						   &MimeSnifferTest::RuleSetTest) );
 						   
 	return suite;
 }		
@@ -1386,3 +1395,185 @@ std::string("\000\034	000 034", 10),	// Otherwise, it thinks the NULL is the end
 	}
 #endif // !TEST_R5
 }
+
+
+// Rule Set Test
+
+// Sniffs all rules with the interpreter and checks that RuleSet never rules
+// out a rule that matches.
+static void
+check_rule_set(const std::vector<Rule*> &rules, const std::vector<int32> &slots,
+	const RuleSet &ruleSet, const std::string &data)
+{
+	std::vector<bool> candidates;
+	ruleSet.FindCandidates(data.data(), data.length(), candidates);
+	CHK((int32)candidates.size() == ruleSet.CountSlots());
+
+	for (size_t i = 0; i < rules.size(); i++) {
+		if (slots[i] < 0)
+			continue;
+
+		BMemoryIO io(data.data(), data.length());
+		if (rules[i]->Sniff(&io))
+			CHK(candidates[slots[i]]);
+	}
+}
+
+
+// Adds the contents of the files in the given directory to the corpus
+static void
+add_directory_to_corpus(const char *path, std::vector<std::string> &corpus,
+	int32 maxFiles)
+{
+	BDirectory directory(path);
+	BEntry entry;
+	while (maxFiles > 0 && directory.GetNextEntry(&entry, true) == B_OK) {
+		BFile file(&entry, B_READ_ONLY);
+		if (file.InitCheck() != B_OK)
+			continue;
+
+		char buffer[1024];
+		ssize_t bytesRead = file.Read(buffer, sizeof(buffer));
+		if (bytesRead <= 0)
+			continue;
+
+		corpus.push_back(std::string(buffer, bytesRead));
+		maxFiles--;
+	}
+}
+
+
+void
+MimeSnifferTest::RuleSetTest() {
+#if TEST_R5
+	Outputf("(no tests actually performed for R5 version)\n");
+#else	// TEST_R5
+	const char *ruleStrings[] = {
+		"1.0 ('#include')",
+		"0.0 [0:32] ('#include')",
+		".2 ([0:32] \"#include\" | [0] '#define' | [0:200] 'int main(')",
+		"1.0 [0:32] ('<html>' | '<head>' | '<body>')",
+		"0.5 [0:64] (-i '<html' | -i '<!doctype html')",
+		"1.0 [0:9] ('rock' | 'roll')",
+		"1.0 ([0] 'rock' | [0:9] 'roll')",
+		"1.0 (\\xFF\\xFF & '\\xF0\\xF0')",
+		"1.0 ('\\33\\34' & \\xFF\\x00)",
+		"1.0 (\\xFF & \\x05)",
+		"1.0 ([4] 'rock') ([9] 'roll')",
+		"1.0 [4] ('rock' | 'roll') ([9] 'rock' | [10] 'roll')",
+		"1.0 (-i [4] 'Rock' | [9] 'Roll')",
+		"1.0 ([9] 'Rock' | -i [4] 'Roll')",
+		"0.9 ('\\x7fELF')",
+		"0.9 ('\\x89PNG\\r\\n\\x1a\\n')",
+		"0.9 ('\\xff\\xd8\\xff')",
+		"0.9 ('GIF8')",
+		"0.9 ('%PDF-')",
+		"0.9 ('PK\\x03\\x04')",
+		"0.8 [0:8] ('ftyp' | 'moov')",
+		"0.4 [0:512] ('\\x00\\x00\\x00\\x00' & '\\xff\\x00\\x00\\xff')",
+	};
+	const int ruleCount = sizeof(ruleStrings) / sizeof(ruleStrings[0]);
+
+	std::vector<Rule*> rules;
+	std::vector<int32> slots;
+	RuleSet ruleSet;
+
+	// test rules plus all sniffer rules of the installed MIME types
+	for (int i = 0; i < ruleCount; i++) {
+		Rule *rule = new Rule;
+		BString parseError;
+		CHK(parse(ruleStrings[i], rule, &parseError) == B_OK);
+		rules.push_back(rule);
+	}
+
+	BMessage types;
+	if (BMimeType::GetInstalledTypes(&types) == B_OK) {
+		const char *type;
+		for (int32 i = 0; types.FindString("types", i, &type) == B_OK; i++) {
+			BMimeType mimeType(type);
+			BString ruleString;
+			if (mimeType.GetSnifferRule(&ruleString) != B_OK)
+				continue;
+
+			Rule *rule = new Rule;
+			BString parseError;
+			if (parse(ruleString.String(), rule, &parseError) != B_OK) {
+				delete rule;
+				continue;
+			}
+			rules.push_back(rule);
+		}
+	}
+
+	for (size_t i = 0; i < rules.size(); i++) {
+		slots.push_back(ruleSet.AddRule(rules[i]));
+		CHK(slots.back() >= 0);
+	}
+
+	// Build the corpus: some handwritten data, random data with the magic
+	// strings of the rules sprinkled in, and real files.
+	std::vector<std::string> corpus;
+	corpus.push_back(std::string());
+	corpus.push_back("#include <stdio.h>\n\nint main() {\n\treturn 0;\n}\n");
+	corpus.push_back("\t#include <stdio.h>\n");
+	corpus.push_back("#define FOO\n");
+	corpus.push_back("<!DOCTYPE HTML><HTML><head></head><body></body></HTML>");
+	corpus.push_back("rockroll rockroll");
+	corpus.push_back("XXXXRoCk RoLl");
+	corpus.push_back(std::string("\033\034\t033 034", 10));
+	corpus.push_back(std::string("\377\377\360\360", 4));
+	corpus.push_back(std::string("\x89PNG\r\n\x1a\n\0\0\0\rIHDR", 16));
+	corpus.push_back(std::string("\0\0\0\x18" "ftypmp42", 12));
+
+	const char *magics[] = { "rock", "roll", "Rock", "ROLL", "<html>",
+		"#include", "\x7f" "ELF", "GIF8", "%PDF-", "PK\x03\x04", "ftyp" };
+	const int magicCount = sizeof(magics) / sizeof(magics[0]);
+	srand(42);
+	for (int i = 0; i < 500; i++) {
+		std::string data;
+		int length = rand() % 600;
+		for (int j = 0; j < length; j++)
+			data += (char)(rand() % 256);
+		int insertions = rand() % 4;
+		for (int j = 0; j < insertions; j++) {
+			int position = rand() % 20;
+			if (position > (int)data.length())
+				position = data.length();
+			data.insert(position, magics[rand() % magicCount]);
+		}
+		corpus.push_back(data);
+	}
+
+	add_directory_to_corpus("resources", corpus, 32);
+	add_directory_to_corpus("/boot/system/bin", corpus, 200);
+	add_directory_to_corpus("/boot/system/data/artwork", corpus, 50);
+
+	for (size_t i = 0; i < corpus.size(); i++) {
+		NextSubTest();
+		check_rule_set(rules, slots, ruleSet, corpus[i]);
+	}
+
+	// Remove every other rule and add it back again, like the registrar does
+	// when a rule changes, then check again.
+	NextSubTestBlock();
+	for (size_t i = 0; i < rules.size(); i += 2) {
+		ruleSet.RemoveRule(slots[i]);
+		slots[i] = -1;
+	}
+	for (size_t i = 0; i < corpus.size(); i++) {
+		NextSubTest();
+		check_rule_set(rules, slots, ruleSet, corpus[i]);
+	}
+	for (size_t i = 0; i < rules.size(); i += 2) {
+		slots[i] = ruleSet.AddRule(rules[i]);
+		CHK(slots[i] >= 0);
+	}
+	for (size_t i = 0; i < corpus.size(); i++) {
+		NextSubTest();
+		check_rule_set(rules, slots, ruleSet, corpus[i]);
+	}
+
+	for (size_t i = 0; i < rules.size(); i++)
+		delete rules[i];
+#endif // !TEST_R5
+}
@@ -15,6 +15,7 @@ public:
 	void ScannerTest();
 	void ParserTest();
 	void SnifferTest();
+	void RuleSetTest();
 
 	//------------------------------------------------------------
 	// Helper functions
@@ -0,0 +1,206 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+//!	Copies and removes a tree of small files with BCopyEngine/BRemoveEngine.
+
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include <fs_attr.h>
+#include <OS.h>
+#include <TypeConstants.h>
+
+#include <CopyEngine.h>
+#include <RemoveEngine.h>
+
+
+extern const char* __progname;
+
+static const int32 kDefaultFileCount = 100000;
+static const int32 kFilesPerDirectory = 100;
+static const size_t kFileSize = 2048;
+
+
+struct CopyController : BCopyEngine::BController {
+	CopyController()
+		:
+		fEntries(0),
+		fAttributes(0)
+	{
+	}
+
+	virtual bool EntryFinished(const char* path, status_t error)
+	{
+		if (error != B_OK) {
+			fprintf(stderr, "%s: failed to copy \"%s\": %s\n", __progname,
+				path, strerror(error));
+			return false;
+		}
+		fEntries++;
+		return true;
+	}
+
+	virtual bool AttributeFinished(const char* path, const char* attribute,
+		uint32 attributeType, status_t error)
+	{
+		fAttributes++;
+		return error == B_OK;
+	}
+
+	int32	fEntries;
+	int32	fAttributes;
+};
+
+
+struct RemoveController : BRemoveEngine::BController {
+	RemoveController()
+		:
+		fEntries(0)
+	{
+	}
+
+	virtual bool EntryFinished(const char* path, status_t error)
+	{
+		if (error != B_OK) {
+			fprintf(stderr, "%s: failed to remove \"%s\": %s\n", __progname,
+				path, strerror(error));
+			return false;
+		}
+		fEntries++;
+		return true;
+	}
+
+	int32	fEntries;
+};
+
+
+static void
+create_tree(const char* path, int32 fileCount)
+{
+	char buffer[kFileSize];
+	memset(buffer, 'x', sizeof(buffer));
+
+	if (mkdir(path, 0755) != 0) {
+		fprintf(stderr, "%s: could not create \"%s\": %s\n", __progname, path,
+			strerror(errno));
+		exit(1);
+	}
+
+	char filePath[B_PATH_NAME_LENGTH];
+	for (int32 i = 0; i < fileCount; i++) {
+		if (i % kFilesPerDirectory == 0) {
+			snprintf(filePath, sizeof(filePath), "%s/%" B_PRId32, path,
+				i / kFilesPerDirectory);
+			mkdir(filePath, 0755);
+		}
+
+		snprintf(filePath, sizeof(filePath), "%s/%" B_PRId32 "/%" B_PRId32,
+			path, i / kFilesPerDirectory, i);
+		FILE* file = fopen(filePath, "w");
+		if (file == NULL) {
+			fprintf(stderr, "%s: could not create \"%s\": %s\n", __progname,
+				filePath, strerror(errno));
+			exit(1);
+		}
+		fwrite(buffer, 1, sizeof(buffer), file);
+		fs_write_attr(fileno(file), "BEOS:TYPE", B_MIME_STRING_TYPE, 0,
+			"text/plain", 11);
+		fclose(file);
+	}
+}
+
+
+static void
+copy_tree(const char* source, const char* target, bool concurrently)
+{
+	CopyController controller;
+	BCopyEngine engine(BCopyEngine::COPY_RECURSIVELY
+		| (concurrently ? BCopyEngine::COPY_CONCURRENTLY : 0));
+	engine.SetController(&controller);
+
+	bigtime_t start = system_time();
+	status_t error = engine.CopyEntry(source, target);
+	bigtime_t time = system_time() - start;
+
+	if (error != B_OK) {
+		fprintf(stderr, "%s: copying failed: %s\n", __progname,
+			strerror(error));
+		exit(1);
+	}
+
+	printf("copy   %-12s %7" B_PRId32 " entries, %7" B_PRId32 " attributes in "
+		"%9" B_PRId64 " usecs\n", concurrently ? "concurrent" : "sequential",
+		controller.fEntries, controller.fAttributes, time);
+}
+
+
+static void
+remove_tree(const char* path, bool concurrently)
+{
+	RemoveController controller;
+	BRemoveEngine engine(
+		concurrently ? BRemoveEngine::REMOVE_CONCURRENTLY : 0);
+	engine.SetController(&controller);
+
+	bigtime_t start = system_time();
+	status_t error = engine.RemoveEntry(path);
+	bigtime_t time = system_time() - start;
+
+	if (error != B_OK) {
+		fprintf(stderr, "%s: removing failed: %s\n", __progname,
+			strerror(error));
+		exit(1);
+	}
+
+	printf("remove %-12s %7" B_PRId32 " entries                    in %9"
+		B_PRId64 " usecs\n", concurrently ? "concurrent" : "sequential",
+		controller.fEntries, time);
+}
+
+
+int
+main(int argc, char** argv)
+{
+	if (argc < 2) {
+		fprintf(stderr, "usage: %s <directory> [file count]\n"
+			"Creates a tree of small files in the (not yet existing) "
+			"directory and copies\nand removes it sequentially and "
+			"concurrently.\n", __progname);
+		return 1;
+	}
+
+	const char* path = argv[1];
+	int32 fileCount = kDefaultFileCount;
+	if (argc > 2)
+		fileCount = atol(argv[2]);
+
+	char source[B_PATH_NAME_LENGTH];
+	char target[B_PATH_NAME_LENGTH];
+	snprintf(source, sizeof(source), "%s/source", path);
+	snprintf(target, sizeof(target), "%s/target", path);
+
+	if (mkdir(path, 0755) != 0) {
+		fprintf(stderr, "%s: could not create \"%s\": %s\n", __progname, path,
+			strerror(errno));
+		return 1;
+	}
+
+	printf("creating %" B_PRId32 " files...\n", fileCount);
+	create_tree(source, fileCount);
+
+	for (int32 i = 0; i < 2; i++) {
+		bool concurrently = i != 0;
+		copy_tree(source, target, concurrently);
+		remove_tree(target, concurrently);
+	}
+
+	remove_tree(path, true);
+	return 0;
+}
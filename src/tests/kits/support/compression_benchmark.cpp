@@ -0,0 +1,216 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+//!	Measures the throughput of the zlib, gzip, and zstd compression.
+
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include <DataIO.h>
+#include <File.h>
+#include <OS.h>
+
+#include <ZlibCompressionAlgorithm.h>
+#include <ZstdCompressionAlgorithm.h>
+
+
+extern const char* __progname;
+
+static const size_t kDefaultDataSize = 64 * 1024 * 1024;
+static const size_t kStreamChunkSize = 64 * 1024;
+
+
+class NullIO : public BDataIO {
+public:
+	virtual ssize_t Write(const void* buffer, size_t size)
+	{
+		return size;
+	}
+};
+
+
+static void
+fill_data(uint8* data, size_t size)
+{
+	// words of a small vocabulary in random order compress about as well as
+	// text does
+	static const char* const kWords[] = {
+		"package", "the", "haiku", "of", "and", "compression", "a", "to",
+		"buffer", "in", "is", "stream", "for", "thread", "data", "with"
+	};
+
+	uint32 seed = 42;
+	size_t offset = 0;
+	while (offset < size) {
+		seed = seed * 1103515245 + 12345;
+		const char* word = kWords[(seed >> 16) % 16];
+		size_t length = std::min(strlen(word), size - offset);
+		memcpy(data + offset, word, length);
+		offset += length;
+		if (offset < size)
+			data[offset++] = (seed >> 24) % 8 == 0 ? '\n' : ' ';
+	}
+}
+
+
+static double
+throughput(size_t size, bigtime_t time)
+{
+	return time > 0 ? (double)size / time : 0;
+		// bytes per microsecond, i.e. MB/s
+}
+
+
+static void
+benchmark(const char* name, BCompressionAlgorithm& algorithm,
+	BCompressionParameters& parameters, int32 workerCount, const uint8* data,
+	size_t size)
+{
+	size_t capacity = size + size / 16 + 64 * 1024;
+	uint8* compressed = (uint8*)malloc(capacity);
+	uint8* uncompressed = (uint8*)malloc(size);
+	if (compressed == NULL || uncompressed == NULL) {
+		fprintf(stderr, "%s: out of memory\n", __progname);
+		exit(1);
+	}
+
+	// buffer to buffer
+	size_t compressedSize;
+	bigtime_t start = system_time();
+	status_t error = algorithm.CompressBuffer(data, size, compressed, capacity,
+		compressedSize, &parameters);
+	bigtime_t compressTime = system_time() - start;
+	if (error != B_OK) {
+		fprintf(stderr, "%s: %s: compressing failed: %s\n", __progname, name,
+			strerror(error));
+		exit(1);
+	}
+
+	size_t uncompressedSize;
+	start = system_time();
+	error = algorithm.DecompressBuffer(compressed, compressedSize,
+		uncompressed, size, uncompressedSize);
+	bigtime_t decompressTime = system_time() - start;
+	if (error != B_OK || uncompressedSize != size
+		|| memcmp(data, uncompressed, size) != 0) {
+		fprintf(stderr, "%s: %s: decompressed data differ: %s\n", __progname,
+			name, strerror(error));
+		exit(1);
+	}
+
+	// output stream
+	NullIO nullIO;
+	BDataIO* stream;
+	error = algorithm.CreateCompressingOutputStream(&nullIO, &parameters,
+		stream);
+	if (error != B_OK) {
+		fprintf(stderr, "%s: %s: creating the stream failed: %s\n",
+			__progname, name, strerror(error));
+		exit(1);
+	}
+
+	start = system_time();
+	for (size_t offset = 0; offset < size && error == B_OK;
+			offset += kStreamChunkSize) {
+		error = stream->WriteExactly(data + offset,
+			std::min(kStreamChunkSize, size - offset));
+	}
+	if (error == B_OK)
+		error = stream->Flush();
+	bigtime_t streamTime = system_time() - start;
+	delete stream;
+	if (error != B_OK) {
+		fprintf(stderr, "%s: %s: writing the stream failed: %s\n",
+			__progname, name, strerror(error));
+		exit(1);
+	}
+
+	printf("%-5s %2" B_PRId32 " workers  ratio %5.3f  compress %7.1f MB/s  "
+		"decompress %7.1f MB/s  stream %7.1f MB/s\n", name, workerCount,
+		(double)compressedSize / size, throughput(size, compressTime),
+		throughput(size, decompressTime), throughput(size, streamTime));
+
+	free(compressed);
+	free(uncompressed);
+}
+
+
+int
+main(int argc, char** argv)
+{
+	if (argc > 2 || (argc == 2 && argv[1][0] == '-')) {
+		fprintf(stderr, "usage: %s [file]\n"
+			"Compresses and decompresses the file's content (or %d MB of "
+			"generated\ntext) with and without worker threads.\n", __progname,
+			(int)(kDefaultDataSize / 1024 / 1024));
+		return 1;
+	}
+
+	uint8* data;
+	size_t size;
+	if (argc == 2) {
+		BFile file;
+		off_t fileSize;
+		status_t error = file.SetTo(argv[1], B_READ_ONLY);
+		if (error == B_OK)
+			error = file.GetSize(&fileSize);
+		if (error != B_OK) {
+			fprintf(stderr, "%s: could not open \"%s\": %s\n", __progname,
+				argv[1], strerror(error));
+			return 1;
+		}
+
+		size = fileSize;
+		data = (uint8*)malloc(size);
+		if (data == NULL
+			|| (error = file.ReadAtExactly(0, data, size)) != B_OK) {
+			fprintf(stderr, "%s: could not read \"%s\": %s\n", __progname,
+				argv[1], strerror(data == NULL ? B_NO_MEMORY : error));
+			return 1;
+		}
+	} else {
+		size = kDefaultDataSize;
+		data = (uint8*)malloc(size);
+		if (data == NULL) {
+			fprintf(stderr, "%s: out of memory\n", __progname);
+			return 1;
+		}
+		fill_data(data, size);
+	}
+
+	system_info info;
+	get_system_info(&info);
+	int32 workerCounts[] = { 0, (int32)info.cpu_count };
+	int32 workerCountCount = info.cpu_count > 1 ? 2 : 1;
+
+	printf("%" B_PRIuSIZE " bytes, %" B_PRIu32 " CPUs\n", size,
+		info.cpu_count);
+
+	BZlibCompressionAlgorithm zlib;
+	BZstdCompressionAlgorithm zstd;
+	for (int32 i = 0; i < workerCountCount; i++) {
+		BZlibCompressionParameters zlibParameters;
+		zlibParameters.SetBufferSize(kStreamChunkSize);
+		zlibParameters.SetWorkerCount(workerCounts[i]);
+		benchmark("zlib", zlib, zlibParameters, workerCounts[i], data, size);
+
+		zlibParameters.SetGzipFormat(true);
+		benchmark("gzip", zlib, zlibParameters, workerCounts[i], data, size);
+
+		BZstdCompressionParameters zstdParameters;
+		zstdParameters.SetBufferSize(kStreamChunkSize);
+		zstdParameters.SetWorkerCount(workerCounts[i]);
+		benchmark("zstd", zstd, zstdParameters, workerCounts[i], data, size);
+	}
+
+	free(data);
+	return 0;
+}
@@ -44,6 +44,8 @@ static const char* kUsage =
 	"      Print this usage info.\n"
 	"  -i, --input-stream\n"
 	"      Use the input stream API (default is output stream API).\n"
+	"  -t <count>\n"
+	"      Compress with <count> worker threads (zstd only).\n"
 ;
 
 
@@ -61,6 +63,7 @@ main(int argc, const char* const* argv)
 	int compressionLevel = -1;
 	bool compress = true;
 	bool useInputStream = false;
+	int32 workerCount = 0;
 	CompressionType compressionType = ZlibCompression;
 
 	while (true) {
@@ -72,7 +75,7 @@ main(int argc, const char* const* argv)
 		};
 
 		opterr = 0; // don't print errors
-		int c = getopt_long(argc, (char**)argv, "+0123456789df:hi",
+		int c = getopt_long(argc, (char**)argv, "+0123456789df:hit:",
 			sLongOptions, NULL);
 		if (c == -1)
 			break;
@@ -117,6 +120,10 @@ main(int argc, const char* const* argv)
 				useInputStream = true;
 				break;
 
+			case 't':
+				workerCount = atoi(optarg);
+				break;
+
 			default:
 				print_usage_and_exit(true);
 				break;
@@ -173,8 +180,10 @@ main(int argc, const char* const* argv)
 			if (compressionLevel < 0)
 				compressionLevel = B_ZSTD_COMPRESSION_DEFAULT;
 			compressionAlgorithm = new BZstdCompressionAlgorithm;
-			compressionParameters
+			BZstdCompressionParameters* zstdCompressionParameters
 				= new BZstdCompressionParameters(compressionLevel);
+			zstdCompressionParameters->SetWorkerCount(workerCount);
+			compressionParameters = zstdCompressionParameters;
 			decompressionParameters = new BZstdDecompressionParameters;
 			break;
 		}
@@ -37,6 +37,7 @@
 
 #include <Application.h>
 #include <Archivable.h>
+#include <DataIO.h>
 #include <File.h>
 #include <Message.h>
 #include <OS.h>
@@ -133,6 +134,10 @@ TranslatorRosterTest::Suite()
 		"TranslatorRosterTest::Translate Test",
 		&TranslatorRosterTest::TranslateTest));			
 
+	suite->addTest(new CppUnit::TestCaller<TranslatorRosterTest>(
+		"TranslatorRosterTest::TranslateBatch Test",
+		&TranslatorRosterTest::TranslateBatchTest));
+
 	return suite;
 }
 
@@ -1012,6 +1017,66 @@ TranslatorRosterTest::TranslateTest()
 	// TODO: the other NULL parameter is
 }
 
+/**
+ * Tests:
+ * status_t TranslateBatch(BPositionIO **sources,
+ * BPositionIO **destinations, int32 count, BMessage *ioExtension,
+ * uint32 wantOutType, status_t *_results = NULL)
+ *
+ * @return B_OK if everything went ok, B_ERROR if not
+ */
+void
+TranslatorRosterTest::TranslateBatchTest()
+{
+	NextSubTest();
+	BApplication app(
+		"application/x-vnd.OpenBeOS-translationkit_translatorrostertest");
+	const char* paths[] = {
+		"../src/tests/kits/translation/data/images/image.gif",
+		"../src/tests/kits/translation/data/images/image.jpg",
+		"../src/tests/kits/translation/data/images/image.png",
+		"../src/tests/kits/translation/data/garbled_data"
+	};
+	const int32 count = sizeof(paths) / sizeof(paths[0]);
+
+	BFile inputs[count];
+	BMallocIO outputs[count];
+	BPositionIO* sources[count];
+	BPositionIO* destinations[count];
+	for (int32 i = 0; i < count; i++) {
+		inputs[i].SetTo(paths[i], B_READ_ONLY);
+		CPPUNIT_ASSERT(inputs[i].InitCheck() == B_OK);
+		sources[i] = &inputs[i];
+		destinations[i] = &outputs[i];
+	}
+
+	BTranslatorRoster *pDefRoster = BTranslatorRoster::Default();
+	CPPUNIT_ASSERT(pDefRoster != NULL);
+
+	// bad parameters
+	NextSubTest();
+	CPPUNIT_ASSERT(pDefRoster->TranslateBatch(NULL, destinations, count,
+		NULL, B_TRANSLATOR_BITMAP) == B_BAD_VALUE);
+	CPPUNIT_ASSERT(pDefRoster->TranslateBatch(sources, NULL, count,
+		NULL, B_TRANSLATOR_BITMAP) == B_BAD_VALUE);
+
+	// the images are translated, the garbled data is not
+	NextSubTest();
+	status_t results[count];
+	CPPUNIT_ASSERT(pDefRoster->TranslateBatch(sources, destinations, count,
+		NULL, B_TRANSLATOR_BITMAP, results) == B_NO_TRANSLATOR);
+	for (int32 i = 0; i < count - 1; i++) {
+		CPPUNIT_ASSERT(results[i] == B_OK);
+		CPPUNIT_ASSERT(outputs[i].BufferLength() > sizeof(TranslatorBitmap));
+	}
+	CPPUNIT_ASSERT(results[count - 1] == B_NO_TRANSLATOR);
+
+	// all of them
+	NextSubTest();
+	CPPUNIT_ASSERT(pDefRoster->TranslateBatch(sources, destinations,
+		count - 1, NULL, B_TRANSLATOR_BITMAP) == B_OK);
+}
+
 int
 main()
 {
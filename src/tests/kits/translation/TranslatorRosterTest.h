@@ -62,5 +62,6 @@ public:
 	void IdentifyTest();
 	void MakeConfigurationViewTest();
 	void TranslateTest();
+	void TranslateBatchTest();
 };
 #endif
@@ -0,0 +1,168 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Measures how fast the translation kit identifies and translates a set of
+	files, one file after the other, and with BTranslatorRoster's batch API.
+	The files are read into memory first, so that only the translation kit
+	is measured.
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <Application.h>
+#include <DataIO.h>
+#include <Directory.h>
+#include <Entry.h>
+#include <File.h>
+#include <ObjectList.h>
+#include <OS.h>
+#include <Path.h>
+#include <TranslatorFormats.h>
+#include <TranslatorRoster.h>
+
+
+extern const char* __progname;
+
+static const int32 kRounds = 5;
+
+
+static status_t
+add_file(BObjectList<BMallocIO>& files, const char* path)
+{
+	BFile file;
+	status_t status = file.SetTo(path, B_READ_ONLY);
+	if (status != B_OK)
+		return status;
+
+	BMallocIO* data = new BMallocIO;
+	char buffer[65536];
+	ssize_t bytesRead;
+	while ((bytesRead = file.Read(buffer, sizeof(buffer))) > 0)
+		data->Write(buffer, bytesRead);
+	if (bytesRead < 0) {
+		delete data;
+		return bytesRead;
+	}
+
+	files.AddItem(data);
+	return B_OK;
+}
+
+
+static status_t
+add_files(BObjectList<BMallocIO>& files, const char* path)
+{
+	BEntry entry(path);
+	if (!entry.IsDirectory())
+		return add_file(files, path);
+
+	BDirectory directory(&entry);
+	while (directory.GetNextEntry(&entry) == B_OK) {
+		BPath childPath(&entry);
+		if (childPath.InitCheck() == B_OK)
+			add_files(files, childPath.Path());
+	}
+
+	return B_OK;
+}
+
+
+static void
+print_result(const char* name, int32 count, bigtime_t time)
+{
+	printf("%-12s %7.1f files/s\n", name,
+		time > 0 ? count * 1000000.0 / time : 0.0);
+}
+
+
+int
+main(int argc, char** argv)
+{
+	if (argc < 2) {
+		fprintf(stderr, "usage: %s <file or directory> ...\n"
+			"Identifies and translates the files to B_TRANSLATOR_BITMAP, and "
+			"prints the\nthroughput.\n", __progname);
+		return 1;
+	}
+
+	BApplication app("application/x-vnd.Haiku-identify_benchmark");
+
+	BObjectList<BMallocIO> files(20, true);
+	for (int32 i = 1; i < argc; i++) {
+		status_t status = add_files(files, argv[i]);
+		if (status != B_OK) {
+			fprintf(stderr, "%s: could not read \"%s\": %s\n", __progname,
+				argv[i], strerror(status));
+			return 1;
+		}
+	}
+
+	int32 count = files.CountItems();
+	if (count == 0) {
+		fprintf(stderr, "%s: no files found\n", __progname);
+		return 1;
+	}
+
+	BTranslatorRoster* roster = BTranslatorRoster::Default();
+
+	// identify
+	int32 identified = 0;
+	bigtime_t start = system_time();
+	for (int32 round = 0; round < kRounds; round++) {
+		for (int32 i = 0; i < count; i++) {
+			translator_info info;
+			if (roster->Identify(files.ItemAt(i), NULL, &info) == B_OK)
+				identified++;
+		}
+	}
+	bigtime_t time = system_time() - start;
+
+	printf("%" B_PRId32 " files, %" B_PRId32 " identified\n", count,
+		identified / kRounds);
+	print_result("identify", count * kRounds, time);
+
+	// translate, one after the other
+	BPositionIO** sources = new BPositionIO*[count];
+	BPositionIO** destinations = new BPositionIO*[count];
+	BMallocIO* outputs = new BMallocIO[count];
+	for (int32 i = 0; i < count; i++) {
+		sources[i] = files.ItemAt(i);
+		destinations[i] = &outputs[i];
+	}
+
+	start = system_time();
+	for (int32 round = 0; round < kRounds; round++) {
+		for (int32 i = 0; i < count; i++) {
+			outputs[i].SetSize(0);
+			outputs[i].Seek(0, SEEK_SET);
+			roster->Translate(sources[i], NULL, NULL, destinations[i],
+				B_TRANSLATOR_BITMAP);
+		}
+	}
+	time = system_time() - start;
+	print_result("translate", count * kRounds, time);
+
+	// translate, in a batch
+	start = system_time();
+	for (int32 round = 0; round < kRounds; round++) {
+		for (int32 i = 0; i < count; i++) {
+			outputs[i].SetSize(0);
+			outputs[i].Seek(0, SEEK_SET);
+		}
+		roster->TranslateBatch(sources, destinations, count, NULL,
+			B_TRANSLATOR_BITMAP);
+	}
+	time = system_time() - start;
+	print_result("batch", count * kRounds, time);
+
+	delete[] sources;
+	delete[] destinations;
+	delete[] outputs;
+	return 0;
+}
@@ -0,0 +1,113 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Measures how fast thumbnails can be made of a folder of images: decoding
+	them at their full size, and with a size hint, that lets translators like
+	the JPEG one decode them at a fraction of it.
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <Application.h>
+#include <Bitmap.h>
+#include <Directory.h>
+#include <Entry.h>
+#include <OS.h>
+#include <TranslationUtils.h>
+#include <TranslatorRoster.h>
+
+
+extern const char* __progname;
+
+static const int32 kRounds = 3;
+static const int32 kDefaultThumbnailSize = 128;
+
+
+static void
+benchmark(const char* name, entry_ref* refs, int32 count,
+	const BRect& sizeHint)
+{
+	int32 decoded = 0;
+	int64 pixels = 0;
+
+	bigtime_t start = system_time();
+	for (int32 round = 0; round < kRounds; round++) {
+		for (int32 i = 0; i < count; i++) {
+			BBitmap* bitmap = BTranslationUtils::GetBitmap(&refs[i], sizeHint);
+			if (bitmap == NULL)
+				continue;
+
+			decoded++;
+			pixels += (int64)(bitmap->Bounds().IntegerWidth() + 1)
+				* (bitmap->Bounds().IntegerHeight() + 1);
+			delete bitmap;
+		}
+	}
+	bigtime_t time = system_time() - start;
+
+	printf("%-10s %5" B_PRId32 " images  %7.1f images/s  %8.1f MPixel/image\n",
+		name, decoded / kRounds,
+		time > 0 ? decoded * 1000000.0 / time : 0.0,
+		decoded > 0 ? pixels / 1000000.0 / decoded : 0.0);
+}
+
+
+int
+main(int argc, char** argv)
+{
+	if (argc != 2 && argc != 3) {
+		fprintf(stderr, "usage: %s <directory> [thumbnail-size]\n"
+			"Decodes all images in the directory at their full size, and for "
+			"a thumbnail\nof the given size (default %" B_PRId32 "), and prints "
+			"the throughput.\n", __progname, kDefaultThumbnailSize);
+		return 1;
+	}
+
+	int32 size = argc == 3 ? atol(argv[2]) : kDefaultThumbnailSize;
+	if (size <= 0) {
+		fprintf(stderr, "%s: invalid thumbnail size \"%s\"\n", __progname,
+			argv[2]);
+		return 1;
+	}
+
+	BApplication app("application/x-vnd.Haiku-thumbnail_benchmark");
+
+	BDirectory directory(argv[1]);
+	status_t status = directory.InitCheck();
+	if (status != B_OK) {
+		fprintf(stderr, "%s: could not open \"%s\": %s\n", __progname,
+			argv[1], strerror(status));
+		return 1;
+	}
+
+	int32 maxCount = directory.CountEntries();
+	entry_ref* refs = new entry_ref[max_c(maxCount, 1)];
+	int32 count = 0;
+	entry_ref ref;
+	while (count < maxCount && directory.GetNextRef(&ref) == B_OK) {
+		BEntry entry(&ref);
+		if (entry.IsFile())
+			refs[count++] = ref;
+	}
+
+	if (count == 0) {
+		fprintf(stderr, "%s: no files found\n", __progname);
+		delete[] refs;
+		return 1;
+	}
+
+	// load the translators before measuring
+	BTranslatorRoster::Default();
+
+	benchmark("full size", refs, count, BRect());
+	benchmark("thumbnail", refs, count, BRect(0, 0, size - 1, size - 1));
+
+	delete[] refs;
+	return 0;
+}
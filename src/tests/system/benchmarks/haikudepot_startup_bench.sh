@@ -0,0 +1,51 @@
+#!/bin/sh
+
+# Times HaikuDepot's bulk load from its start until all of its processes have
+# completed and the package list is usable. The data dumps are served from a
+# local mirror of the web application's "/__reference", "/__repository",
+# "/__pkg" and "/__pkgicon" data (the directory given as first argument), so
+# that the network doesn't dominate the timing. Cached data is dropped first,
+# so everything is downloaded and processed again.
+
+if [ $# -lt 1 ]; then
+	echo "usage: $0 <mirror directory> [runs]"
+	exit 1
+fi
+
+mirror=$1
+runs=${2:-3}
+port=8089
+log=/tmp/haikudepot_startup_bench.log
+
+cd $mirror || exit 1
+python3 -m http.server $port > /dev/null 2>&1 &
+serverPid=$!
+sleep 1
+
+i=0
+while [ $i -lt $runs ]; do
+	start=$(date +%s%N)
+	/boot/system/apps/HaikuDepot --webappbaseurl http://localhost:$port \
+		--dropcache -v info > $log 2>&1 &
+	haikuDepotPid=$!
+
+	while ! grep -q "did complete all processes" $log; do
+		if ! kill -0 $haikuDepotPid 2> /dev/null; then
+			echo "HaikuDepot quit unexpectedly"
+			kill $serverPid
+			exit 1
+		fi
+		sleep 0.1
+	done
+	end=$(date +%s%N)
+
+	grep -E "did complete all processes|did process [0-9]+ packages" $log
+	echo "run $i: usable after $(( (end - start) / 1000000 )) ms"
+
+	kill $haikuDepotPid
+	wait $haikuDepotPid 2> /dev/null
+	i=$((i + 1))
+done
+
+kill $serverPid
+rm -f $log
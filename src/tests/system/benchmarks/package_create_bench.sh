@@ -0,0 +1,47 @@
+#!/bin/sh
+
+# Times "package create" of the given directory tree with 1, 4 and 16
+# compression threads, and checks that all runs produce the same package.
+
+if [ $# -lt 1 ]; then
+	echo "usage: $0 <directory> [ <package options> ]"
+	exit 1
+fi
+
+sourceDir=$1
+shift
+
+testDir=/tmp/package_create_bench
+rm -rf $testDir
+mkdir -p $testDir
+
+cat << EOF > $testDir/.PackageInfo
+name			package_create_bench
+version			1-1
+architecture	any
+summary			"package create benchmark"
+description		"package create benchmark"
+packager		"nobody <nobody@example.com>"
+vendor			"nobody"
+copyrights		"none"
+licenses		"MIT"
+provides {
+	package_create_bench = 1-1
+}
+EOF
+
+for threads in 1 4 16; do
+	echo "$threads thread(s):"
+	time package create -q -j $threads -i $testDir/.PackageInfo \
+		-C "$sourceDir" "$@" $testDir/$threads.hpkg || exit 1
+done
+
+echo
+sha256sum $testDir/*.hpkg
+if [ $(sha256sum $testDir/*.hpkg | cut -d ' ' -f 1 | uniq | wc -l) -ne 1 ]
+then
+	echo "The packages differ!"
+	exit 1
+fi
+
+rm -rf $testDir
@@ -0,0 +1,60 @@
+#!/bin/sh
+
+# Times a package daemon transaction activating many packages at once (by
+# default 200), each of which has a global writable settings file. The
+# packages are generated, installed into the home installation location, and
+# uninstalled again. Besides the total time of both transactions the package
+# daemon's and packagefs' timings for extracting the writable files and
+# loading the packages are reported from the syslog.
+
+count=${1:-200}
+
+testDir=/tmp/package_daemon_commit_bench
+rm -rf $testDir
+mkdir -p $testDir/packages
+
+i=0
+while [ $i -lt $count ]; do
+	name=commit_bench_$i
+	contentDir=$testDir/content/$name
+	mkdir -p $contentDir/settings/$name $contentDir/data/$name
+	echo "setting = $i" > $contentDir/settings/$name/$name.conf
+	dd if=/dev/urandom of=$contentDir/data/$name/data bs=64k count=4 \
+		2> /dev/null
+
+	cat > $contentDir/.PackageInfo << EOF
+name			$name
+version			1.0-1
+architecture	any
+summary			"package daemon commit benchmark package"
+description		"package daemon commit benchmark package"
+packager		"nobody <nobody@localhost>"
+vendor			"Haiku Project"
+licenses		"MIT"
+copyrights		"2026 Haiku, Inc."
+provides		{ $name = 1.0 }
+requires		{ }
+global-writable-files {
+	"settings/$name" directory keep-old
+}
+EOF
+
+	package create -q -C $contentDir $testDir/packages/$name-1.0-1-any.hpkg \
+		|| exit 1
+	i=$((i + 1))
+done
+
+syslogLines=$(wc -l < /var/log/syslog)
+
+echo "installing $count packages:"
+time pkgman install -y $testDir/packages/*.hpkg > /dev/null || exit 1
+
+packageNames=$(ls $testDir/packages | sed 's/-1.0-1-any.hpkg//')
+
+echo "uninstalling $count packages:"
+time pkgman uninstall -y $packageNames > /dev/null || exit 1
+
+tail -n +$((syslogLines + 1)) /var/log/syslog \
+	| grep -E "extracted the writable files|loaded [0-9]+ packages in"
+
+rm -rf $testDir
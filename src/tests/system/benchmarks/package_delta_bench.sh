@@ -0,0 +1,31 @@
+#!/bin/sh
+
+# Creates a delta between two versions of a package, reports how many bytes
+# it saves compared to transferring the new package, times applying it, and
+# checks that the rebuilt package is identical to the new one.
+
+if [ $# != 2 ]; then
+	echo "Usage: $0 <old package> <new package>"
+	exit 1
+fi
+
+oldPackage=$1
+newPackage=$2
+
+testDir=/tmp/package_delta_bench
+rm -rf $testDir
+mkdir -p $testDir
+
+echo "creating delta:"
+time package delta "$oldPackage" "$newPackage" $testDir/delta || exit 1
+
+echo "applying delta:"
+time package patch "$oldPackage" $testDir/delta $testDir/rebuilt.hpkg \
+	|| exit 1
+
+if ! cmp -s "$newPackage" $testDir/rebuilt.hpkg; then
+	echo "The rebuilt package differs!"
+	exit 1
+fi
+
+rm -rf $testDir
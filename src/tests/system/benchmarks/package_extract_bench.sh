@@ -0,0 +1,24 @@
+#!/bin/sh
+
+# Times "package extract" of the given package (by default the system
+# package) with and without reading ahead, and checks that both extract the
+# same files.
+
+package=${1:-/boot/system/packages/haiku.hpkg}
+
+testDir=/tmp/package_extract_bench
+rm -rf $testDir
+mkdir -p $testDir/single $testDir/read-ahead
+
+echo "single thread:"
+time package extract -s -C $testDir/single "$package" || exit 1
+
+echo "read-ahead:"
+time package extract -C $testDir/read-ahead "$package" || exit 1
+
+if ! diff -r $testDir/single $testDir/read-ahead > /dev/null; then
+	echo "The extracted files differ!"
+	exit 1
+fi
+
+rm -rf $testDir
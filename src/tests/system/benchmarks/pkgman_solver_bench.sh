@@ -0,0 +1,23 @@
+#!/bin/sh
+
+# Reports the time pkgman needs to set up the solver pool for an update and
+# for installing the given package (by default "haiku_devel"), first with
+# the libsolv repository cache removed, then with the cache written by the
+# first run. Nothing is actually installed.
+
+package=${1:-haiku_devel}
+cacheDir=$(finddir B_USER_CACHE_DIRECTORY)/package-solver
+
+report()
+{
+	echo no | pkgman "$@" --debug 1 2>&1 | grep "solver pool set up"
+}
+
+for command in update "install $package"; do
+	echo "$command:"
+	rm -rf "$cacheDir"
+	echo -n "  without cache: "
+	report $command
+	echo -n "  with cache:    "
+	report $command
+done
@@ -0,0 +1,263 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+//!	Measures 4 KB random reads from a file through an I/O ring.
+
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include <OS.h>
+
+#include <io_ring_defs.h>
+#include <syscalls.h>
+
+
+extern const char* __progname;
+
+static const size_t kBlockSize = 4096;
+static const int32 kDefaultReadCount = 20000;
+static const uint32 kMaxQueueDepth = 128;
+
+
+static uint64
+random_block(uint64 blockCount)
+{
+	return (((uint64)rand() << 31) ^ rand()) % blockCount;
+}
+
+
+static void
+print_result(const char* test, uint32 queueDepth, int32 count, bigtime_t time)
+{
+	printf("%-8s QD %3" B_PRIu32 ": %7" B_PRId32 " reads in %8" B_PRId64
+		" usecs, %9.0f IOPS, %8.1f MB/s\n", test, queueDepth, count, time,
+		time > 0 ? count * 1000000.0 / time : 0,
+		time > 0 ? count * (double)kBlockSize / time : 0);
+}
+
+
+static void
+benchmark_read_pos(int fd, uint64 blockCount, int32 count, uint8* buffer)
+{
+	bigtime_t start = system_time();
+
+	for (int32 i = 0; i < count; i++) {
+		ssize_t bytesRead = read_pos(fd, random_block(blockCount) * kBlockSize,
+			buffer, kBlockSize);
+		if (bytesRead < 0) {
+			fprintf(stderr, "%s: read failed: %s\n", __progname,
+				strerror(bytesRead));
+			exit(1);
+		}
+	}
+
+	print_result("read_pos", 1, count, system_time() - start);
+}
+
+
+static void
+benchmark_io_ring(int fd, uint64 blockCount, int32 count, uint32 queueDepth,
+	uint8* buffers)
+{
+	io_ring_params params;
+	memset(&params, 0, sizeof(params));
+	params.submission_entries = queueDepth;
+	params.max_workers = queueDepth;
+
+	int ring = _kern_create_io_ring(&params);
+	if (ring < 0) {
+		fprintf(stderr, "%s: could not create I/O ring: %s\n", __progname,
+			strerror(ring));
+		exit(1);
+	}
+
+	io_ring_header* header = (io_ring_header*)params.address;
+	io_ring_submission* submissions = (io_ring_submission*)
+		((uint8*)header + header->sq_offset);
+	io_ring_completion* completions = (io_ring_completion*)
+		((uint8*)header + header->cq_offset);
+
+	// every slot of the queue has its own buffer; the user data tells which
+	// one a completed read used
+	uint32 freeSlots[kMaxQueueDepth];
+	uint32 freeCount = queueDepth;
+	for (uint32 i = 0; i < queueDepth; i++)
+		freeSlots[i] = i;
+
+	int32 submitted = 0;
+	int32 completed = 0;
+	bigtime_t start = system_time();
+
+	while (completed < count) {
+		// fill up the queue
+		uint32 toSubmit = 0;
+		uint32 tail = header->sq_tail;
+		while (freeCount > 0 && submitted + (int32)toSubmit < count) {
+			uint32 slot = freeSlots[--freeCount];
+
+			io_ring_submission& submission
+				= submissions[tail & header->sq_mask];
+			memset(&submission, 0, sizeof(submission));
+			submission.opcode = IO_RING_OP_READ;
+			submission.fd = fd;
+			submission.offset = random_block(blockCount) * kBlockSize;
+			submission.address = (addr_t)(buffers + slot * kBlockSize);
+			submission.length = kBlockSize;
+			submission.user_data = slot;
+
+			tail++;
+			toSubmit++;
+		}
+		atomic_set((int32*)&header->sq_tail, tail);
+
+		int32 result = _kern_io_ring_enter(ring, toSubmit, 1, 0, 0);
+		if (result < 0) {
+			fprintf(stderr, "%s: submitting failed: %s\n", __progname,
+				strerror(result));
+			exit(1);
+		}
+		submitted += result;
+		if ((uint32)result < toSubmit) {
+			// the kernel didn't take all of them; reuse the remaining slots
+			// in the next round
+			for (uint32 i = result; i < toSubmit; i++) {
+				io_ring_submission& submission
+					= submissions[(header->sq_head + i - result)
+						& header->sq_mask];
+				freeSlots[freeCount++] = submission.user_data;
+			}
+			atomic_set((int32*)&header->sq_tail, header->sq_head);
+		}
+
+		// reap all completions
+		uint32 head = header->cq_head;
+		uint32 completionTail = atomic_get((int32*)&header->cq_tail);
+		for (; head != completionTail; head++) {
+			io_ring_completion& completion
+				= completions[head & header->cq_mask];
+			if (completion.result < 0) {
+				fprintf(stderr, "%s: read failed: %s\n", __progname,
+					strerror(completion.result));
+				exit(1);
+			}
+			freeSlots[freeCount++] = completion.user_data;
+			completed++;
+		}
+		atomic_set((int32*)&header->cq_head, head);
+	}
+
+	print_result("io_ring", queueDepth, count, system_time() - start);
+	close(ring);
+}
+
+
+/*!	A child inherits the ring descriptor, but its operations would run in
+	the parent's team, so it must not be able to use it.
+*/
+static void
+check_fork()
+{
+	io_ring_params params;
+	memset(&params, 0, sizeof(params));
+	params.submission_entries = 1;
+
+	int ring = _kern_create_io_ring(&params);
+	if (ring < 0) {
+		fprintf(stderr, "%s: could not create I/O ring: %s\n", __progname,
+			strerror(ring));
+		exit(1);
+	}
+
+	pid_t child = fork();
+	if (child < 0) {
+		fprintf(stderr, "%s: fork failed: %s\n", __progname,
+			strerror(errno));
+		exit(1);
+	}
+
+	if (child == 0) {
+		io_ring_header* header = (io_ring_header*)params.address;
+		io_ring_submission* submissions = (io_ring_submission*)
+			((uint8*)header + header->sq_offset);
+		memset(&submissions[header->sq_tail & header->sq_mask], 0,
+			sizeof(io_ring_submission));
+		atomic_add((int32*)&header->sq_tail, 1);
+
+		int32 result = _kern_io_ring_enter(ring, 1, 0, 0, 0);
+		_exit(result == B_NOT_ALLOWED ? 0 : 1);
+	}
+
+	int status;
+	if (waitpid(child, &status, 0) != child || !WIFEXITED(status)
+		|| WEXITSTATUS(status) != 0) {
+		fprintf(stderr, "%s: a forked child could use the parent's I/O "
+			"ring\n", __progname);
+		exit(1);
+	}
+
+	close(ring);
+}
+
+
+int
+main(int argc, char** argv)
+{
+	bool useCache = false;
+	int argIndex = 1;
+	if (argc > argIndex && strcmp(argv[argIndex], "-c") == 0) {
+		useCache = true;
+		argIndex++;
+	}
+
+	if (argc <= argIndex) {
+		fprintf(stderr, "usage: %s [-c] <file> [reads per run]\n"
+			"Reads random 4 KB blocks from the file at queue depths 1 to %"
+			B_PRIu32 ".\nThe file cache is bypassed unless -c is given.\n",
+			__progname, kMaxQueueDepth);
+		return 1;
+	}
+
+	const char* path = argv[argIndex++];
+	int32 count = kDefaultReadCount;
+	if (argc > argIndex)
+		count = atol(argv[argIndex]);
+
+	int fd = open(path, O_RDONLY | (useCache ? 0 : O_NOCACHE));
+	if (fd < 0) {
+		fprintf(stderr, "%s: could not open \"%s\": %s\n", __progname, path,
+			strerror(errno));
+		return 1;
+	}
+
+	off_t size = lseek(fd, 0, SEEK_END);
+	uint64 blockCount = size / kBlockSize;
+	if (blockCount == 0 || count <= 0) {
+		fprintf(stderr, "%s: file too small\n", __progname);
+		return 1;
+	}
+
+	uint8* buffers = (uint8*)malloc(kMaxQueueDepth * kBlockSize);
+	if (buffers == NULL)
+		return 1;
+
+	srand(system_time());
+
+	check_fork();
+
+	benchmark_read_pos(fd, blockCount, count, buffers);
+	for (uint32 queueDepth = 1; queueDepth <= kMaxQueueDepth; queueDepth *= 2)
+		benchmark_io_ring(fd, blockCount, count, queueDepth, buffers);
+
+	free(buffers);
+	close(fd);
+	return 0;
+}